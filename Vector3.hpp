@@ -1,6 +1,7 @@
 #pragma once
 #include <cmath>
 #include <ostream>
+#include <type_traits>
 
 namespace CPL
 {
@@ -10,15 +11,19 @@ namespace CPL
     public:
         T x, y, z;
 
-        Vector3() : x(0.0f), y(0.0f), z(0.0f) {}
+        // length(), normalization and angles truncate to nothing useful on an
+        // integer lattice; grid_coords.hpp has manhattan() and chebyshev().
+        static constexpr bool IsReal = !std::is_integral<T>::value;
+
+        Vector3() : x(T(0)), y(T(0)), z(T(0)) {}
         Vector3(T x, T y, T z) : x(x), y(y), z(z) {}
         Vector3(const Vector3& other) = default;              // copy-ctor
 
         Vector3& operator=(const Vector3& other) = default;   // assign
 
-        static Vector3 ones() { return Vector3(1.0f, 1.0f, 1.0f); }
-        static Vector3 zeros() { return Vector3(0.0f, 0.0f, 0.0f); }
-        static Vector3 up() { return Vector3(0.0f, 1.0f, 0.0f); }
+        static Vector3 ones() { return Vector3(T(1), T(1), T(1)); }
+        static Vector3 zeros() { return Vector3(T(0), T(0), T(0)); }
+        static Vector3 up() { return Vector3(T(0), T(1), T(0)); }
 
         Vector3 operator+(const Vector3& o) const { return { x + o.x, y + o.y, z + o.z }; }
         Vector3& operator+=(const Vector3& o) { x += o.x; y += o.y; z += o.z; return *this; }
@@ -44,24 +49,35 @@ namespace CPL
         }
 
         T lengthSquared() const { return x * x + y * y + z * z; }
-        T length()        const { return std::sqrt(lengthSquared()); }
+        // Unqualified math so scalar types can supply their own through ADL.
+        T length() const
+        {
+            static_assert(IsReal, "length() needs a non-integer scalar");
+            using std::sqrt;
+            return T(sqrt(lengthSquared()));
+        }
 
         Vector3 normalized() const
         {
+            static_assert(IsReal, "normalized() needs a non-integer scalar");
             T len = length();
             return (len == T(0)) ? Vector3(0, 0, 0) : (*this) / len;
         }
         void normalize()
         {
+            static_assert(IsReal, "normalize() needs a non-integer scalar");
             T len = length();
             if (len != T(0)) { x /= len; y /= len; z /= len; }
         }
 
         T angleBetween(const Vector3& o) const
         {
+            static_assert(IsReal, "angleBetween() needs a non-integer scalar");
             T c = dot(o) / (length() * o.length());
-            if (c > 1) c = 1; if (c < -1) c = -1;
-            return std::acos(c);
+            if (c > 1) c = 1;
+            if (c < -1) c = -1;
+            using std::acos;
+            return T(acos(c));
         }
 
         friend std::ostream& operator<<(std::ostream& os, const Vector3& v)
@@ -0,0 +1,78 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <ostream>
+#include "Vector3.hpp"
+#include "matrix4.hpp"
+
+namespace CPL
+{
+    template<typename T>
+    struct AABB
+    {
+        Vector3<T> min, max;
+
+        AABB() : min(std::numeric_limits<T>::max(), std::numeric_limits<T>::max(), std::numeric_limits<T>::max()),
+                 max(std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest()) {}
+        AABB(const Vector3<T>& min, const Vector3<T>& max) : min(min), max(max) {}
+
+        static AABB fromCenterExtents(const Vector3<T>& c, const Vector3<T>& e)
+        {
+            return { Vector3<T>(c.x - e.x, c.y - e.y, c.z - e.z), c + e };
+        }
+
+        bool empty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+
+        Vector3<T> center()  const { return (min + max) * T(0.5); }
+        Vector3<T> extents() const { return Vector3<T>(max.x - min.x, max.y - min.y, max.z - min.z) * T(0.5); }
+
+        void expand(const Vector3<T>& p)
+        {
+            min = { std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+            max = { std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+        }
+
+        void expand(const AABB& o) { expand(o.min); expand(o.max); }
+
+        bool overlaps(const AABB& o) const
+        {
+            return min.x <= o.max.x && max.x >= o.min.x
+                && min.y <= o.max.y && max.y >= o.min.y
+                && min.z <= o.max.z && max.z >= o.min.z;
+        }
+
+        bool contains(const AABB& o) const
+        {
+            return min.x <= o.min.x && max.x >= o.max.x
+                && min.y <= o.min.y && max.y >= o.max.y
+                && min.z <= o.min.z && max.z >= o.max.z;
+        }
+
+        bool contains(const Vector3<T>& p) const
+        {
+            return min.x <= p.x && max.x >= p.x && min.y <= p.y && max.y >= p.y && min.z <= p.z && max.z >= p.z;
+        }
+
+        // Bounds of the transformed box (Arvo): centre goes through m, the
+        // extents through |m|. Assumes an affine m.
+        AABB transformed(const Matrix4<T>& m) const
+        {
+            Vector3<T> c = center(), e = extents();
+            Vector3<T> nc(m(0, 0) * c.x + m(0, 1) * c.y + m(0, 2) * c.z + m(0, 3),
+                          m(1, 0) * c.x + m(1, 1) * c.y + m(1, 2) * c.z + m(1, 3),
+                          m(2, 0) * c.x + m(2, 1) * c.y + m(2, 2) * c.z + m(2, 3));
+            Vector3<T> ne(std::abs(m(0, 0)) * e.x + std::abs(m(0, 1)) * e.y + std::abs(m(0, 2)) * e.z,
+                          std::abs(m(1, 0)) * e.x + std::abs(m(1, 1)) * e.y + std::abs(m(1, 2)) * e.z,
+                          std::abs(m(2, 0)) * e.x + std::abs(m(2, 1)) * e.y + std::abs(m(2, 2)) * e.z);
+            return fromCenterExtents(nc, ne);
+        }
+
+        friend std::ostream& operator<<(std::ostream& os, const AABB& b)
+        {
+            return os << '[' << b.min << " - " << b.max << ']';
+        }
+    };
+
+    using AABBf = AABB<float>;
+}
@@ -0,0 +1,325 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Vector3.hpp"
+#include "job_pool.hpp"
+#include "matrix4.hpp"
+#include "quaternion.hpp"
+
+namespace CPL
+{
+    // Local transform of one joint: scale, then rotate, then translate.
+    struct JointPose
+    {
+        Vector3f    translation;
+        Quaternionf rotation;
+        Vector3f    scale = Vector3f::ones();
+    };
+
+    // Raw keyframes for one channel; times ascending.
+    template<typename V>
+    struct KeyTrack
+    {
+        std::vector<float> times;
+        std::vector<V>     values;
+    };
+
+    struct JointTracks
+    {
+        KeyTrack<Vector3f>    translation;
+        KeyTrack<Quaternionf> rotation;
+        KeyTrack<Vector3f>    scale;
+    };
+
+    // Unit quaternion in 48 bits, "smallest three": the largest component is
+    // dropped (made positive, since q and -q are the same rotation) and the
+    // other three, which lie in [-1/sqrt2, 1/sqrt2], get 15 bits each. The
+    // dropped index lives in the top bits of a and b.
+    struct PackedQuaternion
+    {
+        uint16_t a, b, c;
+
+        static PackedQuaternion pack(const Quaternionf& q)
+        {
+            const float v[4] = { q.x, q.y, q.z, q.w };
+            int largest = 0;
+            for (int i = 1; i < 4; ++i)
+                if (std::abs(v[i]) > std::abs(v[largest])) largest = i;
+            float sign = v[largest] < 0 ? -1.0f : 1.0f;
+            uint16_t out[3];
+            for (int i = 0, k = 0; i < 4; ++i)
+            {
+                if (i == largest) continue;
+                float unit = std::min(std::max(v[i] * sign * Sqrt2, -1.0f), 1.0f); // [-1, 1]
+                out[k++] = (uint16_t)(std::lround(unit * Steps) + Zero);
+            }
+            return { (uint16_t)(out[0] | (largest & 1) << 15), (uint16_t)(out[1] | (largest >> 1) << 15), out[2] };
+        }
+
+        Quaternionf unpack() const
+        {
+            int largest = (a >> 15) | (b >> 15) << 1;
+            const float scale = 1.0f / (Steps * Sqrt2);
+            float s[3] = { ((a & 0x7FFF) - Zero) * scale, ((b & 0x7FFF) - Zero) * scale, (c - Zero) * scale };
+            float w = std::sqrt(std::max(0.0f, 1 - s[0] * s[0] - s[1] * s[1] - s[2] * s[2]));
+            float v[4];
+            for (int i = 0, k = 0; i < 4; ++i) v[i] = i == largest ? w : s[k++];
+            return { v[0], v[1], v[2], v[3] };
+        }
+
+    private:
+        static constexpr float    Sqrt2 = 1.41421356f;
+        static constexpr int      Steps = 16383, Zero = 16384;  // zero encodes exactly
+    };
+
+    // How far keys may stray from the first and still count as constant.
+    struct AnimationTolerance
+    {
+        float translation = 1e-4f;
+        float rotation = 1e-5f;     // 1 - |dot|
+        float scale = 1e-5f;
+    };
+
+    // Last key index per track, so playing forward finds the next key in O(1).
+    // One per clip instance; a fresh or mismatched cursor is reset on use.
+    struct AnimationCursor
+    {
+        std::vector<uint32_t> keys;
+    };
+
+    // Compressed clip. Tracks whose keys all lie within tolerance of the first
+    // are stored as a single constant key; rotations are PackedQuaternion.
+    class AnimationClip
+    {
+    public:
+        AnimationClip() = default;
+
+        AnimationClip(const std::vector<JointTracks>& joints, float duration, AnimationTolerance tolerance = AnimationTolerance())
+            : length(duration), joints((uint32_t)joints.size())
+        {
+            tracks.reserve(joints.size() * 3);
+            for (const JointTracks& j : joints)
+            {
+                addVectorTrack(j.translation, tolerance.translation, Vector3f());
+                addRotationTrack(j.rotation, tolerance.rotation);
+                addVectorTrack(j.scale, tolerance.scale, Vector3f::ones());
+            }
+        }
+
+        size_t jointCount() const { return joints; }
+        float duration() const { return length; }
+
+        size_t keyCount() const { return vectorKeys.size() + rotationKeys.size(); }
+        size_t constantTrackCount() const
+        {
+            return (size_t)std::count_if(tracks.begin(), tracks.end(), [](const Track& t) { return t.count == 1; });
+        }
+        size_t byteSize() const
+        {
+            return tracks.size() * sizeof(Track) + times.size() * sizeof(float) +
+                   vectorKeys.size() * sizeof(Vector3f) + rotationKeys.size() * sizeof(PackedQuaternion);
+        }
+
+        // Poses for every joint at `time`, clamped to [0, duration].
+        void sample(float time, AnimationCursor& cursor, JointPose* out) const
+        {
+            if (cursor.keys.size() != tracks.size()) cursor.keys.assign(tracks.size(), 0);
+            time = std::min(std::max(time, 0.0f), length);
+            for (uint32_t j = 0; j < joints; ++j)
+            {
+                const Track* t = &tracks[j * 3];
+                uint32_t* k = &cursor.keys[j * 3];
+                float alpha;
+                uint32_t key = locate(t[0], time, k[0], alpha);
+                out[j].translation = lerp(vectorKeys[t[0].value + key], vectorKeys[t[0].value + key + (alpha > 0)], alpha);
+                key = locate(t[1], time, k[1], alpha);
+                Quaternionf q0 = rotationKeys[t[1].value + key].unpack();
+                out[j].rotation = alpha > 0 ? Quaternionf::nlerp(q0, rotationKeys[t[1].value + key + 1].unpack(), alpha) : q0;
+                key = locate(t[2], time, k[2], alpha);
+                out[j].scale = lerp(vectorKeys[t[2].value + key], vectorKeys[t[2].value + key + (alpha > 0)], alpha);
+            }
+        }
+
+    private:
+        // Keys of track i live at times[time .. time + count) and at
+        // vectorKeys or rotationKeys[value .. value + count).
+        struct Track
+        {
+            uint32_t time, value, count;
+        };
+
+        float                         length = 0;
+        uint32_t                      joints = 0;
+        std::vector<Track>            tracks;  // per joint: translation, rotation, scale
+        std::vector<float>            times;
+        std::vector<Vector3f>         vectorKeys;
+        std::vector<PackedQuaternion> rotationKeys;
+
+        static Vector3f lerp(const Vector3f& a, const Vector3f& b, float t)
+        {
+            return a + Vector3f(b.x - a.x, b.y - a.y, b.z - a.z) * t;
+        }
+
+        // Key at or before `time`, starting from the cached index: a few
+        // steps forward, otherwise a binary search (seeks, loops, rewinds).
+        uint32_t locate(const Track& t, float time, uint32_t& cached, float& alpha) const
+        {
+            alpha = 0;
+            if (t.count == 1) return 0;
+            const float* keys = times.data() + t.time;
+            uint32_t k = std::min(cached, t.count - 2);
+            if (keys[k] > time) k = 0;
+            for (int step = 0; step < 4 && k + 2 < t.count && keys[k + 1] <= time; ++step) ++k;
+            if (k + 2 < t.count && keys[k + 1] <= time)
+                k = (uint32_t)(std::upper_bound(keys + k, keys + t.count - 1, time) - keys) - 1;
+            cached = k;
+            float span = keys[k + 1] - keys[k];
+            alpha = span > 0 ? std::min(std::max((time - keys[k]) / span, 0.0f), 1.0f) : 0;
+            return k;
+        }
+
+        void addTimes(const std::vector<float>& src, size_t count)
+        {
+            times.insert(times.end(), src.begin(), src.begin() + count);
+        }
+
+        void addVectorTrack(const KeyTrack<Vector3f>& track, float tolerance, Vector3f fallback)
+        {
+            Track t{ (uint32_t)times.size(), (uint32_t)vectorKeys.size(), 1 };
+            if (track.values.empty())
+            {
+                vectorKeys.push_back(fallback);
+                times.push_back(0);
+            }
+            else
+            {
+                const Vector3f& first = track.values[0];
+                bool constant = std::all_of(track.values.begin(), track.values.end(), [&](const Vector3f& v) {
+                    return std::abs(v.x - first.x) <= tolerance && std::abs(v.y - first.y) <= tolerance && std::abs(v.z - first.z) <= tolerance;
+                });
+                t.count = constant ? 1 : (uint32_t)track.values.size();
+                vectorKeys.insert(vectorKeys.end(), track.values.begin(), track.values.begin() + t.count);
+                addTimes(track.times, t.count);
+            }
+            tracks.push_back(t);
+        }
+
+        void addRotationTrack(const KeyTrack<Quaternionf>& track, float tolerance)
+        {
+            Track t{ (uint32_t)times.size(), (uint32_t)rotationKeys.size(), 1 };
+            if (track.values.empty())
+            {
+                rotationKeys.push_back(PackedQuaternion::pack(Quaternionf::identity()));
+                times.push_back(0);
+            }
+            else
+            {
+                Quaternionf first = track.values[0].normalized();
+                bool constant = std::all_of(track.values.begin(), track.values.end(), [&](const Quaternionf& q) {
+                    return 1 - std::abs(first.dot(q.normalized())) <= tolerance;
+                });
+                t.count = constant ? 1 : (uint32_t)track.values.size();
+                for (uint32_t k = 0; k < t.count; ++k) rotationKeys.push_back(PackedQuaternion::pack(track.values[k].normalized()));
+                addTimes(track.times, t.count);
+            }
+            tracks.push_back(t);
+        }
+    };
+
+    // One clip's contribution to a blended pose.
+    struct AnimationLayer
+    {
+        const AnimationClip* clip;
+        AnimationCursor*     cursor;
+        float                time;
+        float                weight;
+    };
+
+    // Weighted blend of several clips over the same skeleton. Translation and
+    // scale are averaged; rotations are summed on the first layer's hemisphere
+    // and normalized. `scratch` holds one clip's poses between layers.
+    inline void sampleBlended(const AnimationLayer* layers, size_t count, JointPose* out, std::vector<JointPose>& scratch)
+    {
+        if (count == 0) return;
+        const size_t joints = layers[0].clip->jointCount();
+        float total = 0;
+        for (size_t l = 0; l < count; ++l) total += layers[l].weight;
+        float inv = total > 0 ? 1 / total : 0;
+
+        scratch.resize(joints);
+        for (size_t l = 0; l < count; ++l)
+        {
+            const AnimationLayer& layer = layers[l];
+            float w = layer.weight * inv;
+            JointPose* dst = l == 0 ? out : scratch.data();
+            layer.clip->sample(layer.time, *layer.cursor, dst);
+            if (l == 0)
+            {
+                for (size_t j = 0; j < joints; ++j)
+                {
+                    out[j].translation *= w;
+                    out[j].rotation = out[j].rotation * w;
+                    out[j].scale *= w;
+                }
+                continue;
+            }
+            for (size_t j = 0; j < joints; ++j)
+            {
+                const JointPose& p = scratch[j];
+                out[j].translation += p.translation * w;
+                out[j].rotation = out[j].rotation + p.rotation * (out[j].rotation.dot(p.rotation) < 0 ? -w : w);
+                out[j].scale += p.scale * w;
+            }
+        }
+        for (size_t j = 0; j < joints; ++j) out[j].rotation.normalize();
+    }
+
+    // Local matrices T * R * S for a run of poses.
+    inline void posesToMatrices(const JointPose* poses, size_t count, Matrix4f* out)
+    {
+        for (size_t j = 0; j < count; ++j)
+        {
+            const JointPose& p = poses[j];
+            const Quaternionf& q = p.rotation;
+            float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z, xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+            float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+            const Vector3f& s = p.scale;
+            out[j] = Matrix4f{ (1 - 2 * (yy + zz)) * s.x, 2 * (xy - wz) * s.y,       2 * (xz + wy) * s.z,       p.translation.x,
+                               2 * (xy + wz) * s.x,       (1 - 2 * (xx + zz)) * s.y, 2 * (yz - wx) * s.z,       p.translation.y,
+                               2 * (xz - wy) * s.x,       2 * (yz + wx) * s.y,       (1 - 2 * (xx + yy)) * s.z, p.translation.z,
+                               0,                         0,                         0,                         1 };
+        }
+    }
+
+    // One character's frame: its layers blended into `poses`, and converted
+    // to local matrices when `matrices` is set. A single layer is sampled
+    // directly, without blending.
+    struct AnimationJob
+    {
+        const AnimationLayer* layers;
+        size_t                layerCount;
+        JointPose*            poses;
+        Matrix4f*             matrices = nullptr;
+    };
+
+    // Samples many characters across the pool, a few characters per task.
+    // Jobs must not share cursors or outputs.
+    inline void sampleBlended(const AnimationJob* jobs, size_t count, JobPool& pool = JobPool::global())
+    {
+        pool.parallelFor(count, 16, [&](size_t b, size_t e) {
+            std::vector<JointPose> scratch;
+            for (size_t i = b; i < e; ++i)
+            {
+                const AnimationJob& job = jobs[i];
+                if (job.layerCount == 0) continue;
+                const AnimationLayer& first = job.layers[0];
+                if (job.layerCount == 1) first.clip->sample(first.time, *first.cursor, job.poses);
+                else sampleBlended(job.layers, job.layerCount, job.poses, scratch);
+                if (job.matrices) posesToMatrices(job.poses, first.clip->jointCount(), job.matrices);
+            }
+        });
+    }
+}
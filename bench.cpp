@@ -0,0 +1,1489 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "vector2.hpp"
+#include "Vector3.hpp"
+#include "matrix4.hpp"
+#include "profiler.hpp"
+#include "simd_dispatch.hpp"
+#include "job_pool.hpp"
+#include "spatial_hash.hpp"
+#include "kdtree.hpp"
+#include "aabb.hpp"
+#include "loose_octree.hpp"
+#include "sweep_prune.hpp"
+#include "ray.hpp"
+#include "ray_triangle.hpp"
+#include "gjk.hpp"
+#include "rigid_body.hpp"
+#include "particle_system.hpp"
+#include "skinning.hpp"
+#include "animation.hpp"
+#include "spline.hpp"
+#include "triangle_setup.hpp"
+#include "occlusion_culling.hpp"
+#include "lod_selection.hpp"
+#include "mesh_simplify.hpp"
+#include "vertex_cache.hpp"
+#include "mesh_normals.hpp"
+#include "half.hpp"
+#include "vertex_quantization.hpp"
+#include "fixed_point.hpp"
+#include "grid_coords.hpp"
+
+using namespace CPL;
+
+// ───────────────────────────────────────────
+// Harness: each benchmark runs `reps` times and reports the fastest run.
+
+template<typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T* sink;
+    sink = &value;
+#endif
+}
+
+template<typename F>
+double bestOf(int reps, F&& fn)
+{
+    double best = 1e300;
+    for (int r = 0; r < reps; ++r)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        fn();
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (s < best) best = s;
+    }
+    return best;
+}
+
+void report(const char* name, double seconds, double items, const char* unit)
+{
+    std::printf("  %-40s %10.3f ms  %9.2f ns/%s  %9.2f M%s/s\n",
+        name, seconds * 1e3, seconds * 1e9 / items, unit, items / seconds * 1e-6, unit);
+}
+
+std::vector<Vector3f> randomPoints(size_t n, float extent, unsigned seed = 1)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> d(-extent, extent);
+    std::vector<Vector3f> pts(n);
+    for (auto& p : pts) p = Vector3f(d(rng), d(rng), d(rng));
+    return pts;
+}
+
+#pragma region Core
+
+void bench_core()
+{
+    const size_t N = 1 << 20;
+    auto pts = randomPoints(N, 100.0f);
+    std::vector<Vector3f> out(N);
+    Matrix4f m = Matrix4f::translate(1, 2, 3) * Matrix4f::rotateY(0.3f) * Matrix4f::scale(2, 2, 2);
+
+    double s = bestOf(5, [&] {
+        for (size_t i = 0; i < N; ++i) out[i] = m * pts[i];
+        doNotOptimize(out.data());
+    });
+    report("Matrix4f * Vector3f (affine)", s, (double)N, "vec");
+
+    Matrix4f proj = Matrix4f::perspective(1.0f, 16 / 9.f, 0.1f, 100.f);
+    s = bestOf(5, [&] {
+        for (size_t i = 0; i < N; ++i) out[i] = proj * pts[i];
+        doNotOptimize(out.data());
+    });
+    report("Matrix4f * Vector3f (perspective)", s, (double)N, "vec");
+
+    s = bestOf(5, [&] {
+        for (size_t i = 0; i < N; ++i) out[i] = pts[i].normalized();
+        doNotOptimize(out.data());
+    });
+    report("Vector3f::normalized", s, (double)N, "vec");
+
+    float acc = 0;
+    s = bestOf(5, [&] {
+        for (size_t i = 0; i + 1 < N; ++i) acc += pts[i].dot(pts[i + 1]);
+        doNotOptimize(acc);
+    });
+    report("Vector3f::dot", s, (double)N, "vec");
+
+    const size_t M = 1 << 18;
+    Matrix4f r;
+    s = bestOf(5, [&] {
+        for (size_t i = 0; i < M; ++i) { r = r * m; doNotOptimize(r); }
+    });
+    report("Matrix4f * Matrix4f", s, (double)M, "mat");
+
+    s = bestOf(5, [&] {
+        for (size_t i = 0; i < N; ++i) { CPL_PROFILE_SCOPE("bench.scope"); }
+    });
+    Profiler::clear();
+    report("CPL_PROFILE_SCOPE overhead", s, (double)N, "scope");
+}
+
+#pragma endregion
+
+#pragma region SIMD dispatch
+
+void bench_simd()
+{
+    // Small enough to stay in L2, so the kernels are not just measuring DRAM.
+    const size_t N = 1 << 14;
+    auto a = randomPoints(N, 100.0f, 1);
+    auto b = randomPoints(N, 100.0f, 2);
+    std::vector<Vector3f> out(N);
+    std::vector<float> dots(N);
+    Matrix4f m = Matrix4f::perspective(1.0f, 16 / 9.f, 0.1f, 100.f) * Matrix4f::translate(0, 0, -200);
+    std::vector<Vector4f> clip(N), window(N);
+    const Viewport vp{ 0, 0, 1920, 1080 };
+    transformToClip(m, a.data(), clip.data(), N);
+
+    const SimdTier best = cpuFeatures().bestTier();
+    for (int t = 0; t <= (int)best; ++t)
+    {
+        SimdDispatch::forceTier((SimdTier)t);
+        std::printf(" %s\n", tierName((SimdTier)t));
+        report("transformPoints", bestOf(5, [&] { transformPoints(m, a.data(), out.data(), N); }), (double)N, "vec");
+        report("normalizeVectors", bestOf(5, [&] { normalizeVectors(a.data(), out.data(), N); }), (double)N, "vec");
+        report("dotProducts", bestOf(5, [&] { dotProducts(a.data(), b.data(), dots.data(), N); }), (double)N, "vec");
+        report("transformToClip", bestOf(5, [&] { transformToClip(m, a.data(), clip.data(), N); }), (double)N, "vec");
+        report("projectToViewport", bestOf(5, [&] { projectToViewport(vp, clip.data(), window.data(), N); }), (double)N, "vec");
+    }
+    SimdDispatch::resetTier();
+}
+
+#pragma endregion
+
+#pragma region Spatial hash
+
+void bench_spatial_hash()
+{
+    // 1M agents, ~0.5 neighbours per unit-radius query on average.
+    const size_t N = 1 << 20;
+    auto pts = randomPoints(N, 100.0f);
+    JobPool& pool = JobPool::global();
+    SpatialHashGridf grid(2.0f);
+    std::printf("  threads: %u\n", pool.threadCount());
+
+    double build = bestOf(5, [&] { grid.build(pts.data(), N, pool); });
+    report("build", build, (double)N, "pt");
+
+    // Every point queries its own neighbourhood, walked in bucket order.
+    std::vector<uint32_t> counts(N);
+    double query = bestOf(3, [&] {
+        const auto& sorted = grid.points();
+        pool.parallelFor(N, 4096, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i)
+            {
+                uint32_t c = 0;
+                grid.forEachInRadius(sorted[i], 1.0f, [&](uint32_t, float) { ++c; });
+                counts[i] = c;
+            }
+        });
+    });
+    report("radius query (r = 1)", query, (double)N, "query");
+    report("build + query per frame", build + query, (double)N, "pt");
+
+    // Target: build + query inside a 16 ms frame on 8 cores. Projected from
+    // this run assuming perfect scaling, so a miss here is a miss on 8 cores.
+    double projected = (build + query) * 1e3 * pool.threadCount() / 8.0;
+    std::printf("  8-core projection %.1f ms: 16 ms target %s\n", projected, projected <= 16.0 ? "met" : "missed");
+
+    std::vector<uint32_t> knn;
+    const size_t K = 1 << 14;
+    double k8 = bestOf(3, [&] { for (size_t i = 0; i < K; ++i) grid.kNearest(pts[i], 8, knn); });
+    report("kNearest (k = 8, single thread)", k8, (double)K, "query");
+}
+
+#pragma endregion
+
+#pragma region KdTree
+
+void bench_kdtree()
+{
+    const size_t N = 1 << 21, Q = 1 << 16;
+    auto pts = randomPoints(N, 100.0f, 1);
+    auto queries = randomPoints(Q, 100.0f, 2);
+    JobPool& pool = JobPool::global();
+
+    KdTreef tree;
+    report("build (2M points)", bestOf(3, [&] { tree.build(pts.data(), N, pool); }), (double)N, "pt");
+
+    std::vector<uint32_t> nn(Q), knn(Q * 8);
+    report("nearestBatch", bestOf(3, [&] { tree.nearestBatch(queries.data(), Q, nn.data(), nullptr, pool); }), (double)Q, "query");
+    report("kNearestBatch (k = 8)", bestOf(3, [&] { tree.kNearestBatch(queries.data(), Q, 8, knn.data(), pool); }), (double)Q, "query");
+
+    // Brute force on a slice of the queries; it is O(N) per query.
+    const size_t B = 64;
+    std::vector<uint32_t> brute(B);
+    double s = bestOf(1, [&] {
+        for (size_t q = 0; q < B; ++q)
+        {
+            float best = 1e30f;
+            for (size_t i = 0; i < N; ++i)
+            {
+                Vector3f d(pts[i].x - queries[q].x, pts[i].y - queries[q].y, pts[i].z - queries[q].z);
+                float d2 = d.lengthSquared();
+                if (d2 < best) { best = d2; brute[q] = (uint32_t)i; }
+            }
+        }
+    });
+    report("brute-force nearest", s, (double)B, "query");
+    for (size_t q = 0; q < B; ++q)
+        if (brute[q] != nn[q]) std::printf("  mismatch at query %zu\n", q);
+}
+
+#pragma endregion
+
+#pragma region Loose octree
+
+// Boxes of half-size 0.25..1 scattered through a 400^3 world.
+std::vector<AABBf> randomBoxes(size_t n, float extent, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> pos(-extent, extent), size(0.25f, 1.0f);
+    std::vector<AABBf> boxes(n);
+    for (auto& b : boxes)
+    {
+        float s = size(rng);
+        b = AABBf::fromCenterExtents(Vector3f(pos(rng), pos(rng), pos(rng)), Vector3f(s, s, s));
+    }
+    return boxes;
+}
+
+void bench_loose_octree()
+{
+    const size_t N = 100000;
+    auto boxes = randomBoxes(N, 200.0f, 5);
+    JobPool& pool = JobPool::global();
+
+    LooseOctreef tree(Vector3f(0, 0, 0), 256.0f, 6);
+    double s = bestOf(1, [&] { for (size_t i = 0; i < N; ++i) tree.insert(boxes[i], (uint32_t)i); });
+    report("insert 100k", s, (double)N, "obj");
+
+    // 10% of the objects move a little every frame, via Matrix4f like a game would.
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<float> step(-0.5f, 0.5f);
+    const int frames = 20;
+    size_t relocatedBefore = tree.relocations();
+    double update = 0, pairs = 0;
+    std::vector<LooseOctreef::Pair> out;
+    for (int f = 0; f < frames; ++f)
+    {
+        update += bestOf(1, [&] {
+            for (size_t i = f % 10; i < N; i += 10)
+            {
+                boxes[i] = boxes[i].transformed(Matrix4f::translate(step(rng), step(rng), step(rng)));
+                tree.move((uint32_t)i, boxes[i]);
+            }
+        });
+        pairs += bestOf(1, [&] { tree.findPairs(out, pool); });
+    }
+    report("update (10% moving) per frame", update / frames, (double)(N / 10), "move");
+    report("findPairs per frame", pairs / frames, (double)N, "obj");
+    std::printf("  %zu pairs, %zu nodes, %.2f%% of moves relocated\n", out.size(), tree.nodeCount(),
+        100.0 * double(tree.relocations() - relocatedBefore) / double(frames * N / 10));
+}
+
+#pragma endregion
+
+#pragma region Sweep and prune
+
+void bench_sweep_prune()
+{
+    // Boxes strung out along y so the automatic axis picks it.
+    const size_t N = 20000;
+    auto boxes = randomBoxes(N, 60.0f, 6);
+    for (auto& b : boxes)
+    {
+        Vector3f c = b.center();
+        b = AABBf::fromCenterExtents(Vector3f(c.x, c.y * 8.0f, c.z), b.extents());
+    }
+
+    SweepAndPrunef sap;
+    for (const auto& b : boxes) sap.add(b);
+    std::vector<SweepAndPrunef::Pair> added, removed;
+    double s = bestOf(1, [&] { sap.step(added, removed); });
+    report("first step (sort from scratch)", s, (double)N, "obj");
+
+    // Every box drifts a little each frame: nearly sorted input for insertion sort.
+    std::mt19937 rng(10);
+    std::uniform_real_distribution<float> step(-0.2f, 0.2f);
+    const int frames = 20;
+    double total = 0;
+    size_t swaps = 0, deltas = 0;
+    for (int f = 0; f < frames; ++f)
+    {
+        for (uint32_t i = 0; i < N; ++i)
+        {
+            boxes[i] = boxes[i].transformed(Matrix4f::translate(step(rng), step(rng), step(rng)));
+            sap.update(i, boxes[i]);
+        }
+        total += bestOf(1, [&] { sap.step(added, removed); });
+        swaps += sap.lastSwapCount();
+        deltas += added.size() + removed.size();
+    }
+    report("step (all moving) per frame", total / frames, (double)N, "obj");
+    std::printf("  axis %d, %zu pairs, %.0f swaps and %.0f pair deltas per frame\n", sap.axis(), sap.pairs().size(),
+        double(swaps) / frames, double(deltas) / frames);
+
+    s = bestOf(5, [&] { sap.step(added, removed); });
+    report("step (nothing moved)", s, (double)N, "obj");
+
+    size_t naivePairs = 0;
+    s = bestOf(1, [&] {
+        naivePairs = 0;
+        for (size_t a = 0; a < N; ++a)
+            for (size_t b = a + 1; b < N; ++b)
+                naivePairs += boxes[a].overlaps(boxes[b]);
+    });
+    report("naive O(n^2) pairs", s, (double)N, "obj");
+    if (naivePairs != sap.pairs().size()) std::printf("  MISMATCH: naive found %zu pairs\n", naivePairs);
+}
+
+#pragma endregion
+
+#pragma region Ray triangle
+
+void bench_ray_triangle()
+{
+    // 1024 small triangles, every ray brute-forced against all of them.
+    const size_t T = 1024, R = 8192;
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> d(-10.0f, 10.0f), small(-1.0f, 1.0f);
+    std::vector<Vector3f> soup;
+    for (size_t i = 0; i < T; ++i)
+    {
+        Vector3f base(d(rng), d(rng), d(rng));
+        for (int k = 0; k < 3; ++k) soup.push_back(base + Vector3f(small(rng), small(rng), small(rng)));
+    }
+    std::vector<Rayf> rays(R);
+    for (auto& r : rays) r = Rayf(Vector3f(d(rng), d(rng), -30.0f), Vector3f(small(rng) * 0.3f, small(rng) * 0.3f, 1.0f));
+
+    TriangleBatch batch(soup.data(), nullptr, T);
+    std::vector<RayHit> hits(R);
+    JobPool& pool = JobPool::global();
+    const double tests = double(R) * double(T);
+
+    // Baseline: AoS Vector3 cross/dot per triangle.
+    size_t found = 0;
+    double s = bestOf(2, [&] {
+        found = 0;
+        for (const Rayf& r : rays)
+        {
+            float best = r.tMax, t, u, v;
+            for (size_t i = 0; i < T; ++i)
+                if (intersectTriangle(r, soup[3 * i], soup[3 * i + 1], soup[3 * i + 2], t, u, v) && t < best) best = t;
+            found += best < r.tMax;
+        }
+    });
+    report("Vector3 AoS loop", s, (double)R, "ray");
+    std::printf("  %.2f G ray-tri tests/s, %zu of %zu rays hit\n", tests / s * 1e-9, found, R);
+
+    const SimdTier tiers[] = { SimdTier::Scalar, SimdTier::AVX2 };
+    for (SimdTier tier : tiers)
+    {
+        if (SimdDispatch::forceTier(tier) != tier) continue;
+        char name[64];
+        for (TriangleTest test : { TriangleTest::Fast, TriangleTest::Watertight })
+        {
+            const char* testName = test == TriangleTest::Fast ? "fast" : "watertight";
+            s = bestOf(2, [&] { batch.intersect(rays.data(), R, hits.data(), test, pool); });
+            std::snprintf(name, sizeof(name), "closest %s (%s)", testName, tierName(tier));
+            report(name, s, (double)R, "ray");
+
+            size_t blocked = 0;
+            s = bestOf(2, [&] { blocked = 0; for (const Rayf& r : rays) blocked += batch.occluded(r, test); });
+            std::snprintf(name, sizeof(name), "occluded %s (%s)", testName, tierName(tier));
+            report(name, s, (double)R, "ray");
+        }
+    }
+    SimdDispatch::resetTier();
+}
+
+#pragma endregion
+
+#pragma region GJK
+
+void bench_gjk()
+{
+    // Pairs of random hulls (points on a unit sphere) 1.6..2.4 apart, so
+    // roughly a third overlap. Each pair then drifts for a few frames.
+    const int pairs = 2000, frames = 8;
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f), angle(-3.14159f, 3.14159f), gap(1.6f, 2.4f);
+
+    for (size_t verts : { 8u, 16u, 32u, 64u, 128u, 256u })
+    {
+        std::vector<Vector3f> pts(verts);
+        for (auto& p : pts) p = Vector3f(unit(rng), unit(rng), unit(rng)).normalized();
+        ConvexHullf hull(pts.data(), verts);
+
+        std::vector<Matrix4f> ma(pairs), mb(pairs);
+        for (int i = 0; i < pairs; ++i)
+        {
+            Vector3f dir = Vector3f(unit(rng), unit(rng), unit(rng)).normalized() * gap(rng);
+            ma[i] = Matrix4f::rotateX(angle(rng)) * Matrix4f::rotateY(angle(rng));
+            mb[i] = Matrix4f::translate(dir.x, dir.y, dir.z) * Matrix4f::rotateZ(angle(rng));
+        }
+        auto frameMatrix = [&](int i, int f) { return Matrix4f::translate(0.002f * f, -0.001f * f, 0) * mb[i]; };
+
+        long coldIters = 0, warmIters = 0;
+        int hits = 0;
+        double cold = bestOf(1, [&] {
+            for (int f = 0; f < frames; ++f)
+                for (int i = 0; i < pairs; ++i)
+                {
+                    GjkResult<float> r = gjkDistance(hull, ma[i], hull, frameMatrix(i, f));
+                    coldIters += r.iterations;
+                    hits += r.overlap;
+                }
+        });
+        std::vector<GjkCache> caches(pairs);
+        double warm = bestOf(1, [&] {
+            for (int f = 0; f < frames; ++f)
+                for (int i = 0; i < pairs; ++i) warmIters += gjkDistance(hull, ma[i], hull, frameMatrix(i, f), &caches[i]).iterations;
+        });
+        Contact<float> c;
+        double epa = bestOf(1, [&] {
+            for (int i = 0; i < pairs; ++i) doNotOptimize(collide(hull, ma[i], hull, mb[i], c));
+        });
+
+        char name[64];
+        const double queries = double(pairs) * frames;
+        std::snprintf(name, sizeof(name), "%zu verts: GJK cold", verts);
+        report(name, cold, queries, "query");
+        std::snprintf(name, sizeof(name), "%zu verts: GJK warm-started", verts);
+        report(name, warm, queries, "query");
+        std::snprintf(name, sizeof(name), "%zu verts: collide (GJK+EPA)", verts);
+        report(name, epa, (double)pairs, "query");
+        std::printf("  %.2f support calls cold, %.2f warm, %.0f%% overlapping\n", double(coldIters) / queries,
+            double(warmIters) / queries, 100.0 * hits / queries);
+    }
+}
+
+#pragma endregion
+
+#pragma region Rigid body
+
+void bench_rigid_body()
+{
+    const size_t n = 100000;
+    const int steps = 10;
+    const float dt = 1.0f / 60;
+    const Vector3f gravity(0, -9.8f, 0);
+    std::mt19937 rng(14);
+    std::uniform_real_distribution<float> d(-1.0f, 1.0f);
+
+    RigidBodySystem sys;
+    sys.setGravity(gravity);
+    for (size_t i = 0; i < n; ++i)
+    {
+        RigidBodyDesc b;
+        b.position = Vector3f(d(rng), d(rng), d(rng)) * 100.0f;
+        b.velocity = Vector3f(d(rng), d(rng), d(rng));
+        b.angularVelocity = Vector3f(d(rng), d(rng), d(rng));
+        b.orientation = Quaternionf(d(rng), d(rng), d(rng), d(rng));
+        b.inertia = Matrix3f::solidBoxInertia(1.0f, Vector3f(1.0f + d(rng) * 0.5f, 1, 0.5f));
+        sys.add(b);
+    }
+
+    // Baseline: array of structs stepped with the Vector3 / Quaternion / Matrix3 operators.
+    struct Body
+    {
+        Vector3f    position, velocity, angularVelocity, force, torque;
+        Quaternionf orientation;
+        Matrix3f    invInertia;
+        float       invMass;
+    };
+    std::vector<Body> bodies(n);
+    for (size_t i = 0; i < n; ++i)
+        bodies[i] = { sys.position((uint32_t)i), sys.velocity((uint32_t)i), sys.angularVelocity((uint32_t)i), Vector3f(), Vector3f(),
+                      sys.orientation((uint32_t)i), Matrix3f::identity(), 1.0f };
+    double aos = bestOf(3, [&] {
+        for (int s = 0; s < steps; ++s)
+            for (Body& b : bodies)
+            {
+                b.velocity = b.velocity + (b.force * b.invMass + gravity) * dt;
+                b.position = b.position + b.velocity * dt;
+                Matrix3f r = b.orientation.toMatrix3();
+                b.angularVelocity = b.angularVelocity + (r * (b.invInertia * (r.transpose() * b.torque))) * dt;
+                Quaternionf w(b.angularVelocity.x, b.angularVelocity.y, b.angularVelocity.z, 0);
+                b.orientation = (b.orientation + (w * b.orientation) * (0.5f * dt)).normalized();
+                b.force = b.torque = Vector3f();
+            }
+        doNotOptimize(bodies.data());
+    });
+    report("AoS operators", aos, double(n) * steps, "body");
+
+    JobPool single(1);
+    JobPool& pool = JobPool::global();
+    for (SimdTier tier : { SimdTier::Scalar, SimdTier::AVX2 })
+    {
+        if (SimdDispatch::forceTier(tier) != tier) continue;
+        char name[64];
+        std::snprintf(name, sizeof(name), "SoA %s, 1 thread", tierName(tier));
+        double t = bestOf(3, [&] { for (int s = 0; s < steps; ++s) sys.step(dt, single); });
+        report(name, t, double(n) * steps, "body");
+        std::snprintf(name, sizeof(name), "SoA %s, %u-thread pool", tierName(tier), pool.threadCount());
+        double tp = bestOf(3, [&] { for (int s = 0; s < steps; ++s) sys.step(dt, pool); });
+        report(name, tp, double(n) * steps, "body");
+        std::printf("  %.0f bodies/ms (%.1fx AoS)\n", double(n) * steps / (tp * 1e3), aos / tp);
+    }
+    SimdDispatch::resetTier();
+}
+
+#pragma endregion
+
+#pragma region Particle system
+
+void bench_particles()
+{
+    const size_t n = 5000000;
+    const float dt = 1.0f / 60;
+    ParticleEmitter em;
+    em.radius = 50;
+    em.velocityJitter = 5;
+    em.lifetime = 1e6f; // nothing dies during the timed updates
+    ParticleForces forces;
+    forces.gravity = Vector3f(0, -9.8f, 0);
+    forces.drag = 0.2f;
+
+    // Baseline: array of structs driven through Vector3 operator+= / operator*=.
+    struct Particle { Vector3f position, velocity; float age, life; };
+    std::vector<Particle> aos(n);
+    for (auto& p : aos) p = { Vector3f(1, 2, 3), Vector3f(0, 1, 0), 0, 1e6f };
+    const float dragScale = 1 / (1 + forces.drag * dt);
+    double baseline = bestOf(3, [&] {
+        for (Particle& p : aos)
+        {
+            p.velocity += forces.gravity * dt;
+            p.velocity *= dragScale;
+            p.position += p.velocity * dt;
+            p.age += dt;
+        }
+        doNotOptimize(aos.data());
+    });
+    report("AoS Vector3 operators, gravity+drag", baseline, (double)n, "particle");
+
+    JobPool single(1);
+    JobPool& pool = JobPool::global();
+    ParticleSystem ps(n);
+    double emit = bestOf(3, [&] { ps.clear(); ps.emit(em, n, pool); });
+    report("emit", emit, (double)n, "particle");
+
+    for (SimdTier tier : { SimdTier::Scalar, SimdTier::AVX2 })
+    {
+        if (SimdDispatch::forceTier(tier) != tier) continue;
+        for (float curl : { 0.0f, 1.0f })
+        {
+            forces.curlStrength = curl;
+            ps.setForces(forces);
+            for (JobPool* jp : { &single, &pool })
+            {
+                double ms = 1e300;
+                for (int r = 0; r < 3; ++r)
+                {
+                    ps.update(dt, *jp);
+                    ms = std::min(ms, ps.counters().updateMs);
+                }
+                char name[64];
+                std::snprintf(name, sizeof(name), "update %s%s, %u thread%s", tierName(tier), curl ? " +curl" : "",
+                    jp->threadCount(), jp->threadCount() > 1 ? "s" : "");
+                report(name, ms * 1e-3, (double)ps.size(), "particle");
+            }
+        }
+    }
+    SimdDispatch::resetTier();
+
+    // Steady state: emission balances deaths, so compaction runs every frame.
+    ParticleSystem churn(n);
+    em.lifetime = 1;
+    em.lifetimeJitter = 0.5f;
+    churn.setForces(forces);
+    double churnMs = 0;
+    for (int f = 0; f < 120; ++f)
+    {
+        churn.emit(em, n / 60, pool);
+        churn.update(dt, pool);
+        if (f >= 60) churnMs += churn.counters().updateMs;
+    }
+    std::printf("  steady state: %zu live, %zu died last frame, %.3f ms/update\n", churn.counters().live,
+        churn.counters().died, churnMs / 60);
+}
+
+#pragma endregion
+
+#pragma region Skinning
+
+void bench_skinning()
+{
+    // 64 characters of 10k vertices on a 100-joint skeleton.
+    const size_t characters = 64, verts = 10000, joints = 100;
+    std::mt19937 rng(37);
+    std::uniform_real_distribution<float> d(-1.0f, 1.0f), w(0.0f, 1.0f);
+    std::vector<Matrix4f> pose(joints);
+    for (auto& m : pose) m = Matrix4f::translate(d(rng), d(rng), d(rng)) * Matrix4f::rotateY(d(rng)) * Matrix4f::rotateX(d(rng));
+    SkinPalette palette(pose.data(), joints);
+
+    std::vector<Vector3f> positions(verts), normals(verts);
+    for (size_t v = 0; v < verts; ++v)
+    {
+        positions[v] = Vector3f(d(rng), d(rng), d(rng));
+        normals[v] = Vector3f(d(rng), d(rng), d(rng)).normalized();
+    }
+
+    JobPool& pool = JobPool::global();
+    for (int influences : { 4, 8 })
+    {
+        // Influences cluster on nearby joints, as they do on a real rig.
+        std::vector<uint16_t> ids(verts * influences);
+        std::vector<float> weights(verts * influences);
+        for (size_t v = 0; v < verts; ++v)
+        {
+            size_t base = rng() % (joints - 8);
+            for (int k = 0; k < influences; ++k)
+            {
+                ids[v * influences + k] = (uint16_t)(base + rng() % 8);
+                weights[v * influences + k] = w(rng);
+            }
+        }
+        std::vector<SkinMesh> meshes(characters, SkinMesh(positions.data(), normals.data(), verts, ids.data(), weights.data(), influences));
+        std::vector<Vector3f> outP(characters * verts), outN(characters * verts);
+        std::vector<SkinJob> jobs;
+        for (size_t c = 0; c < characters; ++c) jobs.push_back({ &meshes[c], &palette, &outP[c * verts], &outN[c * verts] });
+
+        // Baseline: blend Matrix4 palettes per vertex and transform with Matrix4 * Vector3.
+        double baseline = bestOf(3, [&] {
+            for (size_t c = 0; c < characters; ++c)
+                for (size_t v = 0; v < verts; ++v)
+                {
+                    Matrix4f m = Matrix4f::zeros();
+                    for (int k = 0; k < influences; ++k)
+                    {
+                        const Matrix4f& j = pose[ids[v * influences + k]];
+                        float wk = weights[v * influences + k];
+                        for (int r = 0; r < 4; ++r)
+                            for (int col = 0; col < 4; ++col) m(r, col) += j(r, col) * wk;
+                    }
+                    outP[c * verts + v] = m * positions[v];
+                }
+            doNotOptimize(outP.data());
+        });
+        char name[64];
+        const double total = double(characters) * verts;
+        std::snprintf(name, sizeof(name), "%d weights: Matrix4 blend, positions", influences);
+        report(name, baseline, total, "vertex");
+
+        for (SkinningMethod method : { SkinningMethod::Linear, SkinningMethod::DualQuaternion })
+        {
+            const char* label = method == SkinningMethod::Linear ? "LBS" : "DQS";
+            for (SimdTier tier : { SimdTier::Scalar, SimdTier::AVX2 })
+            {
+                if (SimdDispatch::forceTier(tier) != tier) continue;
+                double t = bestOf(3, [&] { for (const SkinJob& j : jobs) skin(j, method); });
+                std::snprintf(name, sizeof(name), "%d weights: %s %s, 1 thread", influences, label, tierName(tier));
+                report(name, t, total, "vertex");
+            }
+            SimdDispatch::resetTier();
+            double t = bestOf(3, [&] { skin(jobs.data(), jobs.size(), method, pool); });
+            std::snprintf(name, sizeof(name), "%d weights: %s, %u-thread pool", influences, label, pool.threadCount());
+            report(name, t, total, "vertex");
+            std::printf("  %.0f vertices/ms with normals\n", total / (t * 1e3));
+        }
+    }
+}
+
+#pragma endregion
+
+#pragma region Animation
+
+void bench_animation()
+{
+    // 1000 characters x 100 joints, two 2 s clips at 30 keys/s. Scale is
+    // constant, as on most rigs, and a third of the translations too.
+    const size_t characters = 1000, joints = 100;
+    const int keys = 61;
+    std::mt19937 rng(38);
+    std::uniform_real_distribution<float> d(-1.0f, 1.0f);
+    auto makeClip = [&] {
+        std::vector<JointTracks> tracks(joints);
+        for (size_t j = 0; j < joints; ++j)
+        {
+            Vector3f axis = Vector3f(d(rng), d(rng), d(rng)).normalized();
+            Vector3f offset(d(rng), d(rng), d(rng));
+            float speed = d(rng) * 3;
+            for (int k = 0; k < keys; ++k)
+            {
+                float t = k / 30.0f;
+                tracks[j].rotation.times.push_back(t);
+                tracks[j].rotation.values.push_back(Quaternionf::fromAxisAngle(axis, speed * t));
+                tracks[j].translation.times.push_back(t);
+                tracks[j].translation.values.push_back(j % 3 ? offset : offset + Vector3f(0, std::sin(t * 4), 0));
+                tracks[j].scale.times.push_back(t);
+                tracks[j].scale.values.push_back(Vector3f::ones());
+            }
+        }
+        return AnimationClip(tracks, 2.0f);
+    };
+    AnimationClip walk = makeClip(), run = makeClip();
+    const size_t raw = joints * keys * (3 * sizeof(Vector3f) + sizeof(Quaternionf) + 3 * sizeof(float));
+    std::printf("  clip: %zu bytes compressed vs %zu raw, %zu of %zu tracks constant\n", walk.byteSize(), raw,
+        walk.constantTrackCount(), joints * 3);
+
+    std::vector<AnimationCursor> cursors(characters * 2);
+    std::vector<JointPose> poses(characters * joints);
+    std::vector<Matrix4f> matrices(characters * joints);
+    std::vector<float> phase(characters);
+    for (auto& p : phase) p = (d(rng) + 1) * 0.5f;
+    JobPool& pool = JobPool::global();
+    const double total = double(characters) * joints;
+    int frame = 0;
+    auto timeOf = [&](size_t c) { return std::fmod(phase[c] + frame / 60.0f, 2.0f); };
+
+    // Playing forward, so the cached cursors only step ahead.
+    double fresh = bestOf(5, [&] {
+        ++frame;
+        for (size_t c = 0; c < characters; ++c)
+        {
+            AnimationCursor cold;
+            walk.sample(timeOf(c), cold, &poses[c * joints]);
+        }
+    });
+    report("sample, new cursor each frame", fresh, total, "joint");
+    double cached = bestOf(5, [&] {
+        ++frame;
+        for (size_t c = 0; c < characters; ++c) walk.sample(timeOf(c), cursors[c], &poses[c * joints]);
+    });
+    report("sample, cached cursor", cached, total, "joint");
+    double toMatrix = bestOf(5, [&] { posesToMatrices(poses.data(), poses.size(), matrices.data()); });
+    report("pose to Matrix4", toMatrix, total, "joint");
+
+    std::vector<std::vector<JointPose>> scratch(characters);
+    auto blendFrame = [&](size_t b, size_t e) {
+        for (size_t c = b; c < e; ++c)
+        {
+            AnimationLayer layers[2] = { { &walk, &cursors[2 * c], timeOf(c), 0.7f }, { &run, &cursors[2 * c + 1], timeOf(c), 0.3f } };
+            sampleBlended(layers, 2, &poses[c * joints], scratch[c]);
+            posesToMatrices(&poses[c * joints], joints, &matrices[c * joints]);
+        }
+    };
+    double blended = bestOf(5, [&] { ++frame; blendFrame(0, characters); });
+    report("2-clip blend + matrices, 1 thread", blended, total, "joint");
+
+    // The bulk entry point, one job per character.
+    std::vector<AnimationLayer> layers(characters * 2);
+    std::vector<AnimationJob> jobs(characters);
+    auto prepare = [&](size_t layerCount) {
+        ++frame;
+        for (size_t c = 0; c < characters; ++c)
+        {
+            layers[2 * c] = { &walk, &cursors[2 * c], timeOf(c), 0.7f };
+            layers[2 * c + 1] = { &run, &cursors[2 * c + 1], timeOf(c), 0.3f };
+            jobs[c] = { &layers[2 * c], layerCount, &poses[c * joints], &matrices[c * joints] };
+        }
+    };
+    char name[64];
+    double sampled = bestOf(5, [&] { prepare(1); sampleBlended(jobs.data(), characters, pool); });
+    std::snprintf(name, sizeof(name), "sample + matrices, %u-thread pool", pool.threadCount());
+    report(name, sampled, total, "joint");
+    double parallel = bestOf(5, [&] { prepare(2); sampleBlended(jobs.data(), characters, pool); });
+    std::snprintf(name, sizeof(name), "2-clip blend + matrices, %u-thread pool", pool.threadCount());
+    report(name, parallel, total, "joint");
+
+    // Target: 1000 characters x 100 joints sampled in under 2 ms.
+    std::printf("  sampling on %u thread%s: %.2f ms, 2 ms target %s\n", pool.threadCount(), pool.threadCount() == 1 ? "" : "s",
+        sampled * 1e3, sampled * 1e3 <= 2.0 ? "met" : "missed");
+}
+
+#pragma endregion
+
+#pragma region Spline
+
+void bench_spline()
+{
+    const size_t n = 1000000;
+    std::vector<Vector3f> controls = randomPoints(64 * 3 + 1, 100.0f, 39);
+    Spline3f bez = Spline3f::bezier(controls.data(), controls.size());
+    Spline3f cr = Spline3f::catmullRom(controls.data(), controls.size());
+    const size_t segments = bez.segmentCount();
+
+    std::mt19937 rng(39);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<float> params(n);
+    for (auto& t : params) t = unit(rng);
+    std::vector<Vector3f> out(n);
+
+    // Baseline: de Casteljau from Vector3 lerps on the control points.
+    auto lerp = [](const Vector3f& a, const Vector3f& b, float t) { return a * (1 - t) + b * t; };
+    double baseline = bestOf(3, [&] {
+        for (size_t i = 0; i < n; ++i)
+        {
+            float x = params[i] * segments;
+            size_t s = std::min((size_t)x, segments - 1);
+            float u = x - s;
+            const Vector3f* p = &controls[s * 3];
+            Vector3f a = lerp(p[0], p[1], u), b = lerp(p[1], p[2], u), c = lerp(p[2], p[3], u);
+            out[i] = lerp(lerp(a, b, u), lerp(b, c, u), u);
+        }
+        doNotOptimize(out.data());
+    });
+    report("Bezier, Vector3 lerps", baseline, (double)n, "point");
+
+    for (SimdTier tier : { SimdTier::Scalar, SimdTier::AVX2 })
+    {
+        if (SimdDispatch::forceTier(tier) != tier) continue;
+        char name[64];
+        std::snprintf(name, sizeof(name), "Bezier bulk, %s", tierName(tier));
+        report(name, bestOf(3, [&] { bez.evaluate(params.data(), n, out.data()); doNotOptimize(out.data()); }), (double)n, "point");
+        std::snprintf(name, sizeof(name), "Catmull-Rom bulk, %s", tierName(tier));
+        report(name, bestOf(3, [&] { cr.evaluate(params.data(), n, out.data()); doNotOptimize(out.data()); }), (double)n, "point");
+    }
+    SimdDispatch::resetTier();
+
+    double build = bestOf(3, [&] { cr.buildArcLength(); });
+    report("arc-length table (16/segment)", build, double(cr.segmentCount() * 16), "entry");
+    report("sample evenly by arc length", bestOf(3, [&] { cr.sampleEvenly(n, out.data()); doNotOptimize(out.data()); }), (double)n, "point");
+    report("evaluate at distance (search)", bestOf(3, [&] {
+        for (size_t i = 0; i < n; ++i) out[i] = cr.evaluateAtDistance(params[i] * cr.length());
+        doNotOptimize(out.data());
+    }), (double)n, "point");
+}
+
+#pragma endregion
+
+#pragma region Triangle setup
+
+void bench_triangle_setup()
+{
+    // Wavy terrain grid seen from above its near edge: half the triangles
+    // off screen or clipped, the distant ones sub-pixel.
+    const int grid = 512;
+    std::vector<Vector3f> verts;
+    verts.reserve((grid + 1) * (grid + 1));
+    for (int z = 0; z <= grid; ++z)
+        for (int x = 0; x <= grid; ++x)
+            verts.push_back(Vector3f(x - grid / 2.0f, std::sin(x * 0.2f) * std::cos(z * 0.15f), -(float)z));
+    std::vector<uint32_t> indices;
+    indices.reserve(grid * grid * 6);
+    for (int z = 0; z < grid; ++z)
+        for (int x = 0; x < grid; ++x)
+        {
+            uint32_t i = z * (grid + 1) + x;
+            indices.insert(indices.end(), { i, i + 1, i + grid + 1, i + 1, i + grid + 2, i + grid + 1 });
+        }
+    const size_t tris = indices.size() / 3;
+    Matrix4f mvp = Matrix4f::perspective(1.0f, 16.0f / 9.0f, 0.1f, 1000.0f) * Matrix4f::rotateX(0.3f) * Matrix4f::translate(0, -4, 2);
+
+    // Baseline: Matrix4 * Vector3 per corner, no clipping, culling or binning.
+    std::vector<Vector3f> screen(indices.size());
+    double baseline = bestOf(3, [&] {
+        for (size_t i = 0; i < indices.size(); ++i) screen[i] = mvp * verts[indices[i]];
+        doNotOptimize(screen.data());
+    });
+    report("per-corner Matrix4 * Vector3", baseline, (double)tris, "triangle");
+
+    TriangleSetup setup(1920, 1080, 64);
+    for (SimdTier tier : { SimdTier::Scalar, SimdTier::AVX2 })
+    {
+        if (SimdDispatch::forceTier(tier) != tier) continue;
+        char name[64];
+        std::snprintf(name, sizeof(name), "setup + bin, %s", tierName(tier));
+        report(name, bestOf(3, [&] { setup.process(mvp, verts.data(), verts.size(), indices.data(), tris); }), (double)tris, "triangle");
+    }
+    SimdDispatch::resetTier();
+
+    const TriangleSetupStats& st = setup.stats();
+    std::printf("  in %zu: frustum %zu, back %zu, small %zu, clipped %zu, out %zu, bin entries %zu\n",
+                st.trianglesIn, st.culledFrustum, st.culledBackFace, st.culledSmall, st.clipped, st.trianglesOut, st.binEntries);
+}
+
+#pragma endregion
+
+#pragma region Occlusion culling
+
+void bench_occlusion_culling()
+{
+    // Unit cube, wound counter-clockwise from outside.
+    std::vector<Vector3f> cube;
+    for (int c = 0; c < 8; ++c) cube.push_back(Vector3f((c & 1) ? 1.f : -1.f, (c & 2) ? 1.f : -1.f, (c & 4) ? 1.f : -1.f));
+    const int faces[6][4] = { { 0, 2, 6, 4 }, { 1, 3, 7, 5 }, { 0, 1, 5, 4 }, { 2, 3, 7, 6 }, { 0, 1, 3, 2 }, { 4, 5, 7, 6 } };
+    std::vector<uint32_t> cubeIndices;
+    for (const auto& f : faces)
+        for (int t = 0; t < 2; ++t)
+        {
+            uint32_t a = f[0], b = f[1 + t], c = f[2 + t];
+            Vector3f e1 = cube[b] + cube[a] * -1.f, e2 = cube[c] + cube[a] * -1.f;
+            if (e1.cross(e2).dot(cube[a] + cube[b] + cube[c]) < 0) std::swap(b, c);
+            cubeIndices.insert(cubeIndices.end(), { a, b, c });
+        }
+
+    // Dense city: 40x40 blocks of towers 20 m apart, 12 m streets; the camera
+    // stands in a street at head height looking down it. Props are scattered
+    // everywhere, most of them hidden by the towers.
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> u(0.0f, 1.0f);
+    std::vector<OccluderMesh> towers;
+    for (int bz = 0; bz < 40; ++bz)
+        for (int bx = -20; bx < 20; ++bx)
+        {
+            float h = 10 + u(rng) * 40;
+            towers.push_back({ cube.data(), 8, cubeIndices.data(), 12,
+                               Matrix4f::translate(bx * 20.0f + 10, h, -bz * 20.0f - 10) * Matrix4f::scale(4, h, 4) });
+        }
+    std::vector<AABBf> props(200000);
+    for (auto& b : props)
+        b = AABBf::fromCenterExtents(Vector3f((u(rng) - 0.5f) * 800, u(rng) * 20, -u(rng) * 800), Vector3f(0.5f, 0.5f, 0.5f));
+    Matrix4f viewProj = Matrix4f::perspective(1.0f, 2.0f, 0.5f, 1000.0f) * Matrix4f::translate(0, -1.7f, -5);
+
+    OcclusionCuller culler(256, 128);
+    std::vector<uint8_t> visible(props.size());
+    JobPool& pool = JobPool::global();
+    std::printf("  threads: %u, %zu occluder triangles, %zu boxes\n", pool.threadCount(), towers.size() * 12, props.size());
+    for (SimdTier tier : { SimdTier::Scalar, SimdTier::AVX2 })
+    {
+        if (SimdDispatch::forceTier(tier) != tier) continue;
+        char name[64];
+        std::snprintf(name, sizeof(name), "render occluders + pyramid, %s", tierName(tier));
+        report(name, bestOf(5, [&] { culler.renderOccluders(viewProj, towers.data(), towers.size(), pool); }), double(towers.size() * 12), "triangle");
+        std::snprintf(name, sizeof(name), "test boxes, %s", tierName(tier));
+        report(name, bestOf(5, [&] { culler.testBoxes(props.data(), props.size(), visible.data(), pool); }), (double)props.size(), "box");
+    }
+    SimdDispatch::resetTier();
+
+    const OcclusionStats& st = culler.frameStats();
+    size_t submitted = props.size() - st.culledFrustum - st.culledOccluded;
+    std::printf("  frame: raster %.3f ms, pyramid %.3f ms, test %.3f ms\n", st.rasterMs, st.pyramidMs, st.testMs);
+    std::printf("  frustum only: %zu submitted; with occlusion: %zu (%.1fx fewer), cull rate %.1f%%\n",
+                props.size() - st.culledFrustum, submitted, double(props.size() - st.culledFrustum) / double(std::max<size_t>(submitted, 1)),
+                st.cullRate() * 100);
+}
+
+#pragma endregion
+
+#pragma region LOD selection
+
+void bench_lod_selection()
+{
+    const size_t n = 200000;
+    const float thresholds[4] = { 0.4f, 0.15f, 0.05f, 0.01f };
+    std::mt19937 rng(43);
+    std::uniform_real_distribution<float> pos(-1000, 1000), rad(0.5f, 8.0f);
+    std::vector<Vector3f> centers(n);
+    std::vector<float> radii(n);
+    LodSelector lods(thresholds, 4);
+    lods.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        centers[i] = Vector3f(pos(rng), pos(rng) * 0.05f, pos(rng));
+        radii[i] = rad(rng);
+        lods.add(centers[i], radii[i]);
+    }
+    const Matrix4f proj = Matrix4f::perspective(1.0f, 16 / 9.f, 0.1f, 3000.f);
+    const Vector3f eye(0, 2, 0);
+
+    // Baseline: AoS, per-instance sqrt, divide and threshold walk, then push
+    // into one std::vector per LOD.
+    std::vector<std::vector<uint32_t>> buckets(5);
+    double baseline = bestOf(5, [&] {
+        for (auto& b : buckets) b.clear();
+        for (size_t i = 0; i < n; ++i)
+        {
+            float c = LodSelector::coverage(centers[i], radii[i], eye, proj(1, 1));
+            int l = 0;
+            while (l < 4 && c < thresholds[l]) ++l;
+            buckets[l].push_back((uint32_t)i);
+        }
+        doNotOptimize(buckets.data());
+    });
+    report("AoS select + push_back", baseline, (double)n, "instance");
+
+    // The camera walks forward a little each frame, so hysteresis has work to do.
+    float z = 0;
+    for (SimdTier tier : { SimdTier::Scalar, SimdTier::AVX2 })
+    {
+        if (SimdDispatch::forceTier(tier) != tier) continue;
+        char name[64];
+        std::snprintf(name, sizeof(name), "select + compact, %s", tierName(tier));
+        report(name, bestOf(5, [&] { z -= 0.5f; lods.select(Matrix4f::translate(-eye.x, -eye.y, -z), proj); }), (double)n, "instance");
+    }
+    SimdDispatch::resetTier();
+
+    std::printf("  last frame: %.3f ms, %zu changed LOD; per LOD:", lods.stats().selectMs, lods.stats().changed);
+    for (int l = 0; l <= lods.levels(); ++l)
+    {
+        size_t count;
+        lods.instances(l, count);
+        std::printf(" %zu", count);
+    }
+    std::printf("\n");
+}
+
+#pragma endregion
+
+#pragma region Mesh simplification
+
+// Rolling terrain with noise: n x n quads, cells of size 1.
+static void terrainGrid(int n, int x0, int z0, std::mt19937& rng, std::vector<Vector3f>& verts, std::vector<uint32_t>& indices)
+{
+    std::uniform_real_distribution<float> noise(-0.05f, 0.05f);
+    verts.clear(); indices.clear();
+    for (int j = 0; j <= n; ++j)
+        for (int i = 0; i <= n; ++i)
+        {
+            float x = (float)(x0 + i), z = (float)(z0 + j);
+            verts.push_back(Vector3f(x, 4 * std::sin(x * 0.05f) * std::cos(z * 0.07f) + noise(rng), z));
+        }
+    for (int j = 0; j < n; ++j)
+        for (int i = 0; i < n; ++i)
+        {
+            uint32_t a = j * (n + 1) + i, b = a + 1, c = a + n + 1, d = c + 1;
+            indices.insert(indices.end(), { a, c, b, b, c, d });
+        }
+}
+
+void bench_mesh_simplify()
+{
+    const int n = 512;
+    std::mt19937 rng(44);
+    std::vector<Vector3f> verts;
+    std::vector<uint32_t> source, indices;
+    terrainGrid(n, 0, 0, rng, verts, source);
+    const size_t triangles = source.size() / 3;
+
+    // Error against triangle count: one run per target, from the full mesh.
+    MeshSimplifier simplifier;
+    for (double keep : { 0.5, 0.25, 0.1, 0.01 })
+    {
+        SimplifyOptions options;
+        options.targetTriangles = (size_t)(triangles * keep);
+        SimplifyResult res;
+        double sec = bestOf(3, [&] {
+            indices = source;
+            simplifier.simplify(verts.data(), verts.size(), indices.data(), triangles, options, &res);
+        });
+        char name[64];
+        std::snprintf(name, sizeof(name), "simplify to %g%%", keep * 100);
+        report(name, sec, (double)triangles, "input tri");
+        std::printf("  %zu -> %zu triangles, error %.4f, %zu passes\n", triangles, res.triangles, res.error, res.passes);
+    }
+
+    // The same terrain cut into 64 x 64 clusters with locked borders, one
+    // job each across the pool.
+    const int cluster = 64, side = n / cluster;
+    std::vector<std::vector<Vector3f>> clusterVerts(side * side);
+    std::vector<std::vector<uint32_t>> clusterSource(side * side), clusterIndices(side * side);
+    std::vector<SimplifyJob> jobs(side * side);
+    for (int c = 0; c < side * side; ++c)
+        terrainGrid(cluster, (c % side) * cluster, (c / side) * cluster, rng, clusterVerts[c], clusterSource[c]);
+    SimplifyOptions options;
+    options.lockBorder = true;
+    options.targetTriangles = cluster * cluster * 2 / 4;
+    double sec = bestOf(3, [&] {
+        for (int c = 0; c < side * side; ++c)
+        {
+            clusterIndices[c] = clusterSource[c];
+            jobs[c] = { clusterVerts[c].data(), clusterVerts[c].size(), clusterIndices[c].data(), clusterSource[c].size() / 3, options, {} };
+        }
+        simplifyMeshes(jobs.data(), jobs.size());
+    });
+    report("64 clusters to 25%, locked borders", sec, (double)triangles, "input tri");
+    size_t out = 0;
+    float error = 0;
+    for (const SimplifyJob& job : jobs) { out += job.result.triangles; error = std::max(error, job.result.error); }
+    std::printf("  %zu -> %zu triangles, error %.4f, %u threads\n", triangles, out, error, JobPool::global().threadCount());
+}
+
+#pragma endregion
+
+#pragma region Vertex cache
+
+void bench_vertex_cache()
+{
+    // ~1M triangles of terrain, triangle order shuffled as an exporter
+    // that groups by material or smoothing group might leave it.
+    std::mt19937 rng(45);
+    std::vector<Vector3f> verts;
+    std::vector<uint32_t> grid;
+    terrainGrid(724, 0, 0, rng, verts, grid);
+    const size_t triangles = grid.size() / 3;
+    std::vector<uint32_t> order(triangles), shuffled(grid.size());
+    for (size_t t = 0; t < triangles; ++t) order[t] = (uint32_t)t;
+    std::shuffle(order.begin(), order.end(), rng);
+    for (size_t t = 0; t < triangles; ++t)
+        std::copy(grid.begin() + order[t] * 3, grid.begin() + order[t] * 3 + 3, shuffled.begin() + t * 3);
+
+    auto stats = [&](const char* label, const std::vector<uint32_t>& indices) {
+        VertexCacheStats s16 = analyzeVertexCache(indices.data(), indices.size(), verts.size(), 16);
+        VertexCacheStats s32 = analyzeVertexCache(indices.data(), indices.size(), verts.size(), 32);
+        std::printf("  %-10s ACMR %.3f / %.3f, ATVR %.3f / %.3f (FIFO 16 / 32)\n", label, s16.acmr, s32.acmr, s16.atvr, s32.atvr);
+    };
+    stats("shuffled", shuffled);
+
+    report("analyze (FIFO 16)", bestOf(5, [&] {
+        doNotOptimize(analyzeVertexCache(shuffled.data(), shuffled.size(), verts.size()).transformed);
+    }), (double)triangles, "tri");
+
+    std::vector<uint32_t> optimized(grid.size()), drawOrder(grid.size());
+    VertexCacheOptimizer optimizer;
+    report("Forsyth cache order", bestOf(3, [&] {
+        optimizer.optimize(optimized.data(), shuffled.data(), shuffled.size(), verts.size());
+    }), (double)triangles, "tri");
+    stats("forsyth", optimized);
+
+    report("overdraw cluster sort", bestOf(3, [&] {
+        optimizeOverdraw(drawOrder.data(), optimized.data(), optimized.size(), verts.data(), verts.size());
+    }), (double)triangles, "tri");
+    stats("overdraw", drawOrder);
+
+    std::vector<uint32_t> remap(verts.size()), fetch(grid.size());
+    std::vector<Vector3f> fetchVerts(verts.size());
+    report("fetch remap + apply", bestOf(5, [&] {
+        size_t kept = optimizeVertexFetchRemap(remap.data(), drawOrder.data(), drawOrder.size(), verts.size());
+        remapIndices(fetch.data(), drawOrder.data(), drawOrder.size(), remap.data());
+        remapVertices(fetchVerts.data(), verts.data(), verts.size(), remap.data());
+        doNotOptimize(kept);
+    }), (double)triangles, "tri");
+
+    // Vertex fetch locality: distinct 64-byte lines touched per 1024 indices.
+    auto lines = [&](const std::vector<uint32_t>& indices) {
+        size_t total = 0;
+        std::vector<size_t> window;
+        for (size_t i = 0; i < indices.size(); i += 1024)
+        {
+            window.clear();
+            for (size_t k = i; k < std::min(indices.size(), i + 1024); ++k) window.push_back(indices[k] * sizeof(Vector3f) / 64);
+            std::sort(window.begin(), window.end());
+            total += std::unique(window.begin(), window.end()) - window.begin();
+        }
+        return (double)total / (indices.size() / 1024.0);
+    };
+    std::printf("  cache lines per 1024 indices: %.0f before fetch remap, %.0f after\n", lines(drawOrder), lines(fetch));
+}
+
+#pragma endregion
+
+#pragma region Mesh normals
+
+void bench_mesh_normals()
+{
+    // 10M triangles of terrain.
+    std::mt19937 rng(46);
+    std::vector<Vector3f> verts;
+    std::vector<uint32_t> indices;
+    terrainGrid(2236, 0, 0, rng, verts, indices);
+    const size_t triangles = indices.size() / 3;
+    std::vector<Vector3f> normals(verts.size());
+
+    // Baseline: scatter each face's cross product into its vertices, then normalize.
+    report("scatter + normalize (area)", bestOf(3, [&] {
+        std::fill(normals.begin(), normals.end(), Vector3f());
+        for (size_t t = 0; t < triangles; ++t)
+        {
+            const uint32_t* tri = indices.data() + t * 3;
+            const Vector3f &p0 = verts[tri[0]], &p1 = verts[tri[1]], &p2 = verts[tri[2]];
+            Vector3f n = (p1 + p0 * -1).cross(p2 + p0 * -1);
+            normals[tri[0]] += n; normals[tri[1]] += n; normals[tri[2]] += n;
+        }
+        for (Vector3f& n : normals) n = n.normalized();
+    }), (double)triangles, "tri");
+
+    NormalGenerator gen;
+    report("setTopology (corner CSR)", bestOf(3, [&] { gen.setTopology(indices.data(), triangles, verts.size()); }),
+           (double)triangles, "tri");
+
+    const char* names[] = { "uniform", "area", "angle" };
+    for (SimdTier tier : { SimdTier::Scalar, SimdTier::AVX2 })
+    {
+        if (SimdDispatch::forceTier(tier) != tier) continue;
+        for (NormalWeighting w : { NormalWeighting::Area, NormalWeighting::Angle })
+        {
+            char name[64];
+            std::snprintf(name, sizeof(name), "normals, %s, %s", names[(int)w], tierName(tier));
+            report(name, bestOf(3, [&] { gen.computeNormals(verts.data(), normals.data(), w); }), (double)triangles, "tri");
+            std::printf("  faces %.1f ms, vertices %.1f ms\n", gen.stats().faceMs, gen.stats().vertexMs);
+        }
+    }
+    SimdDispatch::resetTier();
+
+    std::vector<Vector2f> uvs(verts.size());
+    for (size_t v = 0; v < verts.size(); ++v) uvs[v] = Vector2f(verts[v].x / 64, verts[v].z / 64);
+    std::vector<Vector4f> tangents(verts.size());
+    report("tangents (MikkTSpace-style)", bestOf(3, [&] {
+        gen.computeTangents(verts.data(), normals.data(), uvs.data(), tangents.data());
+    }), (double)triangles, "tri");
+    std::printf("  faces %.1f ms, vertices %.1f ms, %u threads\n", gen.stats().faceMs, gen.stats().vertexMs,
+                JobPool::global().threadCount());
+}
+
+#pragma endregion
+
+#pragma region Vertex quantization
+
+void bench_vertex_quantization()
+{
+    const size_t n = 1 << 22;
+    std::mt19937 rng(47);
+    std::normal_distribution<float> gauss;
+    std::uniform_real_distribution<float> unit(0, 1);
+    std::vector<Vector3f> positions = randomPoints(n, 100.0f, 47), normals(n), decoded(n);
+    std::vector<Vector2f> uvs(n), decodedUvs(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        normals[i] = Vector3f(gauss(rng), gauss(rng), gauss(rng)).normalized();
+        uvs[i] = Vector2f(unit(rng), unit(rng));
+    }
+    AABBf bounds;
+    for (const Vector3f& p : positions) bounds.expand(p);
+    const Vector2f uvMin(0, 0), uvMax(1, 1);
+
+    std::vector<uint16_t> h3(n * 3), uv16(n * 2);
+    std::vector<int16_t> snorm(n * 3), oct(n * 2);
+    for (SimdTier tier : { SimdTier::Scalar, SimdTier::AVX2 })
+    {
+        if (SimdDispatch::forceTier(tier) != tier) continue;
+        auto run = [&](const char* what, auto&& fn) {
+            char name[64];
+            std::snprintf(name, sizeof(name), "%s, %s", what, tierName(tier));
+            report(name, bestOf(5, fn), (double)n, "vertex");
+        };
+        run("half3 encode", [&] { encodeHalf3(positions.data(), h3.data(), n); });
+        run("half3 decode", [&] { decodeHalf3(h3.data(), decoded.data(), n); });
+        run("snorm16 position encode", [&] { encodeSnorm16(positions.data(), snorm.data(), n, bounds); });
+        run("snorm16 position decode", [&] { decodeSnorm16(snorm.data(), decoded.data(), n, bounds); });
+        run("oct16 normal encode", [&] { encodeOct16(normals.data(), oct.data(), n); });
+        run("oct16 normal decode", [&] { decodeOct16(oct.data(), decoded.data(), n); });
+        run("unorm16 uv encode", [&] { encodeUnorm16(uvs.data(), uv16.data(), n, uvMin, uvMax); });
+        run("unorm16 uv decode", [&] { decodeUnorm16(uv16.data(), decodedUvs.data(), n, uvMin, uvMax); });
+    }
+    SimdDispatch::resetTier();
+
+    // Measured worst cases against the documented bounds.
+    float halfRel = 0, snormErr = 0, octErr = 0, uvErr = 0;
+    decodeHalf3(h3.data(), decoded.data(), n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        Vector3f d(decoded[i].x - positions[i].x, decoded[i].y - positions[i].y, decoded[i].z - positions[i].z);
+        halfRel = std::max(halfRel, d.length() / positions[i].length());
+    }
+    decodeSnorm16(snorm.data(), decoded.data(), n, bounds);
+    for (size_t i = 0; i < n; ++i)
+        snormErr = std::max({ snormErr, std::abs(decoded[i].x - positions[i].x), std::abs(decoded[i].y - positions[i].y),
+                              std::abs(decoded[i].z - positions[i].z) });
+    decodeOct16(oct.data(), decoded.data(), n);
+    for (size_t i = 0; i < n; ++i)
+        octErr = std::max(octErr, std::atan2(decoded[i].cross(normals[i]).length(), decoded[i].dot(normals[i])));
+    decodeUnorm16(uv16.data(), decodedUvs.data(), n, uvMin, uvMax);
+    for (size_t i = 0; i < n; ++i)
+        uvErr = std::max({ uvErr, std::abs(decodedUvs[i].x - uvs[i].x), std::abs(decodedUvs[i].y - uvs[i].y) });
+    std::printf("  max error: half3 %.2e relative, snorm16 %.2e (bound %.2e), oct16 %.2e rad, unorm16 uv %.2e\n",
+                halfRel, snormErr, snorm16PositionError(bounds).x, octErr, uvErr);
+    std::printf("  position + normal + uv: %zu -> %zu bytes per vertex (%.2fx)\n",
+                sizeof(Vector3f) * 2 + sizeof(Vector2f), (size_t)(6 + 4 + 4), (12.0 + 12 + 8) / 14);
+}
+
+#pragma endregion
+
+#pragma region Half vectors
+
+void bench_half_vectors()
+{
+    const size_t n = 1 << 22;
+    std::vector<Vector3f> positions = randomPoints(n, 100.0f, 48), unpacked(n);
+    std::vector<Vector3h> packed(n);
+
+    report("pack, per element", bestOf(5, [&] {
+        for (size_t i = 0; i < n; ++i) packed[i] = Vector3h(positions[i].x, positions[i].y, positions[i].z);
+    }), (double)n, "vector");
+    for (SimdTier tier : { SimdTier::Scalar, SimdTier::AVX2 })
+    {
+        if (SimdDispatch::forceTier(tier) != tier) continue;
+        char name[64];
+        std::snprintf(name, sizeof(name), "packHalf, %s", tierName(tier));
+        report(name, bestOf(5, [&] { packHalf(positions.data(), packed.data(), n); }), (double)n, "vector");
+        std::snprintf(name, sizeof(name), "unpackHalf, %s", tierName(tier));
+        report(name, bestOf(5, [&] { unpackHalf(packed.data(), unpacked.data(), n); }), (double)n, "vector");
+    }
+    SimdDispatch::resetTier();
+
+    // Reading stored vectors directly: half pays a conversion per component.
+    float sum = 0;
+    report("length sum, Vector3f", bestOf(5, [&] {
+        float s = 0;
+        for (const Vector3f& v : positions) s += v.length();
+        sum = s;
+    }), (double)n, "vector");
+    doNotOptimize(sum);
+    report("length sum, Vector3h", bestOf(5, [&] {
+        float s = 0;
+        for (const Vector3h& v : packed) s += v.length();
+        sum = s;
+    }), (double)n, "vector");
+    doNotOptimize(sum);
+    std::printf("  storage: %zu -> %zu bytes per vector\n", sizeof(Vector3f), sizeof(Vector3h));
+}
+
+#pragma endregion
+
+#pragma region Fixed point
+
+// One server tick per call: gravity toward the origin, a steering turn
+// through sin/cos, and integration, all in T.
+template<typename T>
+static void fixedTick(std::vector<Vector3<T>>& pos, std::vector<Vector3<T>>& vel, T dt)
+{
+    using std::cos;
+    using std::sin;
+    for (size_t i = 0; i < pos.size(); ++i)
+    {
+        Vector3<T>& p = pos[i];
+        Vector3<T>& v = vel[i];
+        const T r = p.length() + T(1);
+        v += p * (-dt / (r * r));
+        const T turn = dt * T(i & 7) / 8;
+        const T c = cos(turn), s = sin(turn);
+        v = Vector3<T>(v.x * c - v.y * s, v.x * s + v.y * c, v.z);
+        p += v * dt;
+    }
+}
+
+template<typename T>
+static void benchFixedType(const char* type, size_t n)
+{
+    std::mt19937 rng(49);
+    std::uniform_real_distribution<double> coord(-100, 100);
+    std::vector<Vector3<T>> pos(n), vel(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        pos[i] = Vector3<T>(T(coord(rng)), T(coord(rng)), T(coord(rng)));
+        vel[i] = Vector3<T>(T(coord(rng) / 100), T(coord(rng) / 100), T(coord(rng) / 100));
+    }
+    const T dt = T(1) / 60;
+    char name[64];
+    std::snprintf(name, sizeof(name), "tick, %s", type);
+    report(name, bestOf(5, [&] { fixedTick(pos, vel, dt); }), (double)n, "body");
+
+    std::vector<T> angles(n), out(n);
+    for (size_t i = 0; i < n; ++i) angles[i] = T(coord(rng) / 10);
+    auto kernel = [&](const char* what, auto&& fn) {
+        std::snprintf(name, sizeof(name), "%s, %s", what, type);
+        report(name, bestOf(5, [&] { for (size_t i = 0; i < n; ++i) out[i] = fn(angles[i], angles[n - 1 - i]); }),
+               (double)n, "op");
+        doNotOptimize(out.data());
+    };
+    kernel("mul", [](T a, T b) { return a * b; });
+    kernel("div", [](T a, T b) { return a / b; });
+    kernel("sqrt", [](T a, T) { using std::sqrt; using std::abs; return T(sqrt(abs(a))); });
+    kernel("sin", [](T a, T) { using std::sin; return T(sin(a)); });
+    kernel("atan2", [](T a, T b) { using std::atan2; return T(atan2(a, b)); });
+}
+
+void bench_fixed_point()
+{
+    const size_t n = 1 << 16;
+    benchFixedType<float>("float", n);
+    benchFixedType<Fixed16>("Q16.16", n);
+    benchFixedType<Fixed32>("Q32.32", n);
+}
+
+#pragma endregion
+
+#pragma region Grid coordinates
+
+void bench_grid_coords()
+{
+    const size_t n = 1 << 22;
+    std::vector<Vector3f> points = randomPoints(n, 100.0f, 50);
+    std::vector<Vector2f> points2(n);
+    for (size_t i = 0; i < n; ++i) points2[i] = Vector2f(points[i].x, points[i].z);
+    const Grid3 g3{ Vector3f(-100, -100, -100), 0.5f, Vector3i(400, 400, 400) };
+    const Grid2 g2{ Vector2f(-100, -100), 0.25f, Vector2i(800, 800) };
+    std::vector<Vector3i> cells(n), decoded(n);
+    std::vector<Vector2i> cells2(n), decoded2(n);
+    std::vector<uint32_t> indices(n);
+    std::vector<uint64_t> codes(n);
+
+    for (SimdTier tier : { SimdTier::Scalar, SimdTier::AVX2 })
+    {
+        if (SimdDispatch::forceTier(tier) != tier) continue;
+        auto run = [&](const char* what, auto&& fn) {
+            char name[64];
+            std::snprintf(name, sizeof(name), "%s, %s", what, tierName(tier));
+            report(name, bestOf(5, fn), (double)n, "point");
+        };
+        run("cellsOf 3D", [&] { cellsOf(points.data(), cells.data(), n, g3); });
+        run("cellsOf 2D", [&] { cellsOf(points2.data(), cells2.data(), n, g2); });
+        run("cellIndices 3D", [&] { cellIndices(points.data(), indices.data(), n, g3); });
+        run("cellIndices 2D", [&] { cellIndices(points2.data(), indices.data(), n, g2); });
+        // The AVX2 tier uses pdep/pext when the CPU has BMI2.
+        run("morton encode 3D", [&] { mortonEncode(cells.data(), codes.data(), n); });
+        run("morton decode 3D", [&] { mortonDecode(codes.data(), decoded.data(), n); });
+        run("morton encode 2D", [&] { mortonEncode(cells2.data(), codes.data(), n); });
+        run("morton decode 2D", [&] { mortonDecode(codes.data(), decoded2.data(), n); });
+    }
+    SimdDispatch::resetTier();
+
+    int tiles = 0;
+    report("tileOf + cellInTile 3D", bestOf(5, [&] {
+        int sum = 0;
+        for (const Vector3i& c : cells)
+        {
+            const Vector3i t = tileOf(c, 16), l = cellInTile(c, 16);
+            sum += t.x + t.y + t.z + l.x;
+        }
+        tiles = sum;
+    }), (double)n, "cell");
+    doNotOptimize(tiles);
+    std::printf("  bmi2: %s\n", cpuFeatures().bmi2 ? "yes" : "no");
+}
+
+#pragma endregion
+
+// ───────────────────────────────────────────
+struct Benchmark { const char* name; void (*run)(); };
+
+int main(int argc, char** argv)
+{
+    const Benchmark benchmarks[] = {
+        { "core", bench_core },
+        { "simd", bench_simd },
+        { "spatial_hash", bench_spatial_hash },
+        { "kdtree", bench_kdtree },
+        { "loose_octree", bench_loose_octree },
+        { "sweep_prune", bench_sweep_prune },
+        { "ray_triangle", bench_ray_triangle },
+        { "gjk", bench_gjk },
+        { "rigid_body", bench_rigid_body },
+        { "particles", bench_particles },
+        { "skinning", bench_skinning },
+        { "animation", bench_animation },
+        { "spline", bench_spline },
+        { "triangle_setup", bench_triangle_setup },
+        { "occlusion", bench_occlusion_culling },
+        { "lod", bench_lod_selection },
+        { "simplify", bench_mesh_simplify },
+        { "vertex_cache", bench_vertex_cache },
+        { "normals", bench_mesh_normals },
+        { "quantize", bench_vertex_quantization },
+        { "half", bench_half_vectors },
+        { "fixed", bench_fixed_point },
+        { "grid", bench_grid_coords },
+    };
+
+    // Optional argument: only run benchmarks whose name contains it.
+    const char* filter = argc > 1 ? argv[1] : "";
+    for (const Benchmark& b : benchmarks)
+    {
+        if (!std::strstr(b.name, filter)) continue;
+        std::printf("[%s]\n", b.name);
+        b.run();
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPL_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+#endif
+
+// Lets a single function use an instruction set the rest of the binary was
+// not compiled for. MSVC needs no attribute to emit AVX intrinsics.
+#if defined(CPL_X86) && (defined(__GNUC__) || defined(__clang__))
+#define CPL_TARGET_SSE41  __attribute__((target("sse4.1")))
+#define CPL_TARGET_AVX2   __attribute__((target("avx2,fma")))
+#define CPL_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#define CPL_TARGET_F16C   __attribute__((target("avx2,fma,f16c")))
+#define CPL_TARGET_BMI2   __attribute__((target("bmi2")))
+#else
+#define CPL_TARGET_SSE41
+#define CPL_TARGET_AVX2
+#define CPL_TARGET_AVX512
+#define CPL_TARGET_F16C
+#define CPL_TARGET_BMI2
+#endif
+
+namespace CPL
+{
+    enum class SimdTier { Scalar = 0, SSE41, AVX2, AVX512 };
+
+    inline const char* tierName(SimdTier t)
+    {
+        switch (t)
+        {
+        case SimdTier::SSE41:  return "sse4.1";
+        case SimdTier::AVX2:   return "avx2+fma";
+        case SimdTier::AVX512: return "avx512f";
+        default:               return "scalar";
+        }
+    }
+
+    struct CpuFeatures
+    {
+        bool sse41 = false;
+        bool avx = false;
+        bool avx2 = false;
+        bool fma = false;
+        bool bmi2 = false;
+        bool f16c = false;
+        bool avx512f = false;
+
+        SimdTier bestTier() const
+        {
+            if (avx512f && avx2 && fma) return SimdTier::AVX512;
+            if (avx2 && fma)            return SimdTier::AVX2;
+            if (sse41)                  return SimdTier::SSE41;
+            return SimdTier::Scalar;
+        }
+
+        bool supports(SimdTier t) const { return t <= bestTier(); }
+
+        static CpuFeatures detect()
+        {
+            CpuFeatures f;
+#if defined(CPL_X86)
+            uint32_t r[4];
+            cpuid(0, 0, r);
+            uint32_t maxLeaf = r[0];
+
+            cpuid(1, 0, r);
+            f.sse41 = (r[2] >> 19) & 1;
+            f.fma = (r[2] >> 12) & 1;
+            f.f16c = (r[2] >> 29) & 1;
+            bool osxsave = (r[2] >> 27) & 1;
+            bool avxCpu = (r[2] >> 28) & 1;
+
+            // The OS must save the wide registers on context switch (XCR0).
+            uint64_t xcr0 = osxsave ? xgetbv() : 0;
+            bool ymmOs = (xcr0 & 0x6) == 0x6;
+            bool zmmOs = (xcr0 & 0xE6) == 0xE6;
+
+            f.avx = avxCpu && ymmOs;
+            f.fma = f.fma && f.avx;
+            f.f16c = f.f16c && f.avx;
+            if (maxLeaf >= 7)
+            {
+                cpuid(7, 0, r);
+                f.avx2 = ((r[1] >> 5) & 1) && f.avx;
+                f.bmi2 = (r[1] >> 8) & 1;
+                f.avx512f = ((r[1] >> 16) & 1) && zmmOs;
+            }
+#endif
+            return f;
+        }
+
+    private:
+#if defined(CPL_X86)
+        static void cpuid(uint32_t leaf, uint32_t sub, uint32_t r[4])
+        {
+#if defined(_MSC_VER)
+            int regs[4];
+            __cpuidex(regs, (int)leaf, (int)sub);
+            for (int i = 0; i < 4; ++i) r[i] = (uint32_t)regs[i];
+#else
+            __cpuid_count(leaf, sub, r[0], r[1], r[2], r[3]);
+#endif
+        }
+
+        static uint64_t xgetbv()
+        {
+#if defined(_MSC_VER)
+            return _xgetbv(0);
+#else
+            uint32_t lo, hi;
+            __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+            return ((uint64_t)hi << 32) | lo;
+#endif
+        }
+#endif
+    };
+
+    // Detected once; CPUID is not free.
+    inline const CpuFeatures& cpuFeatures()
+    {
+        static const CpuFeatures f = CpuFeatures::detect();
+        return f;
+    }
+}
@@ -0,0 +1,307 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <type_traits>
+#include "vector2.hpp"
+#include "Vector3.hpp"
+#include "matrix4.hpp"
+
+namespace CPL
+{
+    // Integer kernels behind Fixed. Everything is plain integer arithmetic
+    // (two's complement wrap, arithmetic right shift), so results are the
+    // same bits on every compiler and platform.
+    namespace fixed
+    {
+        // Index of the highest set bit plus one; 0 for 0.
+        inline int bitLength(uint64_t v)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return v ? 64 - __builtin_clzll(v) : 0;
+#else
+            int n = 0;
+            while (v) { v >>= 1; ++n; }
+            return n;
+#endif
+        }
+
+        // Signed 64 x 64 -> 128 bit product as (hi, lo).
+        inline void mulWide(int64_t a, int64_t b, int64_t& hi, uint64_t& lo)
+        {
+            const uint64_t ua = (uint64_t)a, ub = (uint64_t)b;
+            const uint64_t a0 = ua & 0xffffffffu, a1 = ua >> 32, b0 = ub & 0xffffffffu, b1 = ub >> 32;
+            const uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+            const uint64_t mid = (p00 >> 32) + (p01 & 0xffffffffu) + (p10 & 0xffffffffu);
+            lo = (mid << 32) | (p00 & 0xffffffffu);
+            uint64_t uhi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+            // Unsigned to signed: subtract the other operand once per negative input.
+            if (a < 0) uhi -= ub;
+            if (b < 0) uhi -= ua;
+            hi = (int64_t)uhi;
+        }
+
+        // (a * b) / 2^s rounded half up, wrapped to 64 bits; 0 < s < 64.
+        inline int64_t mulShiftPortable(int64_t a, int64_t b, int s)
+        {
+            int64_t hi;
+            uint64_t lo;
+            mulWide(a, b, hi, lo);
+            const uint64_t half = uint64_t(1) << (s - 1);
+            const uint64_t sum = lo + half;
+            const uint64_t uhi = (uint64_t)hi + (sum < lo ? 1 : 0);
+            return (int64_t)((uhi << (64 - s)) | (sum >> s));
+        }
+
+        // (a * 2^s) / b truncated toward zero, wrapped to 64 bits; b != 0, 0 < s < 64.
+        inline int64_t divShiftPortable(int64_t a, int64_t b, int s)
+        {
+            const uint64_t ua = a < 0 ? 0 - (uint64_t)a : (uint64_t)a;
+            const uint64_t ub = b < 0 ? 0 - (uint64_t)b : (uint64_t)b;
+            const uint64_t nHi = ua >> (64 - s), nLo = ua << s;
+            // Restoring long division, one dividend bit at a time from the top.
+            uint64_t r = 0, q = 0;
+            for (int i = 63 + s; i >= 0; --i)
+            {
+                const uint64_t bit = i >= 64 ? (nHi >> (i - 64)) & 1 : (nLo >> i) & 1;
+                const uint64_t carry = r >> 63;
+                r = (r << 1) | bit;
+                if (carry || r >= ub)
+                {
+                    r -= ub;
+                    if (i < 64) q |= uint64_t(1) << i;
+                }
+            }
+            return (a < 0) != (b < 0) ? (int64_t)(0 - q) : (int64_t)q;
+        }
+
+        inline int64_t mulShift(int64_t a, int64_t b, int s)
+        {
+#if defined(__SIZEOF_INT128__)
+            return (int64_t)(((__int128)a * b + ((__int128)1 << (s - 1))) >> s);
+#else
+            return mulShiftPortable(a, b, s);
+#endif
+        }
+
+        inline int64_t divShift(int64_t a, int64_t b, int s)
+        {
+#if defined(__SIZEOF_INT128__)
+            return (int64_t)((__int128)a * ((__int128)1 << s) / b);
+#else
+            return divShiftPortable(a, b, s);
+#endif
+        }
+
+        inline int32_t mulShift(int32_t a, int32_t b, int s)
+        {
+            return (int32_t)(((int64_t)a * b + (int64_t(1) << (s - 1))) >> s);
+        }
+
+        inline int32_t divShift(int32_t a, int32_t b, int s)
+        {
+            return (int32_t)((int64_t)a * (int64_t(1) << s) / b);
+        }
+
+        // sqrt(hi * 2^64 + lo) rounded to nearest, digit by digit; the root
+        // must stay below 2^62.
+        inline uint64_t isqrt(uint64_t hi, uint64_t lo)
+        {
+            const int bits = hi ? 64 + bitLength(hi) : bitLength(lo);
+            uint64_t r = 0, q = 0;
+            for (int pair = (bits - 1) >> 1; pair >= 0; --pair)
+            {
+                const uint64_t digits = (pair >= 32 ? hi >> (2 * pair - 64) : lo >> (2 * pair)) & 3;
+                r = (r << 2) | digits;
+                const uint64_t t = (q << 2) | 1;
+                const uint64_t take = r >= t;
+                r -= t & (0 - take);
+                q = (q << 1) | take;
+            }
+            // n - q^2 > q means n > (q + 1/2)^2.
+            return r > q ? q + 1 : q;
+        }
+
+        // Trig runs in Q32 radians (int64, 32 fraction bits) whatever the
+        // caller's format.
+        constexpr int64_t Pi = 13493037705;
+        constexpr int64_t HalfPi = 6746518852;
+        constexpr int64_t TwoPi = 26986075409;
+        constexpr int CordicSteps = 32;
+        // 1 / prod(sqrt(1 + 2^-2i)) over the 32 steps.
+        constexpr int64_t CordicGain = 2608131496;
+        // atan(2^-i).
+        constexpr int64_t AtanTable[CordicSteps] = {
+            3373259426, 1991351318, 1052175346, 534100635, 268086748, 134174063, 67103403, 33553749,
+            16777131, 8388597, 4194303, 2097152, 1048576, 524288, 262144, 131072,
+            65536, 32768, 16384, 8192, 4096, 2048, 1024, 512, 256, 128, 64, 32, 16, 8, 4, 2 };
+
+        // Negates v when mask is -1, keeps it when mask is 0; lets the CORDIC
+        // steps run without data-dependent branches.
+        inline int64_t negateIf(int64_t v, int64_t mask) { return (v ^ mask) - mask; }
+
+        // CORDIC rotation mode: (cos a, sin a) in Q32. Each step adds about
+        // one bit; steps past 16 no longer move the gain at Q32.
+        inline void sinCos(int64_t a, int64_t& sinOut, int64_t& cosOut, int steps = CordicSteps)
+        {
+            int64_t z = a % TwoPi;
+            if (z > Pi) z -= TwoPi;
+            else if (z < -Pi) z += TwoPi;
+            // CORDIC converges on [-pi/2, pi/2]; fold the rest by a half turn.
+            bool flip = false;
+            if (z > HalfPi) { z -= Pi; flip = true; }
+            else if (z < -HalfPi) { z += Pi; flip = true; }
+
+            int64_t x = CordicGain, y = 0;
+            for (int i = 0; i < steps; ++i)
+            {
+                const int64_t dx = y >> i, dy = x >> i, m = z >> 63;
+                x -= negateIf(dx, m);
+                y += negateIf(dy, m);
+                z -= negateIf(AtanTable[i], m);
+            }
+            cosOut = flip ? -x : x;
+            sinOut = flip ? -y : y;
+        }
+
+        // CORDIC vectoring mode: atan2(y, x) in Q32 for any common scale of x, y.
+        inline int64_t atan2(int64_t y, int64_t x, int steps = CordicSteps)
+        {
+            if (x == 0 && y == 0) return 0;
+            // Scale so the larger magnitude sits in [2^60, 2^61): full
+            // precision for small inputs, headroom for the CORDIC gain.
+            uint64_t ax = x < 0 ? 0 - (uint64_t)x : (uint64_t)x;
+            uint64_t ay = y < 0 ? 0 - (uint64_t)y : (uint64_t)y;
+            const int shift = 61 - bitLength(ax > ay ? ax : ay);
+            if (shift < 0)
+            {
+                x >>= -shift;
+                y >>= -shift;
+            }
+            else
+            {
+                x = (int64_t)((uint64_t)x << shift);
+                y = (int64_t)((uint64_t)y << shift);
+            }
+
+            // Rotate into the right half-plane by a quarter turn.
+            int64_t z = 0;
+            if (x < 0)
+            {
+                const int64_t t = x;
+                if (y >= 0) { x = y; y = -t; z = HalfPi; }
+                else { x = -y; y = t; z = -HalfPi; }
+            }
+            for (int i = 0; i < steps; ++i)
+            {
+                const int64_t dx = y >> i, dy = x >> i, m = -(int64_t)(y <= 0);
+                x += negateIf(dx, m);
+                y -= negateIf(dy, m);
+                z += negateIf(AtanTable[i], m);
+            }
+            return z;
+        }
+    }
+
+    // Binary fixed point with FracBits fraction bits in a signed Raw integer:
+    // Fixed16 is Q16.16 in 32 bits, Fixed32 is Q32.32 in 64. Every operation
+    // is integer-only and bit-exact across compilers, for lockstep simulation.
+    // Overflow wraps; products round half up, quotients truncate toward zero
+    // and x / 0 saturates. Integers convert implicitly, floating point only
+    // explicitly, so a stray float cannot leak into the simulation.
+    // Q16.16 tops out at 32768: lengthSquared() overflows past |v| ~ 181, so
+    // use Fixed32 for world-sized vectors.
+    template<typename Raw, int FracBits>
+    class Fixed
+    {
+        using URaw = std::make_unsigned_t<Raw>;
+        static_assert(std::is_signed<Raw>::value && FracBits > 0 && FracBits <= 32 && FracBits < int(sizeof(Raw) * 8) - 1,
+                      "unsupported fixed-point format");
+
+    public:
+        Raw raw;
+
+        static constexpr Raw One = Raw(1) << FracBits;
+
+        Fixed() = default;
+
+        template<typename I, typename = std::enable_if_t<std::is_integral<I>::value>>
+        constexpr Fixed(I value) : raw(Raw(URaw(Raw(value)) << FracBits)) {}
+
+        explicit Fixed(double value) : raw((Raw)std::llround(value * (double)One)) {}
+
+        static constexpr Fixed fromRaw(Raw r) { Fixed f{}; f.raw = r; return f; }
+
+        explicit operator double() const { return (double)raw / (double)One; }
+        explicit operator float()  const { return (float)(double)*this; }
+        // Rounds toward negative infinity.
+        explicit operator int()    const { return (int)(raw >> FracBits); }
+
+        friend Fixed operator+(Fixed a, Fixed b) { return fromRaw(Raw(URaw(a.raw) + URaw(b.raw))); }
+        friend Fixed operator-(Fixed a, Fixed b) { return fromRaw(Raw(URaw(a.raw) - URaw(b.raw))); }
+        friend Fixed operator*(Fixed a, Fixed b) { return fromRaw(fixed::mulShift(a.raw, b.raw, FracBits)); }
+        friend Fixed operator/(Fixed a, Fixed b)
+        {
+            if (b.raw == 0) return fromRaw(a.raw < 0 ? std::numeric_limits<Raw>::min() : std::numeric_limits<Raw>::max());
+            return fromRaw(fixed::divShift(a.raw, b.raw, FracBits));
+        }
+        Fixed operator-() const { return fromRaw(Raw(URaw(0) - URaw(raw))); }
+
+        Fixed& operator+=(Fixed o) { return *this = *this + o; }
+        Fixed& operator-=(Fixed o) { return *this = *this - o; }
+        Fixed& operator*=(Fixed o) { return *this = *this * o; }
+        Fixed& operator/=(Fixed o) { return *this = *this / o; }
+
+        friend bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+        friend bool operator!=(Fixed a, Fixed b) { return a.raw != b.raw; }
+        friend bool operator< (Fixed a, Fixed b) { return a.raw < b.raw; }
+        friend bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+        friend bool operator> (Fixed a, Fixed b) { return a.raw > b.raw; }
+        friend bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+
+        // Math found by ADL from the vector and matrix templates.
+        friend Fixed abs(Fixed a) { return a.raw < 0 ? -a : a; }
+
+        // Negative inputs give 0.
+        friend Fixed sqrt(Fixed a)
+        {
+            if (a.raw <= 0) return fromRaw(0);
+            const uint64_t v = (uint64_t)a.raw;
+            return fromRaw((Raw)fixed::isqrt(v >> (64 - FracBits), v << FracBits));
+        }
+
+        friend Fixed sin(Fixed a) { int64_t s, c; fixed::sinCos(toQ32(a.raw), s, c, TrigSteps); return fromRaw(fromQ32(s)); }
+        friend Fixed cos(Fixed a) { int64_t s, c; fixed::sinCos(toQ32(a.raw), s, c, TrigSteps); return fromRaw(fromQ32(c)); }
+        friend Fixed tan(Fixed a) { return sin(a) / cos(a); }
+        friend Fixed atan2(Fixed y, Fixed x) { return fromRaw(fromQ32(fixed::atan2(y.raw, x.raw, TrigSteps))); }
+        // Clamps to [-1, 1] first.
+        friend Fixed acos(Fixed a)
+        {
+            if (a >= Fixed(1)) return fromRaw(0);
+            if (a <= Fixed(-1)) return fromRaw(fromQ32(fixed::Pi));
+            return atan2(sqrt(Fixed(1) - a * a), a);
+        }
+
+        friend std::ostream& operator<<(std::ostream& os, Fixed a) { return os << (double)a; }
+
+    private:
+        // A few guard steps past the output precision.
+        static constexpr int TrigSteps = FracBits + 4 < fixed::CordicSteps ? FracBits + 4 : fixed::CordicSteps;
+
+        static int64_t toQ32(Raw r) { return (int64_t)((uint64_t)(int64_t)r << (32 - FracBits)); }
+        static Raw fromQ32(int64_t q)
+        {
+            if constexpr (FracBits == 32) return (Raw)q;
+            else return (Raw)((q + (int64_t(1) << (31 - FracBits))) >> (32 - FracBits));
+        }
+    };
+
+    using Fixed16 = Fixed<int32_t, 16>;
+    using Fixed32 = Fixed<int64_t, 32>;
+
+    // Q16.16 vectors, "x" as in the GL fixed-point entry points.
+    using Vector2x = Vector2<Fixed16>;
+    using Vector3x = Vector3<Fixed16>;
+    using Matrix4x = Matrix4<Fixed16>;
+}
@@ -0,0 +1,563 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Vector3.hpp"
+#include "matrix4.hpp"
+#include "simd_dispatch.hpp"
+
+// GJK distance and EPA penetration between convex shapes. A shape is a point
+// set plus a radius: support(dir) returns the index of a vertex furthest along
+// a local-space direction, vertex(i) its local position, radius() how much the
+// core is rounded (capsules). GJK and EPA run on the cores; radii are applied
+// at the end. Shapes are placed in the world by affine Matrix4s.
+
+namespace CPL
+{
+    // ─── Shapes ───────────────────────────────────────────
+
+    template<typename T>
+    class BoxShape
+    {
+    public:
+        explicit BoxShape(const Vector3<T>& halfExtents) : half(halfExtents) {}
+
+        uint32_t support(const Vector3<T>& d) const { return (d.x >= 0 ? 1 : 0) | (d.y >= 0 ? 2 : 0) | (d.z >= 0 ? 4 : 0); }
+        Vector3<T> vertex(uint32_t i) const { return { i & 1 ? half.x : -half.x, i & 2 ? half.y : -half.y, i & 4 ? half.z : -half.z }; }
+        T radius() const { return T(0); }
+
+        Vector3<T> half;
+    };
+
+    // Segment from -halfHeight to +halfHeight along local y, rounded by radius.
+    template<typename T>
+    class CapsuleShape
+    {
+    public:
+        CapsuleShape(T halfHeight, T radius) : halfHeight(halfHeight), r(radius) {}
+
+        uint32_t support(const Vector3<T>& d) const { return d.y >= 0 ? 1 : 0; }
+        Vector3<T> vertex(uint32_t i) const { return { T(0), i ? halfHeight : -halfHeight, T(0) }; }
+        T radius() const { return r; }
+
+        T halfHeight, r;
+    };
+
+    // Any point cloud; interior points are harmless, just wasted work. Points
+    // are kept SoA and padded to a multiple of 8 with copies of point 0 so the
+    // float support scan runs 8 wide under AVX2.
+    template<typename T>
+    class ConvexHull
+    {
+    public:
+        ConvexHull(const Vector3<T>* points, size_t n) : count(n)
+        {
+            size_t padded = (n + 7) / 8 * 8;
+            xs.resize(padded); ys.resize(padded); zs.resize(padded);
+            for (size_t i = 0; i < padded; ++i)
+            {
+                const Vector3<T>& p = points[i < n ? i : 0];
+                xs[i] = p.x; ys[i] = p.y; zs[i] = p.z;
+            }
+        }
+
+        size_t size() const { return count; }
+
+        // Lowest index among equally far vertices, so results do not depend on the tier.
+        uint32_t support(const Vector3<T>& d) const
+        {
+#if defined(CPL_X86)
+            if constexpr (std::is_same<T, float>::value)
+                if (SimdDispatch::tier() >= SimdTier::AVX2)
+                    return supportAVX2(xs.data(), ys.data(), zs.data(), xs.size(), d.x, d.y, d.z);
+#endif
+            uint32_t best = 0;
+            T bestDot = xs[0] * d.x + ys[0] * d.y + zs[0] * d.z;
+            for (uint32_t i = 1; i < count; ++i)
+            {
+                T dp = xs[i] * d.x + ys[i] * d.y + zs[i] * d.z;
+                if (dp > bestDot) { bestDot = dp; best = i; }
+            }
+            return best;
+        }
+
+        Vector3<T> vertex(uint32_t i) const { return { xs[i], ys[i], zs[i] }; }
+        T radius() const { return T(0); }
+
+    private:
+        size_t         count;
+        std::vector<T> xs, ys, zs;
+
+#if defined(CPL_X86)
+        // Running max and its index per lane, then the lowest index holding
+        // the overall max. Padding copies point 0, which always loses the tie.
+        CPL_TARGET_AVX2 static uint32_t supportAVX2(const float* xs, const float* ys, const float* zs, size_t n,
+                                                    float dx, float dy, float dz)
+        {
+            const __m256 vx = _mm256_set1_ps(dx), vy = _mm256_set1_ps(dy), vz = _mm256_set1_ps(dz);
+            __m256 best = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+            __m256i bestIdx = _mm256_setzero_si256();
+            __m256i idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            const __m256i step = _mm256_set1_epi32(8);
+            for (size_t i = 0; i < n; i += 8)
+            {
+                __m256 dp = _mm256_fmadd_ps(_mm256_loadu_ps(xs + i), vx,
+                            _mm256_fmadd_ps(_mm256_loadu_ps(ys + i), vy, _mm256_mul_ps(_mm256_loadu_ps(zs + i), vz)));
+                __m256 better = _mm256_cmp_ps(dp, best, _CMP_GT_OQ);
+                best = _mm256_blendv_ps(best, dp, better);
+                bestIdx = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIdx), _mm256_castsi256_ps(idx), better));
+                idx = _mm256_add_epi32(idx, step);
+            }
+            alignas(32) float vals[8];
+            alignas(32) uint32_t ids[8];
+            _mm256_store_ps(vals, best);
+            _mm256_store_si256((__m256i*)ids, bestIdx);
+            uint32_t result = ids[0];
+            float top = vals[0];
+            for (int l = 1; l < 8; ++l)
+                if (vals[l] > top || (vals[l] == top && ids[l] < result)) { top = vals[l]; result = ids[l]; }
+            return result;
+        }
+#endif
+    };
+
+    using BoxShapef = BoxShape<float>;
+    using CapsuleShapef = CapsuleShape<float>;
+    using ConvexHullf = ConvexHull<float>;
+
+    // ─── Queries ──────────────────────────────────────────
+
+    // The support vertex indices of the last simplex. Passing the same cache
+    // back next frame restarts GJK from that simplex, so a persistent pair
+    // usually converges after one or two support calls.
+    struct GjkCache
+    {
+        uint32_t count = 0;
+        uint32_t indexA[4], indexB[4];
+    };
+
+    template<typename T>
+    struct GjkResult
+    {
+        T          distance;        // between the rounded shapes; 0 when they touch
+        Vector3<T> pointA, pointB;  // closest points; unspecified when overlapping
+        bool       overlap;
+        int        iterations;      // support calls made
+    };
+
+    template<typename T>
+    struct Contact
+    {
+        Vector3<T> normal;          // unit, from A towards B
+        T          depth;           // translate B by normal * depth to separate
+        Vector3<T> pointA, pointB;  // deepest points of A inside B and of B inside A
+    };
+
+    namespace gjk
+    {
+        template<typename T>
+        inline Vector3<T> sub(const Vector3<T>& a, const Vector3<T>& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+
+        template<typename T>
+        inline Vector3<T> neg(const Vector3<T>& a) { return { -a.x, -a.y, -a.z }; }
+
+        // Shape placed by an affine matrix. The support of M(S) along d is
+        // M applied to the support of S along M^T d.
+        template<typename Shape, typename T>
+        struct Placed
+        {
+            const Shape&      shape;
+            const Matrix4<T>& m;
+
+            uint32_t support(const Vector3<T>& d) const
+            {
+                return shape.support({ m(0, 0) * d.x + m(1, 0) * d.y + m(2, 0) * d.z,
+                                       m(0, 1) * d.x + m(1, 1) * d.y + m(2, 1) * d.z,
+                                       m(0, 2) * d.x + m(1, 2) * d.y + m(2, 2) * d.z });
+            }
+
+            Vector3<T> vertex(uint32_t i) const
+            {
+                Vector3<T> p = shape.vertex(i);
+                return { m(0, 0) * p.x + m(0, 1) * p.y + m(0, 2) * p.z + m(0, 3),
+                         m(1, 0) * p.x + m(1, 1) * p.y + m(1, 2) * p.z + m(1, 3),
+                         m(2, 0) * p.x + m(2, 1) * p.y + m(2, 2) * p.z + m(2, 3) };
+            }
+        };
+
+        template<typename T>
+        struct Vertex
+        {
+            Vector3<T> a, b, w;         // w = a - b, a point of the Minkowski difference
+            uint32_t   ia, ib;
+        };
+
+        template<typename PA, typename PB, typename T = decltype(std::declval<PA>().vertex(0).x)>
+        Vertex<T> makeVertex(const PA& pa, const PB& pb, uint32_t ia, uint32_t ib)
+        {
+            Vertex<T> v{ pa.vertex(ia), pb.vertex(ib), {}, ia, ib };
+            v.w = sub(v.a, v.b);
+            return v;
+        }
+
+        // Closest point of triangle s[0..2] to the origin (Ericson's regions).
+        // Drops the vertices outside the closest feature and writes weights.
+        template<typename T>
+        Vector3<T> solveTriangle(Vertex<T>* s, int& n, T* l)
+        {
+            const Vector3<T> a = s[0].w, b = s[1].w, c = s[2].w;
+            Vector3<T> ab = sub(b, a), ac = sub(c, a);
+            T d1 = -ab.dot(a), d2 = -ac.dot(a);
+            if (d1 <= 0 && d2 <= 0) { n = 1; l[0] = 1; return a; }
+            T d3 = -ab.dot(b), d4 = -ac.dot(b);
+            if (d3 >= 0 && d4 <= d3) { s[0] = s[1]; n = 1; l[0] = 1; return b; }
+            T vc = d1 * d4 - d3 * d2;
+            if (vc <= 0 && d1 >= 0 && d3 <= 0)
+            {
+                T t = d1 / (d1 - d3);
+                n = 2; l[0] = 1 - t; l[1] = t;
+                return a + ab * t;
+            }
+            T d5 = -ab.dot(c), d6 = -ac.dot(c);
+            if (d6 >= 0 && d5 <= d6) { s[0] = s[2]; n = 1; l[0] = 1; return c; }
+            T vb = d5 * d2 - d1 * d6;
+            if (vb <= 0 && d2 >= 0 && d6 <= 0)
+            {
+                T t = d2 / (d2 - d6);
+                s[1] = s[2]; n = 2; l[0] = 1 - t; l[1] = t;
+                return a + ac * t;
+            }
+            T va = d3 * d6 - d5 * d4;
+            if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0)
+            {
+                T t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+                s[0] = s[1]; s[1] = s[2]; n = 2; l[0] = 1 - t; l[1] = t;
+                return b + sub(c, b) * t;
+            }
+            T denom = T(1) / (va + vb + vc);
+            T v = vb * denom, w = vc * denom;
+            n = 3; l[0] = 1 - v - w; l[1] = v; l[2] = w;
+            return a + ab * v + ac * w;
+        }
+
+        // Reduces s[0..n) to the smallest sub-simplex holding the point
+        // closest to the origin. n stays 4 only when the origin is inside.
+        template<typename T>
+        Vector3<T> solveSimplex(Vertex<T>* s, int& n, T* l)
+        {
+            if (n == 1) { l[0] = 1; return s[0].w; }
+            if (n == 2)
+            {
+                Vector3<T> ab = sub(s[1].w, s[0].w);
+                T t = -s[0].w.dot(ab), len2 = ab.dot(ab);
+                if (t <= 0 || len2 <= 0) { n = 1; l[0] = 1; return s[0].w; }
+                if (t >= len2) { s[0] = s[1]; n = 1; l[0] = 1; return s[0].w; }
+                t /= len2;
+                l[0] = 1 - t; l[1] = t;
+                return s[0].w + ab * t;
+            }
+            if (n == 3) return solveTriangle(s, n, l);
+
+            // Tetrahedron: try every face the origin lies in front of.
+            static const int faces[4][4] = { { 0, 1, 2, 3 }, { 0, 3, 1, 2 }, { 0, 2, 3, 1 }, { 1, 3, 2, 0 } };
+            T bestD2 = std::numeric_limits<T>::max();
+            Vertex<T> best[3];
+            T bestL[3] = {};
+            int bestN = 0;
+            Vector3<T> bestP;
+            for (const auto& f : faces)
+            {
+                const Vector3<T>& a = s[f[0]].w;
+                Vector3<T> nrm = sub(s[f[1]].w, a).cross(sub(s[f[2]].w, a));
+                T side = nrm.dot(sub(s[f[3]].w, a)), originSide = -nrm.dot(a);
+                if (side * originSide > 0) continue; // origin on the inner side of this face
+                Vertex<T> tri[3] = { s[f[0]], s[f[1]], s[f[2]] };
+                int tn = 3;
+                T tl[3];
+                Vector3<T> p = solveTriangle(tri, tn, tl);
+                T d2 = p.dot(p);
+                if (d2 < bestD2)
+                {
+                    bestD2 = d2; bestN = tn; bestP = p;
+                    std::copy(tri, tri + tn, best);
+                    std::copy(tl, tl + tn, bestL);
+                }
+            }
+            if (bestN == 0)
+            {
+                std::fill(l, l + 4, T(0.25));
+                return Vector3<T>(0, 0, 0);
+            }
+            n = bestN;
+            std::copy(best, best + n, s);
+            std::copy(bestL, bestL + n, l);
+            return bestP;
+        }
+
+        template<typename T>
+        struct CoreResult
+        {
+            Vertex<T>  simplex[4];
+            int        count;
+            T          weights[4];
+            T          distance;
+            Vector3<T> pointA, pointB;
+            bool       overlap;
+            int        iterations;
+        };
+
+        template<typename PA, typename PB, typename T>
+        void runGjk(const PA& pa, const PB& pb, GjkCache* cache, CoreResult<T>& r)
+        {
+            const T relTol = std::numeric_limits<T>::epsilon() * 100;
+            Vertex<T>* s = r.simplex;
+            int& n = r.count;
+            if (cache && cache->count > 0)
+            {
+                n = (int)cache->count;
+                for (int i = 0; i < n; ++i) s[i] = makeVertex(pa, pb, cache->indexA[i], cache->indexB[i]);
+            }
+            else
+            {
+                n = 1;
+                s[0] = makeVertex(pa, pb, 0, 0);
+            }
+
+            r.overlap = false;
+            r.iterations = 0;
+            T prevVV = std::numeric_limits<T>::max();
+            Vector3<T> v;
+            for (;;)
+            {
+                v = solveSimplex(s, n, r.weights);
+                T vv = v.dot(v);
+                T scale = 0;
+                for (int i = 0; i < n; ++i) scale = std::max(scale, s[i].w.dot(s[i].w));
+                if (n == 4 || vv <= relTol * relTol * scale) { r.overlap = true; break; }
+                if (vv >= prevVV || r.iterations >= 64) break; // no progress: rounding floor
+                prevVV = vv;
+
+                ++r.iterations;
+                uint32_t ia = pa.support(neg(v)), ib = pb.support(v);
+                bool duplicate = false;
+                for (int i = 0; i < n; ++i) duplicate |= s[i].ia == ia && s[i].ib == ib;
+                if (duplicate) break;
+                Vertex<T> w = makeVertex(pa, pb, ia, ib);
+                if (vv - v.dot(w.w) <= relTol * vv) break;
+                s[n++] = w;
+            }
+
+            if (cache)
+            {
+                cache->count = (uint32_t)n;
+                for (int i = 0; i < n; ++i) { cache->indexA[i] = s[i].ia; cache->indexB[i] = s[i].ib; }
+            }
+            r.pointA = r.pointB = Vector3<T>(0, 0, 0);
+            if (r.overlap) { r.distance = 0; return; }
+            for (int i = 0; i < n; ++i)
+            {
+                r.pointA += s[i].a * r.weights[i];
+                r.pointB += s[i].b * r.weights[i];
+            }
+            r.distance = std::sqrt(v.dot(v));
+        }
+
+        // Grows a GJK simplex that ended on the origin into a tetrahedron.
+        // Fails when the Minkowski difference is flat (crossed segments, say);
+        // flatNormal is then a direction the difference has no extent along.
+        template<typename PA, typename PB, typename T>
+        bool inflateSimplex(const PA& pa, const PB& pb, Vertex<T>* s, int& n, T tol, Vector3<T>& flatNormal)
+        {
+            flatNormal = Vector3<T>::up();
+            auto tryDir = [&](const Vector3<T>& d, auto&& accept) {
+                Vertex<T> w = makeVertex(pa, pb, pa.support(d), pb.support(neg(d)));
+                if (!accept(w.w)) return false;
+                s[n++] = w;
+                return true;
+            };
+            const Vector3<T> axes[3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+            if (n == 1)
+            {
+                auto farFromFirst = [&](const Vector3<T>& w) { return sub(w, s[0].w).lengthSquared() > tol * tol; };
+                for (int i = 0; i < 6 && n == 1; ++i) tryDir(i < 3 ? axes[i] : neg(axes[i - 3]), farFromFirst);
+            }
+            if (n == 2)
+            {
+                Vector3<T> ab = sub(s[1].w, s[0].w);
+                T ax = std::abs(ab.x), ay = std::abs(ab.y), az = std::abs(ab.z);
+                Vector3<T> p1 = ab.cross(axes[(ax <= ay && ax <= az) ? 0 : (ay <= az ? 1 : 2)]).normalized();
+                Vector3<T> p2 = ab.cross(p1).normalized();
+                auto offLine = [&](const Vector3<T>& w) { return ab.cross(sub(w, s[0].w)).lengthSquared() > tol * tol * ab.lengthSquared(); };
+                const Vector3<T> dirs[4] = { p1, neg(p1), p2, neg(p2) };
+                for (int i = 0; i < 4 && n == 2; ++i) tryDir(dirs[i], offLine);
+                flatNormal = p1;
+            }
+            if (n == 3)
+            {
+                Vector3<T> nrm = sub(s[1].w, s[0].w).cross(sub(s[2].w, s[0].w)).normalized();
+                auto offPlane = [&](const Vector3<T>& w) { return std::abs(nrm.dot(sub(w, s[0].w))) > tol; };
+                if (!tryDir(nrm, offPlane)) tryDir(neg(nrm), offPlane);
+                flatNormal = nrm;
+            }
+            return n == 4;
+        }
+
+        // Expanding polytope: grow the face closest to the origin until the
+        // support along its normal adds no more than tol.
+        template<typename PA, typename PB, typename T>
+        bool runEpa(const PA& pa, const PB& pb, const Vertex<T>* simplex, T tol, Contact<T>& out)
+        {
+            struct Face { uint32_t v[3]; Vector3<T> n; T d; };
+            std::vector<Vertex<T>> verts(simplex, simplex + 4);
+            std::vector<Face> faces;
+            std::vector<std::pair<uint32_t, uint32_t>> horizon;
+
+            auto addFace = [&](uint32_t a, uint32_t b, uint32_t c) {
+                Vector3<T> nrm = sub(verts[b].w, verts[a].w).cross(sub(verts[c].w, verts[a].w));
+                T len = nrm.length();
+                Face f{ { a, b, c }, nrm, std::numeric_limits<T>::max() };
+                if (len > 0) { f.n = nrm / len; f.d = f.n.dot(verts[a].w); }
+                faces.push_back(f);
+            };
+
+            Vector3<T> centroid = (verts[0].w + verts[1].w + verts[2].w + verts[3].w) * T(0.25);
+            const uint32_t tet[4][3] = { { 0, 1, 2 }, { 0, 3, 1 }, { 0, 2, 3 }, { 1, 3, 2 } };
+            for (const auto& t : tet)
+            {
+                Vector3<T> nrm = sub(verts[t[1]].w, verts[t[0]].w).cross(sub(verts[t[2]].w, verts[t[0]].w));
+                if (nrm.dot(sub(verts[t[0]].w, centroid)) < 0) addFace(t[0], t[2], t[1]);
+                else addFace(t[0], t[1], t[2]);
+            }
+
+            size_t closest = 0;
+            for (int iter = 0; iter < 64; ++iter)
+            {
+                closest = 0;
+                for (size_t i = 1; i < faces.size(); ++i)
+                    if (faces[i].d < faces[closest].d) closest = i;
+                const Face f = faces[closest];
+                if (f.d == std::numeric_limits<T>::max()) return false;
+
+                Vertex<T> w = makeVertex(pa, pb, pa.support(f.n), pb.support(neg(f.n)));
+                if (w.w.dot(f.n) - f.d <= tol) break;
+
+                // Remove every face the new point sees; their unshared edges form the horizon.
+                uint32_t wi = (uint32_t)verts.size();
+                verts.push_back(w);
+                horizon.clear();
+                for (size_t i = 0; i < faces.size();)
+                {
+                    if (faces[i].n.dot(sub(w.w, verts[faces[i].v[0]].w)) > 0)
+                    {
+                        for (int e = 0; e < 3; ++e)
+                        {
+                            std::pair<uint32_t, uint32_t> edge(faces[i].v[e], faces[i].v[(e + 1) % 3]);
+                            auto twin = std::find(horizon.begin(), horizon.end(), std::make_pair(edge.second, edge.first));
+                            if (twin != horizon.end()) horizon.erase(twin);
+                            else horizon.push_back(edge);
+                        }
+                        faces[i] = faces.back();
+                        faces.pop_back();
+                    }
+                    else ++i;
+                }
+                if (horizon.empty()) break;
+                for (const auto& e : horizon) addFace(e.first, e.second, wi);
+            }
+
+            for (size_t i = 1; i < faces.size(); ++i)
+                if (faces[i].d < faces[closest].d) closest = i;
+            const Face& f = faces[closest];
+
+            // Barycentrics of the origin's projection on the face give the witnesses.
+            Vertex<T> tri[3] = { verts[f.v[0]], verts[f.v[1]], verts[f.v[2]] };
+            for (Vertex<T>& v : tri) v.w = sub(v.w, f.n * f.d);
+            int tn = 3;
+            T l[3];
+            solveTriangle(tri, tn, l);
+            out.normal = f.n;
+            out.depth = std::max(f.d, T(0));
+            out.pointA = out.pointB = Vector3<T>(0, 0, 0);
+            for (int i = 0; i < tn; ++i)
+            {
+                out.pointA += tri[i].a * l[i];
+                out.pointB += tri[i].b * l[i];
+            }
+            return true;
+        }
+    }
+
+    // Distance between two placed shapes (radii included). With a cache, GJK
+    // starts from the simplex the previous call ended on and updates it.
+    template<typename ShapeA, typename ShapeB, typename T>
+    GjkResult<T> gjkDistance(const ShapeA& a, const Matrix4<T>& ma, const ShapeB& b, const Matrix4<T>& mb,
+                             GjkCache* cache = nullptr)
+    {
+        gjk::Placed<ShapeA, T> pa{ a, ma };
+        gjk::Placed<ShapeB, T> pb{ b, mb };
+        gjk::CoreResult<T> core{};
+        gjk::runGjk(pa, pb, cache, core);
+
+        GjkResult<T> r{ 0, core.pointA, core.pointB, true, core.iterations };
+        T ra = a.radius(), rb = b.radius();
+        if (core.overlap || core.distance <= ra + rb) return r;
+        Vector3<T> n = gjk::sub(core.pointB, core.pointA) / core.distance;
+        r.distance = core.distance - ra - rb;
+        r.pointA = core.pointA + n * ra;
+        r.pointB = core.pointB + n * -rb;
+        r.overlap = false;
+        return r;
+    }
+
+    // Penetration of two placed shapes. Returns false when they are apart;
+    // otherwise fills `out`, running EPA when the cores themselves overlap.
+    template<typename ShapeA, typename ShapeB, typename T>
+    bool collide(const ShapeA& a, const Matrix4<T>& ma, const ShapeB& b, const Matrix4<T>& mb, Contact<T>& out,
+                 GjkCache* cache = nullptr)
+    {
+        gjk::Placed<ShapeA, T> pa{ a, ma };
+        gjk::Placed<ShapeB, T> pb{ b, mb };
+        gjk::CoreResult<T> core{};
+        gjk::runGjk(pa, pb, cache, core);
+        T ra = a.radius(), rb = b.radius();
+
+        if (!core.overlap)
+        {
+            if (core.distance > ra + rb) return false;
+            Vector3<T> d = gjk::sub(core.pointB, core.pointA);
+            out.normal = core.distance > 0 ? d / core.distance : Vector3<T>::up();
+            out.depth = ra + rb - core.distance;
+        }
+        else
+        {
+            T scale = 0;
+            for (int i = 0; i < core.count; ++i) scale = std::max(scale, core.simplex[i].w.length());
+            T tol = std::max(scale, T(1)) * std::sqrt(std::numeric_limits<T>::epsilon());
+            Vector3<T> flat;
+            // Inflation appends vertices without weights; the fallback below
+            // only uses the ones GJK solved for.
+            const int solved = core.count;
+            if (!gjk::inflateSimplex(pa, pb, core.simplex, core.count, tol, flat) || !gjk::runEpa(pa, pb, core.simplex, tol, out))
+            {
+                // Cores cross without volume: zero core depth along the flat
+                // direction, turned to point from A's origin towards B's.
+                Vector3<T> ab(mb(0, 3) - ma(0, 3), mb(1, 3) - ma(1, 3), mb(2, 3) - ma(2, 3));
+                out.normal = flat.dot(ab) < 0 ? gjk::neg(flat) : flat;
+                out.depth = ra + rb;
+                out.pointA = out.pointB = Vector3<T>(0, 0, 0);
+                for (int i = 0; i < solved; ++i) out.pointA += core.simplex[i].a * core.weights[i];
+                out.pointB = out.pointA;
+            }
+            else out.depth += ra + rb;
+            core.pointA = out.pointA;
+            core.pointB = out.pointB;
+        }
+        out.pointA = core.pointA + out.normal * ra;
+        out.pointB = core.pointB + out.normal * -rb;
+        return true;
+    }
+}
@@ -0,0 +1,385 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include "vector2.hpp"
+#include "Vector3.hpp"
+#include "cpu_features.hpp"
+#include "simd_dispatch.hpp"
+
+// 64-bit pdep/pext only exist in x86-64 mode.
+#if defined(CPL_X86) && (defined(_M_X64) || defined(__x86_64__))
+#define CPL_HAS_PDEP 1
+#endif
+
+namespace CPL
+{
+    static_assert(sizeof(Vector2i) == 2 * sizeof(int32_t) && sizeof(Vector3i) == 3 * sizeof(int32_t),
+                  "integer vectors must be tightly packed");
+
+    // ─── Lattice distances ─────────────────────────────────
+
+    template<typename T>
+    inline T manhattan(const Vector2<T>& a, const Vector2<T>& b) { return std::abs(a.x - b.x) + std::abs(a.y - b.y); }
+
+    template<typename T>
+    inline T manhattan(const Vector3<T>& a, const Vector3<T>& b)
+    {
+        return std::abs(a.x - b.x) + std::abs(a.y - b.y) + std::abs(a.z - b.z);
+    }
+
+    template<typename T>
+    inline T chebyshev(const Vector2<T>& a, const Vector2<T>& b) { return std::max(std::abs(a.x - b.x), std::abs(a.y - b.y)); }
+
+    template<typename T>
+    inline T chebyshev(const Vector3<T>& a, const Vector3<T>& b)
+    {
+        return std::max({ std::abs(a.x - b.x), std::abs(a.y - b.y), std::abs(a.z - b.z) });
+    }
+
+    // ─── Tiles ─────────────────────────────────────────────
+
+    // Quotient and remainder rounding toward negative infinity, so cell -1 is
+    // in tile -1 at local offset size - 1 rather than in tile 0; b > 0.
+    inline int floorDiv(int a, int b) { return a / b - (a % b < 0 ? 1 : 0); }
+    inline int floorMod(int a, int b) { const int r = a % b; return r < 0 ? r + b : r; }
+
+    inline Vector2i tileOf(const Vector2i& cell, int tileSize) { return { floorDiv(cell.x, tileSize), floorDiv(cell.y, tileSize) }; }
+    inline Vector3i tileOf(const Vector3i& cell, int tileSize)
+    {
+        return { floorDiv(cell.x, tileSize), floorDiv(cell.y, tileSize), floorDiv(cell.z, tileSize) };
+    }
+
+    inline Vector2i cellInTile(const Vector2i& cell, int tileSize) { return { floorMod(cell.x, tileSize), floorMod(cell.y, tileSize) }; }
+    inline Vector3i cellInTile(const Vector3i& cell, int tileSize)
+    {
+        return { floorMod(cell.x, tileSize), floorMod(cell.y, tileSize), floorMod(cell.z, tileSize) };
+    }
+
+    // ─── Morton (Z-order) codes ────────────────────────────
+
+    // Bit interleaving, with pdep/pext when the CPU has BMI2 (checked at run
+    // time for the bulk versions, like F16C in half.hpp, and at compile time
+    // for the single-code ones). 2D keeps 32 bits per axis, 3D 21. Coordinates
+    // are taken as unsigned, so bias signed cells into range first.
+    namespace kernels
+    {
+        constexpr uint64_t MortonX2 = 0x5555555555555555ull, MortonY2 = MortonX2 << 1;
+        constexpr uint64_t MortonX3 = 0x1249249249249249ull, MortonY3 = MortonX3 << 1, MortonZ3 = MortonX3 << 2;
+
+        inline uint64_t spread2(uint64_t v)
+        {
+            v &= 0xffffffffull;
+            v = (v | (v << 16)) & 0x0000ffff0000ffffull;
+            v = (v | (v << 8)) & 0x00ff00ff00ff00ffull;
+            v = (v | (v << 4)) & 0x0f0f0f0f0f0f0f0full;
+            v = (v | (v << 2)) & 0x3333333333333333ull;
+            return (v | (v << 1)) & 0x5555555555555555ull;
+        }
+
+        inline uint32_t compact2(uint64_t v)
+        {
+            v &= 0x5555555555555555ull;
+            v = (v | (v >> 1)) & 0x3333333333333333ull;
+            v = (v | (v >> 2)) & 0x0f0f0f0f0f0f0f0full;
+            v = (v | (v >> 4)) & 0x00ff00ff00ff00ffull;
+            v = (v | (v >> 8)) & 0x0000ffff0000ffffull;
+            return (uint32_t)(v | (v >> 16));
+        }
+
+        inline uint64_t spread3(uint64_t v)
+        {
+            v &= 0x1fffff;
+            v = (v | (v << 32)) & 0x001f00000000ffffull;
+            v = (v | (v << 16)) & 0x001f0000ff0000ffull;
+            v = (v | (v << 8)) & 0x100f00f00f00f00full;
+            v = (v | (v << 4)) & 0x10c30c30c30c30c3ull;
+            return (v | (v << 2)) & 0x1249249249249249ull;
+        }
+
+        inline uint32_t compact3(uint64_t v)
+        {
+            v &= 0x1249249249249249ull;
+            v = (v | (v >> 2)) & 0x10c30c30c30c30c3ull;
+            v = (v | (v >> 4)) & 0x100f00f00f00f00full;
+            v = (v | (v >> 8)) & 0x001f0000ff0000ffull;
+            v = (v | (v >> 16)) & 0x001f00000000ffffull;
+            return (uint32_t)((v | (v >> 32)) & 0x1fffff);
+        }
+
+        inline bool useBMI2() { return SimdDispatch::tier() >= SimdTier::AVX2 && cpuFeatures().bmi2; }
+
+#if defined(CPL_HAS_PDEP)
+        CPL_TARGET_BMI2 inline void mortonEncode2BMI2(const Vector2i* in, uint64_t* out, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i)
+                out[i] = _pdep_u64((uint32_t)in[i].x, MortonX2) | _pdep_u64((uint32_t)in[i].y, MortonY2);
+        }
+
+        CPL_TARGET_BMI2 inline void mortonDecode2BMI2(const uint64_t* in, Vector2i* out, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i)
+                out[i] = Vector2i((int)(uint32_t)_pext_u64(in[i], MortonX2), (int)(uint32_t)_pext_u64(in[i], MortonY2));
+        }
+
+        CPL_TARGET_BMI2 inline void mortonEncode3BMI2(const Vector3i* in, uint64_t* out, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i)
+                out[i] = _pdep_u64((uint32_t)in[i].x, MortonX3) | _pdep_u64((uint32_t)in[i].y, MortonY3) |
+                         _pdep_u64((uint32_t)in[i].z, MortonZ3);
+        }
+
+        CPL_TARGET_BMI2 inline void mortonDecode3BMI2(const uint64_t* in, Vector3i* out, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i)
+                out[i] = Vector3i((int)_pext_u64(in[i], MortonX3), (int)_pext_u64(in[i], MortonY3), (int)_pext_u64(in[i], MortonZ3));
+        }
+#endif
+    }
+
+    inline uint64_t mortonEncode(const Vector2i& c)
+    {
+#if defined(__BMI2__) && defined(CPL_HAS_PDEP)
+        return _pdep_u64((uint32_t)c.x, kernels::MortonX2) | _pdep_u64((uint32_t)c.y, kernels::MortonY2);
+#else
+        return kernels::spread2((uint32_t)c.x) | (kernels::spread2((uint32_t)c.y) << 1);
+#endif
+    }
+
+    inline uint64_t mortonEncode(const Vector3i& c)
+    {
+#if defined(__BMI2__) && defined(CPL_HAS_PDEP)
+        return _pdep_u64((uint32_t)c.x, kernels::MortonX3) | _pdep_u64((uint32_t)c.y, kernels::MortonY3) |
+               _pdep_u64((uint32_t)c.z, kernels::MortonZ3);
+#else
+        return kernels::spread3((uint32_t)c.x) | (kernels::spread3((uint32_t)c.y) << 1) | (kernels::spread3((uint32_t)c.z) << 2);
+#endif
+    }
+
+    inline Vector2i mortonDecode2(uint64_t code)
+    {
+#if defined(__BMI2__) && defined(CPL_HAS_PDEP)
+        return Vector2i((int)(uint32_t)_pext_u64(code, kernels::MortonX2), (int)(uint32_t)_pext_u64(code, kernels::MortonY2));
+#else
+        return Vector2i((int)kernels::compact2(code), (int)kernels::compact2(code >> 1));
+#endif
+    }
+
+    inline Vector3i mortonDecode3(uint64_t code)
+    {
+#if defined(__BMI2__) && defined(CPL_HAS_PDEP)
+        return Vector3i((int)_pext_u64(code, kernels::MortonX3), (int)_pext_u64(code, kernels::MortonY3),
+                        (int)_pext_u64(code, kernels::MortonZ3));
+#else
+        return Vector3i((int)kernels::compact3(code), (int)kernels::compact3(code >> 1), (int)kernels::compact3(code >> 2));
+#endif
+    }
+
+    // Bulk versions pick pdep/pext at run time.
+    inline void mortonEncode(const Vector2i* in, uint64_t* out, size_t n)
+    {
+#if defined(CPL_HAS_PDEP)
+        if (kernels::useBMI2()) { kernels::mortonEncode2BMI2(in, out, n); return; }
+#endif
+        for (size_t i = 0; i < n; ++i) out[i] = kernels::spread2((uint32_t)in[i].x) | (kernels::spread2((uint32_t)in[i].y) << 1);
+    }
+
+    inline void mortonEncode(const Vector3i* in, uint64_t* out, size_t n)
+    {
+#if defined(CPL_HAS_PDEP)
+        if (kernels::useBMI2()) { kernels::mortonEncode3BMI2(in, out, n); return; }
+#endif
+        for (size_t i = 0; i < n; ++i)
+            out[i] = kernels::spread3((uint32_t)in[i].x) | (kernels::spread3((uint32_t)in[i].y) << 1) |
+                     (kernels::spread3((uint32_t)in[i].z) << 2);
+    }
+
+    inline void mortonDecode(const uint64_t* in, Vector2i* out, size_t n)
+    {
+#if defined(CPL_HAS_PDEP)
+        if (kernels::useBMI2()) { kernels::mortonDecode2BMI2(in, out, n); return; }
+#endif
+        for (size_t i = 0; i < n; ++i) out[i] = Vector2i((int)kernels::compact2(in[i]), (int)kernels::compact2(in[i] >> 1));
+    }
+
+    inline void mortonDecode(const uint64_t* in, Vector3i* out, size_t n)
+    {
+#if defined(CPL_HAS_PDEP)
+        if (kernels::useBMI2()) { kernels::mortonDecode3BMI2(in, out, n); return; }
+#endif
+        for (size_t i = 0; i < n; ++i)
+            out[i] = Vector3i((int)kernels::compact3(in[i]), (int)kernels::compact3(in[i] >> 1), (int)kernels::compact3(in[i] >> 2));
+    }
+
+    // ─── Points to cells ───────────────────────────────────
+
+    // A uniform grid of dims cells of cellSize from origin. Cell c covers
+    // [origin + c * cellSize, origin + (c + 1) * cellSize). Every path
+    // computes floor((p - origin) * (1 / cellSize)) with the same two IEEE
+    // operations, so the scalar and SIMD results agree exactly.
+    template<typename V, typename C>
+    struct UniformGrid
+    {
+        V     origin;
+        float cellSize = 1;
+        C     dims;
+    };
+
+    using Grid2 = UniformGrid<Vector2f, Vector2i>;
+    using Grid3 = UniformGrid<Vector3f, Vector3i>;
+
+    namespace kernels
+    {
+        inline int cellCoord(float p, float origin, float invCell) { return (int)std::floor((p - origin) * invCell); }
+
+        // Clamped into [0, dim - 1] before the conversion, so far-away points
+        // land on the border cell instead of overflowing.
+        inline int clampedCellCoord(float p, float origin, float invCell, int dim)
+        {
+            const float c = std::floor((p - origin) * invCell);
+            return (int)std::min(std::max(c, 0.0f), (float)(dim - 1));
+        }
+
+#if defined(CPL_X86)
+        CPL_TARGET_AVX2 inline __m256i cellCoordAVX2(__m256 p, __m256 origin, __m256 invCell)
+        {
+            return _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(_mm256_sub_ps(p, origin), invCell)));
+        }
+
+        CPL_TARGET_AVX2 inline __m256i clampedCellCoordAVX2(__m256 p, __m256 origin, __m256 invCell, __m256 maxCell)
+        {
+            const __m256 c = _mm256_floor_ps(_mm256_mul_ps(_mm256_sub_ps(p, origin), invCell));
+            return _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(c, _mm256_setzero_ps()), maxCell));
+        }
+
+        // Interleaved x, y streams are elementwise: one (ox, oy, ox, oy, ...) register.
+        CPL_TARGET_AVX2 inline size_t cellsOfAVX2(const Vector2f* in, Vector2i* out, size_t n, const Grid2& g)
+        {
+            const float* f = &in->x;
+            const __m256 origin = _mm256_setr_ps(g.origin.x, g.origin.y, g.origin.x, g.origin.y,
+                                                 g.origin.x, g.origin.y, g.origin.x, g.origin.y);
+            const __m256 inv = _mm256_set1_ps(1 / g.cellSize);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+                _mm256_storeu_si256((__m256i*)&out[i].x, cellCoordAVX2(_mm256_loadu_ps(f + i * 2), origin, inv));
+            return i;
+        }
+
+        // x, y, z streams repeat every 24 floats, as in the vertex encoders.
+        CPL_TARGET_AVX2 inline size_t cellsOfAVX2(const Vector3f* in, Vector3i* out, size_t n, const Grid3& g)
+        {
+            const float* f = &in->x;
+            const float o[3] = { g.origin.x, g.origin.y, g.origin.z };
+            __m256 origin[3];
+            for (int r = 0; r < 3; ++r)
+            {
+                float lanes[8];
+                for (int l = 0; l < 8; ++l) lanes[l] = o[(r * 8 + l) % 3];
+                origin[r] = _mm256_loadu_ps(lanes);
+            }
+            const __m256 inv = _mm256_set1_ps(1 / g.cellSize);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+                for (int r = 0; r < 3; ++r)
+                    _mm256_storeu_si256((__m256i*)(&out[i].x + r * 8), cellCoordAVX2(_mm256_loadu_ps(f + i * 3 + r * 8), origin[r], inv));
+            return i;
+        }
+
+        CPL_TARGET_AVX2 inline size_t cellIndicesAVX2(const Vector2f* in, uint32_t* out, size_t n, const Grid2& g)
+        {
+            const __m256 ox = _mm256_set1_ps(g.origin.x), oy = _mm256_set1_ps(g.origin.y), inv = _mm256_set1_ps(1 / g.cellSize);
+            const __m256 maxX = _mm256_set1_ps((float)(g.dims.x - 1)), maxY = _mm256_set1_ps((float)(g.dims.y - 1));
+            const __m256i dimX = _mm256_set1_epi32(g.dims.x);
+            const float* f = &in->x;
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                const __m256 a = _mm256_loadu_ps(f + i * 2), b = _mm256_loadu_ps(f + i * 2 + 8);
+                // Deinterleaving within lanes leaves points in 0 1 4 5 | 2 3 6 7
+                // order; one 64-bit permute on the result restores it.
+                const __m256i cx = clampedCellCoordAVX2(_mm256_shuffle_ps(a, b, 0x88), ox, inv, maxX);
+                const __m256i cy = clampedCellCoordAVX2(_mm256_shuffle_ps(a, b, 0xDD), oy, inv, maxY);
+                const __m256i idx = _mm256_add_epi32(cx, _mm256_mullo_epi32(cy, dimX));
+                _mm256_storeu_si256((__m256i*)(out + i), _mm256_permute4x64_epi64(idx, 0xD8));
+            }
+            return i;
+        }
+
+        CPL_TARGET_AVX2 inline size_t cellIndicesAVX2(const Vector3f* in, uint32_t* out, size_t n, const Grid3& g)
+        {
+            const __m256 ox = _mm256_set1_ps(g.origin.x), oy = _mm256_set1_ps(g.origin.y), oz = _mm256_set1_ps(g.origin.z);
+            const __m256 inv = _mm256_set1_ps(1 / g.cellSize);
+            const __m256 maxX = _mm256_set1_ps((float)(g.dims.x - 1)), maxY = _mm256_set1_ps((float)(g.dims.y - 1)),
+                         maxZ = _mm256_set1_ps((float)(g.dims.z - 1));
+            const __m256i dimX = _mm256_set1_epi32(g.dims.x), dimY = _mm256_set1_epi32(g.dims.y);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                __m256 x, y, z;
+                load3(in + i, x, y, z);
+                const __m256i cx = clampedCellCoordAVX2(x, ox, inv, maxX), cy = clampedCellCoordAVX2(y, oy, inv, maxY),
+                              cz = clampedCellCoordAVX2(z, oz, inv, maxZ);
+                const __m256i idx = _mm256_add_epi32(cx, _mm256_mullo_epi32(_mm256_add_epi32(cy, _mm256_mullo_epi32(cz, dimY)), dimX));
+                _mm256_storeu_si256((__m256i*)(out + i), idx);
+            }
+            return i;
+        }
+#endif
+    }
+
+    // Cell coordinates of each point, unclamped; the cells must fit an int.
+    inline void cellsOf(const Vector2f* in, Vector2i* out, size_t n, const Grid2& g)
+    {
+        size_t i = 0;
+#if defined(CPL_X86)
+        if (SimdDispatch::tier() >= SimdTier::AVX2) i = kernels::cellsOfAVX2(in, out, n, g);
+#endif
+        const float inv = 1 / g.cellSize;
+        for (; i < n; ++i)
+            out[i] = Vector2i(kernels::cellCoord(in[i].x, g.origin.x, inv), kernels::cellCoord(in[i].y, g.origin.y, inv));
+    }
+
+    inline void cellsOf(const Vector3f* in, Vector3i* out, size_t n, const Grid3& g)
+    {
+        size_t i = 0;
+#if defined(CPL_X86)
+        if (SimdDispatch::tier() >= SimdTier::AVX2) i = kernels::cellsOfAVX2(in, out, n, g);
+#endif
+        const float inv = 1 / g.cellSize;
+        for (; i < n; ++i)
+            out[i] = Vector3i(kernels::cellCoord(in[i].x, g.origin.x, inv), kernels::cellCoord(in[i].y, g.origin.y, inv),
+                              kernels::cellCoord(in[i].z, g.origin.z, inv));
+    }
+
+    // Row-major index x + dims.x * (y + dims.y * z) of each point's cell,
+    // clamped to the grid.
+    inline void cellIndices(const Vector2f* in, uint32_t* out, size_t n, const Grid2& g)
+    {
+        size_t i = 0;
+#if defined(CPL_X86)
+        if (SimdDispatch::tier() >= SimdTier::AVX2) i = kernels::cellIndicesAVX2(in, out, n, g);
+#endif
+        const float inv = 1 / g.cellSize;
+        for (; i < n; ++i)
+            out[i] = (uint32_t)(kernels::clampedCellCoord(in[i].x, g.origin.x, inv, g.dims.x) +
+                                g.dims.x * kernels::clampedCellCoord(in[i].y, g.origin.y, inv, g.dims.y));
+    }
+
+    inline void cellIndices(const Vector3f* in, uint32_t* out, size_t n, const Grid3& g)
+    {
+        size_t i = 0;
+#if defined(CPL_X86)
+        if (SimdDispatch::tier() >= SimdTier::AVX2) i = kernels::cellIndicesAVX2(in, out, n, g);
+#endif
+        const float inv = 1 / g.cellSize;
+        for (; i < n; ++i)
+        {
+            const int x = kernels::clampedCellCoord(in[i].x, g.origin.x, inv, g.dims.x);
+            const int y = kernels::clampedCellCoord(in[i].y, g.origin.y, inv, g.dims.y);
+            const int z = kernels::clampedCellCoord(in[i].z, g.origin.z, inv, g.dims.z);
+            out[i] = (uint32_t)(x + g.dims.x * (y + g.dims.y * z));
+        }
+    }
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "cpu_features.hpp"
+#include "simd_dispatch.hpp"
+#include "vector2.hpp"
+#include "Vector3.hpp"
+#include "matrix4.hpp"
+
+namespace CPL
+{
+    // IEEE 754 binary16 <-> binary32. Rounds to nearest even and handles
+    // subnormals and infinities like F16C's vcvtps2ph / vcvtph2ps, so the
+    // scalar and bulk paths agree bit for bit on every non-NaN value.
+    inline uint16_t floatToHalf(float value)
+    {
+        uint32_t f;
+        std::memcpy(&f, &value, sizeof(f));
+        const uint32_t sign = (f >> 16) & 0x8000;
+        f &= 0x7fffffff;
+        uint32_t h;
+        if (f >= 0x47800000)                 // >= 65536: infinity, or NaN kept quiet
+            h = f > 0x7f800000 ? 0x7e00 | ((f >> 13) & 0x3ff) : 0x7c00;
+        else if (f < 0x38800000)             // below 2^-14: subnormal half
+        {
+            // Adding 0.5 lines the half's subnormal bits up with the float's
+            // mantissa LSBs; the FPU does the rounding.
+            const uint32_t magicBits = 126u << 23;
+            float magic, sum;
+            std::memcpy(&magic, &magicBits, sizeof(magic));
+            std::memcpy(&sum, &f, sizeof(sum));
+            sum += magic;
+            std::memcpy(&h, &sum, sizeof(h));
+            h -= magicBits;
+        }
+        else
+        {
+            // Rebias the exponent and round the 13 dropped bits to nearest even;
+            // a carry out of the mantissa correctly bumps the exponent.
+            h = (f + (uint32_t(15 - 127) << 23) + 0xfff + ((f >> 13) & 1)) >> 13;
+        }
+        return (uint16_t)(h | sign);
+    }
+
+    inline float halfToFloat(uint16_t half)
+    {
+        const uint32_t exponentMask = 0x7c00u << 13;
+        uint32_t f = (uint32_t)(half & 0x7fff) << 13;
+        const uint32_t exponent = f & exponentMask;
+        f += uint32_t(127 - 15) << 23;
+        float out;
+        if (exponent == exponentMask)        // infinity / NaN
+            f += uint32_t(128 - 16) << 23;
+        else if (exponent == 0)              // zero / subnormal: renormalize through the FPU
+        {
+            const uint32_t magicBits = 113u << 23;
+            float magic;
+            std::memcpy(&magic, &magicBits, sizeof(magic));
+            f += 1u << 23;
+            std::memcpy(&out, &f, sizeof(out));
+            out -= magic;
+            std::memcpy(&f, &out, sizeof(f));
+        }
+        f |= (uint32_t)(half & 0x8000) << 16;
+        std::memcpy(&out, &f, sizeof(out));
+        return out;
+    }
+
+    // Bulk conversions, 8 values per instruction with F16C (checked at run
+    // time and only used from the AVX2 tier up, so forceTier() still
+    // selects the scalar path).
+    namespace kernels
+    {
+        inline bool useF16C() { return SimdDispatch::tier() >= SimdTier::AVX2 && cpuFeatures().f16c; }
+
+#if defined(CPL_X86)
+        CPL_TARGET_F16C inline size_t floatsToHalvesF16C(const float* in, uint16_t* out, size_t n)
+        {
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+                _mm_storeu_si128((__m128i*)(out + i), _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+            return i;
+        }
+
+        CPL_TARGET_F16C inline size_t halvesToFloatsF16C(const uint16_t* in, float* out, size_t n)
+        {
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+                _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(in + i))));
+            return i;
+        }
+#endif
+    }
+
+    inline void floatsToHalves(const float* in, uint16_t* out, size_t n)
+    {
+        size_t i = 0;
+#if defined(CPL_X86)
+        if (kernels::useF16C()) i = kernels::floatsToHalvesF16C(in, out, n);
+#endif
+        for (; i < n; ++i) out[i] = floatToHalf(in[i]);
+    }
+
+    inline void halvesToFloats(const uint16_t* in, float* out, size_t n)
+    {
+        size_t i = 0;
+#if defined(CPL_X86)
+        if (kernels::useF16C()) i = kernels::halvesToFloatsF16C(in, out, n);
+#endif
+        for (; i < n; ++i) out[i] = halfToFloat(in[i]);
+    }
+
+    // binary16 storage scalar. Every operation goes through float: operands
+    // convert on read and the result rounds once when stored back, so
+    // Vector3<half> computes like Vector3f at half the memory.
+    class half
+    {
+    public:
+        uint16_t bits;
+
+        half() = default;
+#if defined(__F16C__)
+        // Built for an F16C target: single-value vcvtps2ph / vcvtph2ps.
+        half(float value) : bits((uint16_t)_cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT)) {}
+        operator float() const { return _cvtsh_ss(bits); }
+#else
+        half(float value) : bits(floatToHalf(value)) {}
+        operator float() const { return halfToFloat(bits); }
+#endif
+
+        static half fromBits(uint16_t b) { half h; h.bits = b; return h; }
+
+        half& operator+=(float v) { return *this = float(*this) + v; }
+        half& operator-=(float v) { return *this = float(*this) - v; }
+        half& operator*=(float v) { return *this = float(*this) * v; }
+        half& operator/=(float v) { return *this = float(*this) / v; }
+    };
+
+    using Vector2h = Vector2<half>;
+    using Vector3h = Vector3<half>;
+    using Matrix4h = Matrix4<half>;
+
+    static_assert(sizeof(Vector3h) == 3 * sizeof(uint16_t), "Vector3h must be tightly packed");
+
+    // Vector3f <-> Vector3h arrays as one 3n-scalar stream, F16C when available.
+    inline void packHalf(const Vector3f* in, Vector3h* out, size_t n) { floatsToHalves(&in->x, &out->x.bits, n * 3); }
+    inline void unpackHalf(const Vector3h* in, Vector3f* out, size_t n) { halvesToFloats(&in->x.bits, &out->x, n * 3); }
+}
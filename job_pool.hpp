@@ -0,0 +1,159 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CPL
+{
+    // Fixed set of worker threads running fork/join loops. Work is split into
+    // chunks of `grain` items whose boundaries depend only on (count, grain),
+    // never on the thread count, so per-chunk results combine deterministically.
+    // The calling thread works too; nested calls from inside a task run inline.
+    class JobPool
+    {
+    public:
+        // `threads` counts the caller, so JobPool(1) never spawns anything.
+        explicit JobPool(unsigned threads = std::thread::hardware_concurrency())
+        {
+            if (threads == 0) threads = 1;
+            for (unsigned i = 1; i < threads; ++i)
+                workers.emplace_back([this] { workerLoop(); });
+        }
+
+        ~JobPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (auto& t : workers) t.join();
+        }
+
+        JobPool(const JobPool&) = delete;
+        JobPool& operator=(const JobPool&) = delete;
+
+        unsigned threadCount() const { return (unsigned)workers.size() + 1; }
+
+        static size_t chunkCount(size_t count, size_t grain)
+        {
+            grain = std::max<size_t>(grain, 1);
+            return (count + grain - 1) / grain;
+        }
+
+        // fn(chunkIndex, begin, end) for every chunk of [0, count).
+        template<typename F>
+        void parallelChunks(size_t count, size_t grain, F&& fn)
+        {
+            grain = std::max<size_t>(grain, 1);
+            const size_t chunks = chunkCount(count, grain);
+            auto runChunk = [&](size_t c) {
+                size_t begin = c * grain;
+                fn(c, begin, std::min(count, begin + grain));
+            };
+
+            if (chunks <= 1 || workers.empty() || insideTask())
+            {
+                for (size_t c = 0; c < chunks; ++c) runChunk(c);
+                return;
+            }
+
+            std::lock_guard<std::mutex> submit(submitMutex);
+            std::function<void(size_t)> job = runChunk;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                task = &job;
+                taskChunks = chunks;
+                nextChunk.store(0, std::memory_order_relaxed);
+                finishedChunks.store(0, std::memory_order_relaxed);
+                ++generation;
+            }
+            wake.notify_all();
+
+            runChunks();
+
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [&] {
+                return finishedChunks.load(std::memory_order_acquire) == taskChunks && activeWorkers == 0;
+            });
+            task = nullptr;
+        }
+
+        // fn(begin, end) over [0, count) in chunks of `grain`.
+        template<typename F>
+        void parallelFor(size_t count, size_t grain, F&& fn)
+        {
+            parallelChunks(count, grain, [&](size_t, size_t begin, size_t end) { fn(begin, end); });
+        }
+
+        // Shared pool sized to the machine.
+        static JobPool& global()
+        {
+            static JobPool pool;
+            return pool;
+        }
+
+    private:
+        std::vector<std::thread>          workers;
+        std::mutex                        mutex;
+        std::mutex                        submitMutex;
+        std::condition_variable           wake;
+        std::condition_variable           done;
+        const std::function<void(size_t)>* task = nullptr;
+        size_t                            taskChunks = 0;
+        std::atomic<size_t>               nextChunk{ 0 };
+        std::atomic<size_t>               finishedChunks{ 0 };
+        unsigned                          activeWorkers = 0;
+        unsigned long long                generation = 0;
+        bool                              stopping = false;
+
+        static bool& insideTask()
+        {
+            static thread_local bool inside = false;
+            return inside;
+        }
+
+        void runChunks()
+        {
+            bool& inside = insideTask();
+            bool wasInside = inside;
+            inside = true;
+            for (size_t c; (c = nextChunk.fetch_add(1, std::memory_order_relaxed)) < taskChunks;)
+            {
+                (*task)(c);
+                if (finishedChunks.fetch_add(1, std::memory_order_acq_rel) + 1 == taskChunks)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    done.notify_all();
+                }
+            }
+            inside = wasInside;
+        }
+
+        void workerLoop()
+        {
+            unsigned long long seen = 0;
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&] { return stopping || (generation != seen && task); });
+                    if (stopping) return;
+                    seen = generation;
+                    ++activeWorkers;
+                }
+                runChunks();
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    --activeWorkers;
+                }
+                done.notify_all();
+            }
+        }
+    };
+}
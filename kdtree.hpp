@@ -0,0 +1,211 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "Vector3.hpp"
+#include "job_pool.hpp"
+
+namespace CPL
+{
+    // Static k-d tree stored implicitly in one permuted point array. A range
+    // [b, e) longer than LeafSize splits at its median m = (b + e) / 2 along
+    // axes[m]: [b, m) lies on the low side, (m, e) on the high side. Shorter
+    // ranges are leaves and get scanned linearly, so no node structs exist.
+    template<typename T>
+    class KdTree
+    {
+    public:
+        static constexpr uint32_t LeafSize = 8;
+        static constexpr uint32_t None = 0xFFFFFFFFu;
+
+        KdTree() = default;
+        KdTree(const Vector3<T>* points, size_t n, JobPool& pool = JobPool::global()) { build(points, n, pool); }
+
+        size_t size() const { return pts.size(); }
+
+        // The top of the tree is split serially until there are enough
+        // independent subtrees to hand one to each job.
+        void build(const Vector3<T>* points, size_t n, JobPool& pool = JobPool::global())
+        {
+            // Points travel with their ids during the build so nth_element
+            // touches contiguous memory instead of chasing indices.
+            std::vector<Entry> entries(n);
+            pool.parallelFor(n, 1 << 14, [&](size_t b, size_t e) {
+                for (size_t i = b; i < e; ++i) entries[i] = { points[i], (uint32_t)i };
+            });
+            axes.assign(n, 0);
+
+            std::vector<std::pair<uint32_t, uint32_t>> ranges{ { 0u, (uint32_t)n } }, next;
+            const size_t wanted = size_t(pool.threadCount()) * 8;
+            while (ranges.size() < wanted)
+            {
+                bool split = false;
+                next.clear();
+                for (auto r : ranges)
+                {
+                    if (r.second - r.first <= LeafSize) { next.push_back(r); continue; }
+                    uint32_t m = splitRange(entries.data(), r.first, r.second);
+                    next.push_back({ r.first, m });
+                    next.push_back({ m + 1, r.second });
+                    split = true;
+                }
+                ranges.swap(next);
+                if (!split) break;
+            }
+
+            pool.parallelFor(ranges.size(), 1, [&](size_t b, size_t e) {
+                for (size_t i = b; i < e; ++i) buildRange(entries.data(), ranges[i].first, ranges[i].second);
+            });
+
+            pts.resize(n);
+            ids.resize(n);
+            pool.parallelFor(n, 1 << 14, [&](size_t b, size_t e) {
+                for (size_t i = b; i < e; ++i) { pts[i] = entries[i].p; ids[i] = entries[i].id; }
+            });
+        }
+
+        // Index of the closest point (None when empty); distance squared in dist2.
+        uint32_t nearest(const Vector3<T>& q, T* dist2 = nullptr) const
+        {
+            uint32_t best = None;
+            T bestD2 = std::numeric_limits<T>::max();
+            search(q, [&](uint32_t i, T d2) {
+                if (d2 < bestD2 || (d2 == bestD2 && best != None && ids[i] < ids[best])) { bestD2 = d2; best = i; }
+                return bestD2;
+            });
+            if (dist2) *dist2 = bestD2;
+            return best == None ? None : ids[best];
+        }
+
+        // Up to k closest original indices, nearest first, ties by index.
+        size_t kNearest(const Vector3<T>& q, size_t k, uint32_t* out, T* outDist2 = nullptr) const
+        {
+            if (k == 0) return 0;
+            // Sorted insertion into a small buffer beats a heap for typical k.
+            std::vector<std::pair<T, uint32_t>> best;
+            best.reserve(k + 1);
+            search(q, [&](uint32_t i, T d2) {
+                std::pair<T, uint32_t> hit{ d2, ids[i] };
+                if (best.size() < k || hit < best.back())
+                {
+                    best.insert(std::upper_bound(best.begin(), best.end(), hit), hit);
+                    if (best.size() > k) best.pop_back();
+                }
+                return best.size() < k ? std::numeric_limits<T>::max() : best.back().first;
+            });
+            for (size_t i = 0; i < best.size(); ++i)
+            {
+                out[i] = best[i].second;
+                if (outDist2) outDist2[i] = best[i].first;
+            }
+            return best.size();
+        }
+
+        // Many queries at once, split across the pool.
+        void nearestBatch(const Vector3<T>* queries, size_t n, uint32_t* outIdx, T* outDist2 = nullptr,
+                          JobPool& pool = JobPool::global()) const
+        {
+            pool.parallelFor(n, 256, [&](size_t b, size_t e) {
+                for (size_t i = b; i < e; ++i) outIdx[i] = nearest(queries[i], outDist2 ? outDist2 + i : nullptr);
+            });
+        }
+
+        // Row i of `out` (k entries) holds the neighbours of queries[i]; unused
+        // slots, when fewer than k points exist, are set to None.
+        void kNearestBatch(const Vector3<T>* queries, size_t n, size_t k, uint32_t* out,
+                           JobPool& pool = JobPool::global()) const
+        {
+            pool.parallelFor(n, 128, [&](size_t b, size_t e) {
+                for (size_t i = b; i < e; ++i)
+                {
+                    size_t got = kNearest(queries[i], k, out + i * k);
+                    std::fill(out + i * k + got, out + (i + 1) * k, None);
+                }
+            });
+        }
+
+    private:
+        std::vector<Vector3<T>> pts;
+        std::vector<uint32_t>   ids;
+        std::vector<uint8_t>    axes;
+
+        static T axisOf(const Vector3<T>& p, int a) { return a == 0 ? p.x : (a == 1 ? p.y : p.z); }
+
+        struct Entry { Vector3<T> p; uint32_t id; };
+
+        // Median split on the widest axis of the range; returns the median index.
+        uint32_t splitRange(Entry* entries, uint32_t b, uint32_t e)
+        {
+            Vector3<T> lo = entries[b].p, hi = lo;
+            for (uint32_t i = b + 1; i < e; ++i)
+            {
+                const Vector3<T>& p = entries[i].p;
+                lo = { std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z) };
+                hi = { std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z) };
+            }
+            T ex = hi.x - lo.x, ey = hi.y - lo.y, ez = hi.z - lo.z;
+            int a = (ex >= ey && ex >= ez) ? 0 : (ey >= ez ? 1 : 2);
+
+            uint32_t m = b + (e - b) / 2;
+            std::nth_element(entries + b, entries + m, entries + e, [a](const Entry& i, const Entry& j) {
+                return axisOf(i.p, a) < axisOf(j.p, a);
+            });
+            axes[m] = (uint8_t)a;
+            return m;
+        }
+
+        void buildRange(Entry* entries, uint32_t b, uint32_t e)
+        {
+            while (e - b > LeafSize)
+            {
+                uint32_t m = splitRange(entries, b, e);
+                if (m - b > e - m - 1) { buildRange(entries, m + 1, e); e = m; }
+                else                   { buildRange(entries, b, m); b = m + 1; }
+            }
+        }
+
+        // visit(slot, d2) returns the current pruning radius squared.
+        template<typename Visit>
+        void search(const Vector3<T>& q, Visit&& visit) const
+        {
+            if (pts.empty()) return;
+            struct Item { uint32_t b, e; T minD2; };
+            Item stack[64];
+            int top = 0;
+            stack[top++] = { 0u, (uint32_t)pts.size(), T(0) };
+            T bound = std::numeric_limits<T>::max();
+
+            while (top > 0)
+            {
+                Item it = stack[--top];
+                if (it.minD2 > bound) continue;
+
+                while (it.e - it.b > LeafSize)
+                {
+                    uint32_t m = it.b + (it.e - it.b) / 2;
+                    int a = axes[m];
+                    T diff = axisOf(q, a) - axisOf(pts[m], a);
+                    const Vector3<T>& p = pts[m];
+                    T dx = p.x - q.x, dy = p.y - q.y, dz = p.z - q.z;
+                    bound = visit(m, dx * dx + dy * dy + dz * dz);
+
+                    // Descend the near side now, defer the far side.
+                    Item nearSide = diff < 0 ? Item{ it.b, m, it.minD2 } : Item{ m + 1, it.e, it.minD2 };
+                    Item farSide = diff < 0 ? Item{ m + 1, it.e, diff * diff } : Item{ it.b, m, diff * diff };
+                    if (farSide.minD2 <= bound && farSide.e > farSide.b) stack[top++] = farSide;
+                    it = nearSide;
+                }
+                for (uint32_t i = it.b; i < it.e; ++i)
+                {
+                    const Vector3<T>& p = pts[i];
+                    T dx = p.x - q.x, dy = p.y - q.y, dz = p.z - q.z;
+                    bound = visit(i, dx * dx + dy * dy + dz * dz);
+                }
+            }
+        }
+    };
+
+    using KdTreef = KdTree<float>;
+    using KdTreed = KdTree<double>;
+}
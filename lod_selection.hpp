@@ -0,0 +1,244 @@
+#pragma once
+#include <algorithm>
+#include <bitset>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "Vector3.hpp"
+#include "matrix4.hpp"
+#include "simd_dispatch.hpp"
+#include "job_pool.hpp"
+
+namespace CPL
+{
+    struct LodStats
+    {
+        size_t instances = 0;
+        size_t changed = 0;      // instances whose LOD differs from the previous select()
+        double selectMs = 0;
+    };
+
+    // LOD choice for many instances from the screen coverage of their
+    // bounding spheres: the projected diameter over the viewport height,
+    // radius * P(1, 1) / distance to the camera. Distance rather than view
+    // depth keeps the choice stable while the camera turns.
+    //
+    // thresholds[k] is the smallest coverage that still gets LOD k, so they
+    // descend; anything below the last is dropped (LOD index lodCount).
+    // Hysteresis: a finer LOD needs coverage (1 + h) times its threshold,
+    // a coarser one waits until coverage falls below (1 - h) times the
+    // current one, so instances near a threshold do not flicker.
+    //
+    // select() works on SoA spheres in chunks across the job pool, 8 at a
+    // time on the AVX2 tier, and then compacts instance indices into one
+    // list per LOD, in index order for any thread count.
+    class LodSelector
+    {
+    public:
+        static constexpr int MaxLods = 8;
+
+        LodSelector(const float* thresholds, int lodCount, float hysteresis = 0.1f)
+            : lodCount(std::min(lodCount, MaxLods)), hysteresis(hysteresis)
+        {
+            std::copy(thresholds, thresholds + this->lodCount, this->thresholds);
+        }
+
+        int levels() const { return lodCount; }
+        size_t size() const { return count; }
+
+        void reserve(size_t n) { if (n > capacity) relayout(n); }
+
+        // New instances start at the dropped level and move to their LOD on
+        // the next select(), under the same hysteresis rule.
+        uint32_t add(const Vector3f& center, float radius)
+        {
+            if (count == capacity) relayout(capacity ? capacity * 2 : 1024);
+            setSphere((uint32_t)count, center, radius);
+            lods.push_back((uint8_t)lodCount);
+            return (uint32_t)count++;
+        }
+
+        void setSphere(uint32_t i, const Vector3f& center, float radius)
+        {
+            data[CX * stride + i] = center.x;
+            data[CY * stride + i] = center.y;
+            data[CZ * stride + i] = center.z;
+            data[Radius * stride + i] = radius;
+        }
+
+        // Coverage with the same formula select() uses.
+        static float coverage(const Vector3f& center, float radius, const Vector3f& eye, float p11)
+        {
+            float dx = center.x - eye.x, dy = center.y - eye.y, dz = center.z - eye.z;
+            float d2 = dx * dx + dy * dy + dz * dz;
+            return d2 > 0 ? radius * p11 / std::sqrt(d2) : std::numeric_limits<float>::infinity();
+        }
+
+        // `view` must be rigid (plus uniform scale), `projection` a perspective.
+        void select(const Matrix4f& view, const Matrix4f& projection, JobPool& pool = JobPool::global())
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            Matrix4f inv = view.inverseTRS();
+            Params p;
+            p.eye[0] = inv(0, 3); p.eye[1] = inv(1, 3); p.eye[2] = inv(2, 3);
+            p.p11 = projection(1, 1);
+            for (int k = 0; k < lodCount; ++k)
+            {
+                p.finer[k] = thresholds[k] * (1 + hysteresis);
+                p.coarser[k] = thresholds[k] * (1 - hysteresis);
+            }
+            p.levels = lodCount;
+
+            const size_t chunks = JobPool::chunkCount(count, Grain);
+            const size_t bins = lodCount + 1;
+            chunkCounts.assign(chunks * (bins + 1), 0);  // per chunk: one per LOD, then changes
+            const float* s[StreamCount];
+            for (int k = 0; k < StreamCount; ++k) s[k] = data.data() + k * stride;
+#if defined(CPL_X86)
+            const bool simd = SimdDispatch::tier() >= SimdTier::AVX2;
+#endif
+            pool.parallelChunks(count, Grain, [&](size_t chunk, size_t b, size_t e) {
+                size_t* counts = chunkCounts.data() + chunk * (bins + 1);
+                size_t i = b;
+#if defined(CPL_X86)
+                if (simd) i = selectAVX2(s, lods.data(), b, e, p, counts[bins]);
+#endif
+                selectScalar(s, lods.data(), i, e, p, counts[bins]);
+                for (i = b; i < e; ++i) ++counts[lods[i]];
+            });
+
+            // Offsets LOD-major then chunk-minor, so each list is in index order.
+            listOffsets.assign(bins + 1, 0);
+            frameStats = LodStats();
+            frameStats.instances = count;
+            size_t running = 0;
+            for (size_t l = 0; l < bins; ++l)
+            {
+                listOffsets[l] = running;
+                for (size_t c = 0; c < chunks; ++c)
+                {
+                    size_t n = chunkCounts[c * (bins + 1) + l];
+                    chunkCounts[c * (bins + 1) + l] = running;
+                    running += n;
+                }
+            }
+            listOffsets[bins] = running;
+            for (size_t c = 0; c < chunks; ++c) frameStats.changed += chunkCounts[c * (bins + 1) + bins];
+
+            lists.resize(count);
+            pool.parallelChunks(count, Grain, [&](size_t chunk, size_t b, size_t e) {
+                size_t* cursor = chunkCounts.data() + chunk * (bins + 1);
+                for (size_t i = b; i < e; ++i) lists[cursor[lods[i]]++] = (uint32_t)i;
+            });
+            frameStats.selectMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        }
+
+        // LOD of instance i after the last select(); levels() means dropped.
+        int lod(uint32_t i) const { return lods[i]; }
+
+        // Instances at LOD `level` (levels() for the dropped ones), ascending.
+        const uint32_t* instances(int level, size_t& n) const
+        {
+            n = listOffsets[level + 1] - listOffsets[level];
+            return lists.data() + listOffsets[level];
+        }
+
+        const LodStats& stats() const { return frameStats; }
+
+    private:
+        enum Stream { CX, CY, CZ, Radius, StreamCount };
+        static constexpr size_t Grain = 8192;
+
+        struct Params
+        {
+            float eye[3], p11;
+            float finer[MaxLods], coarser[MaxLods];
+            int   levels;
+        };
+
+        int   lodCount;
+        float thresholds[MaxLods];
+        float hysteresis;
+
+        // Streams share one buffer, staggered as in RigidBodySystem.
+        std::vector<float>    data;
+        size_t                count = 0, capacity = 0, stride = 0;
+        std::vector<uint8_t>  lods;
+        std::vector<size_t>   chunkCounts;
+        std::vector<size_t>   listOffsets;
+        std::vector<uint32_t> lists;
+        LodStats              frameStats;
+
+        void relayout(size_t newCapacity)
+        {
+            size_t newStride = (newCapacity + 1023) / 1024 * 1024 + 16;
+            std::vector<float> next(StreamCount * newStride);
+            for (int s = 0; s < StreamCount; ++s)
+                std::copy(data.begin() + s * stride, data.begin() + s * stride + count, next.begin() + s * newStride);
+            data.swap(next);
+            lods.reserve(newCapacity);
+            capacity = newCapacity;
+            stride = newStride;
+        }
+
+        // The LOD stays put unless coverage has moved past a threshold by
+        // the hysteresis margin: clamp(previous, relaxed, strict).
+        static void selectScalar(const float* const* s, uint8_t* lods, size_t b, size_t e, const Params& p, size_t& changed)
+        {
+            const Vector3f eye(p.eye[0], p.eye[1], p.eye[2]);
+            for (size_t i = b; i < e; ++i)
+            {
+                float c = coverage(Vector3f(s[CX][i], s[CY][i], s[CZ][i]), s[Radius][i], eye, p.p11);
+                int strict = 0, relaxed = 0;
+                for (int k = 0; k < p.levels; ++k)
+                {
+                    strict += c < p.finer[k];
+                    relaxed += c < p.coarser[k];
+                }
+                int next = std::min(std::max((int)lods[i], relaxed), strict);
+                changed += next != lods[i];
+                lods[i] = (uint8_t)next;
+            }
+        }
+
+#if defined(CPL_X86)
+        CPL_TARGET_AVX2 static size_t selectAVX2(const float* const* s, uint8_t* lods, size_t b, size_t e, const Params& p, size_t& changed)
+        {
+            const __m256 ex = _mm256_set1_ps(p.eye[0]), ey = _mm256_set1_ps(p.eye[1]), ez = _mm256_set1_ps(p.eye[2]);
+            const __m256 p11 = _mm256_set1_ps(p.p11), half = _mm256_set1_ps(0.5f), threeHalves = _mm256_set1_ps(1.5f);
+            __m256 finer[MaxLods], coarser[MaxLods];
+            for (int k = 0; k < p.levels; ++k) { finer[k] = _mm256_set1_ps(p.finer[k]); coarser[k] = _mm256_set1_ps(p.coarser[k]); }
+            size_t i = b;
+            for (; i + 8 <= e; i += 8)
+            {
+                __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(s[CX] + i), ex);
+                __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(s[CY] + i), ey);
+                __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(s[CZ] + i), ez);
+                __m256 d2 = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz)));
+                // rsqrt plus a Newton-Raphson step. At d2 = 0 this is NaN,
+                // which passes no threshold compare: LOD 0, as in the scalar path.
+                __m256 r = _mm256_rsqrt_ps(d2);
+                r = _mm256_mul_ps(r, _mm256_fnmadd_ps(_mm256_mul_ps(half, d2), _mm256_mul_ps(r, r), threeHalves));
+                __m256 c = _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(s[Radius] + i), p11), r);
+                __m256i strict = _mm256_setzero_si256(), relaxed = _mm256_setzero_si256();
+                for (int k = 0; k < p.levels; ++k)
+                {
+                    // A true compare is -1: subtracting counts it.
+                    strict = _mm256_sub_epi32(strict, _mm256_castps_si256(_mm256_cmp_ps(c, finer[k], _CMP_LT_OQ)));
+                    relaxed = _mm256_sub_epi32(relaxed, _mm256_castps_si256(_mm256_cmp_ps(c, coarser[k], _CMP_LT_OQ)));
+                }
+                __m256i prev = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(lods + i)));
+                __m256i next = _mm256_min_epi32(_mm256_max_epi32(prev, relaxed), strict);
+                int same = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(next, prev)));
+                changed += 8 - std::bitset<8>((unsigned)same).count();
+                __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(next), _mm256_extracti128_si256(next, 1));
+                _mm_storel_epi64((__m128i*)(lods + i), _mm_packus_epi16(words, words));
+            }
+            return i;
+        }
+#endif
+    };
+}
@@ -0,0 +1,267 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Vector3.hpp"
+#include "aabb.hpp"
+#include "job_pool.hpp"
+
+namespace CPL
+{
+    // Loose octree (looseness 2): a node's loose bounds are twice its cell, so
+    // an object whose half-extent is at most the cell's half-size can live in
+    // the node holding its centre. Objects are only relocated when a move
+    // takes them outside their node's loose bounds. Nodes and objects come
+    // from pools with free lists; objects in a node form an intrusive list.
+    template<typename T>
+    class LooseOctree
+    {
+    public:
+        static constexpr uint32_t None = 0xFFFFFFFFu;
+
+        using Pair = std::pair<uint32_t, uint32_t>;
+
+        LooseOctree(const Vector3<T>& center, T halfSize, int maxDepth = 8)
+            : maxDepth(std::min(maxDepth, 30))
+        {
+            nodes.push_back(makeNode(center, halfSize, None, 0));
+        }
+
+        size_t objectCount() const { return objects.size() - freeObjects.size(); }
+        size_t nodeCount()   const { return nodes.size() - freeNodes.size(); }
+        size_t relocations() const { return relocationCount; }
+
+        const AABB<T>& bounds(uint32_t handle) const { return objects[handle].bounds; }
+        uint32_t userData(uint32_t handle) const { return objects[handle].userData; }
+
+        uint32_t insert(const AABB<T>& box, uint32_t userData = 0)
+        {
+            uint32_t h;
+            if (!freeObjects.empty()) { h = freeObjects.back(); freeObjects.pop_back(); }
+            else { h = (uint32_t)objects.size(); objects.emplace_back(); }
+            Object& o = objects[h];
+            fitted = false;
+            o.bounds = box;
+            o.userData = userData;
+            o.alive = true;
+            link(h, placeNode(box));
+            return h;
+        }
+
+        // Returns true when the object had to change node.
+        bool move(uint32_t handle, const AABB<T>& box)
+        {
+            Object& o = objects[handle];
+            fitted = false;
+            o.bounds = box;
+            const Node& n = nodes[o.node];
+            if (o.node != 0 ? looseBounds(n).contains(box) : placeNode(box, false) == 0) return false;
+
+            uint32_t old = o.node;
+            unlink(handle);
+            link(handle, placeNode(box));
+            prune(old);
+            ++relocationCount;
+            return true;
+        }
+
+        void remove(uint32_t handle)
+        {
+            uint32_t node = objects[handle].node;
+            fitted = false;
+            unlink(handle);
+            objects[handle].alive = false;
+            freeObjects.push_back(handle);
+            prune(node);
+        }
+
+        // fn(handle) for every object whose bounds overlap `box`.
+        template<typename F>
+        void query(const AABB<T>& box, F&& fn) const
+        {
+            uint32_t stack[8 * 32];
+            int top = 0;
+            stack[top++] = 0;
+            while (top > 0)
+            {
+                const Node& n = nodes[stack[--top]];
+                for (uint32_t h = n.firstObject; h != None; h = objects[h].next)
+                    if (objects[h].bounds.overlaps(box)) fn(h);
+                for (uint32_t c : n.child)
+                    if (c != None && (fitted ? nodes[c].content : looseBounds(nodes[c])).overlaps(box)) stack[top++] = c;
+            }
+        }
+
+        // Shrinks every node's culling bounds to what its subtree actually
+        // holds. Loose bounds overlap heavily (a small box touches most of a
+        // node's children), so batch queries are far cheaper after a refit.
+        // Any insert, move or remove falls back to loose bounds until the next one.
+        void refit()
+        {
+            std::vector<uint32_t> order{ 0 };
+            for (size_t i = 0; i < order.size(); ++i)
+                for (uint32_t c : nodes[order[i]].child)
+                    if (c != None) order.push_back(c);
+
+            treeOrder.clear();
+            for (size_t i = order.size(); i-- > 0;)
+            {
+                Node& n = nodes[order[i]];
+                n.content = AABB<T>();
+                for (uint32_t h = n.firstObject; h != None; h = objects[h].next)
+                {
+                    n.content.expand(objects[h].bounds);
+                    treeOrder.push_back(h);
+                }
+                for (uint32_t c : n.child)
+                    if (c != None) n.content.expand(nodes[c].content);
+            }
+            fitted = true;
+        }
+
+        // All overlapping pairs (a < b by handle), sorted. Refits, then every
+        // live object queries the tree in parallel, walking objects in tree
+        // order so neighbouring queries share cached nodes.
+        void findPairs(std::vector<Pair>& out, JobPool& pool = JobPool::global())
+        {
+            if (!fitted) refit();
+            const size_t grain = 1024;
+            std::vector<std::vector<Pair>> partial(JobPool::chunkCount(treeOrder.size(), grain));
+            pool.parallelChunks(treeOrder.size(), grain, [&](size_t c, size_t b, size_t e) {
+                std::vector<Pair>& local = partial[c];
+                for (size_t i = b; i < e; ++i)
+                {
+                    uint32_t a = treeOrder[i];
+                    query(objects[a].bounds, [&](uint32_t h) { if (h > a) local.emplace_back(a, h); });
+                }
+            });
+            out.clear();
+            for (auto& p : partial) out.insert(out.end(), p.begin(), p.end());
+            std::sort(out.begin(), out.end());
+        }
+
+    private:
+        struct Node
+        {
+            Vector3<T> center;
+            T          half;
+            uint32_t   parent;
+            uint32_t   child[8];
+            uint32_t   firstObject;
+            int        depth;
+            AABB<T>    content;
+        };
+
+        struct Object
+        {
+            AABB<T>  bounds;
+            uint32_t node = None, next = None, prev = None;
+            uint32_t userData = 0;
+            bool     alive = false;
+        };
+
+        int                   maxDepth;
+        std::vector<Node>     nodes;
+        std::vector<uint32_t> freeNodes;
+        std::vector<Object>   objects;
+        std::vector<uint32_t> freeObjects;
+        size_t                relocationCount = 0;
+        bool                  fitted = false;
+        std::vector<uint32_t> treeOrder; // live objects, deepest nodes first; valid while fitted
+
+        static Node makeNode(const Vector3<T>& c, T half, uint32_t parent, int depth)
+        {
+            Node n{ c, half, parent, {}, None, depth, AABB<T>() };
+            std::fill(std::begin(n.child), std::end(n.child), None);
+            return n;
+        }
+
+        static AABB<T> looseBounds(const Node& n)
+        {
+            T l = n.half * 2;
+            return AABB<T>::fromCenterExtents(n.center, Vector3<T>(l, l, l));
+        }
+
+        // Deepest node whose cell holds the box centre and whose half-size
+        // covers the box's largest half-extent; creates missing nodes unless
+        // `create` is false (then stops at the deepest existing one).
+        uint32_t placeNode(const AABB<T>& box, bool create = true)
+        {
+            Vector3<T> c = box.center(), e = box.extents();
+            T extent = std::max(e.x, std::max(e.y, e.z));
+            const Node& root = nodes[0];
+            if (std::abs(c.x - root.center.x) > root.half || std::abs(c.y - root.center.y) > root.half
+                || std::abs(c.z - root.center.z) > root.half)
+                return 0; // outside the world: the root is never culled, so it is safe there
+
+            uint32_t n = 0;
+            while (nodes[n].depth < maxDepth && extent <= nodes[n].half * T(0.5))
+            {
+                const Node& cur = nodes[n];
+                int idx = (c.x >= cur.center.x ? 1 : 0) | (c.y >= cur.center.y ? 2 : 0) | (c.z >= cur.center.z ? 4 : 0);
+                uint32_t child = cur.child[idx];
+                if (child == None)
+                {
+                    if (!create) return n == 0 ? 1 : n; // anything but the root means "would move down"
+                    T h = cur.half * T(0.5);
+                    Vector3<T> cc(cur.center.x + (idx & 1 ? h : -h), cur.center.y + (idx & 2 ? h : -h),
+                                  cur.center.z + (idx & 4 ? h : -h));
+                    child = allocNode(cc, h, n, cur.depth + 1);
+                    nodes[n].child[idx] = child;
+                }
+                n = child;
+            }
+            return n;
+        }
+
+        uint32_t allocNode(const Vector3<T>& c, T half, uint32_t parent, int depth)
+        {
+            if (!freeNodes.empty())
+            {
+                uint32_t i = freeNodes.back();
+                freeNodes.pop_back();
+                nodes[i] = makeNode(c, half, parent, depth);
+                return i;
+            }
+            nodes.push_back(makeNode(c, half, parent, depth));
+            return (uint32_t)nodes.size() - 1;
+        }
+
+        void link(uint32_t h, uint32_t node)
+        {
+            Object& o = objects[h];
+            o.node = node;
+            o.prev = None;
+            o.next = nodes[node].firstObject;
+            if (o.next != None) objects[o.next].prev = h;
+            nodes[node].firstObject = h;
+        }
+
+        void unlink(uint32_t h)
+        {
+            Object& o = objects[h];
+            if (o.prev != None) objects[o.prev].next = o.next;
+            else nodes[o.node].firstObject = o.next;
+            if (o.next != None) objects[o.next].prev = o.prev;
+            o.node = o.next = o.prev = None;
+        }
+
+        // Returns empty leaves to the pool, walking up while parents empty out.
+        void prune(uint32_t n)
+        {
+            while (n != 0 && nodes[n].firstObject == None
+                   && std::all_of(std::begin(nodes[n].child), std::end(nodes[n].child), [](uint32_t c) { return c == None; }))
+            {
+                uint32_t parent = nodes[n].parent;
+                for (uint32_t& c : nodes[parent].child)
+                    if (c == n) c = None;
+                freeNodes.push_back(n);
+                n = parent;
+            }
+        }
+    };
+
+    using LooseOctreef = LooseOctree<float>;
+}
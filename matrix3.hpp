@@ -0,0 +1,126 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <ostream>
+#include <cmath>
+#include "Vector3.hpp"
+
+namespace CPL
+{
+    // Row-major 3x3, for rotations and inertia tensors.
+    template<typename T>
+    class Matrix3
+    {
+        std::array<T, 9> m{};
+
+    public:
+        Matrix3() { loadIdentity(); }
+
+        Matrix3(std::initializer_list<T> list)
+        {
+            std::copy(list.begin(), list.end(), m.begin());
+        }
+
+        T& operator()(int r, int c) { return m[r * 3 + c]; }
+        T  operator()(int r, int c) const { return m[r * 3 + c]; }
+
+        static Matrix3 identity()
+        {
+            return Matrix3{ 1,0,0,
+                            0,1,0,
+                            0,0,1 };
+        }
+
+        static Matrix3 zeros() { return Matrix3{ 0,0,0,0,0,0,0,0,0 }; }
+
+        static Matrix3 diagonal(T a, T b, T c)
+        {
+            return Matrix3{ a,0,0,
+                            0,b,0,
+                            0,0,c };
+        }
+
+        // Inertia tensors of solid shapes about their centre of mass.
+        static Matrix3 solidBoxInertia(T mass, const Vector3<T>& halfExtents)
+        {
+            T x2 = 4 * halfExtents.x * halfExtents.x, y2 = 4 * halfExtents.y * halfExtents.y, z2 = 4 * halfExtents.z * halfExtents.z;
+            return diagonal(mass * (y2 + z2) / 12, mass * (x2 + z2) / 12, mass * (x2 + y2) / 12);
+        }
+
+        static Matrix3 solidSphereInertia(T mass, T radius)
+        {
+            T i = T(2) / 5 * mass * radius * radius;
+            return diagonal(i, i, i);
+        }
+
+        Matrix3 operator*(const Matrix3& o) const
+        {
+            Matrix3 r;
+            for (int row = 0; row < 3; ++row)
+                for (int col = 0; col < 3; ++col)
+                {
+                    r(row, col) = 0;
+                    for (int k = 0; k < 3; ++k)
+                        r(row, col) += (*this)(row, k) * o(k, col);
+                }
+            return r;
+        }
+
+        Vector3<T> operator*(const Vector3<T>& v) const
+        {
+            return { v.x * m[0] + v.y * m[1] + v.z * m[2],
+                     v.x * m[3] + v.y * m[4] + v.z * m[5],
+                     v.x * m[6] + v.y * m[7] + v.z * m[8] };
+        }
+
+        Matrix3 operator*(T s) const
+        {
+            Matrix3 r;
+            for (int i = 0; i < 9; ++i) r.m[i] = m[i] * s;
+            return r;
+        }
+
+        void loadIdentity() { *this = identity(); }
+
+        Matrix3 transpose() const
+        {
+            Matrix3 r;
+            for (int rIdx = 0; rIdx < 3; ++rIdx)
+                for (int cIdx = 0; cIdx < 3; ++cIdx)
+                    r(cIdx, rIdx) = (*this)(rIdx, cIdx);
+            return r;
+        }
+
+        T determinant() const
+        {
+            return m[0] * (m[4] * m[8] - m[5] * m[7])
+                 - m[1] * (m[3] * m[8] - m[5] * m[6])
+                 + m[2] * (m[3] * m[7] - m[4] * m[6]);
+        }
+
+        // Adjugate over determinant; a singular matrix gives zeros.
+        Matrix3 inverse() const
+        {
+            T det = determinant();
+            if (det == T(0)) return zeros();
+            T inv = 1 / det;
+            return Matrix3{
+                (m[4] * m[8] - m[5] * m[7]) * inv, (m[2] * m[7] - m[1] * m[8]) * inv, (m[1] * m[5] - m[2] * m[4]) * inv,
+                (m[5] * m[6] - m[3] * m[8]) * inv, (m[0] * m[8] - m[2] * m[6]) * inv, (m[2] * m[3] - m[0] * m[5]) * inv,
+                (m[3] * m[7] - m[4] * m[6]) * inv, (m[1] * m[6] - m[0] * m[7]) * inv, (m[0] * m[4] - m[1] * m[3]) * inv };
+        }
+
+        friend std::ostream& operator<<(std::ostream& os, const Matrix3& mat)
+        {
+            for (int r = 0; r < 3; ++r) {
+                os << '|';
+                for (int c = 0; c < 3; ++c) os << mat(r, c) << (c < 2 ? ' ' : '|');
+                if (r < 2) os << '\n';
+            }
+            return os;
+        }
+    };
+
+    using Matrix3f = Matrix3<float>;
+}
@@ -1,7 +1,11 @@
 #pragma once
+#include <algorithm>
 #include <array>
+#include <initializer_list>
 #include <ostream>
 #include <cmath>
+#include "Vector3.hpp"
+#include "vector4.hpp"
 
 namespace CPL
 {
@@ -49,7 +53,8 @@ namespace CPL
 
         static Matrix4 rotateZ(T rad)
         {
-            T c = std::cos(rad), s = std::sin(rad);
+            using std::cos; using std::sin;
+            T c = T(cos(rad)), s = T(sin(rad));
             return Matrix4{ c,-s,0,0,
                              s, c,0,0,
                              0, 0,1,0,
@@ -69,6 +74,8 @@ namespace CPL
             return r;
         }
 
+        // Point transform. Divides by w unless it is 0 or 1, which loses w;
+        // use transformHomogeneous() for clip space.
         Vector3<T> operator*(const Vector3<T>& v) const
         {
             T x2 = v.x * m[0] + v.y * m[1] + v.z * m[2] + m[3];
@@ -79,6 +86,23 @@ namespace CPL
             return { x2,y2,z2 };
         }
 
+        Vector4<T> operator*(const Vector4<T>& v) const
+        {
+            return { v.x * m[0] + v.y * m[1] + v.z * m[2] + v.w * m[3],
+                     v.x * m[4] + v.y * m[5] + v.z * m[6] + v.w * m[7],
+                     v.x * m[8] + v.y * m[9] + v.z * m[10] + v.w * m[11],
+                     v.x * m[12] + v.y * m[13] + v.z * m[14] + v.w * m[15] };
+        }
+
+        // The point (v, 1) with w kept and no divide: clip space under a projection.
+        Vector4<T> transformHomogeneous(const Vector3<T>& v) const
+        {
+            return { v.x * m[0] + v.y * m[1] + v.z * m[2] + m[3],
+                     v.x * m[4] + v.y * m[5] + v.z * m[6] + m[7],
+                     v.x * m[8] + v.y * m[9] + v.z * m[10] + m[11],
+                     v.x * m[12] + v.y * m[13] + v.z * m[14] + m[15] };
+        }
+
         void loadIdentity() { *this = identity(); }
 
         friend std::ostream& operator<<(std::ostream& os, const Matrix4& mat)
@@ -93,7 +117,8 @@ namespace CPL
 
         static Matrix4 rotateX(T rad)
         {
-            T c = std::cos(rad), s = std::sin(rad);
+            using std::cos; using std::sin;
+            T c = T(cos(rad)), s = T(sin(rad));
             return Matrix4{
                 1, 0, 0, 0,
                 0, c,-s, 0,
@@ -103,7 +128,8 @@ namespace CPL
 
         static Matrix4 rotateY(T rad)
         {
-            T c = std::cos(rad), s = std::sin(rad);
+            using std::cos; using std::sin;
+            T c = T(cos(rad)), s = T(sin(rad));
             return Matrix4{
                  c, 0, s, 0,
                  0, 1, 0, 0,
@@ -126,27 +152,31 @@ namespace CPL
             Vector3<T> sy{ m[1], m[5], m[9] };
             Vector3<T> sz{ m[2], m[6], m[10] };
 
-            T invSX = 1 / sx.length();
-            T invSY = 1 / sy.length();
-            T invSZ = 1 / sz.length();
+            // Column i of R S is s_i r_i, so row i of S^-1 R^T is that column / s_i^2.
+            T invSX = 1 / sx.lengthSquared();
+            T invSY = 1 / sy.lengthSquared();
+            T invSZ = 1 / sz.lengthSquared();
 
             Matrix4 inv;
             inv = this->transpose();
             inv(0, 0) *= invSX; inv(0, 1) *= invSX; inv(0, 2) *= invSX;
             inv(1, 0) *= invSY; inv(1, 1) *= invSY; inv(1, 2) *= invSY;
             inv(2, 0) *= invSZ; inv(2, 1) *= invSZ; inv(2, 2) *= invSZ;
+            inv(3, 0) = inv(3, 1) = inv(3, 2) = 0; inv(3, 3) = 1;
+            inv(0, 3) = inv(1, 3) = inv(2, 3) = 0;
 
+            // -(S^-1 R^T) t, before the translation column is filled in.
             Vector3<T> t(m[3], m[7], m[11]);
-            Vector3<T> tInv = (inv * (t * -1));
+            Vector3<T> tInv = inv * (t * -1);
 
             inv(0, 3) = tInv.x; inv(1, 3) = tInv.y; inv(2, 3) = tInv.z;
-            inv(3, 0) = inv(3, 1) = inv(3, 2) = 0; inv(3, 3) = 1;
             return inv;
         }
 
         static Matrix4 perspective(T fovY_rad, T aspect, T near, T far)
         {
-            T f = 1 / std::tan(fovY_rad / 2);
+            using std::tan;
+            T f = T(1 / tan(fovY_rad / 2));
             T nf = 1 / (near - far);
 
             return Matrix4{
@@ -0,0 +1,274 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "vector2.hpp"
+#include "Vector3.hpp"
+#include "vector4.hpp"
+#include "simd_dispatch.hpp"
+#include "job_pool.hpp"
+
+namespace CPL
+{
+    // How much each face contributes to the normal of a vertex it touches.
+    enum class NormalWeighting
+    {
+        Uniform,  // every face the same
+        Area,     // large faces dominate; cheapest, shifts with tessellation
+        Angle,    // corner angle at the vertex (Thurmer-Wuthrich); tessellation-independent
+    };
+
+    struct NormalStats
+    {
+        double faceMs = 0;      // per-face normals, tangents and corner weights
+        double vertexMs = 0;    // gathering faces into vertices
+    };
+
+    // Per-vertex normals and tangent frames for indexed triangle meshes.
+    //
+    // setTopology() builds a CSR table of the corners (triangle * 3 + k)
+    // around each vertex, once per index buffer. compute*() then run two
+    // passes across the job pool: one over triangles writing per-face data,
+    // 8 faces at a time with gathers on the AVX2 tier, and one over
+    // vertices, each summing its own corners. Every output is written by
+    // exactly one task, so no atomics or per-thread buffers are needed and
+    // the result does not depend on the thread count.
+    class NormalGenerator
+    {
+    public:
+        // Keeps the pointer: indices must stay valid while compute*() is used.
+        void setTopology(const uint32_t* indices, size_t triangleCount, size_t vertexCount)
+        {
+            tris = indices;
+            triCount = triangleCount;
+            vertCount = vertexCount;
+            offsets.assign(vertexCount + 1, 0);
+            for (size_t i = 0; i < triangleCount * 3; ++i) ++offsets[indices[i] + 1];
+            for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+            corners.resize(triangleCount * 3);
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < triangleCount * 3; ++i) corners[fill[indices[i]]++] = (uint32_t)i;
+        }
+
+        // Unit normals, counter-clockwise faces pointing out. Vertices whose
+        // faces cancel or are all degenerate get (0, 0, 0).
+        void computeNormals(const Vector3f* positions, Vector3f* normals, NormalWeighting weighting = NormalWeighting::Angle,
+                            JobPool& pool = JobPool::global())
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            faceNormals.resize(triCount);
+            cornerWeights.resize(triCount);
+#if defined(CPL_X86)
+            const bool simd = SimdDispatch::tier() >= SimdTier::AVX2;
+#endif
+            pool.parallelFor(triCount, FaceGrain, [&](size_t b, size_t e) {
+                size_t i = b;
+#if defined(CPL_X86)
+                if (simd) i = facesAVX2(positions, tris, b, e, weighting, faceNormals.data(), cornerWeights.data());
+#endif
+                facesScalar(positions, tris, i, e, weighting, faceNormals.data(), cornerWeights.data());
+            });
+            auto t1 = std::chrono::steady_clock::now();
+
+            pool.parallelFor(vertCount, VertexGrain, [&](size_t b, size_t e) {
+                for (size_t v = b; v < e; ++v)
+                {
+                    Vector3f n;
+                    for (uint32_t k = offsets[v]; k < offsets[v + 1]; ++k)
+                    {
+                        uint32_t c = corners[k];
+                        n += faceNormals[c / 3] * weight(cornerWeights[c / 3], c % 3);
+                    }
+                    normals[v] = n.normalized();
+                }
+            });
+            timing.faceMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+            timing.vertexMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count();
+        }
+
+        // Tangents (xyz) with the bitangent sign in w: B = w * cross(N, T).
+        // Follows MikkTSpace per corner: the face's UV-aligned direction,
+        // oriented by the sign of its UV area, is projected into the plane of
+        // the vertex normal, normalized and weighted by the corner angle;
+        // the sum is made orthonormal to N. MikkTSpace also splits vertices
+        // whose corners disagree in orientation; here the index buffer is
+        // taken as given, so a vertex shared across a mirror line gets the
+        // angle-weighted majority sign. On meshes already split at UV seams
+        // and mirror lines the two agree.
+        void computeTangents(const Vector3f* positions, const Vector3f* normals, const Vector2f* uvs, Vector4f* tangents,
+                             JobPool& pool = JobPool::global())
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            faceNormals.resize(triCount);
+            faceTangents.resize(triCount);
+            cornerWeights.resize(triCount);
+#if defined(CPL_X86)
+            const bool simd = SimdDispatch::tier() >= SimdTier::AVX2;
+#endif
+            pool.parallelFor(triCount, FaceGrain, [&](size_t b, size_t e) {
+                // Corner angles come from the normal pass's face kernel.
+                size_t i = b;
+#if defined(CPL_X86)
+                if (simd) i = facesAVX2(positions, tris, b, e, NormalWeighting::Angle, faceNormals.data(), cornerWeights.data());
+#endif
+                facesScalar(positions, tris, i, e, NormalWeighting::Angle, faceNormals.data(), cornerWeights.data());
+                for (size_t t = b; t < e; ++t)
+                {
+                    const uint32_t* tri = tris + t * 3;
+                    const Vector2f &u0 = uvs[tri[0]], &u1 = uvs[tri[1]], &u2 = uvs[tri[2]];
+                    Vector3f d1 = sub(positions[tri[1]], positions[tri[0]]), d2 = sub(positions[tri[2]], positions[tri[0]]);
+                    float s1 = u1.x - u0.x, t1 = u1.y - u0.y, s2 = u2.x - u0.x, t2 = u2.y - u0.y;
+                    float signedArea = s1 * t2 - s2 * t1;
+                    // d1 t2 - d2 t1 is dP/du times the signed UV area; drop the sign.
+                    float orient = signedArea < 0 ? -1.0f : 1.0f;
+                    faceTangents[t] = signedArea != 0 ? (d1 * t2 + d2 * -t1).normalized() * orient : Vector3f();
+                    // Orientation rides on the sign of the corner angles.
+                    cornerWeights[t] *= orient;
+                }
+            });
+            auto t1 = std::chrono::steady_clock::now();
+
+            pool.parallelFor(vertCount, VertexGrain, [&](size_t b, size_t e) {
+                for (size_t v = b; v < e; ++v)
+                {
+                    const Vector3f& n = normals[v];
+                    Vector3f sum;
+                    float orientation = 0;
+                    for (uint32_t k = offsets[v]; k < offsets[v + 1]; ++k)
+                    {
+                        uint32_t c = corners[k];
+                        float w = weight(cornerWeights[c / 3], c % 3);  // angle, negative if mirrored
+                        const Vector3f& d = faceTangents[c / 3];
+                        Vector3f projected = sub(d, n * n.dot(d)).normalized();
+                        sum += projected * std::abs(w);
+                        orientation += w;
+                    }
+                    Vector3f t = sub(sum, n * n.dot(sum)).normalized();
+                    tangents[v] = Vector4f(t, orientation < 0 ? -1.0f : 1.0f);
+                }
+            });
+            timing.faceMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+            timing.vertexMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count();
+        }
+
+        // Timings of the last compute*() call.
+        const NormalStats& stats() const { return timing; }
+
+    private:
+        static constexpr size_t FaceGrain = 16384;
+        static constexpr size_t VertexGrain = 8192;
+
+        const uint32_t*       tris = nullptr;
+        size_t                triCount = 0, vertCount = 0;
+        std::vector<uint32_t> offsets, corners;
+        std::vector<Vector3f> faceNormals, faceTangents;
+        std::vector<Vector3f> cornerWeights;  // x, y, z: weights of corners 0, 1, 2
+        NormalStats           timing;
+
+        static Vector3f sub(const Vector3f& a, const Vector3f& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+        static float weight(const Vector3f& w, uint32_t corner) { return corner == 0 ? w.x : (corner == 1 ? w.y : w.z); }
+
+        static float cornerAngle(const Vector3f& a, const Vector3f& b)
+        {
+            float den = std::sqrt(a.lengthSquared() * b.lengthSquared());
+            return den > 0 ? std::acos(std::min(std::max(a.dot(b) / den, -1.0f), 1.0f)) : 0.0f;
+        }
+
+        static Vector3f cornerAngles(const Vector3f& p0, const Vector3f& p1, const Vector3f& p2)
+        {
+            return { cornerAngle(sub(p1, p0), sub(p2, p0)), cornerAngle(sub(p2, p1), sub(p0, p1)), cornerAngle(sub(p0, p2), sub(p1, p2)) };
+        }
+
+        static void facesScalar(const Vector3f* pos, const uint32_t* tris, size_t b, size_t e, NormalWeighting weighting,
+                                Vector3f* normals, Vector3f* weights)
+        {
+            for (size_t t = b; t < e; ++t)
+            {
+                const Vector3f &p0 = pos[tris[t * 3]], &p1 = pos[tris[t * 3 + 1]], &p2 = pos[tris[t * 3 + 2]];
+                Vector3f c = sub(p1, p0).cross(sub(p2, p0));
+                float len = c.length();
+                normals[t] = len > 0 ? c / len : Vector3f();
+                if (weighting == NormalWeighting::Angle) weights[t] = cornerAngles(p0, p1, p2);
+                else if (weighting == NormalWeighting::Area) weights[t] = Vector3f::ones() * (len * 0.5f);
+                else weights[t] = Vector3f::ones();
+            }
+        }
+
+#if defined(CPL_X86)
+        // acos within 7e-5 rad (Abramowitz-Stegun 4.4.45), for weights only.
+        CPL_TARGET_AVX2 static __m256 acosApprox(__m256 x)
+        {
+            const __m256 sign = _mm256_set1_ps(-0.0f);
+            __m256 ax = _mm256_andnot_ps(sign, x);
+            __m256 p = _mm256_fmadd_ps(_mm256_set1_ps(-0.0187293f), ax, _mm256_set1_ps(0.0742610f));
+            p = _mm256_fmadd_ps(p, ax, _mm256_set1_ps(-0.2121144f));
+            p = _mm256_fmadd_ps(p, ax, _mm256_set1_ps(1.5707288f));
+            __m256 r = _mm256_mul_ps(p, _mm256_sqrt_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), ax)));
+            __m256 negative = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ);
+            return _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(3.14159265f), r), negative);
+        }
+
+        // Angle between a and b from their dot and squared lengths. Zero when
+        // either is zero length, as in cornerAngle(); the clamp alone would
+        // turn the NaN cosine into -1 and the angle into pi.
+        CPL_TARGET_AVX2 static __m256 angle(__m256 dot, __m256 la, __m256 lb)
+        {
+            __m256 den = _mm256_sqrt_ps(_mm256_mul_ps(la, lb));
+            __m256 c = _mm256_min_ps(_mm256_max_ps(_mm256_div_ps(dot, den), _mm256_set1_ps(-1.0f)), _mm256_set1_ps(1.0f));
+            return _mm256_and_ps(acosApprox(c), _mm256_cmp_ps(den, _mm256_setzero_ps(), _CMP_GT_OQ));
+        }
+
+        CPL_TARGET_AVX2 static size_t facesAVX2(const Vector3f* pos, const uint32_t* tris, size_t b, size_t e,
+                                                NormalWeighting weighting, Vector3f* normals, Vector3f* weights)
+        {
+            const float* base = &pos->x;
+            const __m256i stride = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21), three = _mm256_set1_epi32(3);
+            const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), halfOne = _mm256_set1_ps(0.5f);
+            size_t i = b;
+            for (; i + 8 <= e; i += 8)
+            {
+                const int* ip = (const int*)(tris + i * 3);
+                __m256 px[3], py[3], pz[3];
+                for (int k = 0; k < 3; ++k)
+                {
+                    __m256i v = _mm256_mullo_epi32(_mm256_i32gather_epi32(ip + k, stride, 4), three);
+                    px[k] = _mm256_i32gather_ps(base, v, 4);
+                    py[k] = _mm256_i32gather_ps(base + 1, v, 4);
+                    pz[k] = _mm256_i32gather_ps(base + 2, v, 4);
+                }
+                __m256 ax = _mm256_sub_ps(px[1], px[0]), ay = _mm256_sub_ps(py[1], py[0]), az = _mm256_sub_ps(pz[1], pz[0]);
+                __m256 bx = _mm256_sub_ps(px[2], px[0]), by = _mm256_sub_ps(py[2], py[0]), bz = _mm256_sub_ps(pz[2], pz[0]);
+                __m256 cx = _mm256_fmsub_ps(ay, bz, _mm256_mul_ps(az, by));
+                __m256 cy = _mm256_fmsub_ps(az, bx, _mm256_mul_ps(ax, bz));
+                __m256 cz = _mm256_fmsub_ps(ax, by, _mm256_mul_ps(ay, bx));
+                __m256 len = _mm256_sqrt_ps(_mm256_fmadd_ps(cx, cx, _mm256_fmadd_ps(cy, cy, _mm256_mul_ps(cz, cz))));
+                __m256 inv = _mm256_and_ps(_mm256_div_ps(one, len), _mm256_cmp_ps(len, zero, _CMP_GT_OQ));
+                kernels::store3(normals + i, _mm256_mul_ps(cx, inv), _mm256_mul_ps(cy, inv), _mm256_mul_ps(cz, inv));
+
+                __m256 w0 = one, w1 = one, w2 = one;
+                if (weighting == NormalWeighting::Area)
+                    w0 = w1 = w2 = _mm256_mul_ps(len, halfOne);
+                else if (weighting == NormalWeighting::Angle)
+                {
+                    // Edges a = p1 - p0, b = p2 - p0, d = p2 - p1.
+                    __m256 dx = _mm256_sub_ps(bx, ax), dy = _mm256_sub_ps(by, ay), dz = _mm256_sub_ps(bz, az);
+                    __m256 la = _mm256_fmadd_ps(ax, ax, _mm256_fmadd_ps(ay, ay, _mm256_mul_ps(az, az)));
+                    __m256 lb = _mm256_fmadd_ps(bx, bx, _mm256_fmadd_ps(by, by, _mm256_mul_ps(bz, bz)));
+                    __m256 ld = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz)));
+                    __m256 ab = _mm256_fmadd_ps(ax, bx, _mm256_fmadd_ps(ay, by, _mm256_mul_ps(az, bz)));
+                    __m256 ad = _mm256_fmadd_ps(ax, dx, _mm256_fmadd_ps(ay, dy, _mm256_mul_ps(az, dz)));
+                    __m256 bd = _mm256_fmadd_ps(bx, dx, _mm256_fmadd_ps(by, dy, _mm256_mul_ps(bz, dz)));
+                    w0 = angle(ab, la, lb);
+                    w1 = angle(_mm256_sub_ps(zero, ad), la, ld);  // d . -a at p1
+                    w2 = angle(bd, lb, ld);                        // -b . -d at p2
+                }
+                kernels::store3(weights + i, w0, w1, w2);
+            }
+            return i;
+        }
+#endif
+    };
+}
@@ -0,0 +1,375 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include "Vector3.hpp"
+#include "job_pool.hpp"
+
+namespace CPL
+{
+    struct SimplifyOptions
+    {
+        size_t targetTriangles = 0;
+        float  maxError = std::numeric_limits<float>::infinity();  // distance, in mesh units
+        bool   lockBorder = false;  // keep open-boundary vertices, e.g. between clusters
+    };
+
+    struct SimplifyResult
+    {
+        size_t triangles = 0;
+        size_t collapses = 0;
+        size_t passes = 0;
+        float  error = 0;           // largest collapse error: RMS distance to the merged planes
+    };
+
+    // Quadric error metric decimation (Garland-Heckbert) by edge collapse.
+    // Each vertex carries the area-weighted sum of its faces' plane quadrics;
+    // collapsing v into u costs (Q_u + Q_v)(p_u) over the summed area, the
+    // mean squared distance from u to the merged planes. Collapses go to an
+    // existing endpoint, so vertex positions never change and the output
+    // index buffer stays valid for every vertex attribute.
+    //
+    // Work proceeds in passes. A pass lists every edge once from a CSR
+    // vertex-to-triangle adjacency, counting-sorts the collapses into
+    // buckets by cost (no heap), then walks the cheapest third, taking a
+    // collapse only if none of its neighbourhood was touched earlier in the
+    // pass and no triangle would flip. Indices are then remapped and
+    // degenerate triangles dropped.
+    //
+    // One simplifier per thread; it keeps its scratch buffers between calls.
+    class MeshSimplifier
+    {
+    public:
+        // Rewrites indices[0 .. 3 * triangleCount) in place; returns the new
+        // triangle count, which may stay above the target when the error
+        // limit, a locked border, or the mesh topology stops it.
+        size_t simplify(const Vector3f* vertices, size_t vertexCount, uint32_t* indices, size_t triangleCount,
+                        const SimplifyOptions& options, SimplifyResult* result = nullptr)
+        {
+            SimplifyResult res;
+            positions = vertices;
+            vertCount = vertexCount;
+            tris = indices;
+            triCount = triangleCount;
+            const double maxCost = (double)options.maxError * options.maxError;
+
+            buildAdjacency();
+            findBorder();
+            computeQuadrics(!options.lockBorder);
+
+            while (triCount > options.targetTriangles)
+            {
+                listCollapses(options.lockBorder);
+                if (collapses.empty()) break;
+                sortCollapses();
+                size_t removed = applyCollapses(triCount - options.targetTriangles, maxCost, res);
+                if (removed == 0) break;
+                ++res.passes;
+                compact();
+                buildAdjacency();
+            }
+            res.triangles = triCount;
+            if (result) *result = res;
+            return triCount;
+        }
+
+    private:
+        // Symmetric 4x4 [A b; b^T c] for the plane set, evaluated as p^T A p + 2 b.p + c.
+        struct Quadric
+        {
+            double a00, a01, a02, a11, a12, a22, b0, b1, b2, c;
+
+            void addPlane(double nx, double ny, double nz, double d, double w)
+            {
+                a00 += w * nx * nx; a01 += w * nx * ny; a02 += w * nx * nz;
+                a11 += w * ny * ny; a12 += w * ny * nz; a22 += w * nz * nz;
+                b0 += w * nx * d; b1 += w * ny * d; b2 += w * nz * d; c += w * d * d;
+            }
+
+            void add(const Quadric& o)
+            {
+                a00 += o.a00; a01 += o.a01; a02 += o.a02; a11 += o.a11; a12 += o.a12; a22 += o.a22;
+                b0 += o.b0; b1 += o.b1; b2 += o.b2; c += o.c;
+            }
+
+            double eval(const Vector3f& p) const
+            {
+                double x = p.x, y = p.y, z = p.z;
+                return x * (a00 * x + 2 * (a01 * y + a02 * z + b0)) + y * (a11 * y + 2 * (a12 * z + b1)) +
+                       z * (a22 * z + 2 * b2) + c;
+            }
+        };
+
+        struct Collapse
+        {
+            uint32_t from, to;
+            float    cost;
+        };
+
+        static constexpr size_t Buckets = 1024;
+        static constexpr double BorderWeight = 10;  // relative weight of the planes that hold borders in place
+
+        const Vector3f* positions = nullptr;
+        size_t          vertCount = 0, triCount = 0;
+        uint32_t*       tris = nullptr;
+
+        std::vector<uint32_t> adjOffsets, adjTriangles;  // CSR: triangles around each vertex
+        std::vector<Quadric>  quadrics;
+        std::vector<double>   areas, residual;
+        std::vector<uint8_t>  border, touched;
+        std::vector<uint32_t> remap;
+        std::vector<Collapse> collapses, sorted;
+        std::vector<uint32_t> bucketStart, marks, ringNext, ringPrev;
+        uint32_t              stamp = 0;
+
+        static Vector3f sub(const Vector3f& a, const Vector3f& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+
+        void buildAdjacency()
+        {
+            adjOffsets.assign(vertCount + 1, 0);
+            for (size_t i = 0; i < triCount * 3; ++i) ++adjOffsets[tris[i] + 1];
+            for (size_t v = 0; v < vertCount; ++v) adjOffsets[v + 1] += adjOffsets[v];
+            adjTriangles.resize(triCount * 3);
+            remap.assign(adjOffsets.begin(), adjOffsets.end() - 1);  // reused as fill cursors
+            for (size_t t = 0; t < triCount; ++t)
+                for (int k = 0; k < 3; ++k) adjTriangles[remap[tris[t * 3 + k]]++] = (uint32_t)t;
+        }
+
+        // Does some triangle around a contain the directed edge a -> b?
+        bool hasHalfEdge(uint32_t a, uint32_t b) const
+        {
+            for (uint32_t k = adjOffsets[a]; k < adjOffsets[a + 1]; ++k)
+            {
+                const uint32_t* t = tris + adjTriangles[k] * 3;
+                for (int e = 0; e < 3; ++e)
+                    if (t[e] == a && t[(e + 1) % 3] == b) return true;
+            }
+            return false;
+        }
+
+        // The vertices after and before v in each of its triangles: v -> b
+        // has a twin exactly when b is also in the previous list. Both stay
+        // within v's own adjacency, so no lookups around other vertices.
+        void gatherRing(uint32_t v)
+        {
+            ringNext.clear();
+            ringPrev.clear();
+            for (uint32_t k = adjOffsets[v]; k < adjOffsets[v + 1]; ++k)
+            {
+                const uint32_t* t = tris + adjTriangles[k] * 3;
+                int e = t[0] == v ? 0 : (t[1] == v ? 1 : 2);
+                ringNext.push_back(t[e == 2 ? 0 : e + 1]);
+                ringPrev.push_back(t[e == 0 ? 2 : e - 1]);
+            }
+        }
+
+        // Open-boundary vertices: ends of a half-edge without a twin.
+        void findBorder()
+        {
+            border.assign(vertCount, 0);
+            for (uint32_t a = 0; a < vertCount; ++a)
+            {
+                gatherRing(a);
+                for (uint32_t b : ringNext)
+                    if (std::find(ringPrev.begin(), ringPrev.end(), b) == ringPrev.end()) border[a] = border[b] = 1;
+            }
+        }
+
+        void computeQuadrics(bool borderPlanes)
+        {
+            quadrics.assign(vertCount, Quadric{});
+            areas.assign(vertCount, 0);
+            for (size_t t = 0; t < triCount; ++t)
+            {
+                const uint32_t* tri = tris + t * 3;
+                const Vector3f &p0 = positions[tri[0]], &p1 = positions[tri[1]], &p2 = positions[tri[2]];
+                Vector3f n = sub(p1, p0).cross(sub(p2, p0));
+                double len = n.length();
+                if (len == 0) continue;
+                double nx = n.x / len, ny = n.y / len, nz = n.z / len;
+                double d = -(nx * p0.x + ny * p0.y + nz * p0.z), area = len / 2;
+                for (int k = 0; k < 3; ++k)
+                {
+                    quadrics[tri[k]].addPlane(nx, ny, nz, d, area);
+                    areas[tri[k]] += area;
+                }
+                if (!borderPlanes) continue;
+                // A plane through each border edge, perpendicular to the face,
+                // so borders only collapse along themselves.
+                for (int e = 0; e < 3; ++e)
+                {
+                    uint32_t a = tri[e], b = tri[(e + 1) % 3];
+                    if (!border[a] || !border[b] || hasHalfEdge(b, a)) continue;
+                    Vector3f edge = sub(positions[b], positions[a]);
+                    Vector3f m = edge.cross(Vector3f((float)nx, (float)ny, (float)nz));
+                    double ml = m.length();
+                    if (ml == 0) continue;
+                    double mx = m.x / ml, my = m.y / ml, mz = m.z / ml;
+                    double md = -(mx * positions[a].x + my * positions[a].y + mz * positions[a].z);
+                    double w = BorderWeight * edge.lengthSquared();
+                    quadrics[a].addPlane(mx, my, mz, md, w);
+                    quadrics[b].addPlane(mx, my, mz, md, w);
+                }
+            }
+        }
+
+        // (Q_from + Q_to)(p_to), with Q_to(p_to) cached per pass in `residual`.
+        double cost(uint32_t from, uint32_t to) const
+        {
+            double area = areas[from] + areas[to];
+            return std::max(0.0, (quadrics[from].eval(positions[to]) + residual[to]) / (area > 0 ? area : 1));
+        }
+
+        // Every edge once, with its cheaper allowed direction. A border
+        // vertex may only slide along a border edge, or not at all if locked.
+        void listCollapses(bool lockBorder)
+        {
+            collapses.clear();
+            residual.resize(vertCount);
+            for (uint32_t v = 0; v < vertCount; ++v) residual[v] = quadrics[v].eval(positions[v]);
+            for (uint32_t a = 0; a < vertCount; ++a)
+            {
+                gatherRing(a);
+                for (uint32_t b : ringNext)
+                {
+                    bool twin = std::find(ringPrev.begin(), ringPrev.end(), b) != ringPrev.end();
+                    if (twin && a > b) continue;  // listed from b
+                    bool canA = !border[a] || (!twin && !lockBorder);
+                    bool canB = !border[b] || (!twin && !lockBorder);
+                    if (!canA && !canB) continue;
+                    double ca = canA ? cost(a, b) : std::numeric_limits<double>::infinity();
+                    double cb = canB ? cost(b, a) : std::numeric_limits<double>::infinity();
+                    if (ca <= cb) collapses.push_back({ a, b, (float)ca });
+                    else collapses.push_back({ b, a, (float)cb });
+                }
+            }
+        }
+
+        // Counting sort on the float bits of the cost, which order like the
+        // costs themselves for non-negative values: a log-spaced bucket queue.
+        void sortCollapses()
+        {
+            auto key = [](float c) { uint32_t bits; std::memcpy(&bits, &c, sizeof(bits)); return bits; };
+            uint32_t lo = std::numeric_limits<uint32_t>::max(), hi = 0;
+            for (const Collapse& c : collapses) { lo = std::min(lo, key(c.cost)); hi = std::max(hi, key(c.cost)); }
+            const double scale = hi > lo ? double(Buckets - 1) / double(hi - lo) : 0;
+            auto bucket = [&](float c) { return (size_t)(double(key(c) - lo) * scale); };
+            bucketStart.assign(Buckets + 1, 0);
+            for (const Collapse& c : collapses) ++bucketStart[bucket(c.cost) + 1];
+            for (size_t b = 0; b < Buckets; ++b) bucketStart[b + 1] += bucketStart[b];
+            sorted.resize(collapses.size());
+            for (const Collapse& c : collapses) sorted[bucketStart[bucket(c.cost)]++] = c;
+        }
+
+        // Would moving `from` onto `to` turn any surviving triangle around?
+        bool flips(uint32_t from, uint32_t to) const
+        {
+            for (uint32_t k = adjOffsets[from]; k < adjOffsets[from + 1]; ++k)
+            {
+                const uint32_t* t = tris + adjTriangles[k] * 3;
+                if (t[0] == to || t[1] == to || t[2] == to) continue;  // collapses away
+                Vector3f p[3] = { positions[t[0]], positions[t[1]], positions[t[2]] };
+                Vector3f before = sub(p[1], p[0]).cross(sub(p[2], p[0]));
+                for (int i = 0; i < 3; ++i) if (t[i] == from) p[i] = positions[to];
+                Vector3f after = sub(p[1], p[0]).cross(sub(p[2], p[0]));
+                if (before.dot(after) <= 0) return true;
+            }
+            return false;
+        }
+
+        // Link condition: the endpoints may share no neighbours beyond the
+        // apexes of the triangles on their edge, or the collapse pinches the
+        // surface into a non-manifold fin.
+        bool keepsManifold(uint32_t from, uint32_t to)
+        {
+            // Stamp from's ring with a fresh value, then count to's ring hits.
+            if (++stamp == 0) { std::fill(marks.begin(), marks.end(), 0); stamp = 1; }
+            size_t shared = 0, common = 0;
+            for (uint32_t k = adjOffsets[from]; k < adjOffsets[from + 1]; ++k)
+            {
+                const uint32_t* t = tris + adjTriangles[k] * 3;
+                shared += t[0] == to || t[1] == to || t[2] == to;
+                marks[t[0]] = marks[t[1]] = marks[t[2]] = stamp;
+            }
+            marks[from] = marks[to] = 0;
+            for (uint32_t k = adjOffsets[to]; k < adjOffsets[to + 1]; ++k)
+            {
+                const uint32_t* t = tris + adjTriangles[k] * 3;
+                for (int i = 0; i < 3; ++i)
+                    if (marks[t[i]] == stamp) { ++common; marks[t[i]] = 0; }
+            }
+            return common <= shared;
+        }
+
+        size_t applyCollapses(size_t wanted, double maxCost, SimplifyResult& res)
+        {
+            touched.assign(vertCount, 0);
+            marks.resize(vertCount);
+            remap.resize(vertCount);
+            for (uint32_t v = 0; v < vertCount; ++v) remap[v] = v;
+            size_t removed = 0;
+            const size_t limit = (sorted.size() + 2) / 3;
+            for (size_t i = 0; i < limit && removed < wanted; ++i)
+            {
+                const Collapse& c = sorted[i];
+                if (c.cost > maxCost) break;
+                if (touched[c.from] || touched[c.to] || flips(c.from, c.to) || !keepsManifold(c.from, c.to)) continue;
+                // Lock the whole neighbourhood of `from`: its triangles change.
+                size_t shared = 0;
+                for (uint32_t k = adjOffsets[c.from]; k < adjOffsets[c.from + 1]; ++k)
+                {
+                    const uint32_t* t = tris + adjTriangles[k] * 3;
+                    shared += t[0] == c.to || t[1] == c.to || t[2] == c.to;
+                    touched[t[0]] = touched[t[1]] = touched[t[2]] = 1;
+                }
+                remap[c.from] = c.to;
+                quadrics[c.to].add(quadrics[c.from]);
+                areas[c.to] += areas[c.from];
+                removed += shared;
+                ++res.collapses;
+                res.error = std::max(res.error, std::sqrt(c.cost));
+            }
+            return removed;
+        }
+
+        void compact()
+        {
+            size_t out = 0;
+            for (size_t t = 0; t < triCount; ++t)
+            {
+                uint32_t a = remap[tris[t * 3]], b = remap[tris[t * 3 + 1]], c = remap[tris[t * 3 + 2]];
+                if (a == b || b == c || a == c) continue;
+                tris[out * 3] = a; tris[out * 3 + 1] = b; tris[out * 3 + 2] = c;
+                ++out;
+            }
+            triCount = out;
+        }
+    };
+
+    // One independent mesh (e.g. a cluster of a larger one) to simplify in place.
+    struct SimplifyJob
+    {
+        const Vector3f* vertices;
+        size_t          vertexCount;
+        uint32_t*       indices;
+        size_t          triangleCount;
+        SimplifyOptions options;
+        SimplifyResult  result;
+    };
+
+    // Simplifies the jobs across the pool, one job per task. Set
+    // options.lockBorder on clusters cut from one mesh so they still meet.
+    inline void simplifyMeshes(SimplifyJob* jobs, size_t count, JobPool& pool = JobPool::global())
+    {
+        pool.parallelFor(count, 1, [&](size_t b, size_t e) {
+            MeshSimplifier simplifier;
+            for (size_t j = b; j < e; ++j)
+                simplifier.simplify(jobs[j].vertices, jobs[j].vertexCount, jobs[j].indices, jobs[j].triangleCount,
+                                    jobs[j].options, &jobs[j].result);
+        });
+    }
+}
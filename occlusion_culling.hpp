@@ -0,0 +1,439 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "Vector3.hpp"
+#include "vector4.hpp"
+#include "matrix4.hpp"
+#include "aabb.hpp"
+#include "simd_dispatch.hpp"
+#include "job_pool.hpp"
+#include "triangle_setup.hpp"
+
+namespace CPL
+{
+    // One occluder: indexed triangles in model space and their world matrix
+    // (affine). Occluders should be closed or at least front-facing; back
+    // faces are culled.
+    struct OccluderMesh
+    {
+        const Vector3f* vertices;
+        size_t          vertexCount;
+        const uint32_t* indices;
+        size_t          triangleCount;
+        Matrix4f        world;
+    };
+
+    struct OcclusionStats
+    {
+        size_t occluderTriangles = 0;   // submitted
+        size_t rasterTriangles = 0;     // left after clipping and culling
+        size_t tested = 0;
+        size_t culledFrustum = 0;
+        size_t culledOccluded = 0;
+        double rasterMs = 0;            // setup, binning and rasterization
+        double pyramidMs = 0;
+        double testMs = 0;
+
+        double cullRate() const { return tested ? double(culledFrustum + culledOccluded) / double(tested) : 0; }
+    };
+
+    // Software Hi-Z occlusion culling. Occluders are rasterized into a small
+    // depth buffer (depth in [0, 1], 1 = far) through TriangleSetup, one
+    // screen tile per job, 8 pixels per step on AVX2. A pyramid of min/max
+    // depth then answers "is this screen rectangle behind everything drawn
+    // there" with at most 2x2 texel reads. Boxes are projected 8 corners at
+    // a time and are kept visible whenever the answer is unclear (crossing
+    // the near plane, off the pyramid).
+    class OcclusionCuller
+    {
+    public:
+        explicit OcclusionCuller(int width = 256, int height = 128)
+            : width(width), height(height), stride((width + 7) & ~7), setup(width, height, TileSize)
+        {
+            int w = width, h = height, s = stride;
+            size_t offset = 0;
+            for (;;)
+            {
+                levels.push_back({ offset, w, h, s });
+                offset += (size_t)s * h;
+                if (w == 1 && h == 1) break;
+                w = (w + 1) / 2; h = (h + 1) / 2; s = w;
+            }
+            maxDepth.assign(offset, 1.0f);
+            minDepth.assign(offset, 1.0f);
+        }
+
+        int bufferWidth() const { return width; }
+        int bufferHeight() const { return height; }
+        int levelCount() const { return (int)levels.size(); }
+        int levelWidth(int level) const { return levels[level].width; }
+        int levelHeight(int level) const { return levels[level].height; }
+
+        // Nearest and farthest occluder depth over texel (x, y) of a level;
+        // level 0 is the depth buffer, where both are equal.
+        float nearestDepth(int level, int x, int y) const { return minDepth[texel(level, x, y)]; }
+        float farthestDepth(int level, int x, int y) const { return maxDepth[texel(level, x, y)]; }
+
+        // Clears the depth buffer, draws the occluders and rebuilds the pyramid.
+        void renderOccluders(const Matrix4f& viewProj, const OccluderMesh* meshes, size_t count, JobPool& pool = JobPool::global())
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            camera = viewProj;
+            worldVertices.clear();
+            worldIndices.clear();
+            stats = OcclusionStats();
+            for (size_t m = 0; m < count; ++m)
+            {
+                const OccluderMesh& mesh = meshes[m];
+                const uint32_t base = (uint32_t)worldVertices.size();
+                worldVertices.resize(base + mesh.vertexCount);
+                transformPoints(mesh.world, mesh.vertices, worldVertices.data() + base, mesh.vertexCount);
+                for (size_t i = 0; i < mesh.triangleCount * 3; ++i) worldIndices.push_back(base + mesh.indices[i]);
+                stats.occluderTriangles += mesh.triangleCount;
+            }
+            setup.process(viewProj, worldVertices.data(), worldVertices.size(), worldIndices.data(), stats.occluderTriangles, pool);
+            stats.rasterTriangles = setup.stats().trianglesOut;
+
+            std::fill(maxDepth.begin(), maxDepth.begin() + (size_t)stride * height, 1.0f);
+#if defined(CPL_X86)
+            const bool simd = SimdDispatch::tier() >= SimdTier::AVX2;
+#endif
+            const int tilesX = setup.tileCountX();
+            pool.parallelFor((size_t)tilesX * setup.tileCountY(), 1, [&](size_t b, size_t e) {
+                for (size_t tile = b; tile < e; ++tile)
+                {
+                    int tx = int(tile % tilesX), ty = int(tile / tilesX);
+                    size_t n;
+                    const uint32_t* bin = setup.bin(tx, ty, n);
+                    for (size_t k = 0; k < n; ++k)
+                    {
+#if defined(CPL_X86)
+                        if (simd) { rasterizeAVX2(setup.triangles()[bin[k]], tx, ty); continue; }
+#endif
+                        rasterize(setup.triangles()[bin[k]], tx, ty);
+                    }
+                }
+            });
+            auto t1 = std::chrono::steady_clock::now();
+            buildPyramid(pool);
+            auto t2 = std::chrono::steady_clock::now();
+            stats.rasterMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+            stats.pyramidMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+        }
+
+        // visible[i] = 0 when boxes[i] (world space) is outside the frustum or
+        // hidden behind the occluders of the last renderOccluders(), else 1.
+        // Returns the number visible.
+        size_t testBoxes(const AABBf* boxes, size_t count, uint8_t* visible, JobPool& pool = JobPool::global())
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            const size_t chunks = JobPool::chunkCount(count, TestGrain);
+            chunkCulls.assign(chunks * 2, 0);
+#if defined(CPL_X86)
+            const bool simd = SimdDispatch::tier() >= SimdTier::AVX2;
+#endif
+            pool.parallelChunks(count, TestGrain, [&](size_t chunk, size_t b, size_t e) {
+                size_t* culls = chunkCulls.data() + chunk * 2;
+#if defined(CPL_X86)
+                if (simd) { testRangeAVX2(boxes, b, e, visible, culls); return; }
+#endif
+                testRange(boxes, b, e, visible, culls);
+            });
+            stats.tested = count;
+            stats.culledFrustum = stats.culledOccluded = 0;
+            for (size_t c = 0; c < chunks; ++c)
+            {
+                stats.culledFrustum += chunkCulls[c * 2];
+                stats.culledOccluded += chunkCulls[c * 2 + 1];
+            }
+            stats.testMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            return count - stats.culledFrustum - stats.culledOccluded;
+        }
+
+        const OcclusionStats& frameStats() const { return stats; }
+
+    private:
+        static constexpr int    TileSize = 32;      // multiple of 8, the AVX2 step
+        static constexpr size_t TestGrain = 1024;
+
+        struct Level { size_t offset; int width, height, stride; };
+
+        int                 width, height, stride;
+        TriangleSetup       setup;
+        Matrix4f            camera;
+        std::vector<Level>  levels;
+        std::vector<float>  maxDepth, minDepth;  // all levels; level 0 of maxDepth is the depth buffer
+        std::vector<Vector3f> worldVertices;
+        std::vector<uint32_t> worldIndices;
+        std::vector<size_t> chunkCulls;
+        OcclusionStats      stats;
+
+        size_t texel(int level, int x, int y) const
+        {
+            const Level& l = levels[level];
+            return l.offset + (size_t)y * l.stride + x;
+        }
+
+        // ─── Rasterization ─────────────────────────────────
+
+        // Edge functions E_k = a_k x + b_k y + c_k (non-negative inside, as the
+        // setup winds every triangle with positive area) and the depth plane
+        // z = zx x + zy y + z0, all in pixel units.
+        struct Plane
+        {
+            float a[3], b[3], c[3];
+            float zx, zy, z0;
+        };
+
+        static Plane plane(const SetupTriangle& t)
+        {
+            Plane p;
+            for (int k = 0; k < 3; ++k)
+            {
+                int n = (k + 1) % 3;
+                p.a[k] = t.y[k] - t.y[n];
+                p.b[k] = t.x[n] - t.x[k];
+                p.c[k] = -(p.a[k] * t.x[k] + p.b[k] * t.y[k]);
+            }
+            // Barycentrics: E_1 weights vertex 0, E_2 vertex 1, E_0 vertex 2.
+            float inv = 1 / (p.a[0] * t.x[2] + p.b[0] * t.y[2] + p.c[0]);
+            p.zx = (p.a[1] * t.z[0] + p.a[2] * t.z[1] + p.a[0] * t.z[2]) * inv;
+            p.zy = (p.b[1] * t.z[0] + p.b[2] * t.z[1] + p.b[0] * t.z[2]) * inv;
+            p.z0 = (p.c[1] * t.z[0] + p.c[2] * t.z[1] + p.c[0] * t.z[2]) * inv;
+            return p;
+        }
+
+        // Pixel bounds of the triangle inside tile (tx, ty), x0 rounded down to 8.
+        bool tileBounds(const SetupTriangle& t, int tx, int ty, int& x0, int& x1, int& y0, int& y1) const
+        {
+            float minX = std::min({ t.x[0], t.x[1], t.x[2] }), maxX = std::max({ t.x[0], t.x[1], t.x[2] });
+            float minY = std::min({ t.y[0], t.y[1], t.y[2] }), maxY = std::max({ t.y[0], t.y[1], t.y[2] });
+            x0 = std::max(tx * TileSize, (int)std::floor(minX)) & ~7;
+            x1 = std::min({ (tx + 1) * TileSize, width, (int)std::ceil(maxX) + 1 });
+            y0 = std::max(ty * TileSize, (int)std::floor(minY));
+            y1 = std::min({ (ty + 1) * TileSize, height, (int)std::ceil(maxY) + 1 });
+            return x0 < x1 && y0 < y1;
+        }
+
+        void rasterize(const SetupTriangle& t, int tx, int ty)
+        {
+            int x0, x1, y0, y1;
+            if (!tileBounds(t, tx, ty, x0, x1, y0, y1)) return;
+            const Plane p = plane(t);
+            for (int y = y0; y < y1; ++y)
+            {
+                float py = y + 0.5f;
+                float* row = maxDepth.data() + (size_t)y * stride;
+                for (int x = x0; x < x1; ++x)
+                {
+                    float px = x + 0.5f;
+                    if (p.a[0] * px + p.b[0] * py + p.c[0] < 0 || p.a[1] * px + p.b[1] * py + p.c[1] < 0 ||
+                        p.a[2] * px + p.b[2] * py + p.c[2] < 0) continue;
+                    row[x] = std::min(row[x], p.zx * px + p.zy * py + p.z0);
+                }
+            }
+        }
+
+#if defined(CPL_X86)
+        // Eight pixels of a row per step; the row stride is padded to 8 so the
+        // last step of a row never touches the next one.
+        CPL_TARGET_AVX2 void rasterizeAVX2(const SetupTriangle& t, int tx, int ty)
+        {
+            int x0, x1, y0, y1;
+            if (!tileBounds(t, tx, ty, x0, x1, y0, y1)) return;
+            const Plane p = plane(t);
+            const __m256 lane = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+            __m256 a[3];
+            for (int k = 0; k < 3; ++k) a[k] = _mm256_set1_ps(p.a[k]);
+            const __m256 zx = _mm256_set1_ps(p.zx);
+            for (int y = y0; y < y1; ++y)
+            {
+                float py = y + 0.5f;
+                __m256 rowE[3];
+                for (int k = 0; k < 3; ++k) rowE[k] = _mm256_set1_ps(p.b[k] * py + p.c[k]);
+                const __m256 rowZ = _mm256_set1_ps(p.zy * py + p.z0);
+                float* row = maxDepth.data() + (size_t)y * stride;
+                for (int x = x0; x < x1; x += 8)
+                {
+                    __m256 px = _mm256_add_ps(_mm256_set1_ps(float(x)), lane);
+                    __m256 e0 = _mm256_fmadd_ps(a[0], px, rowE[0]);
+                    __m256 e1 = _mm256_fmadd_ps(a[1], px, rowE[1]);
+                    __m256 e2 = _mm256_fmadd_ps(a[2], px, rowE[2]);
+                    // Sign bit of any edge set: outside.
+                    __m256 outside = _mm256_or_ps(_mm256_or_ps(e0, e1), e2);
+                    if (_mm256_movemask_ps(outside) == 0xFF) continue;
+                    __m256 d = _mm256_loadu_ps(row + x);
+                    __m256 z = _mm256_min_ps(d, _mm256_fmadd_ps(zx, px, rowZ));
+                    _mm256_storeu_ps(row + x, _mm256_blendv_ps(z, d, outside));
+                }
+            }
+        }
+#endif
+
+        // ─── Pyramid ───────────────────────────────────────
+
+        void buildPyramid(JobPool& pool)
+        {
+            const Level& base = levels[0];
+            for (int y = 0; y < height; ++y)
+                std::copy(maxDepth.begin() + base.offset + (size_t)y * stride, maxDepth.begin() + base.offset + (size_t)y * stride + width,
+                          minDepth.begin() + base.offset + (size_t)y * stride);
+            for (size_t l = 1; l < levels.size(); ++l)
+            {
+                const Level& src = levels[l - 1];
+                const Level& dst = levels[l];
+                pool.parallelFor((size_t)dst.height, 16, [&](size_t b, size_t e) {
+                    for (int y = (int)b; y < (int)e; ++y)
+                    {
+                        int sy0 = 2 * y, sy1 = std::min(2 * y + 1, src.height - 1);
+                        for (int x = 0; x < dst.width; ++x)
+                        {
+                            int sx0 = 2 * x, sx1 = std::min(2 * x + 1, src.width - 1);
+                            size_t s00 = src.offset + (size_t)sy0 * src.stride + sx0, s01 = src.offset + (size_t)sy0 * src.stride + sx1;
+                            size_t s10 = src.offset + (size_t)sy1 * src.stride + sx0, s11 = src.offset + (size_t)sy1 * src.stride + sx1;
+                            size_t d = dst.offset + (size_t)y * dst.stride + x;
+                            maxDepth[d] = std::max(std::max(maxDepth[s00], maxDepth[s01]), std::max(maxDepth[s10], maxDepth[s11]));
+                            minDepth[d] = std::min(std::min(minDepth[s00], minDepth[s01]), std::min(minDepth[s10], minDepth[s11]));
+                        }
+                    }
+                });
+            }
+        }
+
+        // ─── Box tests ─────────────────────────────────────
+
+        enum class Result { Visible, Frustum, Occluded, Project };
+
+        // Screen bounds in pixels and the nearest depth of a projected box.
+        struct ScreenRect { float minX, minY, maxX, maxY, nearZ; };
+
+        // Near-plane margin in clip w: closer corners make the box visible.
+        static constexpr float MinW = 1e-5f;
+
+        Result finishProject(float ndc[4], float nearZ, ScreenRect& r) const
+        {
+            // ndc = min x, min y, max x, max y
+            r.minX = (ndc[0] * 0.5f + 0.5f) * width;
+            r.maxX = (ndc[2] * 0.5f + 0.5f) * width;
+            r.minY = (0.5f - ndc[3] * 0.5f) * height;
+            r.maxY = (0.5f - ndc[1] * 0.5f) * height;
+            r.nearZ = nearZ * 0.5f + 0.5f;
+            return Result::Project;
+        }
+
+        Result project(const AABBf& box, ScreenRect& r) const
+        {
+            uint32_t all = 0x3F, any = 0;
+            bool behind = false;
+            float ndc[4] = { 1e30f, 1e30f, -1e30f, -1e30f }, nearZ = 1e30f;
+            for (int c = 0; c < 8; ++c)
+            {
+                Vector3f p((c & 1) ? box.max.x : box.min.x, (c & 2) ? box.max.y : box.min.y, (c & 4) ? box.max.z : box.min.z);
+                Vector4f v = camera.transformHomogeneous(p);
+                uint32_t code = (v.x < -v.w) | (v.x > v.w) << 1 | (v.y < -v.w) << 2 | (v.y > v.w) << 3 | (v.z < -v.w) << 4 | (v.z > v.w) << 5;
+                all &= code;
+                any |= code;
+                behind |= v.w <= MinW;
+                if (v.w <= MinW) continue;
+                float inv = 1 / v.w;
+                ndc[0] = std::min(ndc[0], v.x * inv); ndc[2] = std::max(ndc[2], v.x * inv);
+                ndc[1] = std::min(ndc[1], v.y * inv); ndc[3] = std::max(ndc[3], v.y * inv);
+                nearZ = std::min(nearZ, v.z * inv);
+            }
+            if (all) return Result::Frustum;
+            if (behind) return Result::Visible;
+            return finishProject(ndc, nearZ, r);
+        }
+
+#if defined(CPL_X86)
+        // The 8 corners in the 8 lanes.
+        CPL_TARGET_AVX2 Result projectAVX2(const AABBf& box, ScreenRect& r) const
+        {
+            __m256 x = _mm256_blend_ps(_mm256_set1_ps(box.min.x), _mm256_set1_ps(box.max.x), 0xAA);
+            __m256 y = _mm256_blend_ps(_mm256_set1_ps(box.min.y), _mm256_set1_ps(box.max.y), 0xCC);
+            __m256 z = _mm256_blend_ps(_mm256_set1_ps(box.min.z), _mm256_set1_ps(box.max.z), 0xF0);
+            __m256 c[4];
+            for (int k = 0; k < 4; ++k)
+                c[k] = _mm256_fmadd_ps(_mm256_set1_ps(camera(k, 0)), x, _mm256_fmadd_ps(_mm256_set1_ps(camera(k, 1)), y,
+                       _mm256_fmadd_ps(_mm256_set1_ps(camera(k, 2)), z, _mm256_set1_ps(camera(k, 3)))));
+            const __m256 negW = _mm256_xor_ps(c[3], _mm256_set1_ps(-0.0f));
+            for (int axis = 0; axis < 3; ++axis)
+                if (_mm256_movemask_ps(_mm256_cmp_ps(c[axis], negW, _CMP_LT_OQ)) == 0xFF ||
+                    _mm256_movemask_ps(_mm256_cmp_ps(c[axis], c[3], _CMP_GT_OQ)) == 0xFF) return Result::Frustum;
+            if (_mm256_movemask_ps(_mm256_cmp_ps(c[3], _mm256_set1_ps(MinW), _CMP_LE_OQ))) return Result::Visible;
+            __m256 inv = _mm256_div_ps(_mm256_set1_ps(1.0f), c[3]);
+            float ndc[4] = { hmin(_mm256_mul_ps(c[0], inv)), hmin(_mm256_mul_ps(c[1], inv)),
+                             hmax(_mm256_mul_ps(c[0], inv)), hmax(_mm256_mul_ps(c[1], inv)) };
+            return finishProject(ndc, hmin(_mm256_mul_ps(c[2], inv)), r);
+        }
+
+        CPL_TARGET_AVX2 static float hmin(__m256 v)
+        {
+            __m128 m = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+            return _mm_cvtss_f32(_mm_min_ss(m, _mm_movehdup_ps(m)));
+        }
+
+        CPL_TARGET_AVX2 static float hmax(__m256 v)
+        {
+            __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+            return _mm_cvtss_f32(_mm_max_ss(m, _mm_movehdup_ps(m)));
+        }
+#endif
+
+        // culls[0] += frustum culled, culls[1] += occluded.
+        void record(Result res, const ScreenRect& r, uint8_t& visible, size_t* culls) const
+        {
+            if (res == Result::Project) res = occluded(r) ? Result::Occluded : Result::Visible;
+            culls[0] += res == Result::Frustum;
+            culls[1] += res == Result::Occluded;
+            visible = res == Result::Visible;
+        }
+
+        void testRange(const AABBf* boxes, size_t b, size_t e, uint8_t* visible, size_t* culls) const
+        {
+            ScreenRect r;
+            for (size_t i = b; i < e; ++i) record(project(boxes[i], r), r, visible[i], culls);
+        }
+
+#if defined(CPL_X86)
+        CPL_TARGET_AVX2 void testRangeAVX2(const AABBf* boxes, size_t b, size_t e, uint8_t* visible, size_t* culls) const
+        {
+            ScreenRect r;
+            for (size_t i = b; i < e; ++i) record(projectAVX2(boxes[i], r), r, visible[i], culls);
+        }
+#endif
+
+        // Hidden when its nearest depth is behind the farthest occluder depth
+        // over every pixel it may touch. The level is picked so the pixel
+        // span fits in 2x2 texels.
+        bool occluded(const ScreenRect& r) const
+        {
+            if (!(r.maxX >= 0 && r.maxY >= 0 && r.minX < width && r.minY < height)) return false;  // off screen
+            // Clamped to the buffer first, so truncation is floor.
+            int x0 = (int)std::max(r.minX, 0.0f), x1 = (int)std::min(r.maxX, float(width - 1));
+            int y0 = (int)std::max(r.minY, 0.0f), y1 = (int)std::min(r.maxY, float(height - 1));
+            // Texels of 2^level pixels, level = floor(log2(span)) + 1 read off
+            // the float exponent, so that span + 1 pixels touch at most two.
+            int span = std::max(x1 - x0, y1 - y0), level = 0;
+            if (span > 0)
+            {
+                float f = float(span);
+                uint32_t bits;
+                std::memcpy(&bits, &f, sizeof(bits));
+                level = std::min(int(bits >> 23) - 126, (int)levels.size() - 1);
+            }
+            x0 >>= level; x1 >>= level; y0 >>= level; y1 >>= level;
+            const Level& l = levels[level];
+            const float* row0 = maxDepth.data() + l.offset + (size_t)y0 * l.stride;
+            const float* row1 = maxDepth.data() + l.offset + (size_t)y1 * l.stride;
+            return r.nearZ > std::max(std::max(row0[x0], row0[x1]), std::max(row1[x0], row1[x1]));
+        }
+    };
+}
@@ -0,0 +1,334 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Vector3.hpp"
+#include "simd_dispatch.hpp"
+#include "job_pool.hpp"
+
+namespace CPL
+{
+    struct ParticleEmitter
+    {
+        Vector3f position;
+        float    radius = 0;            // spawn uniformly in a cube of this half-size
+        Vector3f velocity;
+        float    velocityJitter = 0;    // per-axis, uniform in [-j, j]
+        float    lifetime = 1;
+        float    lifetimeJitter = 0;
+    };
+
+    struct ParticleForces
+    {
+        Vector3f gravity;
+        float    drag = 0;              // per second; velocities shrink by 1 / (1 + drag * dt)
+        float    curlStrength = 0;
+        float    curlFrequency = 1;
+        Vector3f curlOffset;            // scroll this to animate the noise field
+    };
+
+    struct ParticleCounters
+    {
+        size_t live = 0;
+        size_t emitted = 0;             // since the previous update
+        size_t died = 0;                // in the last update
+        double updateMs = 0;            // wall time of the last update, compaction included
+    };
+
+    // Fixed-capacity particle pool with one float stream per component.
+    // update() integrates in job-pool chunks (8 wide on the AVX2 tier) and
+    // fills dead slots by moving the last live particle in, so the live
+    // range stays dense. Emission draws from a counter-based hash, so both
+    // emit() and update() give the same result for any thread count.
+    class ParticleSystem
+    {
+    public:
+        enum Stream { PX, PY, PZ, VX, VY, VZ, Age, Life, StreamCount };
+
+        explicit ParticleSystem(size_t capacity, uint32_t seed = 1)
+            : maxCount(capacity), seed(seed),
+              // A multiple of 4 KiB plus a cache line, so the streams don't share cache sets.
+              stride((capacity + 1023) / 1024 * 1024 + 16),
+              data(StreamCount * stride) {}
+
+        size_t capacity() const { return maxCount; }
+        size_t size() const { return count; }
+
+        const ParticleForces& forces() const { return params; }
+        void setForces(const ParticleForces& f) { params = f; }
+
+        const ParticleCounters& counters() const { return stats; }
+
+        Vector3f position(size_t i) const { return { at(PX, i), at(PY, i), at(PZ, i) }; }
+        Vector3f velocity(size_t i) const { return { at(VX, i), at(VY, i), at(VZ, i) }; }
+        float age(size_t i) const { return at(Age, i); }
+        float lifetime(size_t i) const { return at(Life, i); }
+
+        const float* stream(Stream s) const { return data.data() + s * stride; }
+
+        // Spawns up to n particles (fewer if the pool is full); returns how many.
+        size_t emit(const ParticleEmitter& em, size_t n, JobPool& pool = JobPool::global())
+        {
+            n = std::min(n, maxCount - count);
+            float* s[StreamCount];
+            streamPointers(s);
+            const size_t first = count;
+            const uint64_t sequence = emitted;
+            pool.parallelFor(n, 4096, [&](size_t b, size_t e) {
+                for (size_t j = b; j < e; ++j)
+                {
+                    uint64_t key = (sequence + j) * 8;
+                    size_t i = first + j;
+                    s[PX][i] = em.position.x + em.radius * signedUnit(key, 0);
+                    s[PY][i] = em.position.y + em.radius * signedUnit(key, 1);
+                    s[PZ][i] = em.position.z + em.radius * signedUnit(key, 2);
+                    s[VX][i] = em.velocity.x + em.velocityJitter * signedUnit(key, 3);
+                    s[VY][i] = em.velocity.y + em.velocityJitter * signedUnit(key, 4);
+                    s[VZ][i] = em.velocity.z + em.velocityJitter * signedUnit(key, 5);
+                    s[Age][i] = 0;
+                    s[Life][i] = em.lifetime + em.lifetimeJitter * signedUnit(key, 6);
+                }
+            });
+            count += n;
+            emitted += n;
+            stats.emitted += n;
+            stats.live = count;
+            return n;
+        }
+
+        void update(float dt, JobPool& pool = JobPool::global())
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            Params p{ dt, params.gravity.x, params.gravity.y, params.gravity.z, 1 / (1 + params.drag * dt),
+                      params.curlStrength, params.curlFrequency,
+                      params.curlOffset.x, params.curlOffset.y, params.curlOffset.z };
+            float* s[StreamCount];
+            streamPointers(s);
+
+            // Each chunk lists its dead particles in ascending order, so the
+            // concatenation is sorted and independent of scheduling.
+            dead.resize(JobPool::chunkCount(count, Grain));
+#if defined(CPL_X86)
+            const bool simd = SimdDispatch::tier() >= SimdTier::AVX2;
+#endif
+            pool.parallelChunks(count, Grain, [&](size_t c, size_t b, size_t e) {
+                std::vector<uint32_t>& out = dead[c];
+                out.clear();
+#if defined(CPL_X86)
+                if (simd) b = updateAVX2(s, b, e, p, out);
+#endif
+                updateScalar(s, b, e, p, out);
+            });
+
+            compact(pool);
+
+            stats.live = count;
+            stats.died = deadList.size();
+            stats.emitted = 0;
+            stats.updateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        }
+
+        void clear()
+        {
+            count = 0;
+            stats.live = 0;
+        }
+
+        // The force field update() applies: curl of the potential
+        // (sin y cos z, sin z cos x, sin x cos y) at p * frequency + offset,
+        // which is divergence-free, so particles swirl without bunching up.
+        // Uses the same sine approximation as update().
+        Vector3f curlNoise(const Vector3f& pos) const
+        {
+            const float k = params.curlFrequency;
+            float sx, cx, sy, cy, sz, cz;
+            sinCos(pos.x * k + params.curlOffset.x, sx, cx);
+            sinCos(pos.y * k + params.curlOffset.y, sy, cy);
+            sinCos(pos.z * k + params.curlOffset.z, sz, cz);
+            return Vector3f(sx * sy + cx * cz, sy * sz + cx * cy, sz * sx + cy * cz) * (-k);
+        }
+
+    private:
+        static constexpr size_t Grain = 4096;
+
+        struct Params
+        {
+            float dt, gx, gy, gz, dragScale;
+            float curlStrength, curlFrequency, ox, oy, oz;
+        };
+
+        size_t             maxCount, count = 0;
+        uint32_t           seed;
+        uint64_t           emitted = 0;
+        size_t             stride;
+        std::vector<float> data;
+        ParticleForces     params;
+        ParticleCounters   stats;
+        std::vector<std::vector<uint32_t>> dead;   // per update chunk
+        std::vector<uint32_t>              deadList;
+        struct Move { uint32_t to, from; };
+        std::vector<Move>                  moves;
+
+        float& at(int s, size_t i) { return data[s * stride + i]; }
+        float  at(int s, size_t i) const { return data[s * stride + i]; }
+
+        void streamPointers(float** s)
+        {
+            for (int k = 0; k < StreamCount; ++k) s[k] = data.data() + k * stride;
+        }
+
+        // Uniform in [-1, 1) from (seed, key + lane).
+        float signedUnit(uint64_t key, uint32_t lane) const
+        {
+            uint64_t h = (key + lane) * 0x9E3779B97F4A7C15ull ^ seed;
+            h ^= h >> 33; h *= 0xFF51AFD7ED558CCDull;
+            h ^= h >> 33; h *= 0xC4CEB9FE1A85EC53ull;
+            h ^= h >> 33;
+            return float(h >> 40) * (2.0f / 16777216.0f) - 1.0f;
+        }
+
+        // Swap-remove: pair holes from the front of the sorted dead list with
+        // live particles from the end (dropping dead ones found there), then
+        // do the copies stream by stream across the pool.
+        void compact(JobPool& pool)
+        {
+            deadList.clear();
+            for (const auto& d : dead) deadList.insert(deadList.end(), d.begin(), d.end());
+            moves.clear();
+            size_t end = count, lo = 0, hi = deadList.size();
+            while (lo < hi)
+            {
+                if (deadList[hi - 1] == end - 1) { --hi; --end; continue; }
+                moves.push_back({ deadList[lo++], (uint32_t)--end });
+            }
+            count = end;
+
+            pool.parallelFor(moves.size(), 4096, [&](size_t b, size_t e) {
+                for (int k = 0; k < StreamCount; ++k)
+                {
+                    float* s = data.data() + k * stride;
+                    for (size_t j = b; j < e; ++j) s[moves[j].to] = s[moves[j].from];
+                }
+            });
+        }
+
+        // sin and cos from one range reduction: fold into [-pi/2, pi/2], then
+        // Taylor polynomials of degree 11 and 10 (error below 1e-6 there).
+        static void sinCos(float x, float& s, float& c)
+        {
+            const float invTwoPi = 0.15915494f, twoPiHi = 6.28125f, twoPiLo = 1.9353072e-3f;
+            const float pi = 3.14159265f, halfPi = 1.57079633f;
+            float q = std::nearbyint(x * invTwoPi);
+            float r = (x - q * twoPiHi) - q * twoPiLo;
+            bool outer = std::abs(r) > halfPi;
+            float f = outer ? std::copysign(pi, r) - r : r;
+            float f2 = f * f;
+            s = f * (1 + f2 * (-1.0f / 6 + f2 * (1.0f / 120 + f2 * (-1.0f / 5040 + f2 * (1.0f / 362880 + f2 * (-1.0f / 39916800))))));
+            float cf = 1 + f2 * (-0.5f + f2 * (1.0f / 24 + f2 * (-1.0f / 720 + f2 * (1.0f / 40320 + f2 * (-1.0f / 3628800)))));
+            c = outer ? -cf : cf;
+        }
+
+        static void updateScalar(float* const* s, size_t b, size_t e, const Params& p, std::vector<uint32_t>& dead)
+        {
+            const float dt = p.dt;
+            for (size_t i = b; i < e; ++i)
+            {
+                float x = s[PX][i], y = s[PY][i], z = s[PZ][i];
+                float ax = p.gx, ay = p.gy, az = p.gz;
+                if (p.curlStrength != 0)
+                {
+                    const float k = p.curlFrequency, m = -k * p.curlStrength;
+                    float sx, cx, sy, cy, sz, cz;
+                    sinCos(x * k + p.ox, sx, cx);
+                    sinCos(y * k + p.oy, sy, cy);
+                    sinCos(z * k + p.oz, sz, cz);
+                    ax += (sx * sy + cx * cz) * m;
+                    ay += (sy * sz + cx * cy) * m;
+                    az += (sz * sx + cy * cz) * m;
+                }
+                float vx = (s[VX][i] + ax * dt) * p.dragScale;
+                float vy = (s[VY][i] + ay * dt) * p.dragScale;
+                float vz = (s[VZ][i] + az * dt) * p.dragScale;
+                s[PX][i] = x + vx * dt; s[PY][i] = y + vy * dt; s[PZ][i] = z + vz * dt;
+                s[VX][i] = vx; s[VY][i] = vy; s[VZ][i] = vz;
+                float age = s[Age][i] + dt;
+                s[Age][i] = age;
+                if (age >= s[Life][i]) dead.push_back((uint32_t)i);
+            }
+        }
+
+#if defined(CPL_X86)
+        CPL_TARGET_AVX2 static void sinCos8(__m256 x, __m256& s, __m256& c)
+        {
+            const __m256 halfPi = _mm256_set1_ps(1.57079633f), pi = _mm256_set1_ps(3.14159265f);
+            const __m256 signBit = _mm256_set1_ps(-0.0f), one = _mm256_set1_ps(1.0f);
+            __m256 q = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(0.15915494f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            __m256 r = _mm256_sub_ps(_mm256_sub_ps(x, _mm256_mul_ps(q, _mm256_set1_ps(6.28125f))),
+                                     _mm256_mul_ps(q, _mm256_set1_ps(1.9353072e-3f)));
+            // |r| > pi/2: r -> copysign(pi, r) - r
+            __m256 absR = _mm256_andnot_ps(signBit, r);
+            __m256 outer = _mm256_cmp_ps(absR, halfPi, _CMP_GT_OQ);
+            __m256 signedPi = _mm256_or_ps(pi, _mm256_and_ps(signBit, r));
+            __m256 folded = _mm256_blendv_ps(r, _mm256_sub_ps(signedPi, r), outer);
+            __m256 f2 = _mm256_mul_ps(folded, folded);
+            __m256 sp = _mm256_fmadd_ps(f2, _mm256_set1_ps(-1.0f / 39916800), _mm256_set1_ps(1.0f / 362880));
+            sp = _mm256_fmadd_ps(f2, sp, _mm256_set1_ps(-1.0f / 5040));
+            sp = _mm256_fmadd_ps(f2, sp, _mm256_set1_ps(1.0f / 120));
+            sp = _mm256_fmadd_ps(f2, sp, _mm256_set1_ps(-1.0f / 6));
+            sp = _mm256_fmadd_ps(f2, sp, one);
+            s = _mm256_mul_ps(folded, sp);
+            __m256 cp = _mm256_fmadd_ps(f2, _mm256_set1_ps(-1.0f / 3628800), _mm256_set1_ps(1.0f / 40320));
+            cp = _mm256_fmadd_ps(f2, cp, _mm256_set1_ps(-1.0f / 720));
+            cp = _mm256_fmadd_ps(f2, cp, _mm256_set1_ps(1.0f / 24));
+            cp = _mm256_fmadd_ps(f2, cp, _mm256_set1_ps(-0.5f));
+            cp = _mm256_fmadd_ps(f2, cp, one);
+            c = _mm256_xor_ps(cp, _mm256_and_ps(outer, signBit));
+        }
+
+        // Same steps as updateScalar, 8 particles per iteration; returns where it stopped.
+        CPL_TARGET_AVX2 static size_t updateAVX2(float* const* s, size_t b, size_t e, const Params& p, std::vector<uint32_t>& dead)
+        {
+            const __m256 dt = _mm256_set1_ps(p.dt), dragScale = _mm256_set1_ps(p.dragScale);
+            const __m256 gx = _mm256_set1_ps(p.gx), gy = _mm256_set1_ps(p.gy), gz = _mm256_set1_ps(p.gz);
+            const __m256 k = _mm256_set1_ps(p.curlFrequency), m = _mm256_set1_ps(-p.curlFrequency * p.curlStrength);
+            const __m256 ox = _mm256_set1_ps(p.ox), oy = _mm256_set1_ps(p.oy), oz = _mm256_set1_ps(p.oz);
+            const bool curl = p.curlStrength != 0;
+
+            size_t i = b;
+            for (; i + 8 <= e; i += 8)
+            {
+                __m256 x = _mm256_loadu_ps(s[PX] + i), y = _mm256_loadu_ps(s[PY] + i), z = _mm256_loadu_ps(s[PZ] + i);
+                __m256 ax = gx, ay = gy, az = gz;
+                if (curl)
+                {
+                    __m256 sx, cx, sy, cy, sz, cz;
+                    sinCos8(_mm256_fmadd_ps(x, k, ox), sx, cx);
+                    sinCos8(_mm256_fmadd_ps(y, k, oy), sy, cy);
+                    sinCos8(_mm256_fmadd_ps(z, k, oz), sz, cz);
+                    ax = _mm256_fmadd_ps(_mm256_fmadd_ps(sx, sy, _mm256_mul_ps(cx, cz)), m, ax);
+                    ay = _mm256_fmadd_ps(_mm256_fmadd_ps(sy, sz, _mm256_mul_ps(cx, cy)), m, ay);
+                    az = _mm256_fmadd_ps(_mm256_fmadd_ps(sz, sx, _mm256_mul_ps(cy, cz)), m, az);
+                }
+                __m256 vx = _mm256_mul_ps(_mm256_fmadd_ps(ax, dt, _mm256_loadu_ps(s[VX] + i)), dragScale);
+                __m256 vy = _mm256_mul_ps(_mm256_fmadd_ps(ay, dt, _mm256_loadu_ps(s[VY] + i)), dragScale);
+                __m256 vz = _mm256_mul_ps(_mm256_fmadd_ps(az, dt, _mm256_loadu_ps(s[VZ] + i)), dragScale);
+                _mm256_storeu_ps(s[PX] + i, _mm256_fmadd_ps(vx, dt, x));
+                _mm256_storeu_ps(s[PY] + i, _mm256_fmadd_ps(vy, dt, y));
+                _mm256_storeu_ps(s[PZ] + i, _mm256_fmadd_ps(vz, dt, z));
+                _mm256_storeu_ps(s[VX] + i, vx);
+                _mm256_storeu_ps(s[VY] + i, vy);
+                _mm256_storeu_ps(s[VZ] + i, vz);
+                __m256 age = _mm256_add_ps(_mm256_loadu_ps(s[Age] + i), dt);
+                _mm256_storeu_ps(s[Age] + i, age);
+                int mask = _mm256_movemask_ps(_mm256_cmp_ps(age, _mm256_loadu_ps(s[Life] + i), _CMP_GE_OQ));
+                for (int lane = 0; mask; ++lane, mask >>= 1)
+                    if (mask & 1) dead.push_back((uint32_t)(i + lane));
+            }
+            return i;
+        }
+#endif
+    };
+}
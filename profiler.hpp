@@ -0,0 +1,225 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <ios>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CPL_PROFILER_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CPL_PROFILER_RDTSC 1
+#endif
+
+namespace CPL
+{
+    struct ProfileEvent
+    {
+        const char* name;
+        uint64_t    begin;
+        uint64_t    end;
+    };
+
+    // One per thread, written only by its owner. Oldest events are overwritten
+    // once the ring is full.
+    struct ProfileBuffer
+    {
+        std::vector<ProfileEvent> events;
+        std::atomic<uint64_t>     head{ 0 };
+        uint64_t                  mask = 0;
+        uint32_t                  tid = 0;
+    };
+
+    class Profiler
+    {
+    public:
+        static uint64_t now()
+        {
+#if defined(CPL_PROFILER_RDTSC)
+            return __rdtsc();
+#else
+            return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+        }
+
+        static bool enabled() { return state().enabled.load(std::memory_order_relaxed); }
+        static void setEnabled(bool on) { state().enabled.store(on, std::memory_order_relaxed); }
+
+        // Events per thread, rounded up to a power of two. Only affects threads
+        // that record their first event after the call.
+        static void setCapacity(size_t events)
+        {
+            size_t cap = 1;
+            while (cap < events) cap <<= 1;
+            state().capacity = cap;
+        }
+
+        static void record(const char* name, uint64_t begin, uint64_t end)
+        {
+            ProfileBuffer* buf = threadBuffer();
+            uint64_t i = buf->head.load(std::memory_order_relaxed);
+            buf->events[i & buf->mask] = { name, begin, end };
+            buf->head.store(i + 1, std::memory_order_release);
+        }
+
+        // Number of events currently held across all threads.
+        static size_t eventCount()
+        {
+            State& s = state();
+            std::lock_guard<std::mutex> lock(s.mutex);
+            size_t n = 0;
+            for (auto& b : s.buffers) n += (size_t)visibleCount(*b);
+            return n;
+        }
+
+        // Drops every held event. Resets other threads' rings, so call it
+        // with no scopes open, like writeChromeTrace().
+        static void clear()
+        {
+            State& s = state();
+            std::lock_guard<std::mutex> lock(s.mutex);
+            for (auto& b : s.buffers) b->head.store(0, std::memory_order_release);
+        }
+
+        // Chrome trace-event JSON (chrome://tracing, Perfetto). Call while the
+        // recording threads are quiescent, e.g. between frames or at exit.
+        static void writeChromeTrace(std::ostream& os)
+        {
+            State& s = state();
+            std::lock_guard<std::mutex> lock(s.mutex);
+            double usPerTick = microsecondsPerTick();
+            // Fixed nanosecond decimals: the default 6 significant digits
+            // drop to 10 us resolution a second in, and worse later.
+            std::ios_base::fmtflags flags = os.flags();
+            std::streamsize precision = os.precision();
+            os << std::fixed << std::setprecision(3);
+
+            os << "{\"traceEvents\":[";
+            bool first = true;
+            for (auto& b : s.buffers)
+            {
+                uint64_t head = b->head.load(std::memory_order_acquire);
+                uint64_t count = visibleCount(*b);
+                for (uint64_t i = head - count; i < head; ++i)
+                {
+                    const ProfileEvent& e = b->events[i & b->mask];
+                    os << (first ? "" : ",") << "\n{\"name\":\"";
+                    writeEscaped(os, e.name);
+                    os << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->tid
+                       << ",\"ts\":" << (double)(e.begin - s.epochTicks) * usPerTick
+                       << ",\"dur\":" << (double)(e.end - e.begin) * usPerTick << '}';
+                    first = false;
+                }
+            }
+            os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+            os.flags(flags);
+            os.precision(precision);
+        }
+
+        static bool dumpChromeTrace(const std::string& path)
+        {
+            std::ofstream out(path);
+            if (!out) return false;
+            writeChromeTrace(out);
+            return (bool)out;
+        }
+
+    private:
+        struct State
+        {
+            std::mutex                                  mutex;
+            std::vector<std::unique_ptr<ProfileBuffer>> buffers;
+            std::atomic<bool>                           enabled{ true };
+            size_t                                      capacity = 1 << 16;
+            uint64_t                                    epochTicks = now();
+            std::chrono::steady_clock::time_point       epochTime = std::chrono::steady_clock::now();
+        };
+
+        static State& state()
+        {
+            static State s;
+            return s;
+        }
+
+        static ProfileBuffer* threadBuffer()
+        {
+            static thread_local ProfileBuffer* tls = nullptr;
+            if (!tls) tls = registerThread();
+            return tls;
+        }
+
+        // Cold path: buffers are owned by the registry so they outlive their thread.
+        static ProfileBuffer* registerThread()
+        {
+            State& s = state();
+            std::lock_guard<std::mutex> lock(s.mutex);
+            auto buf = std::make_unique<ProfileBuffer>();
+            buf->events.resize(s.capacity);
+            buf->mask = s.capacity - 1;
+            buf->tid = (uint32_t)s.buffers.size() + 1;
+            s.buffers.push_back(std::move(buf));
+            return s.buffers.back().get();
+        }
+
+        static uint64_t visibleCount(const ProfileBuffer& b)
+        {
+            uint64_t head = b.head.load(std::memory_order_acquire);
+            return head < b.events.size() ? head : b.events.size();
+        }
+
+        static double microsecondsPerTick()
+        {
+#if defined(CPL_PROFILER_RDTSC)
+            State& s = state();
+            uint64_t ticks = now() - s.epochTicks;
+            double us = std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - s.epochTime).count();
+            return ticks ? us / (double)ticks : 0.0;
+#else
+            return 1e-3;
+#endif
+        }
+
+        static void writeEscaped(std::ostream& os, const char* str)
+        {
+            for (; *str; ++str)
+            {
+                if (*str == '"' || *str == '\\') os << '\\';
+                os << *str;
+            }
+        }
+    };
+
+    class ScopedTimer
+    {
+        const char* name;
+        uint64_t    begin;
+
+    public:
+        explicit ScopedTimer(const char* name)
+            : name(Profiler::enabled() ? name : nullptr), begin(Profiler::now()) {}
+        ~ScopedTimer() { if (name) Profiler::record(name, begin, Profiler::now()); }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+    };
+}
+
+#define CPL_PROFILE_CONCAT_(a, b) a##b
+#define CPL_PROFILE_CONCAT(a, b) CPL_PROFILE_CONCAT_(a, b)
+
+#if defined(CPL_DISABLE_PROFILER)
+#define CPL_PROFILE_SCOPE(name) ((void)0)
+#else
+// `name` must outlive the trace dump; string literals are the intended use.
+#define CPL_PROFILE_SCOPE(name) ::CPL::ScopedTimer CPL_PROFILE_CONCAT(cplScope_, __LINE__)(name)
+#endif
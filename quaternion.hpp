@@ -0,0 +1,121 @@
+#pragma once
+#include <cmath>
+#include <ostream>
+#include "Vector3.hpp"
+#include "matrix3.hpp"
+#include "matrix4.hpp"
+
+namespace CPL
+{
+    // Rotation quaternion x*i + y*j + z*k + w. Products compose like
+    // matrices: (a * b).rotate(v) == a.rotate(b.rotate(v)).
+    template<typename T>
+    class Quaternion
+    {
+    public:
+        T x, y, z, w;
+
+        Quaternion() : x(0), y(0), z(0), w(1) {}
+        Quaternion(T x, T y, T z, T w) : x(x), y(y), z(z), w(w) {}
+
+        static Quaternion identity() { return Quaternion(0, 0, 0, 1); }
+
+        // `axis` must be unit length.
+        static Quaternion fromAxisAngle(const Vector3<T>& axis, T rad)
+        {
+            T s = std::sin(rad / 2);
+            return Quaternion(axis.x * s, axis.y * s, axis.z * s, std::cos(rad / 2));
+        }
+
+        // `r` must be a pure rotation. Branches on the largest diagonal term
+        // so the square root never takes a small argument.
+        static Quaternion fromMatrix3(const Matrix3<T>& r)
+        {
+            T trace = r(0, 0) + r(1, 1) + r(2, 2);
+            if (trace > 0)
+            {
+                T s = std::sqrt(trace + 1) * 2;
+                return Quaternion((r(2, 1) - r(1, 2)) / s, (r(0, 2) - r(2, 0)) / s, (r(1, 0) - r(0, 1)) / s, s / 4);
+            }
+            if (r(0, 0) > r(1, 1) && r(0, 0) > r(2, 2))
+            {
+                T s = std::sqrt(1 + r(0, 0) - r(1, 1) - r(2, 2)) * 2;
+                return Quaternion(s / 4, (r(0, 1) + r(1, 0)) / s, (r(0, 2) + r(2, 0)) / s, (r(2, 1) - r(1, 2)) / s);
+            }
+            if (r(1, 1) > r(2, 2))
+            {
+                T s = std::sqrt(1 + r(1, 1) - r(0, 0) - r(2, 2)) * 2;
+                return Quaternion((r(0, 1) + r(1, 0)) / s, s / 4, (r(1, 2) + r(2, 1)) / s, (r(0, 2) - r(2, 0)) / s);
+            }
+            T s = std::sqrt(1 + r(2, 2) - r(0, 0) - r(1, 1)) * 2;
+            return Quaternion((r(0, 2) + r(2, 0)) / s, (r(1, 2) + r(2, 1)) / s, s / 4, (r(1, 0) - r(0, 1)) / s);
+        }
+
+        Quaternion operator*(const Quaternion& o) const
+        {
+            return { w * o.x + x * o.w + y * o.z - z * o.y,
+                     w * o.y - x * o.z + y * o.w + z * o.x,
+                     w * o.z + x * o.y - y * o.x + z * o.w,
+                     w * o.w - x * o.x - y * o.y - z * o.z };
+        }
+
+        Quaternion operator+(const Quaternion& o) const { return { x + o.x, y + o.y, z + o.z, w + o.w }; }
+        Quaternion operator*(T s) const { return { x * s, y * s, z * s, w * s }; }
+
+        bool operator==(const Quaternion& o) const { return x == o.x && y == o.y && z == o.z && w == o.w; }
+        bool operator!=(const Quaternion& o) const { return !(*this == o); }
+
+        T dot(const Quaternion& o) const { return x * o.x + y * o.y + z * o.z + w * o.w; }
+        T length() const { return std::sqrt(dot(*this)); }
+
+        Quaternion conjugate() const { return { -x, -y, -z, w }; }
+
+        Quaternion normalized() const
+        {
+            T len = length();
+            return (len == T(0)) ? identity() : (*this) * (1 / len);
+        }
+        void normalize() { *this = normalized(); }
+
+        // Normalized lerp along the shorter arc. Not constant speed like
+        // slerp, but close for the small steps between keyframes.
+        static Quaternion nlerp(const Quaternion& a, const Quaternion& b, T t)
+        {
+            T wb = a.dot(b) < 0 ? -t : t;
+            return (a * (1 - t) + b * wb).normalized();
+        }
+
+        // v' = v + 2w(u x v) + 2u x (u x v), u = (x, y, z)
+        Vector3<T> rotate(const Vector3<T>& v) const
+        {
+            Vector3<T> u(x, y, z);
+            Vector3<T> t = u.cross(v) * 2;
+            return v + t * w + u.cross(t);
+        }
+
+        Matrix3<T> toMatrix3() const
+        {
+            T xx = x * x, yy = y * y, zz = z * z, xy = x * y, xz = x * z, yz = y * z, wx = w * x, wy = w * y, wz = w * z;
+            return Matrix3<T>{ 1 - 2 * (yy + zz), 2 * (xy - wz),     2 * (xz + wy),
+                               2 * (xy + wz),     1 - 2 * (xx + zz), 2 * (yz - wx),
+                               2 * (xz - wy),     2 * (yz + wx),     1 - 2 * (xx + yy) };
+        }
+
+        // Rotation followed by translation.
+        Matrix4<T> toMatrix4(const Vector3<T>& translation = Vector3<T>()) const
+        {
+            Matrix3<T> r = toMatrix3();
+            return Matrix4<T>{ r(0, 0), r(0, 1), r(0, 2), translation.x,
+                               r(1, 0), r(1, 1), r(1, 2), translation.y,
+                               r(2, 0), r(2, 1), r(2, 2), translation.z,
+                               0,       0,       0,       1 };
+        }
+
+        friend std::ostream& operator<<(std::ostream& os, const Quaternion& q)
+        {
+            return os << '(' << q.x << ", " << q.y << ", " << q.z << ", " << q.w << ')';
+        }
+    };
+
+    using Quaternionf = Quaternion<float>;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <limits>
+#include <ostream>
+#include "Vector3.hpp"
+#include "matrix4.hpp"
+
+namespace CPL
+{
+    // Half-open segment origin + direction * t for t in [tMin, tMax]. The
+    // direction is not required to be normalized; t is in its units.
+    template<typename T>
+    struct Ray
+    {
+        Vector3<T> origin, direction;
+        T          tMin = T(0);
+        T          tMax = std::numeric_limits<T>::max();
+
+        Ray() = default;
+        Ray(const Vector3<T>& origin, const Vector3<T>& direction, T tMin = T(0), T tMax = std::numeric_limits<T>::max())
+            : origin(origin), direction(direction), tMin(tMin), tMax(tMax) {}
+
+        Vector3<T> at(T t) const { return origin + direction * t; }
+
+        // Origin as a point, direction without translation. t stays valid
+        // because the direction is not renormalized. Assumes an affine m.
+        Ray transformed(const Matrix4<T>& m) const
+        {
+            const Vector3<T>& d = direction;
+            Vector3<T> nd(m(0, 0) * d.x + m(0, 1) * d.y + m(0, 2) * d.z,
+                          m(1, 0) * d.x + m(1, 1) * d.y + m(1, 2) * d.z,
+                          m(2, 0) * d.x + m(2, 1) * d.y + m(2, 2) * d.z);
+            return Ray(m * origin, nd, tMin, tMax);
+        }
+
+        friend std::ostream& operator<<(std::ostream& os, const Ray& r)
+        {
+            return os << '[' << r.origin << " + t" << r.direction << ", t in " << r.tMin << ".." << r.tMax << ']';
+        }
+    };
+
+    using Rayf = Ray<float>;
+}
@@ -0,0 +1,353 @@
+#pragma once
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "Vector3.hpp"
+#include "ray.hpp"
+#include "simd_dispatch.hpp"
+#include "job_pool.hpp"
+
+namespace CPL
+{
+    struct RayHit
+    {
+        static constexpr uint32_t None = 0xFFFFFFFFu;
+
+        float    t = std::numeric_limits<float>::max();
+        float    u = 0, v = 0;          // barycentrics of vertex 1 and 2
+        uint32_t triangle = None;
+
+        bool hit() const { return triangle != None; }
+    };
+
+    enum class TriangleTest
+    {
+        Fast,       // Möller–Trumbore; may miss rays through shared edges
+        Watertight  // Woop, Benthin & Wald 2013; never leaks between adjacent triangles
+    };
+
+    // Möller–Trumbore, two-sided. Returns true for a hit in [ray.tMin, ray.tMax].
+    template<typename T>
+    bool intersectTriangle(const Ray<T>& ray, const Vector3<T>& v0, const Vector3<T>& v1, const Vector3<T>& v2,
+                           T& t, T& u, T& v)
+    {
+        Vector3<T> e1(v1.x - v0.x, v1.y - v0.y, v1.z - v0.z);
+        Vector3<T> e2(v2.x - v0.x, v2.y - v0.y, v2.z - v0.z);
+        Vector3<T> p = ray.direction.cross(e2);
+        T det = e1.dot(p);
+        if (!(std::abs(det) >= std::numeric_limits<T>::min())) return false;
+        T inv = T(1) / det;
+        Vector3<T> s(ray.origin.x - v0.x, ray.origin.y - v0.y, ray.origin.z - v0.z);
+        u = s.dot(p) * inv;
+        if (u < 0 || u > 1) return false;
+        Vector3<T> q = s.cross(e1);
+        v = ray.direction.dot(q) * inv;
+        if (v < 0 || u + v > 1) return false;
+        t = e2.dot(q) * inv;
+        return t >= ray.tMin && t <= ray.tMax;
+    }
+
+    // Triangles transposed into packets of 8 so one ray tests 8 at a time.
+    // The tail packet is padded with NaN triangles, which never hit.
+    class TriangleBatch
+    {
+    public:
+        TriangleBatch() = default;
+        TriangleBatch(const Vector3f* vertices, const uint32_t* indices, size_t triangleCount)
+        {
+            build(vertices, indices, triangleCount);
+        }
+
+        // indices == nullptr means a triangle soup: triangle i is vertices[3i..3i+2].
+        void build(const Vector3f* vertices, const uint32_t* indices, size_t triangleCount)
+        {
+            count = triangleCount;
+            packets.assign((triangleCount + 7) / 8, Packet());
+            for (Packet& p : packets)
+                for (auto& corner : p.v)
+                    for (auto& axis : corner)
+                        for (float& f : axis) f = std::numeric_limits<float>::quiet_NaN();
+
+            for (size_t i = 0; i < triangleCount; ++i)
+            {
+                Packet& p = packets[i / 8];
+                size_t lane = i % 8;
+                for (int c = 0; c < 3; ++c)
+                {
+                    const Vector3f& v = vertices[indices ? indices[3 * i + c] : 3 * i + c];
+                    p.v[c][0][lane] = v.x;
+                    p.v[c][1][lane] = v.y;
+                    p.v[c][2][lane] = v.z;
+                }
+            }
+        }
+
+        size_t size() const { return count; }
+
+        // Closest hit; ties go to the lower triangle index.
+        RayHit intersect(const Rayf& ray, TriangleTest test = TriangleTest::Fast) const
+        {
+            RayHit hit;
+            trace<false>(ray, test, hit);
+            return hit;
+        }
+
+        // Any hit: stops at the first triangle found, so shadow rays skip the sort.
+        bool occluded(const Rayf& ray, TriangleTest test = TriangleTest::Fast) const
+        {
+            RayHit hit;
+            return trace<true>(ray, test, hit);
+        }
+
+        void intersect(const Rayf* rays, size_t n, RayHit* hits, TriangleTest test = TriangleTest::Fast,
+                       JobPool& pool = JobPool::global()) const
+        {
+            pool.parallelFor(n, 64, [&](size_t b, size_t e) {
+                for (size_t i = b; i < e; ++i) hits[i] = intersect(rays[i], test);
+            });
+        }
+
+    private:
+        struct alignas(32) Packet { float v[3][3][8]; }; // [corner][axis][lane]
+
+        // Per-ray constants. The watertight test shears the triangle into a
+        // space where the ray runs along +z (axis kz) from the origin.
+        struct Prepared
+        {
+            float o[3], d[3];
+            float tMin, tMax;
+            int   kx, ky, kz;
+            float sx, sy, sz;
+        };
+
+        std::vector<Packet> packets;
+        size_t              count = 0;
+
+        static Prepared prepare(const Rayf& r)
+        {
+            Prepared p{ { r.origin.x, r.origin.y, r.origin.z }, { r.direction.x, r.direction.y, r.direction.z },
+                        r.tMin, r.tMax, 0, 0, 0, 0, 0, 0 };
+            float ax = std::abs(p.d[0]), ay = std::abs(p.d[1]), az = std::abs(p.d[2]);
+            p.kz = (ax > ay && ax > az) ? 0 : (ay > az ? 1 : 2);
+            p.kx = (p.kz + 1) % 3;
+            p.ky = (p.kx + 1) % 3;
+            if (p.d[p.kz] < 0) std::swap(p.kx, p.ky); // keep the winding
+            p.sx = p.d[p.kx] / p.d[p.kz];
+            p.sy = p.d[p.ky] / p.d[p.kz];
+            p.sz = 1.0f / p.d[p.kz];
+            return p;
+        }
+
+        // ─── Scalar, one lane ──────────────────────────────────
+
+        static bool testFast(const Prepared& r, const Packet& p, int l, float& t, float& u, float& v)
+        {
+            float e1[3], e2[3], s[3];
+            for (int a = 0; a < 3; ++a)
+            {
+                e1[a] = p.v[1][a][l] - p.v[0][a][l];
+                e2[a] = p.v[2][a][l] - p.v[0][a][l];
+                s[a] = r.o[a] - p.v[0][a][l];
+            }
+            float px = r.d[1] * e2[2] - r.d[2] * e2[1], py = r.d[2] * e2[0] - r.d[0] * e2[2], pz = r.d[0] * e2[1] - r.d[1] * e2[0];
+            float det = e1[0] * px + e1[1] * py + e1[2] * pz;
+            if (!(std::abs(det) >= FLT_MIN)) return false;
+            float inv = 1.0f / det;
+            u = (s[0] * px + s[1] * py + s[2] * pz) * inv;
+            float qx = s[1] * e1[2] - s[2] * e1[1], qy = s[2] * e1[0] - s[0] * e1[2], qz = s[0] * e1[1] - s[1] * e1[0];
+            v = (r.d[0] * qx + r.d[1] * qy + r.d[2] * qz) * inv;
+            t = (e2[0] * qx + e2[1] * qy + e2[2] * qz) * inv;
+            return u >= 0 && v >= 0 && u + v <= 1;
+        }
+
+        // Edge functions of the sheared 2D triangle. Float products are exact
+        // in double, so these are antisymmetric between neighbours sharing an
+        // edge whatever the compiler contracts into FMAs.
+        static void edgeFunctions(const Prepared& r, const Packet& p, int l, float& U, float& V, float& W)
+        {
+            float a[3], b[3], c[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                a[k] = p.v[0][k][l] - r.o[k];
+                b[k] = p.v[1][k][l] - r.o[k];
+                c[k] = p.v[2][k][l] - r.o[k];
+            }
+            float ax = a[r.kx] - r.sx * a[r.kz], ay = a[r.ky] - r.sy * a[r.kz];
+            float bx = b[r.kx] - r.sx * b[r.kz], by = b[r.ky] - r.sy * b[r.kz];
+            float cx = c[r.kx] - r.sx * c[r.kz], cy = c[r.ky] - r.sy * c[r.kz];
+            U = (float)((double)cx * by - (double)cy * bx);
+            V = (float)((double)ax * cy - (double)ay * cx);
+            W = (float)((double)bx * ay - (double)by * ax);
+        }
+
+        static bool finishWatertight(const Prepared& r, const Packet& p, int l, float U, float V, float W,
+                                     float& t, float& u, float& v)
+        {
+            if ((U < 0 || V < 0 || W < 0) && (U > 0 || V > 0 || W > 0)) return false;
+            float det = U + V + W;
+            if (det == 0) return false;
+            float az = r.sz * (p.v[0][r.kz][l] - r.o[r.kz]);
+            float bz = r.sz * (p.v[1][r.kz][l] - r.o[r.kz]);
+            float cz = r.sz * (p.v[2][r.kz][l] - r.o[r.kz]);
+            float inv = 1.0f / det;
+            t = (U * az + V * bz + W * cz) * inv;
+            u = V * inv;
+            v = W * inv;
+            return true;
+        }
+
+        template<bool AnyHit>
+        bool traceScalar(const Prepared& r, TriangleTest test, RayHit& hit) const
+        {
+            float best = r.tMax;
+            for (size_t i = 0; i < packets.size(); ++i)
+                for (int l = 0; l < 8; ++l)
+                {
+                    float t, u, v;
+                    bool ok;
+                    if (test == TriangleTest::Fast) ok = testFast(r, packets[i], l, t, u, v);
+                    else
+                    {
+                        float U, V, W;
+                        edgeFunctions(r, packets[i], l, U, V, W);
+                        ok = finishWatertight(r, packets[i], l, U, V, W, t, u, v);
+                    }
+                    // Strict < keeps the first of equal hits.
+                    if (!ok || !(t >= r.tMin) || !(t < best || (t == best && !hit.hit()))) continue;
+                    best = t;
+                    hit = { t, u, v, uint32_t(i * 8 + l) };
+                    if (AnyHit) return true;
+                }
+            return hit.hit();
+        }
+
+#if defined(CPL_X86)
+        // ─── AVX2 + FMA: 8 triangles per step ─────────────────
+
+        CPL_TARGET_AVX2 static __m256 fast8(const Prepared& r, const Packet& p, __m256& t, __m256& u, __m256& v)
+        {
+            __m256 e1[3], e2[3], s[3], d[3];
+            for (int a = 0; a < 3; ++a)
+            {
+                __m256 v0 = _mm256_load_ps(p.v[0][a]);
+                e1[a] = _mm256_sub_ps(_mm256_load_ps(p.v[1][a]), v0);
+                e2[a] = _mm256_sub_ps(_mm256_load_ps(p.v[2][a]), v0);
+                s[a] = _mm256_sub_ps(_mm256_set1_ps(r.o[a]), v0);
+                d[a] = _mm256_set1_ps(r.d[a]);
+            }
+            __m256 px = _mm256_fmsub_ps(d[1], e2[2], _mm256_mul_ps(d[2], e2[1]));
+            __m256 py = _mm256_fmsub_ps(d[2], e2[0], _mm256_mul_ps(d[0], e2[2]));
+            __m256 pz = _mm256_fmsub_ps(d[0], e2[1], _mm256_mul_ps(d[1], e2[0]));
+            __m256 det = _mm256_fmadd_ps(e1[0], px, _mm256_fmadd_ps(e1[1], py, _mm256_mul_ps(e1[2], pz)));
+            __m256 absDet = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), det);
+            __m256 mask = _mm256_cmp_ps(absDet, _mm256_set1_ps(FLT_MIN), _CMP_GE_OQ);
+            __m256 inv = _mm256_div_ps(_mm256_set1_ps(1.0f), det);
+
+            u = _mm256_mul_ps(_mm256_fmadd_ps(s[0], px, _mm256_fmadd_ps(s[1], py, _mm256_mul_ps(s[2], pz))), inv);
+            __m256 qx = _mm256_fmsub_ps(s[1], e1[2], _mm256_mul_ps(s[2], e1[1]));
+            __m256 qy = _mm256_fmsub_ps(s[2], e1[0], _mm256_mul_ps(s[0], e1[2]));
+            __m256 qz = _mm256_fmsub_ps(s[0], e1[1], _mm256_mul_ps(s[1], e1[0]));
+            v = _mm256_mul_ps(_mm256_fmadd_ps(d[0], qx, _mm256_fmadd_ps(d[1], qy, _mm256_mul_ps(d[2], qz))), inv);
+            t = _mm256_mul_ps(_mm256_fmadd_ps(e2[0], qx, _mm256_fmadd_ps(e2[1], qy, _mm256_mul_ps(e2[2], qz))), inv);
+
+            const __m256 zero = _mm256_setzero_ps();
+            mask = _mm256_and_ps(mask, _mm256_cmp_ps(u, zero, _CMP_GE_OQ));
+            mask = _mm256_and_ps(mask, _mm256_cmp_ps(v, zero, _CMP_GE_OQ));
+            return _mm256_and_ps(mask, _mm256_cmp_ps(_mm256_add_ps(u, v), _mm256_set1_ps(1.0f), _CMP_LE_OQ));
+        }
+
+        CPL_TARGET_AVX2 static __m256d lowHalf(__m256 x)  { return _mm256_cvtps_pd(_mm256_castps256_ps128(x)); }
+        CPL_TARGET_AVX2 static __m256d highHalf(__m256 x) { return _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)); }
+
+        // a * b - c * d per lane, evaluated in double and rounded once.
+        CPL_TARGET_AVX2 static __m256 edge8(__m256 a, __m256 b, __m256 c, __m256 d)
+        {
+            __m128 lo = _mm256_cvtpd_ps(_mm256_fmsub_pd(lowHalf(a), lowHalf(b), _mm256_mul_pd(lowHalf(c), lowHalf(d))));
+            __m128 hi = _mm256_cvtpd_ps(_mm256_fmsub_pd(highHalf(a), highHalf(b), _mm256_mul_pd(highHalf(c), highHalf(d))));
+            return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+        }
+
+        CPL_TARGET_AVX2 static __m256 watertight8(const Prepared& r, const Packet& p, __m256& t, __m256& u, __m256& v)
+        {
+            const __m256 ox = _mm256_set1_ps(r.o[r.kx]), oy = _mm256_set1_ps(r.o[r.ky]), oz = _mm256_set1_ps(r.o[r.kz]);
+            const __m256 sx = _mm256_set1_ps(r.sx), sy = _mm256_set1_ps(r.sy), sz = _mm256_set1_ps(r.sz);
+            __m256 x[3], y[3], z[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                __m256 cz = _mm256_sub_ps(_mm256_load_ps(p.v[c][r.kz]), oz);
+                x[c] = _mm256_fnmadd_ps(sx, cz, _mm256_sub_ps(_mm256_load_ps(p.v[c][r.kx]), ox));
+                y[c] = _mm256_fnmadd_ps(sy, cz, _mm256_sub_ps(_mm256_load_ps(p.v[c][r.ky]), oy));
+                z[c] = _mm256_mul_ps(sz, cz);
+            }
+            // Edge functions in double, as in edgeFunctions(): the products are
+            // exact, so contraction into FMAs cannot break antisymmetry.
+            __m256 U = edge8(x[2], y[1], y[2], x[1]);
+            __m256 V = edge8(x[0], y[2], y[0], x[2]);
+            __m256 W = edge8(x[1], y[0], y[1], x[0]);
+
+            const __m256 zero = _mm256_setzero_ps();
+            __m256 anyNeg = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(U, zero, _CMP_LT_OQ), _mm256_cmp_ps(V, zero, _CMP_LT_OQ)),
+                                         _mm256_cmp_ps(W, zero, _CMP_LT_OQ));
+            __m256 anyPos = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(U, zero, _CMP_GT_OQ), _mm256_cmp_ps(V, zero, _CMP_GT_OQ)),
+                                         _mm256_cmp_ps(W, zero, _CMP_GT_OQ));
+            __m256 det = _mm256_add_ps(_mm256_add_ps(U, V), W);
+            __m256 mask = _mm256_andnot_ps(_mm256_and_ps(anyNeg, anyPos), _mm256_cmp_ps(det, zero, _CMP_NEQ_OQ));
+
+            __m256 inv = _mm256_div_ps(_mm256_set1_ps(1.0f), det);
+            t = _mm256_mul_ps(_mm256_fmadd_ps(U, z[0], _mm256_fmadd_ps(V, z[1], _mm256_mul_ps(W, z[2]))), inv);
+            u = _mm256_mul_ps(V, inv);
+            v = _mm256_mul_ps(W, inv);
+            return mask;
+        }
+
+        template<bool AnyHit, bool Watertight>
+        CPL_TARGET_AVX2 bool traceAVX2(const Prepared& r, RayHit& hit) const
+        {
+            const __m256 tMin = _mm256_set1_ps(r.tMin), inf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+            __m256 best = _mm256_set1_ps(r.tMax);
+            __m256 bestIsMax = _mm256_castsi256_ps(_mm256_set1_epi32(-1)); // t == tMax still counts until something hits
+            for (size_t i = 0; i < packets.size(); ++i)
+            {
+                __m256 t, u, v;
+                __m256 mask = Watertight ? watertight8(r, packets[i], t, u, v) : fast8(r, packets[i], t, u, v);
+                __m256 inRange = _mm256_or_ps(_mm256_cmp_ps(t, best, _CMP_LT_OQ), _mm256_and_ps(bestIsMax, _mm256_cmp_ps(t, best, _CMP_EQ_OQ)));
+                mask = _mm256_and_ps(_mm256_and_ps(mask, _mm256_cmp_ps(t, tMin, _CMP_GE_OQ)), inRange);
+                int bits = _mm256_movemask_ps(mask);
+                if (!bits) continue;
+
+                // Nearest lane: broadcast the minimum, then take the lowest lane holding it.
+                __m256 tm = _mm256_blendv_ps(inf, t, mask);
+                __m256 m = _mm256_min_ps(tm, _mm256_permute2f128_ps(tm, tm, 1));
+                m = _mm256_min_ps(m, _mm256_permute_ps(m, _MM_SHUFFLE(1, 0, 3, 2)));
+                m = _mm256_min_ps(m, _mm256_permute_ps(m, _MM_SHUFFLE(2, 3, 0, 1)));
+                int atMin = _mm256_movemask_ps(_mm256_cmp_ps(tm, m, _CMP_EQ_OQ)) & bits, lane = 0;
+                while (!(atMin >> lane & 1)) ++lane;
+
+                alignas(32) float tt[8], uu[8], vv[8];
+                _mm256_store_ps(tt, t);
+                _mm256_store_ps(uu, u);
+                _mm256_store_ps(vv, v);
+                hit = { tt[lane], uu[lane], vv[lane], uint32_t(i * 8 + lane) };
+                if (AnyHit) return true;
+                best = m;
+                bestIsMax = _mm256_setzero_ps();
+            }
+            return hit.hit();
+        }
+#endif
+
+        template<bool AnyHit>
+        bool trace(const Rayf& ray, TriangleTest test, RayHit& hit) const
+        {
+            Prepared r = prepare(ray);
+#if defined(CPL_X86)
+            if (SimdDispatch::tier() >= SimdTier::AVX2)
+                return test == TriangleTest::Fast ? traceAVX2<AnyHit, false>(r, hit) : traceAVX2<AnyHit, true>(r, hit);
+#endif
+            return traceScalar<AnyHit>(r, test, hit);
+        }
+    };
+}
@@ -0,0 +1,277 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Vector3.hpp"
+#include "matrix3.hpp"
+#include "matrix4.hpp"
+#include "quaternion.hpp"
+#include "simd_dispatch.hpp"
+#include "job_pool.hpp"
+
+namespace CPL
+{
+    enum class Integrator
+    {
+        SemiImplicitEuler,  // v += a dt, then x += v dt
+        Verlet              // velocity Verlet, force held over the step: x += v dt + a dt^2 / 2, v += a dt
+    };
+
+    struct RigidBodyDesc
+    {
+        Vector3f    position, velocity, angularVelocity;
+        Quaternionf orientation;
+        float       mass = 1;                        // 0 = kinematic: keeps its velocities, ignores forces
+        Matrix3f    inertia = Matrix3f::identity();  // body space, about the centre of mass
+    };
+
+    // Bodies stored as one float stream per component. step() integrates
+    // them in chunks across the job pool, 8 at a time on the AVX2 tier.
+    // Chunking depends only on the body count, so results are bit-identical
+    // for any thread count (on a given tier). Rotation uses the world inverse
+    // inertia R I^-1 R^T without the gyroscopic term, and always advances
+    // with semi-implicit Euler; the integrator choice applies to translation.
+    class RigidBodySystem
+    {
+    public:
+        enum Stream
+        {
+            PX, PY, PZ, VX, VY, VZ,
+            QX, QY, QZ, QW, WX, WY, WZ,
+            FX, FY, FZ, TX, TY, TZ,
+            InvMass,
+            I00, I01, I02, I10, I11, I12, I20, I21, I22, // body-space inverse inertia
+            StreamCount
+        };
+
+        explicit RigidBodySystem(Integrator integrator = Integrator::SemiImplicitEuler) : integrator(integrator) {}
+
+        void setIntegrator(Integrator i) { integrator = i; }
+        void setGravity(const Vector3f& g) { gravity = g; }
+
+        // Per second; velocities shrink by 1 / (1 + c * dt) each step.
+        void setDamping(float linear, float angular) { linearDamping = linear; angularDamping = angular; }
+
+        size_t size() const { return count; }
+
+        void reserve(size_t n) { if (n > capacity) relayout(n); }
+
+        uint32_t add(const RigidBodyDesc& d)
+        {
+            Matrix3f inv = d.mass > 0 ? d.inertia.inverse() : Matrix3f::zeros();
+            Quaternionf q = d.orientation.normalized();
+            const float values[StreamCount] = {
+                d.position.x, d.position.y, d.position.z, d.velocity.x, d.velocity.y, d.velocity.z,
+                q.x, q.y, q.z, q.w, d.angularVelocity.x, d.angularVelocity.y, d.angularVelocity.z,
+                0, 0, 0, 0, 0, 0,
+                d.mass > 0 ? 1 / d.mass : 0,
+                inv(0, 0), inv(0, 1), inv(0, 2), inv(1, 0), inv(1, 1), inv(1, 2), inv(2, 0), inv(2, 1), inv(2, 2) };
+            if (count == capacity) relayout(capacity ? capacity * 2 : 1024);
+            for (int s = 0; s < StreamCount; ++s) at(s, count) = values[s];
+            return (uint32_t)count++;
+        }
+
+        // Forces and torques accumulate until the next step() consumes them.
+        void applyForce(uint32_t i, const Vector3f& f) { add3(FX, i, f); }
+        void applyTorque(uint32_t i, const Vector3f& t) { add3(TX, i, t); }
+
+        void applyForceAtPoint(uint32_t i, const Vector3f& f, const Vector3f& worldPoint)
+        {
+            Vector3f p = position(i);
+            add3(FX, i, f);
+            add3(TX, i, Vector3f(worldPoint.x - p.x, worldPoint.y - p.y, worldPoint.z - p.z).cross(f));
+        }
+
+        Vector3f position(uint32_t i) const        { return get3(PX, i); }
+        Vector3f velocity(uint32_t i) const        { return get3(VX, i); }
+        Vector3f angularVelocity(uint32_t i) const { return get3(WX, i); }
+        Quaternionf orientation(uint32_t i) const  { return { at(QX, i), at(QY, i), at(QZ, i), at(QW, i) }; }
+        Matrix4f transform(uint32_t i) const       { return orientation(i).toMatrix4(position(i)); }
+
+        void setPosition(uint32_t i, const Vector3f& p)        { set3(PX, i, p); }
+        void setVelocity(uint32_t i, const Vector3f& v)        { set3(VX, i, v); }
+        void setAngularVelocity(uint32_t i, const Vector3f& w) { set3(WX, i, w); }
+
+        // Raw stream, e.g. to upload positions without going through Vector3f.
+        const float* stream(Stream s) const { return data.data() + s * stride; }
+
+        void step(float dt, JobPool& pool = JobPool::global())
+        {
+            Params p{ dt, gravity.x, gravity.y, gravity.z, 1 / (1 + linearDamping * dt), 1 / (1 + angularDamping * dt),
+                      integrator == Integrator::Verlet };
+            float* s[StreamCount];
+            for (int k = 0; k < StreamCount; ++k) s[k] = data.data() + k * stride;
+#if defined(CPL_X86)
+            const bool simd = SimdDispatch::tier() >= SimdTier::AVX2;
+#endif
+            pool.parallelFor(size(), 1024, [&](size_t b, size_t e) {
+#if defined(CPL_X86)
+                if (simd) b = stepAVX2(s, b, e, p);
+#endif
+                stepScalar(s, b, e, p);
+            });
+        }
+
+    private:
+        struct Params
+        {
+            float dt, gx, gy, gz;
+            float linearScale, angularScale;
+            bool  verlet;
+        };
+
+        // All streams share one buffer. The stride is a multiple of 4 KiB plus
+        // one cache line, so the streams don't all map to the same cache sets.
+        std::vector<float> data;
+        size_t             count = 0, capacity = 0, stride = 0;
+        Integrator         integrator;
+        Vector3f           gravity;
+        float              linearDamping = 0, angularDamping = 0;
+
+        float& at(int s, size_t i) { return data[s * stride + i]; }
+        float  at(int s, size_t i) const { return data[s * stride + i]; }
+
+        Vector3f get3(int s, uint32_t i) const { return { at(s, i), at(s + 1, i), at(s + 2, i) }; }
+        void set3(int s, uint32_t i, const Vector3f& v) { at(s, i) = v.x; at(s + 1, i) = v.y; at(s + 2, i) = v.z; }
+        void add3(int s, uint32_t i, const Vector3f& v) { at(s, i) += v.x; at(s + 1, i) += v.y; at(s + 2, i) += v.z; }
+
+        void relayout(size_t newCapacity)
+        {
+            size_t newStride = (newCapacity + 1023) / 1024 * 1024 + 16;
+            std::vector<float> next(StreamCount * newStride);
+            for (int s = 0; s < StreamCount; ++s)
+                std::copy(data.begin() + s * stride, data.begin() + s * stride + count, next.begin() + s * newStride);
+            data.swap(next);
+            capacity = newCapacity;
+            stride = newStride;
+        }
+
+        static void stepScalar(float* const* s, size_t b, size_t e, const Params& p)
+        {
+            const float dt = p.dt, halfDt = 0.5f * dt;
+            for (size_t i = b; i < e; ++i)
+            {
+                // Linear. Kinematic bodies (inverse mass 0) skip gravity and damping.
+                float im = s[InvMass][i];
+                bool dynamic = im > 0;
+                float ls = dynamic ? p.linearScale : 1, as = dynamic ? p.angularScale : 1;
+                const float g[3] = { dynamic ? p.gx : 0, dynamic ? p.gy : 0, dynamic ? p.gz : 0 };
+                for (int k = 0; k < 3; ++k)
+                {
+                    float a = s[FX + k][i] * im + g[k];
+                    float x = s[PX + k][i], v = s[VX + k][i];
+                    if (p.verlet) { x += (v + a * halfDt) * dt; v = (v + a * dt) * ls; }
+                    else          { v = (v + a * dt) * ls; x += v * dt; }
+                    s[PX + k][i] = x; s[VX + k][i] = v; s[FX + k][i] = 0;
+                }
+
+                // Angular: torque into body space, through I^-1, back to world.
+                float qx = s[QX][i], qy = s[QY][i], qz = s[QZ][i], qw = s[QW][i];
+                float r00 = 1 - 2 * (qy * qy + qz * qz), r01 = 2 * (qx * qy - qw * qz), r02 = 2 * (qx * qz + qw * qy);
+                float r10 = 2 * (qx * qy + qw * qz), r11 = 1 - 2 * (qx * qx + qz * qz), r12 = 2 * (qy * qz - qw * qx);
+                float r20 = 2 * (qx * qz - qw * qy), r21 = 2 * (qy * qz + qw * qx), r22 = 1 - 2 * (qx * qx + qy * qy);
+                float tx = s[TX][i], ty = s[TY][i], tz = s[TZ][i];
+                float lx = r00 * tx + r10 * ty + r20 * tz, ly = r01 * tx + r11 * ty + r21 * tz, lz = r02 * tx + r12 * ty + r22 * tz;
+                float bx = s[I00][i] * lx + s[I01][i] * ly + s[I02][i] * lz;
+                float by = s[I10][i] * lx + s[I11][i] * ly + s[I12][i] * lz;
+                float bz = s[I20][i] * lx + s[I21][i] * ly + s[I22][i] * lz;
+                float wx = (s[WX][i] + (r00 * bx + r01 * by + r02 * bz) * dt) * as;
+                float wy = (s[WY][i] + (r10 * bx + r11 * by + r12 * bz) * dt) * as;
+                float wz = (s[WZ][i] + (r20 * bx + r21 * by + r22 * bz) * dt) * as;
+                s[WX][i] = wx; s[WY][i] = wy; s[WZ][i] = wz;
+                s[TX][i] = s[TY][i] = s[TZ][i] = 0;
+
+                // q += dt/2 * (w, 0) * q, renormalized.
+                float nx = qx + halfDt * (wx * qw + wy * qz - wz * qy);
+                float ny = qy + halfDt * (wy * qw + wz * qx - wx * qz);
+                float nz = qz + halfDt * (wz * qw + wx * qy - wy * qx);
+                float nw = qw - halfDt * (wx * qx + wy * qy + wz * qz);
+                float inv = 1 / std::sqrt(nx * nx + ny * ny + nz * nz + nw * nw);
+                s[QX][i] = nx * inv; s[QY][i] = ny * inv; s[QZ][i] = nz * inv; s[QW][i] = nw * inv;
+            }
+        }
+
+#if defined(CPL_X86)
+        // Same steps as stepScalar, 8 bodies per iteration; returns where it stopped.
+        CPL_TARGET_AVX2 static size_t stepAVX2(float* const* s, size_t b, size_t e, const Params& p)
+        {
+            const __m256 dt = _mm256_set1_ps(p.dt), halfDt = _mm256_set1_ps(0.5f * p.dt);
+            const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), two = _mm256_set1_ps(2.0f);
+            const __m256 g[3] = { _mm256_set1_ps(p.gx), _mm256_set1_ps(p.gy), _mm256_set1_ps(p.gz) };
+            const __m256 linearScale = _mm256_set1_ps(p.linearScale), angularScale = _mm256_set1_ps(p.angularScale);
+
+            size_t i = b;
+            for (; i + 8 <= e; i += 8)
+            {
+                __m256 im = _mm256_loadu_ps(s[InvMass] + i);
+                __m256 dynamic = _mm256_cmp_ps(im, zero, _CMP_GT_OQ);
+                __m256 ls = _mm256_blendv_ps(one, linearScale, dynamic), as = _mm256_blendv_ps(one, angularScale, dynamic);
+                for (int k = 0; k < 3; ++k)
+                {
+                    __m256 a = _mm256_fmadd_ps(_mm256_loadu_ps(s[FX + k] + i), im, _mm256_and_ps(g[k], dynamic));
+                    __m256 x = _mm256_loadu_ps(s[PX + k] + i), v = _mm256_loadu_ps(s[VX + k] + i);
+                    if (p.verlet)
+                    {
+                        x = _mm256_fmadd_ps(_mm256_fmadd_ps(a, halfDt, v), dt, x);
+                        v = _mm256_mul_ps(_mm256_fmadd_ps(a, dt, v), ls);
+                    }
+                    else
+                    {
+                        v = _mm256_mul_ps(_mm256_fmadd_ps(a, dt, v), ls);
+                        x = _mm256_fmadd_ps(v, dt, x);
+                    }
+                    _mm256_storeu_ps(s[PX + k] + i, x);
+                    _mm256_storeu_ps(s[VX + k] + i, v);
+                    _mm256_storeu_ps(s[FX + k] + i, zero);
+                }
+
+                __m256 qx = _mm256_loadu_ps(s[QX] + i), qy = _mm256_loadu_ps(s[QY] + i);
+                __m256 qz = _mm256_loadu_ps(s[QZ] + i), qw = _mm256_loadu_ps(s[QW] + i);
+                __m256 xx = _mm256_mul_ps(qx, qx), yy = _mm256_mul_ps(qy, qy), zz = _mm256_mul_ps(qz, qz);
+                __m256 xy = _mm256_mul_ps(qx, qy), xz = _mm256_mul_ps(qx, qz), yz = _mm256_mul_ps(qy, qz);
+                __m256 wx_ = _mm256_mul_ps(qw, qx), wy_ = _mm256_mul_ps(qw, qy), wz_ = _mm256_mul_ps(qw, qz);
+                __m256 r00 = _mm256_fnmadd_ps(two, _mm256_add_ps(yy, zz), one);
+                __m256 r11 = _mm256_fnmadd_ps(two, _mm256_add_ps(xx, zz), one);
+                __m256 r22 = _mm256_fnmadd_ps(two, _mm256_add_ps(xx, yy), one);
+                __m256 r01 = _mm256_mul_ps(two, _mm256_sub_ps(xy, wz_)), r10 = _mm256_mul_ps(two, _mm256_add_ps(xy, wz_));
+                __m256 r02 = _mm256_mul_ps(two, _mm256_add_ps(xz, wy_)), r20 = _mm256_mul_ps(two, _mm256_sub_ps(xz, wy_));
+                __m256 r12 = _mm256_mul_ps(two, _mm256_sub_ps(yz, wx_)), r21 = _mm256_mul_ps(two, _mm256_add_ps(yz, wx_));
+
+                __m256 tx = _mm256_loadu_ps(s[TX] + i), ty = _mm256_loadu_ps(s[TY] + i), tz = _mm256_loadu_ps(s[TZ] + i);
+                __m256 lx = _mm256_fmadd_ps(r00, tx, _mm256_fmadd_ps(r10, ty, _mm256_mul_ps(r20, tz)));
+                __m256 ly = _mm256_fmadd_ps(r01, tx, _mm256_fmadd_ps(r11, ty, _mm256_mul_ps(r21, tz)));
+                __m256 lz = _mm256_fmadd_ps(r02, tx, _mm256_fmadd_ps(r12, ty, _mm256_mul_ps(r22, tz)));
+                __m256 bx = _mm256_fmadd_ps(_mm256_loadu_ps(s[I00] + i), lx, _mm256_fmadd_ps(_mm256_loadu_ps(s[I01] + i), ly, _mm256_mul_ps(_mm256_loadu_ps(s[I02] + i), lz)));
+                __m256 by = _mm256_fmadd_ps(_mm256_loadu_ps(s[I10] + i), lx, _mm256_fmadd_ps(_mm256_loadu_ps(s[I11] + i), ly, _mm256_mul_ps(_mm256_loadu_ps(s[I12] + i), lz)));
+                __m256 bz = _mm256_fmadd_ps(_mm256_loadu_ps(s[I20] + i), lx, _mm256_fmadd_ps(_mm256_loadu_ps(s[I21] + i), ly, _mm256_mul_ps(_mm256_loadu_ps(s[I22] + i), lz)));
+                __m256 ax = _mm256_fmadd_ps(r00, bx, _mm256_fmadd_ps(r01, by, _mm256_mul_ps(r02, bz)));
+                __m256 ay = _mm256_fmadd_ps(r10, bx, _mm256_fmadd_ps(r11, by, _mm256_mul_ps(r12, bz)));
+                __m256 az = _mm256_fmadd_ps(r20, bx, _mm256_fmadd_ps(r21, by, _mm256_mul_ps(r22, bz)));
+                __m256 wx = _mm256_mul_ps(_mm256_fmadd_ps(ax, dt, _mm256_loadu_ps(s[WX] + i)), as);
+                __m256 wy = _mm256_mul_ps(_mm256_fmadd_ps(ay, dt, _mm256_loadu_ps(s[WY] + i)), as);
+                __m256 wz = _mm256_mul_ps(_mm256_fmadd_ps(az, dt, _mm256_loadu_ps(s[WZ] + i)), as);
+                _mm256_storeu_ps(s[WX] + i, wx);
+                _mm256_storeu_ps(s[WY] + i, wy);
+                _mm256_storeu_ps(s[WZ] + i, wz);
+                _mm256_storeu_ps(s[TX] + i, zero);
+                _mm256_storeu_ps(s[TY] + i, zero);
+                _mm256_storeu_ps(s[TZ] + i, zero);
+
+                __m256 nx = _mm256_fmadd_ps(halfDt, _mm256_fmadd_ps(wx, qw, _mm256_fmsub_ps(wy, qz, _mm256_mul_ps(wz, qy))), qx);
+                __m256 ny = _mm256_fmadd_ps(halfDt, _mm256_fmadd_ps(wy, qw, _mm256_fmsub_ps(wz, qx, _mm256_mul_ps(wx, qz))), qy);
+                __m256 nz = _mm256_fmadd_ps(halfDt, _mm256_fmadd_ps(wz, qw, _mm256_fmsub_ps(wx, qy, _mm256_mul_ps(wy, qx))), qz);
+                __m256 nw = _mm256_fnmadd_ps(halfDt, _mm256_fmadd_ps(wx, qx, _mm256_fmadd_ps(wy, qy, _mm256_mul_ps(wz, qz))), qw);
+                __m256 len2 = _mm256_fmadd_ps(nx, nx, _mm256_fmadd_ps(ny, ny, _mm256_fmadd_ps(nz, nz, _mm256_mul_ps(nw, nw))));
+                __m256 inv = _mm256_div_ps(one, _mm256_sqrt_ps(len2));
+                _mm256_storeu_ps(s[QX] + i, _mm256_mul_ps(nx, inv));
+                _mm256_storeu_ps(s[QY] + i, _mm256_mul_ps(ny, inv));
+                _mm256_storeu_ps(s[QZ] + i, _mm256_mul_ps(nz, inv));
+                _mm256_storeu_ps(s[QW] + i, _mm256_mul_ps(nw, inv));
+            }
+            return i;
+        }
+#endif
+    };
+}
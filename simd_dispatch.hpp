@@ -0,0 +1,571 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include "Vector3.hpp"
+#include "vector4.hpp"
+#include "matrix4.hpp"
+#include "cpu_features.hpp"
+
+// Bulk Vector3f kernels, one implementation per SimdTier, selected once at
+// startup from CPUID. Arrays are AoS Vector3f (Vector4f for the clip-space
+// stages); `in` and `out` may alias where their types match.
+//
+// Every vector kernel works on blocks of 4 vectors per 128-bit lane: three
+// loads give x0y0z0x1 | y1z1x2y2 | z2x3y3z3, which two blends and an in-lane
+// shuffle turn into xxxx / yyyy / zzzz (and back again for stores).
+
+namespace CPL
+{
+    static_assert(sizeof(Vector3f) == 3 * sizeof(float), "Vector3f must be tightly packed");
+
+    // Window rectangle in pixels, origin top-left with y down (as in
+    // TriangleSetup), and the depth range NDC z in [-1, 1] maps onto.
+    struct Viewport
+    {
+        float x = 0, y = 0, width = 0, height = 0;
+        float minDepth = 0, maxDepth = 1;
+
+        // window = ndc * scale + offset, per axis.
+        void mapping(float scale[3], float offset[3]) const
+        {
+            scale[0] = width * 0.5f;                 offset[0] = x + width * 0.5f;
+            scale[1] = -height * 0.5f;               offset[1] = y + height * 0.5f;
+            scale[2] = (maxDepth - minDepth) * 0.5f; offset[2] = minDepth + scale[2];
+        }
+    };
+
+    struct BulkKernels
+    {
+        SimdTier tier;
+        void (*transformPoints)(const Matrix4f& m, const Vector3f* in, Vector3f* out, size_t n);
+        void (*normalize)(const Vector3f* in, Vector3f* out, size_t n);
+        void (*dot)(const Vector3f* a, const Vector3f* b, float* out, size_t n);
+        void (*transformClip)(const Matrix4f& m, const Vector3f* in, Vector4f* out, size_t n);
+        void (*projectViewport)(const Viewport& vp, const Vector4f* in, Vector4f* out, size_t n);
+    };
+
+    namespace kernels
+    {
+        // ─── Scalar reference ──────────────────────────────────
+
+        inline void transformPointsScalar(const Matrix4f& m, const Vector3f* in, Vector3f* out, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i) out[i] = m * in[i];
+        }
+
+        inline void normalizeScalar(const Vector3f* in, Vector3f* out, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i) out[i] = in[i].normalized();
+        }
+
+        inline void dotScalar(const Vector3f* a, const Vector3f* b, float* out, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i) out[i] = a[i].dot(b[i]);
+        }
+
+        inline void transformClipScalar(const Matrix4f& m, const Vector3f* in, Vector4f* out, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i) out[i] = m.transformHomogeneous(in[i]);
+        }
+
+        inline void projectViewportScalar(const Viewport& vp, const Vector4f* in, Vector4f* out, size_t n)
+        {
+            float scale[3], offset[3];
+            vp.mapping(scale, offset);
+            for (size_t i = 0; i < n; ++i)
+            {
+                const Vector4f v = in[i];
+                float invW = 1 / v.w;
+                out[i] = { v.x * invW * scale[0] + offset[0], v.y * invW * scale[1] + offset[1],
+                           v.z * invW * scale[2] + offset[2], invW };
+            }
+        }
+
+#if defined(CPL_X86)
+        // ─── SSE4.1: 4 vectors per iteration ───────────────────
+
+        CPL_TARGET_SSE41 inline void load3(const Vector3f* v, __m128& x, __m128& y, __m128& z)
+        {
+            const float* p = &v->x;
+            __m128 m0 = _mm_loadu_ps(p), m1 = _mm_loadu_ps(p + 4), m2 = _mm_loadu_ps(p + 8);
+            __m128 bx = _mm_blend_ps(_mm_blend_ps(m0, m1, 0x4), m2, 0x2);
+            __m128 by = _mm_blend_ps(_mm_blend_ps(m0, m1, 0x9), m2, 0x4);
+            __m128 bz = _mm_blend_ps(_mm_blend_ps(m0, m1, 0x2), m2, 0x9);
+            x = _mm_shuffle_ps(bx, bx, _MM_SHUFFLE(1, 2, 3, 0));
+            y = _mm_shuffle_ps(by, by, _MM_SHUFFLE(2, 3, 0, 1));
+            z = _mm_shuffle_ps(bz, bz, _MM_SHUFFLE(3, 0, 1, 2));
+        }
+
+        CPL_TARGET_SSE41 inline void store3(Vector3f* v, __m128 x, __m128 y, __m128 z)
+        {
+            float* p = &v->x;
+            __m128 bx = _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 2, 3, 0));
+            __m128 by = _mm_shuffle_ps(y, y, _MM_SHUFFLE(2, 3, 0, 1));
+            __m128 bz = _mm_shuffle_ps(z, z, _MM_SHUFFLE(3, 0, 1, 2));
+            _mm_storeu_ps(p, _mm_blend_ps(_mm_blend_ps(bx, by, 0x2), bz, 0x4));
+            _mm_storeu_ps(p + 4, _mm_blend_ps(_mm_blend_ps(by, bz, 0x2), bx, 0x4));
+            _mm_storeu_ps(p + 8, _mm_blend_ps(_mm_blend_ps(bz, bx, 0x2), by, 0x4));
+        }
+
+        CPL_TARGET_SSE41 inline void transformPointsSSE41(const Matrix4f& m, const Vector3f* in, Vector3f* out, size_t n)
+        {
+            __m128 c[16];
+            for (int i = 0; i < 16; ++i) c[i] = _mm_set1_ps(m(i / 4, i % 4));
+            const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                __m128 x, y, z;
+                load3(in + i, x, y, z);
+                __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, c[0]), _mm_mul_ps(y, c[1])), _mm_add_ps(_mm_mul_ps(z, c[2]), c[3]));
+                __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, c[4]), _mm_mul_ps(y, c[5])), _mm_add_ps(_mm_mul_ps(z, c[6]), c[7]));
+                __m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, c[8]), _mm_mul_ps(y, c[9])), _mm_add_ps(_mm_mul_ps(z, c[10]), c[11]));
+                __m128 w = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, c[12]), _mm_mul_ps(y, c[13])), _mm_add_ps(_mm_mul_ps(z, c[14]), c[15]));
+                // Same rule as Matrix4::operator*: divide unless w is 0 or 1.
+                __m128 divide = _mm_and_ps(_mm_cmpneq_ps(w, zero), _mm_cmpneq_ps(w, one));
+                __m128 invW = _mm_blendv_ps(one, _mm_div_ps(one, w), divide);
+                store3(out + i, _mm_mul_ps(rx, invW), _mm_mul_ps(ry, invW), _mm_mul_ps(rz, invW));
+            }
+            transformPointsScalar(m, in + i, out + i, n - i);
+        }
+
+        CPL_TARGET_SSE41 inline void normalizeSSE41(const Vector3f* in, Vector3f* out, size_t n)
+        {
+            const __m128 zero = _mm_setzero_ps();
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                __m128 x, y, z;
+                load3(in + i, x, y, z);
+                __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+                __m128 inv = _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.0f), len), _mm_cmpneq_ps(len, zero));
+                store3(out + i, _mm_mul_ps(x, inv), _mm_mul_ps(y, inv), _mm_mul_ps(z, inv));
+            }
+            normalizeScalar(in + i, out + i, n - i);
+        }
+
+        CPL_TARGET_SSE41 inline void dotSSE41(const Vector3f* a, const Vector3f* b, float* out, size_t n)
+        {
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                __m128 ax, ay, az, bx, by, bz;
+                load3(a + i, ax, ay, az);
+                load3(b + i, bx, by, bz);
+                _mm_storeu_ps(out + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz)));
+            }
+            dotScalar(a + i, b + i, out + i, n - i);
+        }
+
+        // 1 / w from rcpps and one Newton-Raphson step, about 22 bits.
+        CPL_TARGET_SSE41 inline __m128 reciprocal(__m128 w)
+        {
+            __m128 r = _mm_rcp_ps(w);
+            return _mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(2.0f), _mm_mul_ps(w, r)));
+        }
+
+        CPL_TARGET_SSE41 inline void transformClipSSE41(const Matrix4f& m, const Vector3f* in, Vector4f* out, size_t n)
+        {
+            __m128 c[16];
+            for (int i = 0; i < 16; ++i) c[i] = _mm_set1_ps(m(i / 4, i % 4));
+
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                __m128 x, y, z;
+                load3(in + i, x, y, z);
+                __m128 r[4];
+                for (int k = 0; k < 4; ++k)
+                    r[k] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, c[4 * k]), _mm_mul_ps(y, c[4 * k + 1])), _mm_add_ps(_mm_mul_ps(z, c[4 * k + 2]), c[4 * k + 3]));
+                _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+                for (int k = 0; k < 4; ++k) _mm_storeu_ps(&out[i + k].x, r[k]);
+            }
+            transformClipScalar(m, in + i, out + i, n - i);
+        }
+
+        CPL_TARGET_SSE41 inline void projectViewportSSE41(const Viewport& vp, const Vector4f* in, Vector4f* out, size_t n)
+        {
+            float scale[3], offset[3];
+            vp.mapping(scale, offset);
+            __m128 s[3], o[3];
+            for (int k = 0; k < 3; ++k) { s[k] = _mm_set1_ps(scale[k]); o[k] = _mm_set1_ps(offset[k]); }
+
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                __m128 r[4];
+                for (int k = 0; k < 4; ++k) r[k] = _mm_loadu_ps(&in[i + k].x);
+                _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+                r[3] = reciprocal(r[3]);
+                for (int k = 0; k < 3; ++k) r[k] = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(r[k], r[3]), s[k]), o[k]);
+                _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+                for (int k = 0; k < 4; ++k) _mm_storeu_ps(&out[i + k].x, r[k]);
+            }
+            projectViewportScalar(vp, in + i, out + i, n - i);
+        }
+
+        // ─── AVX2 + FMA: 8 vectors per iteration ───────────────
+
+        CPL_TARGET_AVX2 inline __m256 loadLanes(const float* p)
+        {
+            return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p)), _mm_loadu_ps(p + 12), 1);
+        }
+
+        CPL_TARGET_AVX2 inline void storeLanes(float* p, __m256 v)
+        {
+            _mm_storeu_ps(p, _mm256_castps256_ps128(v));
+            _mm_storeu_ps(p + 12, _mm256_extractf128_ps(v, 1));
+        }
+
+        CPL_TARGET_AVX2 inline void load3(const Vector3f* v, __m256& x, __m256& y, __m256& z)
+        {
+            const float* p = &v->x;
+            __m256 m0 = loadLanes(p), m1 = loadLanes(p + 4), m2 = loadLanes(p + 8);
+            __m256 bx = _mm256_blend_ps(_mm256_blend_ps(m0, m1, 0x44), m2, 0x22);
+            __m256 by = _mm256_blend_ps(_mm256_blend_ps(m0, m1, 0x99), m2, 0x44);
+            __m256 bz = _mm256_blend_ps(_mm256_blend_ps(m0, m1, 0x22), m2, 0x99);
+            x = _mm256_permute_ps(bx, _MM_SHUFFLE(1, 2, 3, 0));
+            y = _mm256_permute_ps(by, _MM_SHUFFLE(2, 3, 0, 1));
+            z = _mm256_permute_ps(bz, _MM_SHUFFLE(3, 0, 1, 2));
+        }
+
+        CPL_TARGET_AVX2 inline void store3(Vector3f* v, __m256 x, __m256 y, __m256 z)
+        {
+            float* p = &v->x;
+            __m256 bx = _mm256_permute_ps(x, _MM_SHUFFLE(1, 2, 3, 0));
+            __m256 by = _mm256_permute_ps(y, _MM_SHUFFLE(2, 3, 0, 1));
+            __m256 bz = _mm256_permute_ps(z, _MM_SHUFFLE(3, 0, 1, 2));
+            storeLanes(p, _mm256_blend_ps(_mm256_blend_ps(bx, by, 0x22), bz, 0x44));
+            storeLanes(p + 4, _mm256_blend_ps(_mm256_blend_ps(by, bz, 0x22), bx, 0x44));
+            storeLanes(p + 8, _mm256_blend_ps(_mm256_blend_ps(bz, bx, 0x22), by, 0x44));
+        }
+
+        // Four floats from lo in the low 128-bit lane, four from hi in the high one.
+        CPL_TARGET_AVX2 inline __m256 loadPair(const float* lo, const float* hi)
+        {
+            return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(lo)), _mm_loadu_ps(hi), 1);
+        }
+
+        CPL_TARGET_AVX2 inline void storePair(float* lo, float* hi, __m256 v)
+        {
+            _mm_storeu_ps(lo, _mm256_castps256_ps128(v));
+            _mm_storeu_ps(hi, _mm256_extractf128_ps(v, 1));
+        }
+
+        // 4x4 transpose within each 128-bit lane: after loadPair of rows for
+        // items (0, 4), (1, 5), (2, 6), (3, 7), lane l of each result is item l.
+        CPL_TARGET_AVX2 inline void transpose4(__m256& a, __m256& b, __m256& c, __m256& d)
+        {
+            __m256 t0 = _mm256_unpacklo_ps(a, b), t1 = _mm256_unpacklo_ps(c, d);
+            __m256 t2 = _mm256_unpackhi_ps(a, b), t3 = _mm256_unpackhi_ps(c, d);
+            a = _mm256_shuffle_ps(t0, t1, 0x44); b = _mm256_shuffle_ps(t0, t1, 0xEE);
+            c = _mm256_shuffle_ps(t2, t3, 0x44); d = _mm256_shuffle_ps(t2, t3, 0xEE);
+        }
+
+        CPL_TARGET_AVX2 inline void transformPointsAVX2(const Matrix4f& m, const Vector3f* in, Vector3f* out, size_t n)
+        {
+            __m256 c[16];
+            for (int i = 0; i < 16; ++i) c[i] = _mm256_set1_ps(m(i / 4, i % 4));
+            const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                __m256 x, y, z;
+                load3(in + i, x, y, z);
+                __m256 rx = _mm256_fmadd_ps(x, c[0], _mm256_fmadd_ps(y, c[1], _mm256_fmadd_ps(z, c[2], c[3])));
+                __m256 ry = _mm256_fmadd_ps(x, c[4], _mm256_fmadd_ps(y, c[5], _mm256_fmadd_ps(z, c[6], c[7])));
+                __m256 rz = _mm256_fmadd_ps(x, c[8], _mm256_fmadd_ps(y, c[9], _mm256_fmadd_ps(z, c[10], c[11])));
+                __m256 w = _mm256_fmadd_ps(x, c[12], _mm256_fmadd_ps(y, c[13], _mm256_fmadd_ps(z, c[14], c[15])));
+                __m256 divide = _mm256_and_ps(_mm256_cmp_ps(w, zero, _CMP_NEQ_UQ), _mm256_cmp_ps(w, one, _CMP_NEQ_UQ));
+                __m256 invW = _mm256_blendv_ps(one, _mm256_div_ps(one, w), divide);
+                store3(out + i, _mm256_mul_ps(rx, invW), _mm256_mul_ps(ry, invW), _mm256_mul_ps(rz, invW));
+            }
+            transformPointsSSE41(m, in + i, out + i, n - i);
+        }
+
+        CPL_TARGET_AVX2 inline void normalizeAVX2(const Vector3f* in, Vector3f* out, size_t n)
+        {
+            const __m256 zero = _mm256_setzero_ps();
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                __m256 x, y, z;
+                load3(in + i, x, y, z);
+                __m256 len = _mm256_sqrt_ps(_mm256_fmadd_ps(x, x, _mm256_fmadd_ps(y, y, _mm256_mul_ps(z, z))));
+                __m256 inv = _mm256_and_ps(_mm256_div_ps(_mm256_set1_ps(1.0f), len), _mm256_cmp_ps(len, zero, _CMP_NEQ_UQ));
+                store3(out + i, _mm256_mul_ps(x, inv), _mm256_mul_ps(y, inv), _mm256_mul_ps(z, inv));
+            }
+            normalizeSSE41(in + i, out + i, n - i);
+        }
+
+        CPL_TARGET_AVX2 inline void dotAVX2(const Vector3f* a, const Vector3f* b, float* out, size_t n)
+        {
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                __m256 ax, ay, az, bx, by, bz;
+                load3(a + i, ax, ay, az);
+                load3(b + i, bx, by, bz);
+                _mm256_storeu_ps(out + i, _mm256_fmadd_ps(ax, bx, _mm256_fmadd_ps(ay, by, _mm256_mul_ps(az, bz))));
+            }
+            dotSSE41(a + i, b + i, out + i, n - i);
+        }
+
+        CPL_TARGET_AVX2 inline __m256 reciprocal(__m256 w)
+        {
+            __m256 r = _mm256_rcp_ps(w);
+            return _mm256_mul_ps(r, _mm256_fnmadd_ps(w, r, _mm256_set1_ps(2.0f)));
+        }
+
+        // Results are computed SoA, then transpose4 turns x/y/z/w into
+        // vertices (0, 4), (1, 5), (2, 6), (3, 7), one pair per register.
+        CPL_TARGET_AVX2 inline void transformClipAVX2(const Matrix4f& m, const Vector3f* in, Vector4f* out, size_t n)
+        {
+            __m256 c[16];
+            for (int i = 0; i < 16; ++i) c[i] = _mm256_set1_ps(m(i / 4, i % 4));
+
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                __m256 x, y, z;
+                load3(in + i, x, y, z);
+                __m256 r[4];
+                for (int k = 0; k < 4; ++k)
+                    r[k] = _mm256_fmadd_ps(x, c[4 * k], _mm256_fmadd_ps(y, c[4 * k + 1], _mm256_fmadd_ps(z, c[4 * k + 2], c[4 * k + 3])));
+                transpose4(r[0], r[1], r[2], r[3]);
+                for (int k = 0; k < 4; ++k) storePair(&out[i + k].x, &out[i + k + 4].x, r[k]);
+            }
+            transformClipSSE41(m, in + i, out + i, n - i);
+        }
+
+        CPL_TARGET_AVX2 inline void projectViewportAVX2(const Viewport& vp, const Vector4f* in, Vector4f* out, size_t n)
+        {
+            float scale[3], offset[3];
+            vp.mapping(scale, offset);
+            __m256 s[3], o[3];
+            for (int k = 0; k < 3; ++k) { s[k] = _mm256_set1_ps(scale[k]); o[k] = _mm256_set1_ps(offset[k]); }
+
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                __m256 r[4];
+                for (int k = 0; k < 4; ++k) r[k] = loadPair(&in[i + k].x, &in[i + k + 4].x);
+                transpose4(r[0], r[1], r[2], r[3]);
+                r[3] = reciprocal(r[3]);
+                for (int k = 0; k < 3; ++k) r[k] = _mm256_fmadd_ps(_mm256_mul_ps(r[k], r[3]), s[k], o[k]);
+                transpose4(r[0], r[1], r[2], r[3]);
+                for (int k = 0; k < 4; ++k) storePair(&out[i + k].x, &out[i + k + 4].x, r[k]);
+            }
+            projectViewportSSE41(vp, in + i, out + i, n - i);
+        }
+
+        // ─── AVX-512F: 16 vectors per iteration ────────────────
+
+        // GCC 12's avx512fintrin.h trips -Wmaybe-uninitialized on its own
+        // _mm512_undefined_ps(); nothing here reads undefined lanes.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+        CPL_TARGET_AVX512 inline __m512 loadLanes4(const float* p)
+        {
+            __m512 v = _mm512_castps128_ps512(_mm_loadu_ps(p));
+            v = _mm512_insertf32x4(v, _mm_loadu_ps(p + 12), 1);
+            v = _mm512_insertf32x4(v, _mm_loadu_ps(p + 24), 2);
+            return _mm512_insertf32x4(v, _mm_loadu_ps(p + 36), 3);
+        }
+
+        CPL_TARGET_AVX512 inline void storeLanes4(float* p, __m512 v)
+        {
+            _mm_storeu_ps(p, _mm512_castps512_ps128(v));
+            _mm_storeu_ps(p + 12, _mm512_extractf32x4_ps(v, 1));
+            _mm_storeu_ps(p + 24, _mm512_extractf32x4_ps(v, 2));
+            _mm_storeu_ps(p + 36, _mm512_extractf32x4_ps(v, 3));
+        }
+
+        CPL_TARGET_AVX512 inline void load3(const Vector3f* v, __m512& x, __m512& y, __m512& z)
+        {
+            const float* p = &v->x;
+            __m512 m0 = loadLanes4(p), m1 = loadLanes4(p + 4), m2 = loadLanes4(p + 8);
+            __m512 bx = _mm512_mask_blend_ps(0x2222, _mm512_mask_blend_ps(0x4444, m0, m1), m2);
+            __m512 by = _mm512_mask_blend_ps(0x4444, _mm512_mask_blend_ps(0x9999, m0, m1), m2);
+            __m512 bz = _mm512_mask_blend_ps(0x9999, _mm512_mask_blend_ps(0x2222, m0, m1), m2);
+            x = _mm512_permute_ps(bx, _MM_SHUFFLE(1, 2, 3, 0));
+            y = _mm512_permute_ps(by, _MM_SHUFFLE(2, 3, 0, 1));
+            z = _mm512_permute_ps(bz, _MM_SHUFFLE(3, 0, 1, 2));
+        }
+
+        CPL_TARGET_AVX512 inline void store3(Vector3f* v, __m512 x, __m512 y, __m512 z)
+        {
+            float* p = &v->x;
+            __m512 bx = _mm512_permute_ps(x, _MM_SHUFFLE(1, 2, 3, 0));
+            __m512 by = _mm512_permute_ps(y, _MM_SHUFFLE(2, 3, 0, 1));
+            __m512 bz = _mm512_permute_ps(z, _MM_SHUFFLE(3, 0, 1, 2));
+            storeLanes4(p, _mm512_mask_blend_ps(0x4444, _mm512_mask_blend_ps(0x2222, bx, by), bz));
+            storeLanes4(p + 4, _mm512_mask_blend_ps(0x4444, _mm512_mask_blend_ps(0x2222, by, bz), bx));
+            storeLanes4(p + 8, _mm512_mask_blend_ps(0x4444, _mm512_mask_blend_ps(0x2222, bz, bx), by));
+        }
+
+        CPL_TARGET_AVX512 inline void transformPointsAVX512(const Matrix4f& m, const Vector3f* in, Vector3f* out, size_t n)
+        {
+            __m512 c[16];
+            for (int i = 0; i < 16; ++i) c[i] = _mm512_set1_ps(m(i / 4, i % 4));
+            const __m512 zero = _mm512_setzero_ps(), one = _mm512_set1_ps(1.0f);
+
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                __m512 x, y, z;
+                load3(in + i, x, y, z);
+                __m512 rx = _mm512_fmadd_ps(x, c[0], _mm512_fmadd_ps(y, c[1], _mm512_fmadd_ps(z, c[2], c[3])));
+                __m512 ry = _mm512_fmadd_ps(x, c[4], _mm512_fmadd_ps(y, c[5], _mm512_fmadd_ps(z, c[6], c[7])));
+                __m512 rz = _mm512_fmadd_ps(x, c[8], _mm512_fmadd_ps(y, c[9], _mm512_fmadd_ps(z, c[10], c[11])));
+                __m512 w = _mm512_fmadd_ps(x, c[12], _mm512_fmadd_ps(y, c[13], _mm512_fmadd_ps(z, c[14], c[15])));
+                __mmask16 divide = _mm512_cmp_ps_mask(w, zero, _CMP_NEQ_UQ) & _mm512_cmp_ps_mask(w, one, _CMP_NEQ_UQ);
+                __m512 invW = _mm512_mask_div_ps(one, divide, one, w);
+                store3(out + i, _mm512_mul_ps(rx, invW), _mm512_mul_ps(ry, invW), _mm512_mul_ps(rz, invW));
+            }
+            transformPointsAVX2(m, in + i, out + i, n - i);
+        }
+
+        CPL_TARGET_AVX512 inline void normalizeAVX512(const Vector3f* in, Vector3f* out, size_t n)
+        {
+            const __m512 zero = _mm512_setzero_ps();
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                __m512 x, y, z;
+                load3(in + i, x, y, z);
+                __m512 len = _mm512_sqrt_ps(_mm512_fmadd_ps(x, x, _mm512_fmadd_ps(y, y, _mm512_mul_ps(z, z))));
+                __m512 inv = _mm512_maskz_div_ps(_mm512_cmp_ps_mask(len, zero, _CMP_NEQ_UQ), _mm512_set1_ps(1.0f), len);
+                store3(out + i, _mm512_mul_ps(x, inv), _mm512_mul_ps(y, inv), _mm512_mul_ps(z, inv));
+            }
+            normalizeAVX2(in + i, out + i, n - i);
+        }
+
+        CPL_TARGET_AVX512 inline void dotAVX512(const Vector3f* a, const Vector3f* b, float* out, size_t n)
+        {
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                __m512 ax, ay, az, bx, by, bz;
+                load3(a + i, ax, ay, az);
+                load3(b + i, bx, by, bz);
+                _mm512_storeu_ps(out + i, _mm512_fmadd_ps(ax, bx, _mm512_fmadd_ps(ay, by, _mm512_mul_ps(az, bz))));
+            }
+            dotAVX2(a + i, b + i, out + i, n - i);
+        }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+    }
+
+    class SimdDispatch
+    {
+    public:
+        static BulkKernels kernelsFor(SimdTier tier)
+        {
+#if defined(CPL_X86)
+            switch (tier)
+            {
+            case SimdTier::AVX512:
+                // The clip-space stages are store-bound; AVX2 already saturates them.
+                return { tier, kernels::transformPointsAVX512, kernels::normalizeAVX512, kernels::dotAVX512,
+                         kernels::transformClipAVX2, kernels::projectViewportAVX2 };
+            case SimdTier::AVX2:
+                return { tier, kernels::transformPointsAVX2, kernels::normalizeAVX2, kernels::dotAVX2,
+                         kernels::transformClipAVX2, kernels::projectViewportAVX2 };
+            case SimdTier::SSE41:
+                return { tier, kernels::transformPointsSSE41, kernels::normalizeSSE41, kernels::dotSSE41,
+                         kernels::transformClipSSE41, kernels::projectViewportSSE41 };
+            default:
+                break;
+            }
+#endif
+            return { SimdTier::Scalar, kernels::transformPointsScalar, kernels::normalizeScalar, kernels::dotScalar,
+                     kernels::transformClipScalar, kernels::projectViewportScalar };
+        }
+
+        static const BulkKernels& active() { return table(); }
+        static SimdTier tier() { return table().tier; }
+
+        // Pin a tier for benchmarking or testing. Tiers the CPU lacks are
+        // clamped down to the best supported one, which is what gets returned.
+        // Not thread-safe: call while no bulk kernel is running.
+        static SimdTier forceTier(SimdTier t)
+        {
+            SimdTier best = cpuFeatures().bestTier();
+            table() = kernelsFor(t > best ? best : t);
+            return table().tier;
+        }
+
+        // Back to the startup choice (CPUID, then CPL_SIMD_TIER if set).
+        static void resetTier() { table() = kernelsFor(startupTier()); }
+
+        // Accepts the names printed by tierName() plus "sse41"/"avx2"/"avx512".
+        static bool parseTier(const char* name, SimdTier& out)
+        {
+            for (int t = 0; t <= (int)SimdTier::AVX512; ++t)
+                if (std::strcmp(name, tierName((SimdTier)t)) == 0) { out = (SimdTier)t; return true; }
+            if (std::strcmp(name, "sse41") == 0)  { out = SimdTier::SSE41;  return true; }
+            if (std::strcmp(name, "avx2") == 0)   { out = SimdTier::AVX2;   return true; }
+            if (std::strcmp(name, "avx512") == 0) { out = SimdTier::AVX512; return true; }
+            return false;
+        }
+
+    private:
+        static SimdTier startupTier()
+        {
+            SimdTier best = cpuFeatures().bestTier();
+            SimdTier requested;
+            const char* env = std::getenv("CPL_SIMD_TIER");
+            if (env && parseTier(env, requested) && requested < best) return requested;
+            return best;
+        }
+
+        static BulkKernels& table()
+        {
+            static BulkKernels k = kernelsFor(startupTier());
+            return k;
+        }
+    };
+
+    // ─── Public entry points ───────────────────────────────
+
+    // out[i] = m * in[i], with the same perspective-divide rule as Matrix4::operator*.
+    inline void transformPoints(const Matrix4f& m, const Vector3f* in, Vector3f* out, size_t n)
+    {
+        SimdDispatch::active().transformPoints(m, in, out, n);
+    }
+
+    // out[i] = in[i].normalized(); zero-length vectors stay zero.
+    inline void normalizeVectors(const Vector3f* in, Vector3f* out, size_t n)
+    {
+        SimdDispatch::active().normalize(in, out, n);
+    }
+
+    // out[i] = a[i].dot(b[i])
+    inline void dotProducts(const Vector3f* a, const Vector3f* b, float* out, size_t n)
+    {
+        SimdDispatch::active().dot(a, b, out, n);
+    }
+
+    // out[i] = m.transformHomogeneous(in[i]): clip space, w kept, no divide.
+    inline void transformToClip(const Matrix4f& m, const Vector3f* in, Vector4f* out, size_t n)
+    {
+        SimdDispatch::active().transformClip(m, in, out, n);
+    }
+
+    // Perspective divide and viewport map: out[i] = (window x, y, depth, 1 / w).
+    // One reciprocal per vertex, then multiplies. Vertices must have w != 0,
+    // i.e. be clipped against the near plane first; `in` and `out` may alias.
+    inline void projectToViewport(const Viewport& vp, const Vector4f* in, Vector4f* out, size_t n)
+    {
+        SimdDispatch::active().projectViewport(vp, in, out, n);
+    }
+}
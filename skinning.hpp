@@ -0,0 +1,339 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Vector3.hpp"
+#include "matrix3.hpp"
+#include "matrix4.hpp"
+#include "quaternion.hpp"
+#include "simd_dispatch.hpp"
+#include "job_pool.hpp"
+
+namespace CPL
+{
+    enum class SkinningMethod
+    {
+        Linear,         // blend matrices (LBS)
+        DualQuaternion  // blend unit dual quaternions; joints must be rigid
+    };
+
+    // Joint matrices for one frame (joint world transform * inverse bind),
+    // flattened for the kernels: 3x4 affine rows and, for dual-quaternion
+    // skinning, (real xyzw, dual xyzw).
+    class SkinPalette
+    {
+    public:
+        SkinPalette() = default;
+        SkinPalette(const Matrix4f* joints, size_t count) { set(joints, count); }
+
+        void set(const Matrix4f* joints, size_t count)
+        {
+            affineRows.resize(count * 12);
+            dualQuats.resize(count * 8);
+            for (size_t j = 0; j < count; ++j)
+            {
+                const Matrix4f& m = joints[j];
+                for (int r = 0; r < 3; ++r)
+                    for (int c = 0; c < 4; ++c) affineRows[j * 12 + r * 4 + c] = m(r, c);
+
+                // dual = t * real / 2, with t as a pure quaternion
+                Quaternionf q = Quaternionf::fromMatrix3(Matrix3f{ m(0, 0), m(0, 1), m(0, 2),
+                                                                   m(1, 0), m(1, 1), m(1, 2),
+                                                                   m(2, 0), m(2, 1), m(2, 2) }).normalized();
+                Quaternionf d = Quaternionf(m(0, 3), m(1, 3), m(2, 3), 0) * q * 0.5f;
+                const float dq[8] = { q.x, q.y, q.z, q.w, d.x, d.y, d.z, d.w };
+                std::copy(dq, dq + 8, dualQuats.begin() + j * 8);
+            }
+        }
+
+        size_t size() const { return affineRows.size() / 12; }
+        const float* affine() const { return affineRows.data(); }
+        const float* dualQuaternions() const { return dualQuats.data(); }
+
+    private:
+        std::vector<float> affineRows, dualQuats;
+    };
+
+    // Bind-pose mesh in SoA form: one stream per coordinate and, for each
+    // influence slot, a joint stream and a weight stream.
+    class SkinMesh
+    {
+    public:
+        // `joints` and `weights` hold `influences` (4 or 8) entries per vertex.
+        // Weights are renormalized to sum to one; `normals` may be null.
+        SkinMesh(const Vector3f* positions, const Vector3f* normals, size_t count,
+                 const uint16_t* joints, const float* weights, int influences)
+            : count(count), slots(influences), hasNormals(normals != nullptr),
+              streams(6 * count), jointIds(influences * count), jointWeights(influences * count)
+        {
+            for (size_t v = 0; v < count; ++v)
+            {
+                streams[v] = positions[v].x; streams[count + v] = positions[v].y; streams[2 * count + v] = positions[v].z;
+                if (normals) { streams[3 * count + v] = normals[v].x; streams[4 * count + v] = normals[v].y; streams[5 * count + v] = normals[v].z; }
+                float sum = 0;
+                for (int k = 0; k < influences; ++k) sum += weights[v * influences + k];
+                for (int k = 0; k < influences; ++k)
+                {
+                    jointIds[k * count + v] = joints[v * influences + k];
+                    jointWeights[k * count + v] = sum > 0 ? weights[v * influences + k] / sum : (k == 0 ? 1.0f : 0.0f);
+                }
+            }
+        }
+
+        size_t size() const { return count; }
+        int influences() const { return slots; }
+        bool normals() const { return hasNormals; }
+
+        const float* position(int axis) const { return streams.data() + axis * count; }
+        const float* normal(int axis) const { return streams.data() + (3 + axis) * count; }
+        const uint16_t* joints(int slot) const { return jointIds.data() + slot * count; }
+        const float* weights(int slot) const { return jointWeights.data() + slot * count; }
+
+    private:
+        size_t                count;
+        int                   slots;
+        bool                  hasNormals;
+        std::vector<float>    streams;
+        std::vector<uint16_t> jointIds;
+        std::vector<float>    jointWeights;
+    };
+
+    // One mesh to deform; `normals` may be null to skip them.
+    struct SkinJob
+    {
+        const SkinMesh*    mesh;
+        const SkinPalette* palette;
+        Vector3f*          positions;
+        Vector3f*          normals = nullptr;
+    };
+
+    namespace skinning
+    {
+        struct Output
+        {
+            Vector3f* positions;
+            Vector3f* normals;
+        };
+
+        inline void linearScalar(const SkinMesh& m, const float* affine, size_t b, size_t e, Output out)
+        {
+            for (size_t v = b; v < e; ++v)
+            {
+                float r[12] = {};
+                for (int k = 0; k < m.influences(); ++k)
+                {
+                    const float* a = affine + m.joints(k)[v] * 12;
+                    float w = m.weights(k)[v];
+                    for (int c = 0; c < 12; ++c) r[c] += a[c] * w;
+                }
+                float x = m.position(0)[v], y = m.position(1)[v], z = m.position(2)[v];
+                out.positions[v] = { r[0] * x + r[1] * y + r[2] * z + r[3],
+                                     r[4] * x + r[5] * y + r[6] * z + r[7],
+                                     r[8] * x + r[9] * y + r[10] * z + r[11] };
+                if (out.normals)
+                {
+                    x = m.normal(0)[v]; y = m.normal(1)[v]; z = m.normal(2)[v];
+                    Vector3f n(r[0] * x + r[1] * y + r[2] * z, r[4] * x + r[5] * y + r[6] * z, r[8] * x + r[9] * y + r[10] * z);
+                    out.normals[v] = n * (1 / std::sqrt(n.dot(n)));
+                }
+            }
+        }
+
+        inline void dualQuaternionScalar(const SkinMesh& m, const float* dq, size_t b, size_t e, Output out)
+        {
+            for (size_t v = b; v < e; ++v)
+            {
+                // Flip quaternions on the far hemisphere from the first influence.
+                const float* first = dq + m.joints(0)[v] * 8;
+                float r[8] = {};
+                for (int k = 0; k < m.influences(); ++k)
+                {
+                    const float* q = dq + m.joints(k)[v] * 8;
+                    float w = m.weights(k)[v];
+                    if (q[0] * first[0] + q[1] * first[1] + q[2] * first[2] + q[3] * first[3] < 0) w = -w;
+                    for (int c = 0; c < 8; ++c) r[c] += q[c] * w;
+                }
+                float inv = 1 / std::sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2] + r[3] * r[3]);
+                Vector3f rv(r[0] * inv, r[1] * inv, r[2] * inv), dv(r[4] * inv, r[5] * inv, r[6] * inv);
+                float rw = r[3] * inv, dw = r[7] * inv;
+
+                // t = 2 (rw dv - dw rv + rv x dv); p' = p + 2 rv x (rv x p + rw p) + t
+                Vector3f t = (dv * rw + rv * -dw + rv.cross(dv)) * 2;
+                Vector3f p(m.position(0)[v], m.position(1)[v], m.position(2)[v]);
+                out.positions[v] = p + rv.cross(rv.cross(p) + p * rw) * 2 + t;
+                if (out.normals)
+                {
+                    Vector3f n(m.normal(0)[v], m.normal(1)[v], m.normal(2)[v]);
+                    out.normals[v] = n + rv.cross(rv.cross(n) + n * rw) * 2;
+                }
+            }
+        }
+
+#if defined(CPL_X86)
+        // The kernels below blend palette rows for vertex v in the low
+        // 128-bit lane and v + 4 in the high lane, then transpose four such
+        // pairs so lane l of each result belongs to vertex l. Contiguous row
+        // loads are much cheaper than gathering every matrix element.
+        using kernels::loadPair;
+        using kernels::transpose4;
+        using kernels::store3;
+
+        CPL_TARGET_AVX2 inline __m256 splatPair(float lo, float hi)
+        {
+            return _mm256_insertf128_ps(_mm256_set1_ps(lo), _mm_set1_ps(hi), 1);
+        }
+
+        // Same as linearScalar, 8 vertices per iteration; returns where it stopped.
+        CPL_TARGET_AVX2 inline size_t linearAVX2(const SkinMesh& m, const float* affine, size_t b, size_t e, Output out)
+        {
+            size_t v = b;
+            for (; v + 8 <= e; v += 8)
+            {
+                // rows[row][pair], then transposed in place to r[row * 4 + col]
+                __m256 r[12];
+                for (int c = 0; c < 12; ++c) r[c] = _mm256_setzero_ps();
+                for (int k = 0; k < m.influences(); ++k)
+                {
+                    const uint16_t* ids = m.joints(k) + v;
+                    const float* ws = m.weights(k) + v;
+                    for (int pair = 0; pair < 4; ++pair)
+                    {
+                        const float* lo = affine + ids[pair] * 12;
+                        const float* hi = affine + ids[pair + 4] * 12;
+                        __m256 w = splatPair(ws[pair], ws[pair + 4]);
+                        for (int row = 0; row < 3; ++row)
+                            r[row * 4 + pair] = _mm256_fmadd_ps(loadPair(lo + row * 4, hi + row * 4), w, r[row * 4 + pair]);
+                    }
+                }
+                for (int row = 0; row < 3; ++row) transpose4(r[row * 4], r[row * 4 + 1], r[row * 4 + 2], r[row * 4 + 3]);
+                __m256 x = _mm256_loadu_ps(m.position(0) + v), y = _mm256_loadu_ps(m.position(1) + v), z = _mm256_loadu_ps(m.position(2) + v);
+                store3(out.positions + v,
+                       _mm256_fmadd_ps(r[0], x, _mm256_fmadd_ps(r[1], y, _mm256_fmadd_ps(r[2], z, r[3]))),
+                       _mm256_fmadd_ps(r[4], x, _mm256_fmadd_ps(r[5], y, _mm256_fmadd_ps(r[6], z, r[7]))),
+                       _mm256_fmadd_ps(r[8], x, _mm256_fmadd_ps(r[9], y, _mm256_fmadd_ps(r[10], z, r[11]))));
+                if (out.normals)
+                {
+                    x = _mm256_loadu_ps(m.normal(0) + v); y = _mm256_loadu_ps(m.normal(1) + v); z = _mm256_loadu_ps(m.normal(2) + v);
+                    __m256 nx = _mm256_fmadd_ps(r[0], x, _mm256_fmadd_ps(r[1], y, _mm256_mul_ps(r[2], z)));
+                    __m256 ny = _mm256_fmadd_ps(r[4], x, _mm256_fmadd_ps(r[5], y, _mm256_mul_ps(r[6], z)));
+                    __m256 nz = _mm256_fmadd_ps(r[8], x, _mm256_fmadd_ps(r[9], y, _mm256_mul_ps(r[10], z)));
+                    __m256 len2 = _mm256_fmadd_ps(nx, nx, _mm256_fmadd_ps(ny, ny, _mm256_mul_ps(nz, nz)));
+                    __m256 inv = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(len2));
+                    store3(out.normals + v, _mm256_mul_ps(nx, inv), _mm256_mul_ps(ny, inv), _mm256_mul_ps(nz, inv));
+                }
+            }
+            return v;
+        }
+
+        // a x b, per lane
+        CPL_TARGET_AVX2 inline void cross8(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz,
+                                           __m256& cx, __m256& cy, __m256& cz)
+        {
+            cx = _mm256_fmsub_ps(ay, bz, _mm256_mul_ps(az, by));
+            cy = _mm256_fmsub_ps(az, bx, _mm256_mul_ps(ax, bz));
+            cz = _mm256_fmsub_ps(ax, by, _mm256_mul_ps(ay, bx));
+        }
+
+        // p + 2 rv x (rv x p + rw p)
+        CPL_TARGET_AVX2 inline void rotate8(const __m256* rv, __m256 rw, __m256& x, __m256& y, __m256& z)
+        {
+            __m256 cx, cy, cz, ux, uy, uz;
+            cross8(rv[0], rv[1], rv[2], x, y, z, cx, cy, cz);
+            cx = _mm256_fmadd_ps(x, rw, cx); cy = _mm256_fmadd_ps(y, rw, cy); cz = _mm256_fmadd_ps(z, rw, cz);
+            cross8(rv[0], rv[1], rv[2], cx, cy, cz, ux, uy, uz);
+            const __m256 two = _mm256_set1_ps(2.0f);
+            x = _mm256_fmadd_ps(ux, two, x); y = _mm256_fmadd_ps(uy, two, y); z = _mm256_fmadd_ps(uz, two, z);
+        }
+
+        CPL_TARGET_AVX2 inline size_t dualQuaternionAVX2(const SkinMesh& m, const float* dq, size_t b, size_t e, Output out)
+        {
+            const __m256 signBit = _mm256_set1_ps(-0.0f);
+            size_t v = b;
+            for (; v + 8 <= e; v += 8)
+            {
+                // real and dual halves per pair, transposed to r[c] below
+                __m256 r[8];
+                for (int c = 0; c < 8; ++c) r[c] = _mm256_setzero_ps();
+                for (int pair = 0; pair < 4; ++pair)
+                {
+                    __m256 first = loadPair(dq + m.joints(0)[v + pair] * 8, dq + m.joints(0)[v + pair + 4] * 8);
+                    for (int k = 0; k < m.influences(); ++k)
+                    {
+                        const float* lo = dq + m.joints(k)[v + pair] * 8;
+                        const float* hi = dq + m.joints(k)[v + pair + 4] * 8;
+                        __m256 real = loadPair(lo, hi);
+                        __m256 sign = _mm256_and_ps(_mm256_dp_ps(real, first, 0xFF), signBit);
+                        __m256 w = _mm256_xor_ps(splatPair(m.weights(k)[v + pair], m.weights(k)[v + pair + 4]), sign);
+                        r[pair] = _mm256_fmadd_ps(real, w, r[pair]);
+                        r[pair + 4] = _mm256_fmadd_ps(loadPair(lo + 4, hi + 4), w, r[pair + 4]);
+                    }
+                }
+                transpose4(r[0], r[1], r[2], r[3]);
+                transpose4(r[4], r[5], r[6], r[7]);
+                __m256 len2 = _mm256_fmadd_ps(r[0], r[0], _mm256_fmadd_ps(r[1], r[1], _mm256_fmadd_ps(r[2], r[2], _mm256_mul_ps(r[3], r[3]))));
+                __m256 inv = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(len2));
+                for (int c = 0; c < 8; ++c) r[c] = _mm256_mul_ps(r[c], inv);
+
+                __m256 tx, ty, tz;
+                cross8(r[0], r[1], r[2], r[4], r[5], r[6], tx, ty, tz);
+                tx = _mm256_fmadd_ps(r[4], r[3], _mm256_fnmadd_ps(r[0], r[7], tx));
+                ty = _mm256_fmadd_ps(r[5], r[3], _mm256_fnmadd_ps(r[1], r[7], ty));
+                tz = _mm256_fmadd_ps(r[6], r[3], _mm256_fnmadd_ps(r[2], r[7], tz));
+
+                __m256 x = _mm256_loadu_ps(m.position(0) + v), y = _mm256_loadu_ps(m.position(1) + v), z = _mm256_loadu_ps(m.position(2) + v);
+                rotate8(r, r[3], x, y, z);
+                const __m256 two = _mm256_set1_ps(2.0f);
+                store3(out.positions + v, _mm256_fmadd_ps(tx, two, x), _mm256_fmadd_ps(ty, two, y), _mm256_fmadd_ps(tz, two, z));
+                if (out.normals)
+                {
+                    x = _mm256_loadu_ps(m.normal(0) + v); y = _mm256_loadu_ps(m.normal(1) + v); z = _mm256_loadu_ps(m.normal(2) + v);
+                    rotate8(r, r[3], x, y, z);
+                    store3(out.normals + v, x, y, z);
+                }
+            }
+            return v;
+        }
+#endif
+
+        inline void run(const SkinJob& job, SkinningMethod method, size_t b, size_t e)
+        {
+            const SkinMesh& m = *job.mesh;
+            Output out{ job.positions, m.normals() ? job.normals : nullptr };
+            bool linear = method == SkinningMethod::Linear;
+#if defined(CPL_X86)
+            if (SimdDispatch::tier() >= SimdTier::AVX2)
+                b = linear ? linearAVX2(m, job.palette->affine(), b, e, out)
+                           : dualQuaternionAVX2(m, job.palette->dualQuaternions(), b, e, out);
+#endif
+            if (linear) linearScalar(m, job.palette->affine(), b, e, out);
+            else        dualQuaternionScalar(m, job.palette->dualQuaternions(), b, e, out);
+        }
+    }
+
+    // Deforms one mesh on the calling thread.
+    inline void skin(const SkinJob& job, SkinningMethod method)
+    {
+        skinning::run(job, method, 0, job.mesh->size());
+    }
+
+    // Deforms many meshes across the pool. Meshes are cut into vertex chunks
+    // so a few large meshes still spread over every thread.
+    inline void skin(const SkinJob* jobs, size_t count, SkinningMethod method, JobPool& pool = JobPool::global())
+    {
+        const size_t grain = 2048;
+        std::vector<size_t> firstChunk(count + 1, 0);
+        for (size_t j = 0; j < count; ++j)
+            firstChunk[j + 1] = firstChunk[j] + JobPool::chunkCount(jobs[j].mesh->size(), grain);
+
+        pool.parallelChunks(firstChunk[count], 1, [&](size_t, size_t b, size_t e) {
+            for (size_t c = b; c < e; ++c)
+            {
+                size_t j = std::upper_bound(firstChunk.begin(), firstChunk.end(), c) - firstChunk.begin() - 1;
+                size_t begin = (c - firstChunk[j]) * grain;
+                skinning::run(jobs[j], method, begin, std::min(begin + grain, jobs[j].mesh->size()));
+            }
+        });
+    }
+}
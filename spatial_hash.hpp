@@ -0,0 +1,303 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "Vector3.hpp"
+#include "job_pool.hpp"
+
+namespace CPL
+{
+    // Uniform grid over hashed cell coordinates. build() counting-sorts the
+    // points by bucket into flat arrays: bucket b owns [cellStart[b], cellStart[b+1])
+    // of sortedPoints / sortedIndices. Several cells may share a bucket, so every
+    // entry keeps its own cell coordinates and queries skip foreign ones.
+    template<typename T>
+    class SpatialHashGrid
+    {
+    public:
+        struct Cell { int32_t x, y, z; };
+
+        explicit SpatialHashGrid(T cellSize) : cellSize(cellSize), invCellSize(T(1) / cellSize) {}
+
+        T cell() const { return cellSize; }
+        size_t size() const { return sortedIndices.size(); }
+        size_t bucketCount() const { return mask + 1; }
+
+        // Coordinates are clamped to +-2^30 cells before the int conversion, so
+        // far-away points share the outermost cells instead of overflowing.
+        // Queries still test exact distances, so results stay correct.
+        Cell cellOf(const Vector3<T>& p) const
+        {
+            return { toCell(p.x * invCellSize), toCell(p.y * invCellSize), toCell(p.z * invCellSize) };
+        }
+
+        // Rebuilds from scratch. Bucket count is the next power of two >= 2n.
+        // Two-level counting sort without atomics, so the result is identical
+        // for any thread count: chunks first split points by the top bucket bits
+        // into 256 partitions, then each partition sorts its own bucket range
+        // with a histogram small enough to stay in cache.
+        void build(const Vector3<T>* points, size_t n, JobPool& pool = JobPool::global())
+        {
+            const size_t grain = 16384;
+            unsigned bits = 10;
+            while ((size_t(1) << bits) < 2 * n) ++bits;
+            const unsigned shift = bits - radixBits;
+            const size_t buckets = size_t(1) << bits;
+            const size_t parts = size_t(1) << radixBits;
+            mask = buckets - 1;
+
+            bucketOf.resize(n);
+            scratch.resize(n);
+            sortedPoints.resize(n);
+            sortedIndices.resize(n);
+            pointCells.resize(n);
+            cellStart.resize(buckets + 1);
+
+            // 0. Bounds, which fix the hash strides.
+            const size_t chunks = JobPool::chunkCount(n, grain);
+            std::vector<Vector3<T>> chunkMin(chunks), chunkMax(chunks);
+            pool.parallelChunks(n, grain, [&](size_t c, size_t b, size_t e) {
+                Vector3<T> lo = points[b], hi = lo;
+                for (size_t i = b + 1; i < e; ++i)
+                {
+                    const Vector3<T>& p = points[i];
+                    lo = { std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z) };
+                    hi = { std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z) };
+                }
+                chunkMin[c] = lo;
+                chunkMax[c] = hi;
+            });
+            boundsMin = chunks ? chunkMin[0] : Vector3<T>();
+            boundsMax = chunks ? chunkMax[0] : Vector3<T>();
+            for (size_t c = 1; c < chunks; ++c)
+            {
+                const Vector3<T>& lo = chunkMin[c];
+                const Vector3<T>& hi = chunkMax[c];
+                boundsMin = { std::min(boundsMin.x, lo.x), std::min(boundsMin.y, lo.y), std::min(boundsMin.z, lo.z) };
+                boundsMax = { std::max(boundsMax.x, hi.x), std::max(boundsMax.y, hi.y), std::max(boundsMax.z, hi.z) };
+            }
+            boundsLo = cellOf(boundsMin);
+            boundsHi = cellOf(boundsMax);
+            strideY = (uint32_t)boundsHi.x - (uint32_t)boundsLo.x + 1;
+            strideZ = strideY * ((uint32_t)boundsHi.y - (uint32_t)boundsLo.y + 1);
+
+            // 1. Bucket per point, per-chunk histogram of the partition digit.
+            std::vector<uint32_t> offsets(chunks * parts, 0);
+            pool.parallelChunks(n, grain, [&](size_t c, size_t b, size_t e) {
+                uint32_t* hist = &offsets[c * parts];
+                for (size_t i = b; i < e; ++i)
+                {
+                    uint32_t h = hash(cellOf(points[i]));
+                    bucketOf[i] = h;
+                    ++hist[h >> shift];
+                }
+            });
+
+            // 2. Partition offsets, partition-major then chunk, which keeps the
+            // scatter stable.
+            std::vector<uint32_t> partStart(parts + 1);
+            uint32_t run = 0;
+            for (size_t d = 0; d < parts; ++d)
+            {
+                partStart[d] = run;
+                for (size_t c = 0; c < chunks; ++c)
+                {
+                    uint32_t count = offsets[c * parts + d];
+                    offsets[c * parts + d] = run;
+                    run += count;
+                }
+            }
+            partStart[parts] = run;
+
+            pool.parallelChunks(n, grain, [&](size_t c, size_t b, size_t e) {
+                uint32_t* cursor = &offsets[c * parts];
+                for (size_t i = b; i < e; ++i)
+                    scratch[cursor[bucketOf[i] >> shift]++] = (uint32_t)i;
+            });
+
+            // 3. Per partition: histogram its buckets, fill cellStart, scatter
+            // indices, then gather points and cells in sorted order.
+            const size_t partBuckets = buckets / parts;
+            pool.parallelFor(parts, 1, [&](size_t pb, size_t pe) {
+                std::vector<uint32_t> cursor(partBuckets);
+                for (size_t d = pb; d < pe; ++d)
+                {
+                    const uint32_t begin = partStart[d], end = partStart[d + 1];
+                    const size_t base = d * partBuckets;
+                    std::fill(cursor.begin(), cursor.end(), 0);
+                    for (uint32_t i = begin; i < end; ++i) ++cursor[bucketOf[scratch[i]] - base];
+
+                    uint32_t at = begin;
+                    for (size_t j = 0; j < partBuckets; ++j)
+                    {
+                        cellStart[base + j] = at;
+                        uint32_t count = cursor[j];
+                        cursor[j] = at;
+                        at += count;
+                    }
+                    for (uint32_t i = begin; i < end; ++i)
+                    {
+                        uint32_t idx = scratch[i];
+                        sortedIndices[cursor[bucketOf[idx] - base]++] = idx;
+                    }
+                    for (uint32_t i = begin; i < end; ++i)
+                    {
+                        sortedPoints[i] = points[sortedIndices[i]];
+                        pointCells[i] = cellOf(sortedPoints[i]);
+                    }
+                }
+            });
+            cellStart[buckets] = (uint32_t)n;
+
+        }
+
+        // fn(originalIndex, distanceSquared) for every point within `radius`.
+        template<typename F>
+        void forEachInRadius(const Vector3<T>& center, T radius, F&& fn) const
+        {
+            if (sortedIndices.empty()) return;
+            const T r2 = radius * radius;
+            Cell lo = cellOf(Vector3<T>(center.x - radius, center.y - radius, center.z - radius));
+            Cell hi = cellOf(Vector3<T>(center.x + radius, center.y + radius, center.z + radius));
+            lo = { std::max(lo.x, boundsLo.x), std::max(lo.y, boundsLo.y), std::max(lo.z, boundsLo.z) };
+            hi = { std::min(hi.x, boundsHi.x), std::min(hi.y, boundsHi.y), std::min(hi.z, boundsHi.z) };
+            if (lo.x > hi.x || lo.y > hi.y || lo.z > hi.z) return;  // misses the bounds
+
+            // The hash is linear in x, so each row of cells is a contiguous
+            // run of buckets: scan it once and keep the entries whose cell is
+            // in the row, rather than hashing and scanning cell by cell. A row
+            // longer than the table covers every bucket once.
+            const uint32_t span = (uint32_t)hi.x - (uint32_t)lo.x + 1;
+            const uint32_t buckets = (uint32_t)mask + 1;
+            for (int32_t z = lo.z; z <= hi.z; ++z)
+                for (int32_t y = lo.y; y <= hi.y; ++y)
+                {
+                    const uint32_t h = hash(Cell{ lo.x, y, z });
+                    if (span >= buckets)
+                        scanBuckets(0, buckets, lo.x, hi.x, y, z, center, r2, fn);
+                    else if (h + span <= buckets)
+                        scanBuckets(h, h + span, lo.x, hi.x, y, z, center, r2, fn);
+                    else
+                    {
+                        // The row wraps around the end of the table.
+                        scanBuckets(h, buckets, lo.x, hi.x, y, z, center, r2, fn);
+                        scanBuckets(0, h + span - buckets, lo.x, hi.x, y, z, center, r2, fn);
+                    }
+                }
+        }
+
+        // Appends indices of points within `radius`; returns how many were added.
+        size_t queryRadius(const Vector3<T>& center, T radius, std::vector<uint32_t>& out) const
+        {
+            size_t before = out.size();
+            forEachInRadius(center, radius, [&](uint32_t idx, T) { out.push_back(idx); });
+            return out.size() - before;
+        }
+
+        // Up to k nearest points, closest first (ties broken by index). Searches
+        // a growing sphere until it holds k points or encloses the whole point
+        // set. Points farther than maxRadius are never returned.
+        size_t kNearest(const Vector3<T>& center, size_t k, std::vector<uint32_t>& out,
+                        T maxRadius = std::numeric_limits<T>::max()) const
+        {
+            out.clear();
+            if (k == 0 || sortedIndices.empty()) return 0;
+
+            // Distances to the nearest and farthest point of the bounding box.
+            T nearSq = 0, farSq = 0;
+            const T c[3] = { center.x, center.y, center.z };
+            const T lo[3] = { boundsMin.x, boundsMin.y, boundsMin.z };
+            const T hi[3] = { boundsMax.x, boundsMax.y, boundsMax.z };
+            for (int a = 0; a < 3; ++a)
+            {
+                T dn = c[a] < lo[a] ? lo[a] - c[a] : (c[a] > hi[a] ? c[a] - hi[a] : T(0));
+                T df = std::max(c[a] - lo[a], hi[a] - c[a]);
+                nearSq += dn * dn;
+                farSq += df * df;
+            }
+
+            std::vector<std::pair<T, uint32_t>> hits;
+            T radius = std::sqrt(nearSq) + cellSize;
+            for (;;)
+            {
+                T r = std::min(radius, maxRadius);
+                hits.clear();
+                forEachInRadius(center, r, [&](uint32_t idx, T d2) { hits.emplace_back(d2, idx); });
+                if (hits.size() >= k || r * r >= farSq || r >= maxRadius) break;
+                radius *= 2;
+            }
+
+            size_t m = std::min(k, hits.size());
+            std::partial_sort(hits.begin(), hits.begin() + m, hits.end());
+            for (size_t i = 0; i < m; ++i) out.push_back(hits[i].second);
+            return m;
+        }
+
+        // Points and their original indices in bucket order. Iterating queries
+        // in this order keeps neighbouring lookups in cache.
+        const std::vector<Vector3<T>>& points() const { return sortedPoints; }
+        const std::vector<uint32_t>& indices() const { return sortedIndices; }
+
+    private:
+        T                        cellSize;
+        T                        invCellSize;
+        size_t                   mask = 0;
+        std::vector<uint32_t>    cellStart;
+        std::vector<uint32_t>    sortedIndices;
+        std::vector<Vector3<T>>  sortedPoints;
+        std::vector<Cell>        pointCells;
+        Vector3<T>               boundsMin, boundsMax;
+        Cell                     boundsLo{}, boundsHi{};
+        uint32_t                 strideY = 1, strideZ = 1;
+
+        static constexpr unsigned radixBits = 8;
+        static constexpr int32_t cellLimit = 1 << 30;
+
+        static int32_t toCell(T v)
+        {
+            // NaN fails the first test and maps to -cellLimit. Floors by
+            // truncating and stepping down: GCC stops inlining floor() once
+            // the clamp is in front of it.
+            v = v > T(-cellLimit) ? v : T(-cellLimit);
+            v = v < T(cellLimit) ? v : T(cellLimit);
+            int32_t i = (int32_t)v;
+            return i - (int32_t)(v < T(i));
+        }
+
+        template<typename F>
+        void scanBuckets(uint32_t hb, uint32_t he, int32_t x0, int32_t x1, int32_t y, int32_t z,
+                         const Vector3<T>& center, T r2, F& fn) const
+        {
+            for (uint32_t i = cellStart[hb], e = cellStart[he]; i < e; ++i)
+            {
+                const Cell& pc = pointCells[i];
+                if (pc.y != y || pc.z != z || pc.x < x0 || pc.x > x1) continue;
+                const Vector3<T>& p = sortedPoints[i];
+                T dx = p.x - center.x, dy = p.y - center.y, dz = p.z - center.z;
+                T d2 = dx * dx + dy * dy + dz * dz;
+                if (d2 <= r2) fn(sortedIndices[i], d2);
+            }
+        }
+
+        // Build scratch, kept between rebuilds to avoid reallocating every frame.
+        std::vector<uint32_t>    bucketOf;
+        std::vector<uint32_t>    scratch;
+
+        // Row-major cell index within the bounds, wrapped to the table. A
+        // query's rows are runs of adjacent buckets, and its neighbouring rows
+        // and slices sit a fixed stride away, so queries walked in bucket
+        // order stream through memory. Collision-free while the bounds hold
+        // no more cells than there are buckets.
+        uint32_t hash(const Cell& c) const
+        {
+            uint32_t h = ((uint32_t)c.x - (uint32_t)boundsLo.x) + ((uint32_t)c.y - (uint32_t)boundsLo.y) * strideY +
+                         ((uint32_t)c.z - (uint32_t)boundsLo.z) * strideZ;
+            return h & (uint32_t)mask;
+        }
+    };
+
+    using SpatialHashGridf = SpatialHashGrid<float>;
+}
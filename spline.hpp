@@ -0,0 +1,282 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include "vector2.hpp"
+#include "Vector3.hpp"
+#include "simd_dispatch.hpp"
+
+namespace CPL
+{
+    namespace spline
+    {
+        // Component access, so the curves work on Vector2<T> and Vector3<T> alike.
+        template<typename V> struct Traits;
+
+        template<typename T>
+        struct Traits<Vector2<T>>
+        {
+            using Scalar = T;
+            static constexpr int Dims = 2;
+            static T get(const Vector2<T>& v, int i) { return i == 0 ? v.x : v.y; }
+            static Vector2<T> make(const T* c) { return Vector2<T>(c[0], c[1]); }
+        };
+
+        template<typename T>
+        struct Traits<Vector3<T>>
+        {
+            using Scalar = T;
+            static constexpr int Dims = 3;
+            static T get(const Vector3<T>& v, int i) { return i == 0 ? v.x : (i == 1 ? v.y : v.z); }
+            static Vector3<T> make(const T* c) { return Vector3<T>(c[0], c[1], c[2]); }
+        };
+    }
+
+    // Piecewise cubic curve. Every segment is stored in power form
+    // c0 + c1 u + c2 u^2 + c3 u^3 whatever it was built from, so all three
+    // kinds evaluate the same way. The parameter t in [0, 1] spans the whole
+    // curve, one equal slice per segment; the arc-length table maps distance
+    // along the curve back to t. A curve with no segments (default, or built
+    // from too few points) evaluates to zero, and until buildArcLength() has
+    // run every distance maps to t = 0.
+    template<typename V>
+    class Spline
+    {
+    public:
+        using T = typename spline::Traits<V>::Scalar;
+        static constexpr int Dims = spline::Traits<V>::Dims;
+
+        Spline() = default;
+
+        // Centripetal (alpha = 0.5) Catmull-Rom through all n >= 2 points. The
+        // ends get phantom points mirrored from their neighbours.
+        static Spline catmullRom(const V* points, size_t n, T alpha = T(0.5))
+        {
+            Spline s;
+            for (size_t i = 0; i + 1 < n; ++i)
+            {
+                T p0[Dims], p1[Dims], p2[Dims], p3[Dims], m1[Dims], m2[Dims];
+                for (int d = 0; d < Dims; ++d)
+                {
+                    p1[d] = get(points[i], d);
+                    p2[d] = get(points[i + 1], d);
+                    p0[d] = i > 0 ? get(points[i - 1], d) : 2 * p1[d] - p2[d];
+                    p3[d] = i + 2 < n ? get(points[i + 2], d) : 2 * p2[d] - p1[d];
+                }
+                // Knot spacing |p_{k+1} - p_k|^alpha, kept away from zero for repeated points.
+                T t01 = knot(p0, p1, alpha), t12 = knot(p1, p2, alpha), t23 = knot(p2, p3, alpha);
+                for (int d = 0; d < Dims; ++d)
+                {
+                    m1[d] = p2[d] - p1[d] + t12 * ((p1[d] - p0[d]) / t01 - (p2[d] - p0[d]) / (t01 + t12));
+                    m2[d] = p2[d] - p1[d] + t12 * ((p3[d] - p2[d]) / t23 - (p3[d] - p1[d]) / (t12 + t23));
+                }
+                s.addHermite(p1, p2, m1, m2);
+            }
+            return s;
+        }
+
+        // Cubic Bezier segments sharing end points: n = 3k + 1 controls.
+        static Spline bezier(const V* controls, size_t n)
+        {
+            Spline s;
+            for (size_t i = 0; i + 3 < n; i += 3)
+                for (int d = 0; d < Dims; ++d)
+                {
+                    T p0 = get(controls[i], d), p1 = get(controls[i + 1], d);
+                    T p2 = get(controls[i + 2], d), p3 = get(controls[i + 3], d);
+                    s.coeffs.insert(s.coeffs.end(), { p0, 3 * (p1 - p0), 3 * (p0 - 2 * p1 + p2), p3 - p0 + 3 * (p1 - p2) });
+                }
+            return s;
+        }
+
+        // Through n points with the given tangents, per unit of segment parameter.
+        static Spline hermite(const V* points, const V* tangents, size_t n)
+        {
+            Spline s;
+            for (size_t i = 0; i + 1 < n; ++i)
+            {
+                T p1[Dims], p2[Dims], m1[Dims], m2[Dims];
+                for (int d = 0; d < Dims; ++d)
+                {
+                    p1[d] = get(points[i], d); p2[d] = get(points[i + 1], d);
+                    m1[d] = get(tangents[i], d); m2[d] = get(tangents[i + 1], d);
+                }
+                s.addHermite(p1, p2, m1, m2);
+            }
+            return s;
+        }
+
+        size_t segmentCount() const { return coeffs.size() / (4 * Dims); }
+
+        V evaluate(T t) const
+        {
+            if (coeffs.empty()) return V();
+            T u;
+            const T* c = segment(t, u);
+            T out[Dims];
+            for (int d = 0; d < Dims; ++d, c += 4) out[d] = ((c[3] * u + c[2]) * u + c[1]) * u + c[0];
+            return spline::Traits<V>::make(out);
+        }
+
+        // dp/dt for the whole-curve parameter t.
+        V derivative(T t) const
+        {
+            if (coeffs.empty()) return V();
+            T u;
+            const T* c = segment(t, u);
+            T out[Dims];
+            T scale = T(segmentCount());
+            for (int d = 0; d < Dims; ++d, c += 4) out[d] = ((3 * c[3] * u + 2 * c[2]) * u + c[1]) * scale;
+            return spline::Traits<V>::make(out);
+        }
+
+        // out[i] = evaluate(params[i]); 8 at a time on the AVX2 tier for float curves.
+        void evaluate(const T* params, size_t n, V* out) const
+        {
+            size_t i = 0;
+#if defined(CPL_X86)
+            if constexpr (std::is_same<T, float>::value)
+                if (SimdDispatch::tier() >= SimdTier::AVX2 && segmentCount() > 0) i = evaluateAVX2(params, n, out);
+#endif
+            for (; i < n; ++i) out[i] = evaluate(params[i]);
+        }
+
+        // Cumulative chord lengths at samplesPerSegment steps per segment.
+        // Must be rebuilt if the curve changes.
+        void buildArcLength(int samplesPerSegment = 16)
+        {
+            const size_t steps = segmentCount() * samplesPerSegment;
+            arcLengths.assign(1, T(0));
+            arcLengths.reserve(steps + 1);
+            V prev = evaluate(T(0));
+            for (size_t k = 1; k <= steps; ++k)
+            {
+                V p = evaluate(T(k) / T(steps));
+                T len2 = 0;
+                for (int d = 0; d < Dims; ++d)
+                {
+                    T diff = get(p, d) - get(prev, d);
+                    len2 += diff * diff;
+                }
+                arcLengths.push_back(arcLengths.back() + std::sqrt(len2));
+                prev = p;
+            }
+        }
+
+        T length() const { return arcLengths.empty() ? T(0) : arcLengths.back(); }
+
+        // Inverse of the arc-length table, linear between entries; s is clamped.
+        T parameterAtDistance(T s) const
+        {
+            if (arcLengths.size() < 2) return T(0);
+            size_t k = std::upper_bound(arcLengths.begin(), arcLengths.end(), s) - arcLengths.begin();
+            return interpolate(std::min(std::max<size_t>(k, 1), arcLengths.size() - 1) - 1, s);
+        }
+
+        V evaluateAtDistance(T s) const { return evaluate(parameterAtDistance(s)); }
+
+        // n points evenly spaced along the curve, ends included; n = 1 gives
+        // the start. The distances are sorted, so the table is walked once
+        // instead of searched.
+        void sampleEvenly(size_t n, V* out) const
+        {
+            std::vector<T> params(n, T(0));
+            if (arcLengths.size() >= 2 && n >= 2)
+            {
+                const T step = length() / T(n - 1);
+                size_t k = 0;
+                for (size_t i = 0; i < n; ++i)
+                {
+                    T s = step * T(i);
+                    while (k + 2 < arcLengths.size() && arcLengths[k + 1] <= s) ++k;
+                    params[i] = interpolate(k, s);
+                }
+            }
+            evaluate(params.data(), n, out);
+        }
+
+    private:
+        std::vector<T> coeffs;      // per segment, per dimension: c0, c1, c2, c3
+        std::vector<T> arcLengths;  // length from the start at t = k / (size - 1)
+
+        static T get(const V& v, int d) { return spline::Traits<V>::get(v, d); }
+
+        static T knot(const T* a, const T* b, T alpha)
+        {
+            T len2 = 0;
+            for (int d = 0; d < Dims; ++d) len2 += (b[d] - a[d]) * (b[d] - a[d]);
+            return std::max(std::pow(len2, alpha / 2), T(1e-6));
+        }
+
+        void addHermite(const T* p1, const T* p2, const T* m1, const T* m2)
+        {
+            for (int d = 0; d < Dims; ++d)
+                coeffs.insert(coeffs.end(), { p1[d], m1[d], 3 * (p2[d] - p1[d]) - 2 * m1[d] - m2[d], 2 * (p1[d] - p2[d]) + m1[d] + m2[d] });
+        }
+
+        // Coefficients of the segment holding t, and the local parameter u.
+        const T* segment(T t, T& u) const
+        {
+            const size_t segments = segmentCount();
+            T x = std::min(std::max(t, T(0)), T(1)) * T(segments);
+            size_t s = std::min((size_t)x, segments - 1);
+            u = x - T(s);
+            return coeffs.data() + s * 4 * Dims;
+        }
+
+        // t for distance s between table entries k and k + 1.
+        T interpolate(size_t k, T s) const
+        {
+            const T steps = T(arcLengths.size() - 1);
+            T span = arcLengths[k + 1] - arcLengths[k];
+            T f = span > 0 ? std::min(std::max((s - arcLengths[k]) / span, T(0)), T(1)) : T(0);
+            return (T(k) + f) / steps;
+        }
+
+#if defined(CPL_X86)
+        // Each lane loads its segment's four coefficients per dimension with
+        // one 128-bit load, transposed to SoA; cheaper than four gathers.
+        CPL_TARGET_AVX2 size_t evaluateAVX2(const float* params, size_t n, V* out) const
+        {
+            const float* c = coeffs.data();
+            const __m256 segments = _mm256_set1_ps(float(segmentCount()));
+            const __m256i lastSegment = _mm256_set1_epi32((int)segmentCount() - 1);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                __m256 t = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(params + i), _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+                __m256 x = _mm256_mul_ps(t, segments);
+                __m256i s = _mm256_min_epi32(_mm256_cvttps_epi32(x), lastSegment);
+                __m256 u = _mm256_sub_ps(x, _mm256_cvtepi32_ps(s));
+                alignas(32) int32_t seg[8];
+                _mm256_store_si256((__m256i*)seg, _mm256_mullo_epi32(s, _mm256_set1_epi32(4 * Dims)));
+
+                __m256 r[Dims];
+                for (int d = 0; d < Dims; ++d)
+                {
+                    __m256 k[4];
+                    for (int p = 0; p < 4; ++p) k[p] = kernels::loadPair(c + seg[p] + d * 4, c + seg[p + 4] + d * 4);
+                    kernels::transpose4(k[0], k[1], k[2], k[3]);
+                    r[d] = _mm256_fmadd_ps(_mm256_fmadd_ps(_mm256_fmadd_ps(k[3], u, k[2]), u, k[1]), u, k[0]);
+                }
+                if constexpr (Dims == 3)
+                    kernels::store3(out + i, r[0], r[1], r[2]);
+                else
+                {
+                    // x0 y0 x1 y1 ... in two 256-bit stores
+                    __m256 lo = _mm256_unpacklo_ps(r[0], r[1]), hi = _mm256_unpackhi_ps(r[0], r[1]);
+                    float* dst = &out[i].x;
+                    _mm256_storeu_ps(dst, _mm256_permute2f128_ps(lo, hi, 0x20));
+                    _mm256_storeu_ps(dst + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+                }
+            }
+            return i;
+        }
+#endif
+    };
+
+    using Spline2f = Spline<Vector2f>;
+    using Spline3f = Spline<Vector3f>;
+}
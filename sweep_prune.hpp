@@ -0,0 +1,309 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "Vector3.hpp"
+#include "aabb.hpp"
+#include "job_pool.hpp"
+
+namespace CPL
+{
+    // Incremental sweep and prune. Each axis keeps the boxes' min and max
+    // endpoints in one sorted array; step() re-sorts all three with insertion
+    // sort, which is close to O(n) when motion is coherent. Whenever a min
+    // and a max endpoint swap, the two boxes may have started or stopped
+    // overlapping on that axis; if they overlap on the other two axes at
+    // that point, the pair becomes a candidate. After the sorts each
+    // candidate is checked on all three axes against the previous pair
+    // list, which yields the added and removed pairs; pairs() is then
+    // patched with those deltas. A step in which nothing crossed costs the
+    // sort passes and nothing else.
+    //
+    // Equal values order a min before a max, so boxes that touch overlap,
+    // as in AABB::overlaps(). Many adds at once (the first step, say) fall
+    // back to full sorts and one sweep along the axis of greatest spread.
+    template<typename T>
+    class SweepAndPrune
+    {
+    public:
+        using Pair = std::pair<uint32_t, uint32_t>;
+
+        // axis: 0/1/2 pins the axis the full rebuild sweeps along, -1 picks
+        // the axis along which box centres vary most (re-checked every step,
+        // with hysteresis).
+        explicit SweepAndPrune(int axis = -1) : autoAxis(axis < 0), sweepAxis(axis < 0 ? 0 : axis) {}
+
+        int axis() const { return sweepAxis; }
+        size_t size() const { return ends[0].size() / 2 - pendingRemoves; }
+        size_t lastSwapCount() const { return swaps; }
+
+        // Current overlapping pairs (a < b by handle), sorted; valid after step().
+        const std::vector<Pair>& pairs() const { return current; }
+
+        uint32_t add(const AABB<T>& box)
+        {
+            uint32_t h;
+            if (!freeHandles.empty()) { h = freeHandles.back(); freeHandles.pop_back(); }
+            else
+            {
+                h = (uint32_t)boxes.size();
+                boxes.emplace_back();
+                alive.push_back(0);
+                for (int a = 0; a < 3; ++a) { minAt[a].push_back(0); maxAt[a].push_back(0); }
+            }
+            boxes[h] = box;
+            alive[h] = 1;
+            // Appended past every other endpoint, i.e. overlapping nothing;
+            // the next sort carries them into place and reports the crossings.
+            for (int a = 0; a < 3; ++a)
+            {
+                minAt[a][h] = (uint32_t)ends[a].size();
+                ends[a].push_back({ axisOf(box.min, a), h << 1 });
+                maxAt[a][h] = (uint32_t)ends[a].size();
+                ends[a].push_back({ axisOf(box.max, a), h << 1 | 1 });
+            }
+            ++pendingAdds;
+            return h;
+        }
+
+        void update(uint32_t h, const AABB<T>& box)
+        {
+            boxes[h] = box;
+            for (int a = 0; a < 3; ++a)
+            {
+                ends[a][minAt[a][h]].value = axisOf(box.min, a);
+                ends[a][maxAt[a][h]].value = axisOf(box.max, a);
+            }
+        }
+
+        const AABB<T>& bounds(uint32_t h) const { return boxes[h]; }
+
+        // O(1): the box is marked and its endpoints dropped in the next
+        // step(). The handle is not reused until after that step, so its
+        // pairs are reported as removed rather than carried over to whichever
+        // box takes the handle next.
+        void remove(uint32_t h)
+        {
+            alive[h] = 0;
+            retiredHandles.push_back(h);
+            ++pendingRemoves;
+        }
+
+        void step(std::vector<Pair>& added, std::vector<Pair>& removed, JobPool& pool = JobPool::global())
+        {
+            added.clear();
+            removed.clear();
+            if (pendingRemoves) compact();
+            if (autoAxis) chooseAxis();
+
+            // Past a few fresh boxes, full sorts and one sweep are cheaper
+            // than carrying each one across the arrays.
+            if (pendingAdds * 8 > size()) rebuild(added, removed, pool);
+            else
+            {
+                // One axis after another: a crossing is checked against the
+                // other axes' order at that moment, so the axes cannot sort
+                // concurrently.
+                crossed.clear();
+                swaps = insertionSort(0, crossed) + insertionSort(1, crossed) + insertionSort(2, crossed);
+                std::sort(crossed.begin(), crossed.end());
+                crossed.erase(std::unique(crossed.begin(), crossed.end()), crossed.end());
+                for (uint64_t key : crossed)
+                {
+                    Pair p((uint32_t)(key >> 32), (uint32_t)key);
+                    bool was = std::binary_search(current.begin(), current.end(), p);
+                    if (overlapping(p.first, p.second) != was) (was ? removed : added).push_back(p);
+                }
+            }
+            applyDeltas(added, removed);
+            pendingAdds = 0;
+            freeHandles.insert(freeHandles.end(), retiredHandles.begin(), retiredHandles.end());
+            retiredHandles.clear();
+        }
+
+    private:
+        // data = handle << 1 | isMax.
+        struct Endpoint
+        {
+            T        value;
+            uint32_t data;
+        };
+
+        bool                  autoAxis;
+        int                   sweepAxis;
+        std::vector<Endpoint> ends[3];
+        std::vector<uint32_t> minAt[3], maxAt[3]; // endpoint slots, by handle
+        std::vector<AABB<T>>  boxes;              // by handle
+        std::vector<uint8_t>  alive;              // by handle
+        std::vector<uint32_t> freeHandles;
+        std::vector<uint32_t> retiredHandles;     // removed since the last step()
+        std::vector<Pair>     current, scratch;
+        std::vector<uint64_t> crossed;            // candidate pairs, reused across steps
+        size_t                swaps = 0;
+        size_t                pendingAdds = 0, pendingRemoves = 0;
+
+        static T axisOf(const Vector3<T>& v, int a) { return a == 0 ? v.x : (a == 1 ? v.y : v.z); }
+
+        // Sort key: value, then min before max.
+        static bool before(const Endpoint& a, const Endpoint& b)
+        {
+            return a.value < b.value || (a.value == b.value && (a.data & 1) < (b.data & 1));
+        }
+
+        void place(int a, const Endpoint& e, uint32_t slot)
+        {
+            (e.data & 1 ? maxAt[a] : minAt[a])[e.data >> 1] = slot;
+        }
+
+        static uint64_t pairKey(uint32_t a, uint32_t b)
+        {
+            return a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a;
+        }
+
+        // Overlap on every axis, read off the endpoint order.
+        bool overlapping(uint32_t x, uint32_t y) const
+        {
+            for (int a = 0; a < 3; ++a)
+                if (minAt[a][x] > maxAt[a][y] || minAt[a][y] > maxAt[a][x]) return false;
+            return true;
+        }
+
+        // Overlap on the two axes other than `a`.
+        bool overlappingBesides(int a, uint32_t x, uint32_t y) const
+        {
+            for (int b = 0; b < 3; ++b)
+                if (b != a && (minAt[b][x] > maxAt[b][y] || minAt[b][y] > maxAt[b][x])) return false;
+            return true;
+        }
+
+        // A min crossing a max starts or ends the pair's overlap on this axis;
+        // that only changes the full overlap if the other axes overlap now.
+        // Such pairs go to `crossed`; whether they still overlap is decided
+        // after all three sorts, since a pair can cross back within a step.
+        size_t insertionSort(int a, std::vector<uint64_t>& crossed)
+        {
+            std::vector<Endpoint>& v = ends[a];
+            size_t moved = 0;
+            for (size_t i = 1; i < v.size(); ++i)
+            {
+                if (!before(v[i], v[i - 1])) continue;
+                Endpoint e = v[i];
+                size_t j = i;
+                for (; j > 0 && before(e, v[j - 1]); --j)
+                {
+                    const Endpoint& o = v[j - 1];
+                    if (((o.data ^ e.data) & 1) && overlappingBesides(a, o.data >> 1, e.data >> 1))
+                        crossed.push_back(pairKey(o.data >> 1, e.data >> 1));
+                    v[j] = o;
+                    place(a, o, (uint32_t)j);
+                }
+                v[j] = e;
+                place(a, e, (uint32_t)j);
+                moved += i - j;
+            }
+            return moved;
+        }
+
+        // Drops removed boxes' endpoints and reports their pairs as removed.
+        void compact()
+        {
+            for (int a = 0; a < 3; ++a)
+            {
+                std::vector<Endpoint>& v = ends[a];
+                v.erase(std::remove_if(v.begin(), v.end(), [&](const Endpoint& e) { return !alive[e.data >> 1]; }), v.end());
+                for (uint32_t i = 0; i < v.size(); ++i) place(a, v[i], i);
+            }
+            pendingRemoves = 0;
+        }
+
+        // Full sorts, then every overlap found by sweeping one axis: from
+        // each min up to its own max, the mins passed belong to boxes that
+        // overlap on that axis. Deltas come from diffing with the old list.
+        void rebuild(std::vector<Pair>& added, std::vector<Pair>& removed, JobPool& pool)
+        {
+            pool.parallelFor(3, 1, [&](size_t b, size_t e) {
+                for (size_t a = b; a < e; ++a)
+                {
+                    std::vector<Endpoint>& v = ends[a];
+                    std::sort(v.begin(), v.end(), before);
+                    for (uint32_t i = 0; i < v.size(); ++i) place((int)a, v[i], i);
+                }
+            });
+            swaps = ends[0].size();
+
+            const std::vector<Endpoint>& v = ends[sweepAxis];
+            const size_t grain = 4096;
+            std::vector<std::vector<Pair>> partial(JobPool::chunkCount(v.size(), grain));
+            pool.parallelChunks(v.size(), grain, [&](size_t c, size_t b, size_t e) {
+                std::vector<Pair>& local = partial[c];
+                for (size_t i = b; i < e; ++i)
+                {
+                    if (v[i].data & 1) continue;
+                    uint32_t x = v[i].data >> 1;
+                    for (size_t j = i + 1, end = maxAt[sweepAxis][x]; j < end; ++j)
+                    {
+                        if (v[j].data & 1) continue;
+                        uint32_t y = v[j].data >> 1;
+                        if (overlapping(x, y)) local.push_back(x < y ? Pair(x, y) : Pair(y, x));
+                    }
+                }
+            });
+            scratch.clear();
+            for (auto& p : partial) scratch.insert(scratch.end(), p.begin(), p.end());
+            std::sort(scratch.begin(), scratch.end());
+
+            std::set_difference(scratch.begin(), scratch.end(), current.begin(), current.end(), std::back_inserter(added));
+            std::set_difference(current.begin(), current.end(), scratch.begin(), scratch.end(), std::back_inserter(removed));
+        }
+
+        // Patches the sorted pair list; pairs of removed boxes are added to
+        // `removed` here, with one pass over the list in steps that removed.
+        void applyDeltas(std::vector<Pair>& added, std::vector<Pair>& removed)
+        {
+            if (!retiredHandles.empty())
+            {
+                // A rebuild already reported them; the sorted prefix says which.
+                const size_t reported = removed.size();
+                for (const Pair& p : current)
+                    if ((!alive[p.first] || !alive[p.second]) && !std::binary_search(removed.begin(), removed.begin() + reported, p))
+                        removed.push_back(p);
+            }
+            std::sort(added.begin(), added.end());
+            std::sort(removed.begin(), removed.end());
+            if (added.empty() && removed.empty()) return;
+
+            scratch.clear();
+            std::set_difference(current.begin(), current.end(), removed.begin(), removed.end(), std::back_inserter(scratch));
+            current.clear();
+            std::merge(scratch.begin(), scratch.end(), added.begin(), added.end(), std::back_inserter(current));
+        }
+
+        // Switch only when another axis spreads the centres 20% wider, so
+        // the choice does not flicker on a near-tie.
+        void chooseAxis()
+        {
+            const size_t n = size();
+            if (n == 0) return;
+            double sum[3] = {}, sumSq[3] = {};
+            for (const Endpoint& e : ends[0])
+            {
+                if (e.data & 1) continue;
+                Vector3<T> c = boxes[e.data >> 1].center();
+                for (int a = 0; a < 3; ++a)
+                {
+                    double v = (double)axisOf(c, a);
+                    sum[a] += v;
+                    sumSq[a] += v * v;
+                }
+            }
+            double var[3];
+            for (int a = 0; a < 3; ++a) var[a] = sumSq[a] / n - (sum[a] / n) * (sum[a] / n);
+            int best = (var[0] >= var[1] && var[0] >= var[2]) ? 0 : (var[1] >= var[2] ? 1 : 2);
+            if (best != sweepAxis && var[best] > 1.2 * var[sweepAxis]) sweepAxis = best;
+        }
+    };
+
+    using SweepAndPrunef = SweepAndPrune<float>;
+}
@@ -0,0 +1,10 @@
+#include <iostream>
+#include "tests.hpp"
+
+// Headless entry point: no window, no GL, just the math tests.
+int main()
+{
+    run_all_tests();
+    std::cout << "All tests passed\n";
+    return 0;
+}
@@ -0,0 +1,2714 @@
+#include <iostream>
+#include <cassert>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <array>
+#include <cstring>
+#include <algorithm>
+#include <random>
+#include <limits>
+#include "vector2.hpp"
+#include "Vector3.hpp"
+#include "matrix4.hpp"
+#include "profiler.hpp"
+#include "simd_dispatch.hpp"
+#include "job_pool.hpp"
+#include "spatial_hash.hpp"
+#include "kdtree.hpp"
+#include "aabb.hpp"
+#include "loose_octree.hpp"
+#include "sweep_prune.hpp"
+#include "ray.hpp"
+#include "ray_triangle.hpp"
+#include "gjk.hpp"
+#include "matrix3.hpp"
+#include "quaternion.hpp"
+#include "rigid_body.hpp"
+#include "particle_system.hpp"
+#include "skinning.hpp"
+#include "animation.hpp"
+#include "spline.hpp"
+#include "triangle_setup.hpp"
+#include "occlusion_culling.hpp"
+#include "lod_selection.hpp"
+#include "mesh_simplify.hpp"
+#include "vertex_cache.hpp"
+#include "mesh_normals.hpp"
+#include "half.hpp"
+#include "vertex_quantization.hpp"
+#include "fixed_point.hpp"
+#include "grid_coords.hpp"
+#include "tests.hpp"
+
+using namespace CPL;
+
+#pragma region Vector 2
+
+// ───────────────────────────────────────────
+
+void t_angle()
+{
+    Vector2f right(1, 0);
+    Vector2f up = Vector2f::up();
+
+    assert(std::abs(right.angle()) < 1e-6);
+
+    assert(std::abs(up.angle() - 1.570796f) < 1e-4);
+
+    assert(std::abs(right.angleBetween(up) - 1.570796f) < 1e-4);
+
+    std::cout << "[Vector2] Angle tests done\n";
+
+}
+
+void t_dot_and_cross()
+{
+    Vector2f a(3, 4);
+    Vector2f b(1, 0);
+
+    assert(a.dot(b) == 3);
+    assert(a.cross(b) == -4);
+    std::cout << "[Vector2] Dot and Cross tests done\n";
+
+}
+
+void t_length_and_normalize()
+{
+    Vector2f v(3, 4);
+    assert(v.length() == 5);
+    assert(v.lengthSquared() == 25);
+
+    Vector2f unit = v.normalized();
+    float len = unit.length();
+    assert(std::abs(len - 1.0f) < 1e-5);
+
+    v.normalize();
+    assert(std::abs(v.length() - 1.0f) < 1e-5);
+    std::cout << "[Vector2] Length and Normalize tests done\n";
+
+}
+
+void run_vector2_tests()
+{
+    Vector2f v1(10, 10);
+    Vector2f v2;
+    v2 = v1;
+    assert(v1 == v2);
+
+    Vector2f v3(v1);
+    assert(v3 == v1);
+
+    Vector2f v4 = v1 + Vector2f(5, 5);
+    assert(v4 == Vector2f(15, 15));
+
+    v4 += Vector2f(5, 5);
+    assert(v4 == Vector2f(20, 20));
+
+    Vector2f v5 = v4 * 0.5f;
+    assert(v5 == Vector2f(10, 10));
+
+    assert(Vector2f::ones() == Vector2f(1, 1));
+    assert(Vector2f::zeros() == Vector2f(0, 0));
+    assert(Vector2f::up() == Vector2f(0, 1));
+
+    std::cout << "[Vector2] Tests done\n";
+
+    t_angle();
+    t_dot_and_cross();
+    t_length_and_normalize();
+}
+
+#pragma endregion
+
+#pragma region Vecyot 3
+
+void run_vector3_tests()
+{
+    Vector3f a(1, 0, 0), b(0, 1, 0);
+
+    assert(a.cross(b) == Vector3f(0, 0, 1));
+    assert(a.dot(b) == 0);
+
+    Vector3f c(3, 4, 0);
+    assert(c.length() == 5);
+    assert(c.normalized().length() - 1.0f < 1e-5);
+
+    Vector3f d = Vector3f::up();
+    assert(d == Vector3f(0, 1, 0));
+
+    std::cout << "[Vector3] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Matrix4
+void run_matrix4_projection_tests()
+{
+    using namespace CPL;
+    Matrix4f proj = Matrix4f::perspective(3.14159f / 2, 16 / 9.f, 0.1f, 100.f);
+    Vector3f p(0, 0, -0.1f);
+    Vector3f clip = proj * p;
+    assert(std::abs(clip.z + 1) < 1e-3);
+
+    // The homogeneous transform keeps w (= -z for this projection) and agrees after the divide.
+    Vector3f q(1, 2, -5);
+    Vector4f h = proj.transformHomogeneous(q);
+    assert(std::abs(h.w - 5) < 1e-6f);
+    Vector3f divided = h.perspectiveDivide(), direct = proj * q;
+    assert(std::abs(divided.x - direct.x) < 1e-6f && std::abs(divided.y - direct.y) < 1e-6f && std::abs(divided.z - direct.z) < 1e-6f);
+    assert(proj * Vector4f(q, 1) == h);
+    assert(Matrix4f::translate(1, 2, 3) * Vector4f(1, 1, 1, 0) == Vector4f(1, 1, 1, 0)); // directions ignore translation
+    std::cout << "[Matrix4] projection test passed\n";
+}
+
+void run_matrix4_tests()
+{
+    using namespace CPL;
+    Matrix4f mTranslate = Matrix4f::translate(5, 0, 0);
+    Vector3f p(1, 0, 0);
+    Vector3f moved = mTranslate * p;
+    assert(moved == Vector3f(6, 0, 0));
+
+    Matrix4f mScale = Matrix4f::scale(2, 2, 2);
+    assert((mScale * p) == Vector3f(2, 0, 0));
+
+    Matrix4f mRot = Matrix4f::rotateZ(3.14159265f / 2);
+    Vector3f up = mRot * Vector3f(1, 0, 0);
+    assert(std::abs(up.x) < 1e-4 && std::abs(up.y - 1) < 1e-4);
+
+    Matrix4f trs = Matrix4f::translate(3, -2, 7) * Matrix4f::rotateY(0.7f) * Matrix4f::rotateX(-0.4f) * Matrix4f::scale(2, 0.5f, 3);
+    Matrix4f roundTrip = trs.inverseTRS() * trs;
+    for (int r = 0; r < 4; ++r)
+        for (int c = 0; c < 4; ++c) assert(std::abs(roundTrip(r, c) - (r == c ? 1.0f : 0.0f)) < 1e-5f);
+
+    std::cout << "[Matrix4] basic tests passed\n";
+
+    run_matrix4_projection_tests();
+}
+
+#pragma endregion
+
+#pragma region Profiler
+
+void run_profiler_tests()
+{
+    Profiler::clear();
+    {
+        CPL_PROFILE_SCOPE("test.scope");
+        Matrix4f m = Matrix4f::rotateZ(0.5f) * Matrix4f::translate(1, 2, 3);
+        (void)m;
+    }
+    assert(Profiler::eventCount() == 1);
+
+    std::ostringstream json;
+    Profiler::writeChromeTrace(json);
+    assert(json.str().find("\"name\":\"test.scope\"") != std::string::npos);
+    assert(json.str().find("\"ph\":\"X\"") != std::string::npos);
+
+    Profiler::setEnabled(false);
+    {
+        CPL_PROFILE_SCOPE("test.disabled");
+    }
+    Profiler::setEnabled(true);
+    assert(Profiler::eventCount() == 1);
+
+    // Events long after the epoch keep sub-microsecond resolution: two
+    // events a few hundred ticks apart, ~2^40 ticks in, still parse apart.
+    Profiler::clear();
+    uint64_t late = Profiler::now() + (uint64_t(1) << 40);
+    Profiler::record("late.a", late, late + 100);
+    Profiler::record("late.b", late + 600, late + 700);
+    std::ostringstream trace;
+    trace << std::setprecision(2);
+    Profiler::writeChromeTrace(trace);
+    assert(trace.precision() == 2 && !(trace.flags() & std::ios_base::fixed));
+    auto tsOf = [&](const char* name) {
+        size_t at = trace.str().find(name);
+        assert(at != std::string::npos);
+        size_t ts = trace.str().find("\"ts\":", at) + 5;
+        size_t end = trace.str().find(',', ts);
+        std::string text = trace.str().substr(ts, end - ts);
+        assert(text.find('e') == std::string::npos && text.find('.') != std::string::npos);
+        return std::stod(text);
+    };
+    double a = tsOf("late.a"), b = tsOf("late.b");
+    assert(a > 1e5 && b > a);
+
+    Profiler::clear();
+    std::cout << "[Profiler] Tests done\n";
+}
+
+#pragma endregion
+
+
+#pragma region SIMD dispatch
+
+void run_simd_dispatch_tests()
+{
+    const size_t n = 67; // not a multiple of any block width, so tails run too
+    std::vector<Vector3f> a(n), b(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        a[i] = Vector3f(float(i) - 30.0f, 0.5f * float(i), 3.0f - 0.25f * float(i));
+        b[i] = Vector3f(1.0f, -2.0f, float(i % 7));
+    }
+    a[5] = Vector3f(0, 0, 0);
+
+    Matrix4f affine = Matrix4f::translate(1, 2, 3) * Matrix4f::rotateY(0.4f);
+    Matrix4f proj = Matrix4f::perspective(1.2f, 4 / 3.f, 0.1f, 50.f);
+
+    auto close = [](const Vector3f& u, const Vector3f& v) {
+        float tol = 1e-4f * (1.0f + std::abs(u.x) + std::abs(u.y) + std::abs(u.z));
+        return std::abs(u.x - v.x) < tol && std::abs(u.y - v.y) < tol && std::abs(u.z - v.z) < tol;
+    };
+
+    const SimdTier best = cpuFeatures().bestTier();
+    for (int t = 0; t <= (int)best; ++t)
+    {
+        assert(SimdDispatch::forceTier((SimdTier)t) == (SimdTier)t);
+
+        std::vector<Vector3f> out(n);
+        std::vector<float> dots(n);
+        for (const Matrix4f* m : { &affine, &proj })
+        {
+            transformPoints(*m, a.data(), out.data(), n);
+            for (size_t i = 0; i < n; ++i) assert(close(out[i], *m * a[i]));
+        }
+
+        normalizeVectors(a.data(), out.data(), n);
+        for (size_t i = 0; i < n; ++i) assert(close(out[i], a[i].normalized()));
+        assert(out[5] == Vector3f(0, 0, 0));
+
+        dotProducts(a.data(), b.data(), dots.data(), n);
+        for (size_t i = 0; i < n; ++i) assert(std::abs(dots[i] - a[i].dot(b[i])) < 1e-3f);
+
+        std::vector<Vector3f> inPlace = a;
+        normalizeVectors(inPlace.data(), inPlace.data(), n);
+        for (size_t i = 0; i < n; ++i) assert(close(inPlace[i], a[i].normalized()));
+
+        // Clip transform keeps w; the viewport stage matches a divide (in place).
+        std::vector<Vector4f> clip(n);
+        transformToClip(proj, a.data(), clip.data(), n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            Vector4f e = proj.transformHomogeneous(a[i]);
+            assert(close(clip[i].xyz(), e.xyz()) && std::abs(clip[i].w - e.w) < 1e-4f);
+        }
+        for (size_t i = 0; i < n; ++i) if (clip[i].w == 0) clip[i].w = 1;
+        const Viewport vp{ 10, 20, 640, 480, 0.25f, 0.75f };
+        std::vector<Vector4f> window = clip;
+        projectToViewport(vp, window.data(), window.data(), n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            Vector3f ndc = clip[i].perspectiveDivide();
+            Vector3f e(10 + (ndc.x + 1) * 320, 20 + (1 - ndc.y) * 240, 0.25f + (ndc.z + 1) * 0.25f);
+            assert(close(window[i].xyz(), e) && std::abs(window[i].w * clip[i].w - 1) < 1e-5f);
+        }
+    }
+
+    assert(SimdDispatch::forceTier(SimdTier::AVX512) == best);
+    SimdTier parsed;
+    assert(SimdDispatch::parseTier("avx2", parsed) && parsed == SimdTier::AVX2);
+    assert(!SimdDispatch::parseTier("neon", parsed));
+    SimdDispatch::resetTier();
+
+    std::cout << "[SIMD] Dispatch tests done (best tier: " << tierName(best) << ")\n";
+}
+
+#pragma endregion
+#pragma region Job pool
+
+void run_job_pool_tests()
+{
+    JobPool pool(4);
+    assert(pool.threadCount() == 4);
+
+    const size_t n = 100000;
+    std::vector<int> hits(n, 0);
+    pool.parallelFor(n, 1000, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) hits[i]++;
+    });
+    assert(std::count(hits.begin(), hits.end(), 1) == (long)n);
+
+    // Per-chunk partials are deterministic whatever the thread count.
+    std::vector<double> partial(JobPool::chunkCount(n, 777));
+    pool.parallelChunks(n, 777, [&](size_t c, size_t b, size_t e) {
+        double s = 0;
+        for (size_t i = b; i < e; ++i) s += 1.0 / double(i + 1);
+        partial[c] = s;
+    });
+    std::vector<double> serial(partial.size());
+    JobPool(1).parallelChunks(n, 777, [&](size_t c, size_t b, size_t e) {
+        double s = 0;
+        for (size_t i = b; i < e; ++i) s += 1.0 / double(i + 1);
+        serial[c] = s;
+    });
+    assert(partial == serial);
+
+    // Nested loops run inline instead of deadlocking.
+    std::atomic<int> inner{ 0 };
+    pool.parallelFor(8, 1, [&](size_t, size_t) {
+        pool.parallelFor(10, 1, [&](size_t b, size_t e) { inner += int(e - b); });
+    });
+    assert(inner == 80);
+
+    std::cout << "[JobPool] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Spatial hash
+
+void run_spatial_hash_tests()
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> d(-10.0f, 10.0f);
+    std::vector<Vector3f> pts(5000);
+    for (auto& p : pts) p = Vector3f(d(rng), d(rng), d(rng));
+
+    JobPool pool(3);
+    SpatialHashGridf grid(1.5f);
+    grid.build(pts.data(), pts.size(), pool);
+    assert(grid.size() == pts.size());
+
+    auto dist2 = [&](const Vector3f& a, const Vector3f& b) {
+        Vector3f v(a.x - b.x, a.y - b.y, a.z - b.z);
+        return v.lengthSquared();
+    };
+
+    for (int q = 0; q < 50; ++q)
+    {
+        Vector3f c(d(rng), d(rng), d(rng));
+        float r = 0.5f + 0.1f * float(q);
+
+        std::vector<uint32_t> got;
+        grid.queryRadius(c, r, got);
+        std::sort(got.begin(), got.end());
+
+        std::vector<uint32_t> want;
+        for (uint32_t i = 0; i < pts.size(); ++i)
+            if (dist2(pts[i], c) <= r * r) want.push_back(i);
+        assert(got == want);
+
+        std::vector<uint32_t> knn;
+        size_t k = 1 + q % 12;
+        assert(grid.kNearest(c, k, knn) == k);
+        std::vector<uint32_t> order(pts.size());
+        for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::partial_sort(order.begin(), order.begin() + k, order.end(), [&](uint32_t a, uint32_t b) {
+            float da = dist2(pts[a], c), db = dist2(pts[b], c);
+            return da < db || (da == db && a < b);
+        });
+        for (size_t i = 0; i < k; ++i) assert(knn[i] == order[i]);
+    }
+
+    // Asking for more neighbours than points returns them all.
+    SpatialHashGridf small(1.0f);
+    small.build(pts.data(), 10, pool);
+    std::vector<uint32_t> all;
+    assert(small.kNearest(Vector3f(100, 100, 100), 50, all) == 10);
+
+    // Points beyond the int32 cell range clamp to the outermost cells and
+    // are still found by exact distance.
+    std::vector<Vector3f> far(pts.begin(), pts.begin() + 100);
+    far.push_back(Vector3f(1e20f, 0, 0));
+    far.push_back(Vector3f(1e20f, 1e20f, -1e20f));
+    far.push_back(Vector3f(-3e38f, 5, 5));
+    SpatialHashGridf wide(1.0f);
+    wide.build(far.data(), far.size(), pool);
+    std::vector<uint32_t> hit;
+    assert(wide.queryRadius(Vector3f(1e20f, 0, 0), 1.0f, hit) == 1 && hit[0] == 100);
+    hit.clear();
+    assert(wide.queryRadius(Vector3f(-3e38f, 5, 5), 1.0f, hit) == 1 && hit[0] == 102);
+    hit.clear();
+    wide.queryRadius(Vector3f(0, 0, 0), 4.0f, hit);
+    std::sort(hit.begin(), hit.end());
+    std::vector<uint32_t> want;
+    for (uint32_t i = 0; i < far.size(); ++i)
+        if (dist2(far[i], Vector3f(0, 0, 0)) <= 16.0f) want.push_back(i);
+    assert(!want.empty() && hit == want);
+
+    // Query boxes wholly outside the bounds find nothing; a row of cells
+    // longer than the bucket table is scanned once, not split.
+    std::vector<Vector3f> cube;
+    for (int i = 0; i < 1000; ++i) cube.push_back(Vector3f(float(i % 10), float(i / 10 % 10), float(i / 100)));
+    SpatialHashGridf unit(1.0f);
+    unit.build(cube.data(), cube.size(), pool);
+    hit.clear();
+    assert(unit.queryRadius(Vector3f(-2000, 5, 5), 1.0f, hit) == 0);
+    assert(unit.queryRadius(Vector3f(5, 5, 2000), 1.0f, hit) == 0);
+    std::vector<Vector3f> row;
+    for (int i = 0; i < 1000; ++i) row.push_back(Vector3f(float(i) * 10, 0, 0));
+    unit.build(row.data(), row.size(), pool);
+    assert(unit.bucketCount() < 10000);
+    assert(unit.queryRadius(Vector3f(5000, 0, 0), 6000.0f, hit) == 1000);
+
+    std::cout << "[SpatialHash] Tests done\n";
+}
+
+#pragma endregion
+#pragma region KdTree
+
+template<typename T>
+void t_kdtree_against_brute_force()
+{
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<T> d(-50, 50);
+    std::vector<Vector3<T>> pts(3000);
+    for (auto& p : pts) p = Vector3<T>(d(rng), d(rng), d(rng));
+    for (int i = 0; i < 20; ++i) pts[100 + i] = pts[7]; // duplicates
+
+    JobPool pool(4);
+    KdTree<T> tree(pts.data(), pts.size(), pool);
+    assert(tree.size() == pts.size());
+
+    auto dist2 = [](const Vector3<T>& a, const Vector3<T>& b) {
+        T dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+        return dx * dx + dy * dy + dz * dz;
+    };
+
+    std::vector<Vector3<T>> queries(200);
+    for (auto& q : queries) q = Vector3<T>(d(rng), d(rng), d(rng));
+    queries[0] = pts[7];
+
+    const size_t k = 6;
+    std::vector<uint32_t> nn(queries.size()), knn(queries.size() * k);
+    tree.nearestBatch(queries.data(), queries.size(), nn.data(), nullptr, pool);
+    tree.kNearestBatch(queries.data(), queries.size(), k, knn.data(), pool);
+
+    for (size_t qi = 0; qi < queries.size(); ++qi)
+    {
+        std::vector<uint32_t> order(pts.size());
+        for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            T da = dist2(pts[a], queries[qi]), db = dist2(pts[b], queries[qi]);
+            return da < db || (da == db && a < b);
+        });
+        assert(nn[qi] == order[0]);
+        for (size_t j = 0; j < k; ++j) assert(knn[qi * k + j] == order[j]);
+    }
+
+    KdTree<T> empty(pts.data(), 0, pool);
+    assert(empty.nearest(queries[0]) == KdTree<T>::None);
+
+    KdTree<T> tiny(pts.data(), 3, pool);
+    std::vector<uint32_t> few(5);
+    tiny.kNearestBatch(queries.data(), 1, 5, few.data(), pool);
+    assert(few[3] == KdTree<T>::None && few[4] == KdTree<T>::None);
+}
+
+void run_kdtree_tests()
+{
+    t_kdtree_against_brute_force<float>();
+    t_kdtree_against_brute_force<double>();
+    std::cout << "[KdTree] Tests done\n";
+}
+
+#pragma endregion
+#pragma region AABB
+
+void run_aabb_tests()
+{
+    AABBf box(Vector3f(-1, -1, -1), Vector3f(1, 1, 1));
+    assert(box.center() == Vector3f(0, 0, 0));
+    assert(box.extents() == Vector3f(1, 1, 1));
+    assert(box.overlaps(AABBf(Vector3f(1, 1, 1), Vector3f(2, 2, 2))));
+    assert(!box.overlaps(AABBf(Vector3f(1.5f, 0, 0), Vector3f(2, 1, 1))));
+    assert(box.contains(Vector3f(0.5f, -0.5f, 0)));
+    assert(AABBf().empty());
+
+    AABBf moved = box.transformed(Matrix4f::translate(5, 0, 0) * Matrix4f::scale(2, 1, 1));
+    assert(moved.min == Vector3f(3, -1, -1) && moved.max == Vector3f(7, 1, 1));
+
+    AABBf rotated = box.transformed(Matrix4f::rotateZ(3.14159265f / 4));
+    assert(std::abs(rotated.max.x - std::sqrt(2.0f)) < 1e-5f);
+
+    std::cout << "[AABB] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Loose octree
+
+using PairList = std::vector<std::pair<uint32_t, uint32_t>>;
+
+PairList brute_force_pairs(const std::vector<AABBf>& boxes, const std::vector<bool>& alive)
+{
+    PairList pairs;
+    for (uint32_t a = 0; a < boxes.size(); ++a)
+        for (uint32_t b = a + 1; b < boxes.size(); ++b)
+            if (alive[a] && alive[b] && boxes[a].overlaps(boxes[b])) pairs.emplace_back(a, b);
+    return pairs;
+}
+
+void run_loose_octree_tests()
+{
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> pos(-60.0f, 60.0f), size(0.2f, 4.0f), step(-3.0f, 3.0f);
+    auto randomBox = [&](const Vector3f& c) {
+        float s = size(rng);
+        return AABBf::fromCenterExtents(c, Vector3f(s, s * 0.5f, s));
+    };
+
+    JobPool pool(3);
+    LooseOctreef tree(Vector3f(0, 0, 0), 50.0f, 6);
+    std::vector<AABBf> boxes;
+    std::vector<bool> alive;
+    for (int i = 0; i < 800; ++i)
+    {
+        boxes.push_back(randomBox(Vector3f(pos(rng), pos(rng), pos(rng)))); // some land outside the world
+        alive.push_back(true);
+        assert(tree.insert(boxes.back(), i) == (uint32_t)i);
+    }
+    assert(tree.objectCount() == 800);
+
+    PairList pairs;
+    tree.findPairs(pairs, pool);
+    assert(pairs == brute_force_pairs(boxes, alive));
+
+    for (int frame = 0; frame < 5; ++frame)
+    {
+        for (uint32_t i = 0; i < boxes.size(); i += 3)
+        {
+            Vector3f c = boxes[i].center() + Vector3f(step(rng), step(rng), step(rng));
+            boxes[i] = AABBf::fromCenterExtents(c, boxes[i].extents());
+            tree.move(i, boxes[i]);
+        }
+        tree.findPairs(pairs, pool);
+        assert(pairs == brute_force_pairs(boxes, alive));
+    }
+
+    for (uint32_t i = 0; i < boxes.size(); i += 2) { tree.remove(i); alive[i] = false; }
+    tree.findPairs(pairs, pool);
+    assert(pairs == brute_force_pairs(boxes, alive));
+
+    // Freed handles are reused.
+    uint32_t reused = tree.insert(randomBox(Vector3f(0, 0, 0)), 42);
+    assert(!alive[reused] && tree.userData(reused) == 42);
+    tree.remove(reused);
+
+    for (uint32_t i = 1; i < boxes.size(); i += 2) tree.remove(i);
+    assert(tree.objectCount() == 0 && tree.nodeCount() == 1);
+
+    std::cout << "[LooseOctree] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Sweep and prune
+
+void run_sweep_prune_tests()
+{
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<float> pos(-40.0f, 40.0f), size(0.2f, 3.0f), step(-1.5f, 1.5f);
+    auto randomBox = [&](const Vector3f& c) {
+        float s = size(rng);
+        return AABBf::fromCenterExtents(c, Vector3f(s, s, s * 0.5f));
+    };
+
+    JobPool pool(3);
+    SweepAndPrunef sap;
+    std::vector<AABBf> boxes;
+    std::vector<bool> alive;
+    for (int i = 0; i < 600; ++i)
+    {
+        // Spread mostly along z so the automatic axis has a clear winner.
+        boxes.push_back(randomBox(Vector3f(pos(rng) * 0.2f, pos(rng) * 0.2f, pos(rng) * 4.0f)));
+        alive.push_back(true);
+        assert(sap.add(boxes.back()) == (uint32_t)i);
+    }
+
+    PairList added, removed, prev;
+    sap.step(added, removed, pool);
+    assert(sap.axis() == 2);
+    assert(sap.pairs() == brute_force_pairs(boxes, alive));
+    assert(added == sap.pairs() && removed.empty());
+
+    // Deltas applied to the previous set must reproduce the current one.
+    auto checkDeltas = [&] {
+        PairList rebuilt;
+        std::set_difference(prev.begin(), prev.end(), removed.begin(), removed.end(), std::back_inserter(rebuilt));
+        rebuilt.insert(rebuilt.end(), added.begin(), added.end());
+        std::sort(rebuilt.begin(), rebuilt.end());
+        assert(rebuilt == sap.pairs());
+        assert(sap.pairs() == brute_force_pairs(boxes, alive));
+    };
+
+    for (int frame = 0; frame < 6; ++frame)
+    {
+        prev = sap.pairs();
+        for (uint32_t i = frame % 2; i < boxes.size(); i += 2)
+        {
+            Vector3f c = boxes[i].center() + Vector3f(step(rng), step(rng), step(rng));
+            boxes[i] = AABBf::fromCenterExtents(c, boxes[i].extents());
+            sap.update(i, boxes[i]);
+        }
+        sap.step(added, removed, pool);
+        checkDeltas();
+    }
+
+    // Nothing moved: no swaps, no deltas.
+    prev = sap.pairs();
+    sap.step(added, removed, pool);
+    assert(sap.lastSwapCount() == 0 && added.empty() && removed.empty());
+    assert(sap.pairs() == prev);
+
+    // Removing boxes reports their pairs as removed; freed handles are reused.
+    prev = sap.pairs();
+    for (uint32_t i = 0; i < boxes.size(); i += 3) { sap.remove(i); alive[i] = false; }
+    sap.step(added, removed, pool);
+    assert(added.empty());
+    checkDeltas();
+    uint32_t reused = sap.add(boxes[1]);
+    assert(!alive[reused]);
+    boxes[reused] = boxes[1];
+    alive[reused] = true;
+    prev = sap.pairs();
+    sap.step(added, removed, pool);
+    assert(std::find(added.begin(), added.end(), std::make_pair(std::min(reused, 1u), std::max(reused, 1u))) != added.end());
+    checkDeltas();
+
+    // Removing and adding in the same frame must not recycle the handle, or
+    // the old box's pairs would silently pass to the new one.
+    uint32_t gone = 1;
+    PairList goneWas;
+    for (const auto& p : sap.pairs())
+        if (p.first == gone || p.second == gone) goneWas.push_back(p);
+    assert(!goneWas.empty());
+    sap.remove(gone);
+    alive[gone] = false;
+    uint32_t fresh = sap.add(boxes[gone]);
+    assert(fresh != gone);
+    if (fresh == boxes.size()) { boxes.push_back(boxes[gone]); alive.push_back(true); }
+    else { boxes[fresh] = boxes[gone]; alive[fresh] = true; }
+    prev = sap.pairs();
+    sap.step(added, removed, pool);
+    for (const auto& p : goneWas) assert(std::find(removed.begin(), removed.end(), p) != removed.end());
+    assert(!added.empty());
+    checkDeltas();
+
+    // Stretch the scene along x: the sweep axis follows, results stay exact.
+    for (uint32_t i = 0; i < boxes.size(); ++i)
+    {
+        if (!alive[i]) continue;
+        Vector3f c = boxes[i].center();
+        boxes[i] = AABBf::fromCenterExtents(Vector3f(c.z * 3.0f, c.y, c.x), boxes[i].extents());
+        sap.update(i, boxes[i]);
+    }
+    prev = sap.pairs();
+    sap.step(added, removed, pool);
+    assert(sap.axis() == 0);
+    checkDeltas();
+
+    // Adds, removes and moves mixed in the same frames.
+    std::uniform_int_distribution<int> op(0, 9);
+    for (int frame = 0; frame < 8; ++frame)
+    {
+        prev = sap.pairs();
+        for (uint32_t i = 0; i < boxes.size(); ++i)
+        {
+            if (!alive[i]) continue;
+            int o = op(rng);
+            if (o == 0) { sap.remove(i); alive[i] = false; }
+            else if (o < 6)
+            {
+                Vector3f c = boxes[i].center() + Vector3f(step(rng), step(rng), step(rng));
+                boxes[i] = AABBf::fromCenterExtents(c, boxes[i].extents());
+                sap.update(i, boxes[i]);
+            }
+        }
+        for (int k = 0; k < 20; ++k)
+        {
+            AABBf box = randomBox(Vector3f(pos(rng) * 3.0f, pos(rng) * 0.2f, pos(rng) * 0.2f));
+            uint32_t h = sap.add(box);
+            if (h == boxes.size()) { boxes.push_back(box); alive.push_back(true); }
+            else { assert(!alive[h]); boxes[h] = box; alive[h] = true; }
+        }
+        sap.step(added, removed, pool);
+        checkDeltas();
+    }
+
+    std::cout << "[SweepAndPrune] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Ray triangle
+
+void run_ray_triangle_tests()
+{
+    // Ray basics.
+    Rayf ray(Vector3f(0.25f, 0.25f, 1), Vector3f(0, 0, -1));
+    assert(ray.at(2) == Vector3f(0.25f, 0.25f, -1));
+    Rayf moved = ray.transformed(Matrix4f::translate(1, 2, 3));
+    assert(moved.origin == Vector3f(1.25f, 2.25f, 4) && moved.direction == ray.direction);
+
+    Vector3f a(0, 0, 0), b(1, 0, 0), c(0, 1, 0);
+    float t, u, v;
+    assert(intersectTriangle(ray, a, b, c, t, u, v));
+    assert(std::abs(t - 1) < 1e-6f && std::abs(u - 0.25f) < 1e-6f && std::abs(v - 0.25f) < 1e-6f);
+    assert(intersectTriangle(Rayf(ray.origin, Vector3f(0, 0, -1)), a, c, b, t, u, v)); // two-sided
+    assert(!intersectTriangle(Rayf(Vector3f(0.8f, 0.8f, 1), Vector3f(0, 0, -1)), a, b, c, t, u, v));
+    assert(!intersectTriangle(Rayf(ray.origin, ray.direction, 0, 0.5f), a, b, c, t, u, v));
+
+    // Random soup, 13 triangles short of a full packet at the end.
+    std::mt19937 rng(8);
+    std::uniform_real_distribution<float> d(-10.0f, 10.0f), small(-1.5f, 1.5f);
+    const size_t triCount = 8 * 40 + 3;
+    std::vector<Vector3f> soup;
+    for (size_t i = 0; i < triCount; ++i)
+    {
+        Vector3f base(d(rng), d(rng), d(rng));
+        for (int k = 0; k < 3; ++k) soup.push_back(base + Vector3f(small(rng), small(rng), small(rng)));
+    }
+    TriangleBatch batch(soup.data(), nullptr, triCount);
+    assert(batch.size() == triCount);
+
+    std::vector<Rayf> rays;
+    for (int i = 0; i < 2000; ++i)
+    {
+        Vector3f o(d(rng), d(rng), d(rng));
+        Vector3f target = soup[(size_t)(rng() % soup.size())];
+        rays.emplace_back(o, Vector3f(target.x - o.x, target.y - o.y, target.z - o.z) + Vector3f(small(rng), small(rng), small(rng)) * 0.2f);
+    }
+
+    JobPool pool(3);
+    const SimdTier tiers[] = { SimdTier::Scalar, SimdTier::AVX2 };
+    std::vector<RayHit> hits[2][2];
+    for (int ti = 0; ti < 2; ++ti)
+    {
+        SimdDispatch::forceTier(tiers[ti]);
+        for (int mode = 0; mode < 2; ++mode)
+        {
+            TriangleTest test = mode ? TriangleTest::Watertight : TriangleTest::Fast;
+            hits[ti][mode].resize(rays.size());
+            batch.intersect(rays.data(), rays.size(), hits[ti][mode].data(), test, pool);
+            for (size_t r = 0; r < rays.size(); r += 7)
+                assert(batch.occluded(rays[r], test) == hits[ti][mode][r].hit());
+        }
+    }
+    SimdDispatch::resetTier();
+
+    // Every path agrees with the brute-force Vector3 loop, up to rays that
+    // graze an edge and round the other way.
+    size_t hitCount = 0, disagree = 0;
+    for (size_t r = 0; r < rays.size(); ++r)
+    {
+        float bestT = std::numeric_limits<float>::max();
+        uint32_t best = RayHit::None;
+        for (uint32_t i = 0; i < triCount; ++i)
+            if (intersectTriangle(rays[r], soup[3 * i], soup[3 * i + 1], soup[3 * i + 2], t, u, v) && t < bestT) { bestT = t; best = i; }
+        hitCount += best != RayHit::None;
+        for (auto& perTier : hits)
+            for (auto& h : perTier)
+            {
+                if (h[r].hit() != (best != RayHit::None)) ++disagree;
+                else if (h[r].hit()) assert(std::abs(h[r].t - bestT) <= 1e-4f * std::max(1.0f, bestT));
+            }
+        if (hits[1][0][r].hit())
+        {
+            const RayHit& h = hits[1][0][r];
+            const Vector3f* tri = &soup[3 * h.triangle];
+            Vector3f p = tri[0] * (1 - h.u - h.v) + tri[1] * h.u + tri[2] * h.v;
+            Vector3f q = rays[r].at(h.t);
+            assert(std::abs(p.x - q.x) + std::abs(p.y - q.y) + std::abs(p.z - q.z) < 1e-3f);
+        }
+    }
+    assert(hitCount > rays.size() / 4 && disagree <= 4);
+
+    // Watertight: rays aimed exactly at the shared vertices and edge midpoints
+    // of a 16x16 grid must always hit it.
+    const int G = 16;
+    std::vector<Vector3f> gridVerts;
+    std::vector<uint32_t> gridIdx;
+    for (int y = 0; y <= G; ++y)
+        for (int x = 0; x <= G; ++x) gridVerts.emplace_back((float)x, (float)y, 0.0f);
+    for (int y = 0; y < G; ++y)
+        for (int x = 0; x < G; ++x)
+        {
+            uint32_t i0 = y * (G + 1) + x, i1 = i0 + 1, i2 = i0 + G + 1, i3 = i2 + 1;
+            gridIdx.insert(gridIdx.end(), { i0, i1, i3, i0, i3, i2 });
+        }
+    TriangleBatch grid(gridVerts.data(), gridIdx.data(), gridIdx.size() / 3);
+    std::uniform_real_distribution<float> above(-20.0f, 36.0f);
+    for (int ti = 0; ti < 2; ++ti)
+    {
+        SimdDispatch::forceTier(tiers[ti]);
+        for (int i = 0; i < 3000; ++i)
+        {
+            Vector3f target((float)(1 + rng() % (G - 1)), (float)(1 + rng() % (G - 1)), 0.0f);
+            if (i % 2) target.x += 0.5f; // horizontal edge midpoints
+            Vector3f o(above(rng), above(rng), 5.0f + small(rng) * 3.0f);
+            Rayf r(o, Vector3f(target.x - o.x, target.y - o.y, target.z - o.z));
+            RayHit h = grid.intersect(r, TriangleTest::Watertight);
+            assert(h.hit() && std::abs(h.t - 1.0f) < 1e-4f);
+        }
+    }
+    SimdDispatch::resetTier();
+
+    std::cout << "[RayTriangle] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region GJK
+
+// Separating-axis reference for two oriented boxes.
+bool sat_boxes_overlap(const Vector3f& ha, const Matrix4f& ma, const Vector3f& hb, const Matrix4f& mb)
+{
+    auto column = [](const Matrix4f& m, int c) { return Vector3f(m(0, c), m(1, c), m(2, c)); };
+    Vector3f ea[3] = { column(ma, 0), column(ma, 1), column(ma, 2) }, eb[3] = { column(mb, 0), column(mb, 1), column(mb, 2) };
+    Vector3f d(mb(0, 3) - ma(0, 3), mb(1, 3) - ma(1, 3), mb(2, 3) - ma(2, 3));
+    const float hA[3] = { ha.x, ha.y, ha.z }, hB[3] = { hb.x, hb.y, hb.z };
+    std::vector<Vector3f> axes(ea, ea + 3);
+    axes.insert(axes.end(), eb, eb + 3);
+    for (auto& a : ea)
+        for (auto& b : eb) axes.push_back(a.cross(b));
+    for (const Vector3f& axis : axes)
+    {
+        if (axis.lengthSquared() < 1e-8f) continue;
+        float ra = 0, rb = 0;
+        for (int i = 0; i < 3; ++i) { ra += hA[i] * std::abs(ea[i].dot(axis)); rb += hB[i] * std::abs(eb[i].dot(axis)); }
+        if (std::abs(d.dot(axis)) > ra + rb) return false;
+    }
+    return true;
+}
+
+void run_gjk_tests()
+{
+    const Vector3f ones(1, 1, 1);
+    BoxShapef box(ones);
+    Matrix4f I = Matrix4f::identity();
+
+    // Axis-aligned boxes 3 apart: gap of 1, witnesses on the facing faces.
+    GjkResult<float> r = gjkDistance(box, I, box, Matrix4f::translate(3, 0.5f, 0));
+    assert(!r.overlap && std::abs(r.distance - 1) < 1e-5f);
+    assert(std::abs(r.pointA.x - 1) < 1e-5f && std::abs(r.pointB.x - 2) < 1e-5f);
+
+    // 0.5 deep along +x.
+    Contact<float> c;
+    assert(collide(box, I, box, Matrix4f::translate(1.5f, 0.2f, 0.1f), c));
+    assert(std::abs(c.depth - 0.5f) < 1e-4f && std::abs(c.normal.x - 1) < 1e-4f);
+    assert(!collide(box, I, box, Matrix4f::translate(2.1f, 0, 0), c));
+
+    // Capsules: parallel, 3 apart, radius 0.5 each.
+    CapsuleShapef cap(1.0f, 0.5f);
+    r = gjkDistance(cap, I, cap, Matrix4f::translate(3, 0.5f, 0));
+    assert(std::abs(r.distance - 2) < 1e-5f && std::abs(r.pointA.x - 0.5f) < 1e-5f && std::abs(r.pointB.x - 2.5f) < 1e-5f);
+    assert(collide(cap, I, cap, Matrix4f::translate(0.8f, 0, 0), c));
+    assert(std::abs(c.depth - 0.2f) < 1e-5f && std::abs(c.normal.x - 1) < 1e-5f);
+    // Crossed capsules with overlapping cores go through EPA.
+    assert(collide(cap, I, cap, Matrix4f::rotateZ(1.5707963f), c));
+    assert(std::abs(c.depth - 1.0f) < 1e-3f && std::abs(c.normal.z) > 0.999f);
+    // Their contact points sit on the crossing, offset by each radius.
+    CapsuleShapef thin(1.0f, 0.1f);
+    for (float dx : { 1.0f, 0.5f, 0.0f, -0.7f })
+    {
+        assert(collide(thin, I, thin, Matrix4f::translate(dx, 0.5f, 0) * Matrix4f::rotateZ(1.5707963f), c));
+        Vector3f crossing(0, 0.5f, 0);
+        assert(std::abs(c.depth - 0.2f) < 1e-3f && std::abs(c.normal.z) > 0.999f);
+        Vector3f ea = c.pointA + (crossing + c.normal * 0.1f) * -1.0f, eb = c.pointB + (crossing + c.normal * -0.1f) * -1.0f;
+        assert(ea.length() < 1e-4f && eb.length() < 1e-4f);
+    }
+
+    // Capsule resting on a box, rotated box, through Matrix4 placement.
+    assert(collide(box, Matrix4f::rotateY(0.7f), cap, Matrix4f::translate(0, 2.3f, 0), c));
+    assert(std::abs(c.depth - 0.2f) < 1e-4f && std::abs(c.normal.y - 1) < 1e-4f);
+
+    // A hull of the cube corners behaves like the box.
+    Vector3f corners[8];
+    for (uint32_t i = 0; i < 8; ++i) corners[i] = box.vertex(i);
+    ConvexHullf cube(corners, 8);
+
+    std::mt19937 rng(12);
+    std::uniform_real_distribution<float> angle(-3.14159f, 3.14159f), off(-2.2f, 2.2f), half(0.3f, 1.2f);
+
+    // Scalar and SIMD support scans pick the same vertex, padding included.
+    std::vector<Vector3f> cloud;
+    for (int i = 0; i < 37; ++i) cloud.emplace_back(off(rng), off(rng), off(rng));
+    ConvexHullf hull(cloud.data(), cloud.size());
+    for (int i = 0; i < 200; ++i)
+    {
+        Vector3f d(off(rng), off(rng), off(rng));
+        SimdDispatch::forceTier(SimdTier::Scalar);
+        uint32_t scalar = hull.support(d);
+        SimdDispatch::resetTier();
+        assert(hull.support(d) == scalar && scalar < cloud.size());
+    }
+    // Doubles never take the float-only SIMD scan.
+    std::vector<Vector3<double>> cloudD;
+    for (const Vector3f& p : cloud) cloudD.emplace_back(p.x, p.y, p.z);
+    ConvexHull<double> hullD(cloudD.data(), cloudD.size());
+    assert(hullD.support(Vector3<double>(1, 0, 0)) == hull.support(Vector3f(1, 0, 0)));
+    int overlaps = 0, epaRuns = 0;
+    for (int i = 0; i < 400; ++i)
+    {
+        Vector3f ha(half(rng), half(rng), half(rng)), hb(half(rng), half(rng), half(rng));
+        BoxShapef a(ha), b(hb);
+        Matrix4f ma = Matrix4f::translate(off(rng), off(rng), off(rng)) * Matrix4f::rotateX(angle(rng)) * Matrix4f::rotateY(angle(rng));
+        Matrix4f mb = Matrix4f::translate(off(rng), off(rng), off(rng)) * Matrix4f::rotateZ(angle(rng)) * Matrix4f::rotateX(angle(rng));
+        bool expected = sat_boxes_overlap(ha, ma, hb, mb);
+
+        GjkResult<float> g = gjkDistance(a, ma, b, mb);
+        if (g.distance > 1e-3f) assert(!expected);
+        else if (g.overlap && !expected) assert(false);
+        overlaps += expected;
+        if (!g.overlap)
+        {
+            assert(std::abs((g.pointB + g.pointA * -1.0f).length() - g.distance) < 1e-3f);
+            // Same answer from the hull path, with the cube scaled to the box.
+            GjkResult<float> h = gjkDistance(cube, ma * Matrix4f::scale(ha.x, ha.y, ha.z), b, mb);
+            assert(std::abs(h.distance - g.distance) < 1e-3f);
+        }
+        else if (expected && collide(a, ma, b, mb, c))
+        {
+            // Pushing B out along the normal separates; stopping short does not.
+            ++epaRuns;
+            assert(std::abs(c.normal.length() - 1) < 1e-4f && c.depth >= 0);
+            Vector3f push = c.normal * (c.depth + 1e-2f), shy = c.normal * (c.depth - 1e-2f);
+            assert(!sat_boxes_overlap(ha, ma, hb, Matrix4f::translate(push.x, push.y, push.z) * mb));
+            if (c.depth > 2e-2f) assert(sat_boxes_overlap(ha, ma, hb, Matrix4f::translate(shy.x, shy.y, shy.z) * mb));
+        }
+
+        // Warm start: nudge B and requery from the cached simplex.
+        GjkCache cache;
+        gjkDistance(a, ma, b, mb, &cache);
+        Matrix4f nudged = Matrix4f::translate(0.002f, -0.001f, 0.001f) * mb;
+        GjkResult<float> warm = gjkDistance(a, ma, b, nudged, &cache);
+        GjkResult<float> cold = gjkDistance(a, ma, b, nudged);
+        assert(warm.overlap == cold.overlap && std::abs(warm.distance - cold.distance) < 1e-4f);
+        if (!warm.overlap) assert(warm.iterations <= 2);
+    }
+    assert(overlaps > 40 && overlaps < 360 && epaRuns > 20);
+
+    std::cout << "[GJK] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Matrix3 / Quaternion
+
+static bool near3(const Vector3f& a, const Vector3f& b, float eps = 1e-5f)
+{
+    return std::abs(a.x - b.x) < eps && std::abs(a.y - b.y) < eps && std::abs(a.z - b.z) < eps;
+}
+
+void run_matrix3_tests()
+{
+    Matrix3f m{ 2, 1, 0,
+                0, 3, 1,
+                1, 0, 4 };
+    assert(m.determinant() == 25);
+    Matrix3f p = m * m.inverse();
+    for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 3; ++c) assert(std::abs(p(r, c) - (r == c ? 1 : 0)) < 1e-6f);
+    assert(m.transpose()(0, 2) == 1 && m.transpose()(2, 0) == 0);
+    assert(m * Vector3f(1, 1, 1) == Vector3f(3, 4, 5));
+    assert(Matrix3f::zeros().inverse()(0, 0) == 0);
+
+    Matrix3f box = Matrix3f::solidBoxInertia(12.0f, Vector3f(0.5f, 1.0f, 1.5f));
+    assert(std::abs(box(0, 0) - 13) < 1e-5f && std::abs(box(1, 1) - 10) < 1e-5f && std::abs(box(2, 2) - 5) < 1e-5f);
+
+    std::cout << "[Matrix3] Tests done\n";
+}
+
+void run_quaternion_tests()
+{
+    const float halfPi = 1.5707963f;
+    Quaternionf qz = Quaternionf::fromAxisAngle(Vector3f(0, 0, 1), halfPi);
+    assert(near3(qz.rotate(Vector3f(1, 0, 0)), Vector3f(0, 1, 0)));
+    assert(near3(qz.toMatrix3() * Vector3f(1, 2, 3), Matrix4f::rotateZ(halfPi) * Vector3f(1, 2, 3)));
+
+    // (a * b) applies b first, like matrices.
+    Quaternionf qx = Quaternionf::fromAxisAngle(Vector3f(1, 0, 0), 0.7f);
+    Vector3f v(0.3f, -1.2f, 2.0f);
+    assert(near3((qz * qx).rotate(v), qz.rotate(qx.rotate(v))));
+    assert(near3((qz * qx).toMatrix3() * v, (Matrix4f::rotateZ(halfPi) * Matrix4f::rotateX(0.7f)) * v));
+    assert(near3((qx * qx.conjugate()).rotate(v), v));
+    assert(std::abs(Quaternionf(1, 2, 3, 4).normalized().length() - 1) < 1e-6f);
+
+    Matrix4f t = qz.toMatrix4(Vector3f(5, 6, 7));
+    assert(near3(t * Vector3f(1, 0, 0), Vector3f(5, 7, 7)));
+
+    std::cout << "[Quaternion] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Rigid body
+
+void run_rigid_body_tests()
+{
+    const float dt = 1.0f / 64; // exact in binary, so the ballistic checks are tight
+    const int steps = 64;
+    const Vector3f g(0, -9.75f, 0);
+
+    for (SimdTier tier : { SimdTier::Scalar, SimdTier::AVX2 })
+    {
+        SimdDispatch::forceTier(tier);
+
+        // Ballistic flight, enough bodies to cover the SIMD body and tail.
+        RigidBodySystem euler(Integrator::SemiImplicitEuler), verlet(Integrator::Verlet);
+        for (RigidBodySystem* sys : { &euler, &verlet })
+        {
+            sys->setGravity(g);
+            for (int i = 0; i < 11; ++i)
+            {
+                RigidBodyDesc d;
+                d.position = Vector3f((float)i, 0, 0);
+                d.velocity = Vector3f(1, 10, 0);
+                sys->add(d);
+            }
+            for (int s = 0; s < steps; ++s) sys->step(dt);
+        }
+        // Verlet is exact under constant acceleration; Euler is ahead by g dt^2 n / 2.
+        float t = dt * steps;
+        for (uint32_t i = 0; i < 11; ++i)
+        {
+            Vector3f exact((float)i + t, 10 * t + 0.5f * g.y * t * t, 0);
+            assert(near3(verlet.position(i), exact, 1e-4f));
+            assert(near3(euler.position(i), Vector3f(exact.x, exact.y + 0.5f * g.y * dt * dt * steps, 0), 1e-4f));
+            assert(near3(verlet.velocity(i), Vector3f(1, 10 + g.y * t, 0), 1e-4f));
+        }
+
+        // Kinematic bodies ignore gravity and forces but keep moving.
+        RigidBodySystem sys;
+        sys.setGravity(g);
+        RigidBodyDesc kin;
+        kin.mass = 0;
+        kin.velocity = Vector3f(2, 0, 0);
+        kin.angularVelocity = Vector3f(0, 1, 0);
+        uint32_t k = sys.add(kin);
+        sys.applyForce(k, Vector3f(0, 100, 0));
+        sys.step(0.5f);
+        assert(near3(sys.position(k), Vector3f(1, 0, 0)) && near3(sys.angularVelocity(k), Vector3f(0, 1, 0)));
+
+        // Torque about a principal axis: w = I^-1 t dt, then a steady spin.
+        sys.setGravity(Vector3f());
+        RigidBodyDesc spin;
+        spin.mass = 12;
+        spin.inertia = Matrix3f::solidBoxInertia(12.0f, Vector3f(0.5f, 1.0f, 1.5f)); // Izz = 5
+        uint32_t b = sys.add(spin);
+        sys.applyForceAtPoint(b, Vector3f(0, 5, 0), Vector3f(1, 0, 0)); // torque (0, 0, 5)
+        sys.step(0.1f);
+        assert(near3(sys.angularVelocity(b), Vector3f(0, 0, 0.1f)) && near3(sys.velocity(b), Vector3f(0, 0.5f / 12, 0)));
+        for (int s = 0; s < 999; ++s) sys.step(0.01f);
+        // 0.1 rad/s for 9.99 s after the first 0.1 s step.
+        Quaternionf expected = Quaternionf::fromAxisAngle(Vector3f(0, 0, 1), 0.1f * (0.1f + 9.99f));
+        assert(std::abs(std::abs(sys.orientation(b).dot(expected)) - 1) < 1e-5f);
+
+        // Damping.
+        RigidBodySystem damped;
+        damped.setDamping(1.0f, 1.0f);
+        RigidBodyDesc d;
+        d.velocity = Vector3f(1, 0, 0);
+        d.angularVelocity = Vector3f(0, 1, 0);
+        damped.add(d);
+        damped.step(1.0f);
+        assert(near3(damped.velocity(0), Vector3f(0.5f, 0, 0)) && near3(damped.angularVelocity(0), Vector3f(0, 0.5f, 0)));
+    }
+
+    // Bit-identical for any thread count; tiers agree to rounding.
+    auto simulate = [](unsigned threads) {
+        JobPool pool(threads);
+        RigidBodySystem sys(Integrator::Verlet);
+        sys.setGravity(Vector3f(0, -9.8f, 0));
+        sys.setDamping(0.1f, 0.2f);
+        std::mt19937 rng(14);
+        std::uniform_real_distribution<float> d(-1.0f, 1.0f);
+        for (int i = 0; i < 3001; ++i)
+        {
+            RigidBodyDesc body;
+            body.position = Vector3f(d(rng), d(rng), d(rng)) * 10.0f;
+            body.orientation = Quaternionf(d(rng), d(rng), d(rng), d(rng));
+            body.angularVelocity = Vector3f(d(rng), d(rng), d(rng));
+            body.mass = 1.0f + d(rng) * 0.5f;
+            body.inertia = Matrix3f::solidBoxInertia(body.mass, Vector3f(1.0f + d(rng) * 0.5f, 1, 0.5f));
+            sys.add(body);
+        }
+        for (int s = 0; s < 20; ++s)
+        {
+            for (uint32_t i = 0; i < sys.size(); i += 3)
+                sys.applyForceAtPoint(i, Vector3f(d(rng), d(rng), d(rng)), sys.position(i) + Vector3f(0.5f, 0, 0));
+            sys.step(1.0f / 60, pool);
+        }
+        std::vector<float> state;
+        for (int s = 0; s < RigidBodySystem::StreamCount; ++s)
+            state.insert(state.end(), sys.stream((RigidBodySystem::Stream)s), sys.stream((RigidBodySystem::Stream)s) + sys.size());
+        return state;
+    };
+    SimdDispatch::forceTier(SimdTier::Scalar);
+    std::vector<float> scalar = simulate(1);
+    assert(simulate(4) == scalar);
+    SimdDispatch::resetTier();
+    std::vector<float> one = simulate(1);
+    assert(simulate(3) == one);
+    for (size_t i = 0; i < one.size(); ++i) assert(std::abs(one[i] - scalar[i]) < 1e-3f);
+
+    std::cout << "[RigidBody] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Particle system
+
+void run_particle_system_tests()
+{
+    ParticleEmitter em;
+    em.position = Vector3f(1, 2, 3);
+    em.radius = 0.5f;
+    em.velocity = Vector3f(0, 4, 0);
+    em.velocityJitter = 1;
+    em.lifetime = 1;
+    em.lifetimeJitter = 0.5f;
+
+    // Emission fills up to capacity and stays within the emitter's ranges.
+    {
+        ParticleSystem ps(1000);
+        assert(ps.emit(em, 600) == 600 && ps.emit(em, 600) == 400 && ps.size() == 1000);
+        assert(ps.counters().live == 1000 && ps.counters().emitted == 1000);
+        for (size_t i = 0; i < ps.size(); ++i)
+        {
+            Vector3f p = ps.position(i), v = ps.velocity(i);
+            assert(std::abs(p.x - 1) <= 0.5f && std::abs(p.y - 2) <= 0.5f && std::abs(p.z - 3) <= 0.5f);
+            assert(std::abs(v.y - 4) <= 1 && ps.lifetime(i) >= 0.5f && ps.lifetime(i) <= 1.5f && ps.age(i) == 0);
+        }
+        assert(ps.position(0) != ps.position(1));
+    }
+
+    // Ballistic motion with drag matches the closed form of the integrator.
+    for (SimdTier tier : { SimdTier::Scalar, SimdTier::AVX2 })
+    {
+        SimdDispatch::forceTier(tier);
+        ParticleSystem ps(64);
+        ParticleForces f;
+        f.gravity = Vector3f(0, -8, 0);
+        f.drag = 0;
+        ps.setForces(f);
+        ParticleEmitter still;
+        still.velocity = Vector3f(2, 0, 0);
+        still.lifetime = 100;
+        ps.emit(still, 19);
+        const float dt = 1.0f / 32;
+        for (int s = 0; s < 32; ++s) ps.update(dt);
+        for (size_t i = 0; i < ps.size(); ++i)
+            assert(near3(ps.position(i), Vector3f(2, -8 * dt * dt * 32 * 33 / 2, 0), 1e-4f) && near3(ps.velocity(i), Vector3f(2, -8, 0), 1e-4f));
+
+        f.gravity = Vector3f();
+        f.drag = 1;
+        ps.setForces(f);
+        ps.update(1.0f);
+        assert(near3(ps.velocity(0), Vector3f(1, -4, 0), 1e-5f));
+    }
+    SimdDispatch::resetTier();
+
+    // Dead particles are removed and the survivors are exactly the ones still alive.
+    {
+        ParticleSystem ps(20000, 7);
+        ParticleEmitter em2 = em;
+        em2.lifetime = 0.5f;
+        em2.lifetimeJitter = 0.45f;
+        ps.emit(em2, 20000);
+        std::vector<float> life(ps.stream(ParticleSystem::Life), ps.stream(ParticleSystem::Life) + ps.size());
+        for (int step = 1; step <= 10; ++step)
+        {
+            ps.update(0.1f);
+            float t = 0.1f * step;
+            size_t expected = 0;
+            for (float l : life) expected += l > t + 1e-4f;
+            // Lifetimes within rounding of a step boundary may go either way.
+            size_t borderline = 0;
+            for (float l : life) borderline += std::abs(l - t) <= 1e-4f;
+            assert(ps.size() >= expected && ps.size() <= expected + borderline);
+            assert(ps.counters().live == ps.size());
+            for (size_t i = 0; i < ps.size(); ++i) assert(ps.age(i) < ps.lifetime(i));
+        }
+        assert(ps.size() == 0);
+    }
+
+    // Curl noise is divergence-free and the sine approximation is close to libm.
+    {
+        ParticleSystem ps(1);
+        ParticleForces f;
+        f.curlFrequency = 0.7f;
+        f.curlOffset = Vector3f(0.3f, -1.1f, 2.0f);
+        ps.setForces(f);
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<float> d(-20.0f, 20.0f);
+        for (int i = 0; i < 200; ++i)
+        {
+            Vector3f p(d(rng), d(rng), d(rng));
+            const float h = 1e-2f;
+            float div = (ps.curlNoise(p + Vector3f(h, 0, 0)).x - ps.curlNoise(p + Vector3f(-h, 0, 0)).x
+                       + ps.curlNoise(p + Vector3f(0, h, 0)).y - ps.curlNoise(p + Vector3f(0, -h, 0)).y
+                       + ps.curlNoise(p + Vector3f(0, 0, h)).z - ps.curlNoise(p + Vector3f(0, 0, -h)).z) / (2 * h);
+            assert(std::abs(div) < 2e-3f);
+
+            float k = f.curlFrequency;
+            float sx = std::sin(p.x * k + 0.3f), cx = std::cos(p.x * k + 0.3f);
+            float sy = std::sin(p.y * k - 1.1f), cy = std::cos(p.y * k - 1.1f);
+            float sz = std::sin(p.z * k + 2.0f), cz = std::cos(p.z * k + 2.0f);
+            Vector3f exact = Vector3f(sx * sy + cx * cz, sy * sz + cx * cy, sz * sx + cy * cz) * (-k);
+            assert(near3(ps.curlNoise(p), exact, 1e-4f));
+        }
+    }
+
+    // Bit-identical for any thread count on a tier; tiers agree to rounding.
+    auto simulate = [&](unsigned threads) {
+        JobPool pool(threads);
+        ParticleSystem ps(50000, 3);
+        ParticleForces f;
+        f.gravity = Vector3f(0, -9.8f, 0);
+        f.drag = 0.3f;
+        f.curlStrength = 2;
+        f.curlFrequency = 0.5f;
+        ps.setForces(f);
+        for (int s = 0; s < 20; ++s)
+        {
+            ps.emit(em, 3001, pool);
+            f.curlOffset = Vector3f(0.1f * s, 0, 0);
+            ps.setForces(f);
+            ps.update(1.0f / 60, pool);
+        }
+        std::vector<float> state;
+        for (int s = 0; s < ParticleSystem::StreamCount; ++s)
+            state.insert(state.end(), ps.stream((ParticleSystem::Stream)s), ps.stream((ParticleSystem::Stream)s) + ps.size());
+        return state;
+    };
+    SimdDispatch::forceTier(SimdTier::Scalar);
+    std::vector<float> scalar = simulate(1);
+    assert(simulate(4) == scalar);
+    SimdDispatch::resetTier();
+    std::vector<float> one = simulate(1);
+    assert(simulate(3) == one);
+    assert(one.size() == scalar.size());
+    for (size_t i = 0; i < one.size(); ++i) assert(std::abs(one[i] - scalar[i]) < 1e-3f);
+
+    std::cout << "[ParticleSystem] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Skinning
+
+void run_skinning_tests()
+{
+    // fromMatrix3 covers every branch, including half turns.
+    for (float angle : { 0.3f, 2.0f, 3.14159265f, -2.9f })
+        for (Vector3f axis : { Vector3f(1, 0, 0), Vector3f(0, 1, 0), Vector3f(0, 0, 1), Vector3f(1, 2, -2).normalized() })
+        {
+            Quaternionf q = Quaternionf::fromAxisAngle(axis, angle);
+            Quaternionf r = Quaternionf::fromMatrix3(q.toMatrix3());
+            assert(std::abs(std::abs(q.dot(r)) - 1) < 1e-5f);
+        }
+
+    Vector3f bindPos[3] = { Vector3f(1, 0, 0), Vector3f(0, 2, 1), Vector3f(-1, 0.5f, 3) };
+    Vector3f bindNrm[3] = { Vector3f(0, 1, 0), Vector3f(1, 0, 0), Vector3f(0, 0, 1) };
+    Vector3f outP[3], outN[3];
+
+    // A single influence reproduces the joint matrix with either method.
+    {
+        Matrix4f joints[2] = { Matrix4f::translate(1, 2, 3) * Matrix4f::rotateY(0.8f) * Matrix4f::rotateX(-0.4f),
+                               Matrix4f::rotateZ(2.5f) };
+        SkinPalette palette(joints, 2);
+        uint16_t ids[12] = { 0, 1, 1, 1,  1, 0, 0, 0,  0, 0, 0, 0 };
+        float weights[12] = { 1, 0, 0, 0,  1, 0, 0, 0,  2, 0, 0, 0 };
+        SkinMesh mesh(bindPos, bindNrm, 3, ids, weights, 4);
+        for (SkinningMethod method : { SkinningMethod::Linear, SkinningMethod::DualQuaternion })
+        {
+            skin(SkinJob{ &mesh, &palette, outP, outN }, method);
+            for (int v = 0; v < 3; ++v)
+            {
+                const Matrix4f& m = joints[ids[v * 4]];
+                Vector3f n = m * bindNrm[v];
+                n = Vector3f(n.x - m(0, 3), n.y - m(1, 3), n.z - m(2, 3));
+                assert(near3(outP[v], m * bindPos[v], 1e-5f) && near3(outN[v], n, 1e-5f));
+            }
+        }
+    }
+
+    // Blends: LBS averages the transformed points; DQS keeps the distance to
+    // the twist axis and handles quaternions from opposite hemispheres.
+    {
+        Matrix4f joints[4] = { Matrix4f::rotateX(0.0f), Matrix4f::rotateX(1.5707963f),
+                               Matrix4f::rotateZ(2.9670597f), Matrix4f::rotateZ(-2.9670597f) }; // +-170 degrees
+        SkinPalette palette(joints, 4);
+        uint16_t ids[12] = { 0, 1, 0, 0,  0, 1, 0, 0,  2, 3, 0, 0 };
+        float weights[12] = { 0.5f, 0.5f, 0, 0,  0.5f, 0.5f, 0, 0,  0.5f, 0.5f, 0, 0 };
+        Vector3f pos[3] = { Vector3f(1, 0, 2), Vector3f(0, 2, 1), Vector3f(1, 0, 0) };
+        SkinMesh mesh(pos, nullptr, 3, ids, weights, 4);
+
+        skin(SkinJob{ &mesh, &palette, outP }, SkinningMethod::Linear);
+        for (int v = 0; v < 3; ++v)
+        {
+            Vector3f a = joints[ids[v * 4]] * pos[v], b = joints[ids[v * 4 + 1]] * pos[v];
+            assert(near3(outP[v], (a + b) * 0.5f, 1e-5f));
+        }
+        assert(outP[1].y * outP[1].y + outP[1].z * outP[1].z < 4.5f); // collapsed toward the axis
+
+        skin(SkinJob{ &mesh, &palette, outP }, SkinningMethod::DualQuaternion);
+        // halfway, 45 degrees about x
+        assert(near3(outP[1], Vector3f(0, 0.70710678f * 2 - 0.70710678f * 1, 0.70710678f * 2 + 0.70710678f * 1), 1e-5f));
+        assert(near3(outP[2], Vector3f(-1, 0, 0), 1e-5f)); // +-170 blends to 180, not 0
+    }
+
+    // SIMD and scalar agree, for 4 and 8 influences and many meshes at once.
+    {
+        std::mt19937 rng(37);
+        std::uniform_real_distribution<float> d(-1.0f, 1.0f), w(0.0f, 1.0f);
+        const size_t joints = 40;
+        std::vector<Matrix4f> palette(joints);
+        for (auto& m : palette) m = Matrix4f::translate(d(rng), d(rng), d(rng)) * Matrix4f::rotateY(d(rng) * 3) * Matrix4f::rotateX(d(rng) * 3);
+        SkinPalette pal(palette.data(), joints);
+
+        std::vector<SkinMesh> meshes;
+        for (int influences : { 4, 8, 4 })
+        {
+            size_t n = influences == 8 ? 5003 : 333;
+            std::vector<Vector3f> p(n), nr(n);
+            std::vector<uint16_t> ids(n * influences);
+            std::vector<float> ws(n * influences);
+            for (size_t v = 0; v < n; ++v)
+            {
+                p[v] = Vector3f(d(rng), d(rng), d(rng));
+                nr[v] = Vector3f(d(rng), d(rng), d(rng)).normalized();
+            }
+            for (auto& id : ids) id = (uint16_t)(rng() % joints);
+            for (auto& x : ws) x = w(rng);
+            meshes.emplace_back(p.data(), nr.data(), n, ids.data(), ws.data(), influences);
+        }
+        for (SkinningMethod method : { SkinningMethod::Linear, SkinningMethod::DualQuaternion })
+        {
+            std::vector<std::vector<Vector3f>> ref(meshes.size()), refN(meshes.size()), out(meshes.size()), outNrm(meshes.size());
+            std::vector<SkinJob> jobs;
+            SimdDispatch::forceTier(SimdTier::Scalar);
+            for (size_t i = 0; i < meshes.size(); ++i)
+            {
+                ref[i].resize(meshes[i].size()); refN[i].resize(meshes[i].size());
+                out[i].resize(meshes[i].size()); outNrm[i].resize(meshes[i].size());
+                skin(SkinJob{ &meshes[i], &pal, ref[i].data(), refN[i].data() }, method);
+                jobs.push_back({ &meshes[i], &pal, out[i].data(), outNrm[i].data() });
+            }
+            SimdDispatch::resetTier();
+            JobPool pool(3);
+            skin(jobs.data(), jobs.size(), method, pool);
+            for (size_t i = 0; i < meshes.size(); ++i)
+                for (size_t v = 0; v < meshes[i].size(); ++v)
+                {
+                    assert(near3(out[i][v], ref[i][v], 1e-4f) && near3(outNrm[i][v], refN[i][v], 1e-4f));
+                    assert(std::abs(outNrm[i][v].length() - 1) < 1e-4f);
+                }
+        }
+    }
+
+    std::cout << "[Skinning] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Animation
+
+static bool nearQuat(const Quaternionf& a, const Quaternionf& b, float eps)
+{
+    return 1 - std::abs(a.dot(b)) < eps;
+}
+
+void run_animation_tests()
+{
+    std::mt19937 rng(38);
+    std::uniform_real_distribution<float> d(-1.0f, 1.0f);
+
+    // Smallest-three packing: error well under 1e-4 per component.
+    for (int i = 0; i < 1000; ++i)
+    {
+        Quaternionf q = Quaternionf(d(rng), d(rng), d(rng), d(rng)).normalized();
+        Quaternionf u = PackedQuaternion::pack(q).unpack();
+        assert(std::abs(std::abs(q.dot(u)) - 1) < 1e-6f);
+        float sign = q.dot(u) < 0 ? -1.0f : 1.0f;
+        assert(std::abs(q.x - u.x * sign) < 1e-4f && std::abs(q.w - u.w * sign) < 1e-4f);
+    }
+    assert(PackedQuaternion::pack(Quaternionf(0, 0, 0, -1)).unpack() == Quaternionf::identity());
+
+    // Three joints: animated, constant within tolerance, and no keys at all.
+    std::vector<JointTracks> tracks(3);
+    const int keys = 11;
+    for (int k = 0; k < keys; ++k)
+    {
+        float t = 0.1f * k;
+        tracks[0].translation.times.push_back(t);
+        tracks[0].translation.values.push_back(Vector3f(t, 2 * t, 0));
+        tracks[0].rotation.times.push_back(t);
+        tracks[0].rotation.values.push_back(Quaternionf::fromAxisAngle(Vector3f(0, 0, 1), t));
+        tracks[0].scale.times.push_back(t);
+        tracks[0].scale.values.push_back(Vector3f(1, 1, 1) * (1 + t));
+        tracks[1].translation.times.push_back(t);
+        tracks[1].translation.values.push_back(Vector3f(5, 0, 0) + Vector3f(5e-6f, 0, 0) * (float)k);
+        tracks[1].rotation.times.push_back(t);
+        tracks[1].rotation.values.push_back(Quaternionf::fromAxisAngle(Vector3f(1, 0, 0), 0.5f));
+    }
+    AnimationClip clip(tracks, 1.0f);
+    assert(clip.jointCount() == 3 && clip.constantTrackCount() == 6);
+    assert(clip.keyCount() == 3 * keys + 6);
+
+    AnimationCursor cursor;
+    std::vector<JointPose> pose(3), fresh(3);
+    // Forward playback, including between keys, past the end and a rewind.
+    for (float t : { 0.0f, 0.05f, 0.1f, 0.37f, 0.42f, 0.99f, 1.0f, 1.5f, 0.25f, -1.0f, 0.75f })
+    {
+        clip.sample(t, cursor, pose.data());
+        AnimationCursor other;
+        clip.sample(t, other, fresh.data());
+        float c = std::min(std::max(t, 0.0f), 1.0f);
+        assert(near3(pose[0].translation, Vector3f(c, 2 * c, 0), 1e-5f));
+        assert(near3(pose[0].scale, Vector3f(1, 1, 1) * (1 + c), 1e-5f));
+        assert(nearQuat(pose[0].rotation, Quaternionf::fromAxisAngle(Vector3f(0, 0, 1), c), 1e-6f));
+        assert(near3(pose[1].translation, Vector3f(5, 0, 0)) && nearQuat(pose[1].rotation, Quaternionf::fromAxisAngle(Vector3f(1, 0, 0), 0.5f), 1e-6f));
+        assert(pose[2].translation == Vector3f() && pose[2].scale == Vector3f::ones() && nearQuat(pose[2].rotation, Quaternionf(), 1e-7f));
+        for (int j = 0; j < 3; ++j)
+            assert(pose[j].translation == fresh[j].translation && pose[j].rotation == fresh[j].rotation && pose[j].scale == fresh[j].scale);
+    }
+
+    // Blending: weights normalize, a zero weight is ignored, rotations take the short way.
+    std::vector<JointTracks> other(3);
+    other[0].translation = { { 0.0f }, { Vector3f(0, 0, 4) } };
+    other[0].rotation = { { 0.0f }, { Quaternionf::fromAxisAngle(Vector3f(0, 0, 1), 0.6f) * -1.0f } };
+    AnimationClip still(other, 1.0f);
+    AnimationCursor c0, c1;
+    std::vector<JointPose> scratch, blended(3);
+    AnimationLayer layers[2] = { { &clip, &c0, 0.2f, 3.0f }, { &still, &c1, 0.0f, 0.0f } };
+    sampleBlended(layers, 2, blended.data(), scratch);
+    clip.sample(0.2f, cursor, pose.data());
+    for (int j = 0; j < 3; ++j)
+        assert(near3(blended[j].translation, pose[j].translation) && nearQuat(blended[j].rotation, pose[j].rotation, 1e-6f));
+    layers[1].weight = 3.0f;
+    sampleBlended(layers, 2, blended.data(), scratch);
+    assert(near3(blended[0].translation, Vector3f(0.1f, 0.2f, 2), 1e-5f));
+    assert(nearQuat(blended[0].rotation, Quaternionf::fromAxisAngle(Vector3f(0, 0, 1), 0.4f), 1e-6f));
+    assert(near3(blended[0].scale, Vector3f(1.1f, 1.1f, 1.1f), 1e-5f));
+
+    // Bulk pose-to-matrix matches composing the Matrix4 helpers.
+    JointPose p;
+    p.translation = Vector3f(1, -2, 3);
+    p.rotation = Quaternionf::fromAxisAngle(Vector3f(0, 1, 0), 0.7f);
+    p.scale = Vector3f(2, 3, 4);
+    Matrix4f m;
+    posesToMatrices(&p, 1, &m);
+    Matrix4f expected = Matrix4f::translate(1, -2, 3) * Matrix4f::rotateY(0.7f) * Matrix4f::scale(2, 3, 4);
+    for (int r = 0; r < 4; ++r)
+        for (int c = 0; c < 4; ++c) assert(std::abs(m(r, c) - expected(r, c)) < 1e-5f);
+
+    // Bulk jobs across a pool match per-character calls: one- and two-layer
+    // characters, with and without matrices.
+    const size_t characters = 40;
+    std::vector<AnimationCursor> cursors(characters * 2);
+    std::vector<AnimationLayer> charLayers(characters * 2);
+    std::vector<JointPose> bulk(characters * 3), single(3);
+    std::vector<Matrix4f> bulkMatrices(characters * 3), singleMatrices(3);
+    std::vector<AnimationJob> jobs(characters);
+    for (size_t i = 0; i < characters; ++i)
+    {
+        float t = 0.025f * float(i);
+        charLayers[2 * i] = { &clip, &cursors[2 * i], t, 1.0f };
+        charLayers[2 * i + 1] = { &still, &cursors[2 * i + 1], t, 0.5f };
+        jobs[i] = { &charLayers[2 * i], 1 + i % 2, &bulk[i * 3], i % 3 ? &bulkMatrices[i * 3] : nullptr };
+    }
+    JobPool pool(3);
+    sampleBlended(jobs.data(), jobs.size(), pool);
+    for (size_t i = 0; i < characters; ++i)
+    {
+        AnimationCursor a, b;
+        AnimationLayer l[2] = { charLayers[2 * i], charLayers[2 * i + 1] };
+        l[0].cursor = &a;
+        l[1].cursor = &b;
+        sampleBlended(l, jobs[i].layerCount, single.data(), scratch);
+        posesToMatrices(single.data(), 3, singleMatrices.data());
+        for (int j = 0; j < 3; ++j)
+        {
+            const JointPose& q = bulk[i * 3 + j];
+            assert(near3(q.translation, single[j].translation) && nearQuat(q.rotation, single[j].rotation, 1e-6f));
+            if (jobs[i].matrices)
+                for (int r = 0; r < 4; ++r)
+                    for (int c = 0; c < 4; ++c) assert(std::abs(bulkMatrices[i * 3 + j](r, c) - singleMatrices[j](r, c)) < 1e-5f);
+        }
+    }
+
+    std::cout << "[Animation] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Spline
+
+void run_spline_tests()
+{
+    // Bezier: ends, the de Casteljau midpoint, and end tangents along the control legs.
+    Vector3f ctrl[7] = { Vector3f(0, 0, 0), Vector3f(1, 2, 0), Vector3f(3, 2, 1), Vector3f(4, 0, 1),
+                         Vector3f(5, -2, 1), Vector3f(7, -1, 0), Vector3f(8, 0, 0) };
+    Spline3f bez = Spline3f::bezier(ctrl, 7);
+    assert(bez.segmentCount() == 2);
+    assert(near3(bez.evaluate(0), ctrl[0]) && near3(bez.evaluate(0.5f), ctrl[3]) && near3(bez.evaluate(1), ctrl[6]));
+    assert(near3(bez.evaluate(0.25f), (ctrl[0] + ctrl[1] * 3 + ctrl[2] * 3 + ctrl[3]) * 0.125f));
+    assert(near3(bez.derivative(0), Vector3f(1, 2, 0) * 6)); // 3 (P1 - P0) per segment, 2 segments
+
+    // Hermite: through the points with the given tangents.
+    Vector3f pts[3] = { Vector3f(0, 0, 0), Vector3f(1, 1, 0), Vector3f(2, 0, 0) };
+    Vector3f tan[3] = { Vector3f(1, 0, 0), Vector3f(0, 0, 2), Vector3f(1, -1, 0) };
+    Spline3f her = Spline3f::hermite(pts, tan, 3);
+    assert(near3(her.evaluate(0.5f), pts[1]) && near3(her.evaluate(1), pts[2]));
+    assert(near3(her.derivative(0.5f), tan[1] * 2) && near3(her.derivative(1), tan[2] * 2));
+
+    // Catmull-Rom passes through every point; evenly spaced collinear points move uniformly.
+    Vector3f line[4] = { Vector3f(0, 0, 0), Vector3f(1, 0, 0), Vector3f(2, 0, 0), Vector3f(3, 0, 0) };
+    Spline3f cr = Spline3f::catmullRom(line, 4);
+    for (float t : { 0.0f, 0.1f, 0.5f, 0.8f, 1.0f }) assert(near3(cr.evaluate(t), Vector3f(3 * t, 0, 0)));
+    Vector3f zig[5] = { Vector3f(0, 0, 0), Vector3f(1, 3, 0), Vector3f(1.2f, 3, 0), Vector3f(4, 0, 1), Vector3f(4, 0, 1) };
+    Spline3f zz = Spline3f::catmullRom(zig, 5);
+    for (int i = 0; i < 5; ++i) assert(near3(zz.evaluate(i / 4.0f), zig[i]));
+    for (int i = 0; i <= 100; ++i) assert(std::isfinite(zz.evaluate(i / 100.0f).x)); // repeated end point
+
+    // Vector2 curves.
+    Vector2f flat[4] = { Vector2f(0, 0), Vector2f(1, 1), Vector2f(2, 0), Vector2f(3, 1) };
+    Spline2f cr2 = Spline2f::catmullRom(flat, 4);
+    Vector2f mid = cr2.evaluate(1.0f / 3);
+    assert(std::abs(mid.x - 1) < 1e-5f && std::abs(mid.y - 1) < 1e-5f);
+
+    // Arc length: a straight Bezier with bunched controls still samples evenly.
+    Vector3f bunched[4] = { Vector3f(0, 0, 0), Vector3f(0.1f, 0, 0), Vector3f(0.2f, 0, 0), Vector3f(10, 0, 0) };
+    Spline3f straight = Spline3f::bezier(bunched, 4);
+    straight.buildArcLength(64);
+    assert(std::abs(straight.length() - 10) < 1e-4f);
+    for (float s : { 0.0f, 1.0f, 2.5f, 7.0f, 10.0f }) assert(std::abs(straight.evaluateAtDistance(s).x - s) < 0.02f);
+    std::vector<Vector3f> even(11);
+    straight.sampleEvenly(11, even.data());
+    for (int i = 0; i <= 10; ++i) assert(std::abs(even[i].x - i) < 0.02f);
+
+    // Quarter circle from the usual Bezier approximation, radius 2.
+    const float k = 0.5522847f * 2;
+    Vector3f arc[4] = { Vector3f(2, 0, 0), Vector3f(2, k, 0), Vector3f(k, 2, 0), Vector3f(0, 2, 0) };
+    Spline3f quarter = Spline3f::bezier(arc, 4);
+    quarter.buildArcLength();
+    assert(std::abs(quarter.length() - 3.14159265f) < 2e-3f);
+
+    // Bulk evaluation matches the scalar path on every tier, for 2D and 3D.
+    std::mt19937 rng(39);
+    std::uniform_real_distribution<float> d(-0.1f, 1.1f);
+    std::vector<float> params(1003);
+    for (auto& t : params) t = d(rng);
+    std::vector<Vector3f> bulk(params.size());
+    std::vector<Vector2f> bulk2(params.size());
+    for (SimdTier tier : { SimdTier::Scalar, SimdTier::AVX2 })
+    {
+        SimdDispatch::forceTier(tier);
+        zz.evaluate(params.data(), params.size(), bulk.data());
+        cr2.evaluate(params.data(), params.size(), bulk2.data());
+        for (size_t i = 0; i < params.size(); ++i)
+        {
+            assert(near3(bulk[i], zz.evaluate(params[i]), 1e-5f));
+            Vector2f e = cr2.evaluate(params[i]);
+            assert(std::abs(bulk2[i].x - e.x) < 1e-5f && std::abs(bulk2[i].y - e.y) < 1e-5f);
+        }
+    }
+    SimdDispatch::resetTier();
+
+    // Degenerate curves and a missing arc-length table stay in bounds.
+    Vector3f one(1, 2, 3);
+    for (const Spline3f& empty : { Spline3f(), Spline3f::catmullRom(&one, 1), Spline3f::bezier(&one, 1) })
+    {
+        assert(empty.segmentCount() == 0 && empty.evaluate(0.5f) == Vector3f() && empty.derivative(0.5f) == Vector3f());
+        Vector3f few[9];
+        empty.evaluate(params.data(), 9, few);
+        for (const Vector3f& p : few) assert(p == Vector3f());
+        Spline3f built = empty;
+        built.buildArcLength();
+        assert(built.length() == 0 && built.parameterAtDistance(1.0f) == 0);
+        built.sampleEvenly(3, few);
+    }
+    Spline3f fresh = Spline3f::bezier(line, 4);
+    assert(fresh.parameterAtDistance(2.0f) == 0 && near3(fresh.evaluateAtDistance(2.0f), Vector3f()));
+    Vector3f ends[2];
+    fresh.sampleEvenly(2, ends);
+    assert(near3(ends[0], Vector3f()) && near3(ends[1], Vector3f()));
+    fresh.buildArcLength();
+    fresh.sampleEvenly(1, ends);
+    assert(near3(ends[0], Vector3f()));
+    fresh.sampleEvenly(2, ends);
+    assert(near3(ends[1], Vector3f(3, 0, 0), 1e-4f));
+
+    // Doubles take the scalar path.
+    Vector3<double> dpts[3] = { Vector3<double>(0, 0, 0), Vector3<double>(1, 0, 0), Vector3<double>(1, 1, 0) };
+    Spline<Vector3<double>> dcr = Spline<Vector3<double>>::catmullRom(dpts, 3);
+    std::vector<double> dparams = { 0.0, 0.5, 1.0 };
+    std::vector<Vector3<double>> dout(3);
+    dcr.evaluate(dparams.data(), 3, dout.data());
+    assert(dout[1].x == 1 && dout[1].y == 0 && dout[2].y == 1);
+
+    std::cout << "[Spline] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Triangle setup
+
+// Clip position of a setup vertex rebuilt from its barycentrics, projected to pixels.
+static Vector2f reprojected(const Matrix4f& mvp, const Vector3f* v, const uint32_t* tri, float b0, float b1, float w, float h)
+{
+    float c[4];
+    for (int r = 0; r < 4; ++r)
+    {
+        float a[3];
+        for (int k = 0; k < 3; ++k) a[k] = mvp(r, 0) * v[tri[k]].x + mvp(r, 1) * v[tri[k]].y + mvp(r, 2) * v[tri[k]].z + mvp(r, 3);
+        c[r] = a[0] * b0 + a[1] * b1 + a[2] * (1 - b0 - b1);
+    }
+    return Vector2f((c[0] / c[3] * 0.5f + 0.5f) * w, (0.5f - c[1] / c[3] * 0.5f) * h);
+}
+
+void run_triangle_setup_tests()
+{
+    JobPool pool(3);
+    const Matrix4f id = Matrix4f::identity();
+
+    // Front, back, outside, and sub-pixel triangles through an identity MVP.
+    Vector3f v[] = { Vector3f(-0.5f, -0.5f, 0), Vector3f(0.5f, -0.5f, 0), Vector3f(0, 0.5f, 0),
+                     Vector3f(1.5f, 0, 0), Vector3f(2, 0, 0), Vector3f(2, 1, 0),
+                     Vector3f(0.001f, 0.001f, 0), Vector3f(0.005f, 0.001f, 0), Vector3f(0.003f, 0.005f, 0) };
+    uint32_t idx[] = { 0, 1, 2,  0, 2, 1,  3, 4, 5,  6, 7, 8 };
+    TriangleSetup setup(100, 100, 32);
+    assert(setup.tileCountX() == 4 && setup.tileCountY() == 4);
+    setup.process(id, v, 9, idx, 4, pool);
+    const TriangleSetupStats& st = setup.stats();
+    assert(st.trianglesIn == 4 && st.culledBackFace == 1 && st.culledFrustum == 1 && st.culledSmall == 1 && st.trianglesOut == 1);
+    const SetupTriangle& t = setup.triangles()[0];
+    assert(t.primitive == 0 && !t.backFacing);
+    assert(t.x[0] == 25 && t.y[0] == 75 && t.z[0] == 0.5f && t.invW[0] == 1);
+    assert((t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.x[2] - t.x[0]) * (t.y[1] - t.y[0]) > 0);
+
+    // Binned into its 3x3 tile footprint, except the top corners the edges miss.
+    assert(st.binEntries == 7);
+    size_t n;
+    setup.bin(1, 1, n);
+    assert(n == 1);
+    setup.bin(0, 0, n);
+    assert(n == 0);
+    setup.bin(3, 3, n);
+    assert(n == 0);
+
+    // Other cull modes keep the back face, flagged and rewound.
+    setup.setCullMode(CullMode::None);
+    setup.process(id, v, 9, idx, 4, pool);
+    assert(setup.stats().trianglesOut == 2 && setup.triangles()[1].backFacing && setup.triangles()[1].primitive == 1);
+    const SetupTriangle& back = setup.triangles()[1];
+    assert((back.x[1] - back.x[0]) * (back.y[2] - back.y[0]) - (back.x[2] - back.x[0]) * (back.y[1] - back.y[0]) > 0);
+    setup.setCullMode(CullMode::Front);
+    setup.process(id, v, 9, idx, 4, pool);
+    assert(setup.stats().trianglesOut == 1 && setup.triangles()[0].primitive == 1);
+    setup.setCullMode(CullMode::Back);
+
+    // A ground triangle reaching behind the camera is clipped; every piece
+    // stays on screen and its barycentrics reproduce its pixel positions.
+    const float w = 320, h = 240;
+    Matrix4f mvp = Matrix4f::perspective(1.2f, w / h, 0.1f, 100.0f) * Matrix4f::translate(0, -1, 0);
+    Vector3f ground[] = { Vector3f(-3, 0, -20), Vector3f(3, 0, 5), Vector3f(3, 0, -20) };
+    uint32_t gi[] = { 0, 1, 2 };
+    TriangleSetup wide(320, 240, 64);
+    wide.setCullMode(CullMode::None);
+    wide.process(mvp, ground, 3, gi, 1, pool);
+    assert(wide.stats().clipped == 1 && wide.stats().trianglesOut >= 1);
+    // Repeated corners, by index or by position, are culled as degenerate in
+    // every cull mode and before clipping, whatever FMA does to the area.
+    Vector3f dup[] = { ground[0], ground[1], ground[1], ground[2] };
+    uint32_t di[] = { 0, 1, 1,  0, 1, 2,  1, 2, 0 };
+    for (CullMode mode : { CullMode::None, CullMode::Back, CullMode::Front })
+    {
+        wide.setCullMode(mode);
+        wide.process(mvp, dup, 4, di, 3, pool);
+        assert(wide.stats().culledSmall == 3 && wide.stats().clipped == 0 && wide.stats().trianglesOut == 0);
+    }
+    wide.setCullMode(CullMode::None);
+    wide.process(mvp, ground, 3, gi, 1, pool);
+    for (const SetupTriangle& p : wide.triangles())
+        for (int k = 0; k < 3; ++k)
+        {
+            assert(p.x[k] >= -1e-3f && p.x[k] <= w + 1e-3f && p.y[k] >= -1e-3f && p.y[k] <= h + 1e-3f);
+            assert(p.z[k] >= -1e-5f && p.z[k] <= 1 + 1e-5f && p.invW[k] > 0);
+            Vector2f r = reprojected(mvp, ground, gi, p.b0[k], p.b1[k], w, h);
+            assert(std::abs(r.x - p.x[k]) < 0.05f && std::abs(r.y - p.y[k]) < 0.05f);
+        }
+
+    // Random soup: identical across thread counts on one tier, and within
+    // rounding (FMA moves a few edge-on triangles) across tiers. Every bin is
+    // in submission order and overlaps its triangles' bounding boxes.
+    std::mt19937 rng(40);
+    std::uniform_real_distribution<float> pos(-12, 12);
+    std::vector<Vector3f> verts(6001);
+    for (auto& p : verts) p = Vector3f(pos(rng), pos(rng), pos(rng) - 14);
+    std::vector<uint32_t> soup(3 * 9000);
+    std::uniform_int_distribution<uint32_t> pick(0, (uint32_t)verts.size() - 1);
+    for (size_t i = 0; i < soup.size(); ++i) soup[i] = i % 3 == 0 ? pick(rng) : (soup[i - i % 3] + pick(rng) % 16) % verts.size();
+
+    TriangleSetup one(320, 240, 64), many(320, 240, 64), simd(320, 240, 64);
+    JobPool single(1);
+    SimdDispatch::forceTier(SimdTier::Scalar);
+    one.process(mvp, verts.data(), verts.size(), soup.data(), 9000, single);
+    many.process(mvp, verts.data(), verts.size(), soup.data(), 9000, pool);
+    SimdDispatch::resetTier();
+    simd.process(mvp, verts.data(), verts.size(), soup.data(), 9000, pool);
+    const TriangleSetupStats& a = one.stats();
+    const TriangleSetupStats& b = many.stats();
+    assert(a.trianglesIn == 9000 && a.clipped > 0 && a.culledFrustum > 0 && a.culledBackFace > 0 && a.trianglesOut > 0);
+    assert(a.trianglesOut == b.trianglesOut && a.binEntries == b.binEntries && a.culledSmall == b.culledSmall && a.culledBackFace == b.culledBackFace);
+    const TriangleSetupStats& c = simd.stats();
+    assert(c.clipped == a.clipped && c.culledFrustum == a.culledFrustum);
+    assert(std::abs((double)c.trianglesOut - (double)a.trianglesOut) < 10 && std::abs((double)c.culledBackFace - (double)a.culledBackFace) < 10);
+    for (size_t i = 0; i < a.trianglesOut; ++i)
+    {
+        const SetupTriangle& p = one.triangles()[i];
+        const SetupTriangle& q = many.triangles()[i];
+        assert(p.primitive == q.primitive);
+        for (int k = 0; k < 3; ++k) assert(p.x[k] == q.x[k] && p.y[k] == q.y[k] && p.z[k] == q.z[k]);
+    }
+    size_t entries = 0;
+    for (int ty = 0; ty < many.tileCountY(); ++ty)
+        for (int tx = 0; tx < many.tileCountX(); ++tx)
+        {
+            const uint32_t* list = many.bin(tx, ty, n);
+            size_t m;
+            const uint32_t* other = one.bin(tx, ty, m);
+            assert(n == m && std::equal(list, list + n, other));
+            for (size_t k = 0; k < n; ++k)
+            {
+                assert(k == 0 || list[k - 1] < list[k]);
+                const SetupTriangle& p = many.triangles()[list[k]];
+                assert(std::max({ p.x[0], p.x[1], p.x[2] }) >= tx * 64 && std::min({ p.x[0], p.x[1], p.x[2] }) <= (tx + 1) * 64);
+                assert(std::max({ p.y[0], p.y[1], p.y[2] }) >= ty * 64 && std::min({ p.y[0], p.y[1], p.y[2] }) <= (ty + 1) * 64);
+            }
+            entries += n;
+        }
+    assert(entries == b.binEntries);
+
+    std::cout << "[TriangleSetup] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Occlusion culling
+
+void run_occlusion_culling_tests()
+{
+    JobPool pool(3);
+    const Matrix4f proj = Matrix4f::perspective(1.2f, 2.0f, 0.1f, 100.0f);
+    const Vector3f quad[4] = { Vector3f(-1, -1, 0), Vector3f(1, -1, 0), Vector3f(1, 1, 0), Vector3f(-1, 1, 0) };
+    const uint32_t quadIndices[6] = { 0, 1, 2, 0, 2, 3 };
+
+    // A wall at z = -10 wider than the view.
+    OccluderMesh wall{ quad, 4, quadIndices, 2, Matrix4f::translate(0, 0, -10) * Matrix4f::scale(20, 20, 1) };
+    OcclusionCuller culler(256, 128);
+    assert(culler.levelCount() == 9 && culler.levelWidth(8) == 1 && culler.levelHeight(8) == 1);
+    culler.renderOccluders(proj, &wall, 1, pool);
+    Vector4f w = proj.transformHomogeneous(Vector3f(0, 0, -10));
+    float wallDepth = w.z / w.w * 0.5f + 0.5f;
+    assert(std::abs(culler.farthestDepth(0, 128, 64) - wallDepth) < 1e-5f);
+    assert(std::abs(culler.farthestDepth(8, 0, 0) - wallDepth) < 1e-5f);
+
+    AABBf boxes[] = {
+        AABBf::fromCenterExtents(Vector3f(0, 0, -20), Vector3f(1, 1, 1)),    // behind the wall
+        AABBf::fromCenterExtents(Vector3f(2, 1, -5), Vector3f(1, 1, 1)),     // in front
+        AABBf::fromCenterExtents(Vector3f(0, 0, -9.5f), Vector3f(1, 1, 1)),  // through it
+        AABBf::fromCenterExtents(Vector3f(0, 0, 10), Vector3f(1, 1, 1)),     // behind the camera
+        AABBf::fromCenterExtents(Vector3f(0, 0, 0), Vector3f(1, 1, 1)),      // around the camera
+        AABBf::fromCenterExtents(Vector3f(100, 0, -20), Vector3f(1, 1, 1)),  // off to the side
+    };
+    uint8_t visible[6];
+    assert(culler.testBoxes(boxes, 6, visible, pool) == 3);
+    assert(!visible[0] && visible[1] && visible[2] && !visible[3] && visible[4] && !visible[5]);
+    const OcclusionStats& st = culler.frameStats();
+    assert(st.occluderTriangles == 2 && st.rasterTriangles >= 2 && st.tested == 6); // clipped to the screen
+    assert(st.culledFrustum == 2 && st.culledOccluded == 1 && st.cullRate() == 0.5);
+
+    // Half a wall: the pyramid keeps the far plane where it is open.
+    OccluderMesh half{ quad, 4, quadIndices, 2, Matrix4f::translate(-10, 0, -10) * Matrix4f::scale(10, 20, 1) };
+    culler.renderOccluders(proj, &half, 1, pool);
+    assert(culler.farthestDepth(8, 0, 0) == 1.0f && std::abs(culler.nearestDepth(8, 0, 0) - wallDepth) < 1e-5f);
+    assert(culler.farthestDepth(0, 200, 64) == 1.0f && std::abs(culler.farthestDepth(0, 50, 64) - wallDepth) < 1e-5f);
+    AABBf sides[] = { AABBf::fromCenterExtents(Vector3f(-8, 0, -20), Vector3f(1, 1, 1)),
+                      AABBf::fromCenterExtents(Vector3f(5, 0, -20), Vector3f(1, 1, 1)) };
+    uint8_t sideVisible[2];
+    culler.testBoxes(sides, 2, sideVisible, pool);
+    assert(!sideVisible[0] && sideVisible[1]);
+
+    // A street of random buildings: same answers for any thread count, and
+    // close across SIMD tiers (edge pixels may round differently).
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> u(0, 1);
+    std::vector<OccluderMesh> buildings;
+    for (int i = 0; i < 40; ++i)
+    {
+        float x = (u(rng) - 0.5f) * 60, z = -5 - u(rng) * 60, h = 2 + u(rng) * 8;
+        buildings.push_back({ quad, 4, quadIndices, 2, Matrix4f::translate(x, h - 2, z) * Matrix4f::scale(2 + u(rng) * 3, h, 1) });
+    }
+    std::vector<AABBf> props(5000);
+    for (auto& b : props) b = AABBf::fromCenterExtents(Vector3f((u(rng) - 0.5f) * 120, u(rng) * 3 - 2, -u(rng) * 90), Vector3f(0.3f, 0.3f, 0.3f));
+    std::vector<uint8_t> a(props.size()), b(props.size()), c(props.size());
+    JobPool single(1);
+    SimdDispatch::forceTier(SimdTier::Scalar);
+    culler.renderOccluders(proj, buildings.data(), buildings.size(), single);
+    size_t scalarVisible = culler.testBoxes(props.data(), props.size(), a.data(), single);
+    culler.renderOccluders(proj, buildings.data(), buildings.size(), pool);
+    culler.testBoxes(props.data(), props.size(), b.data(), pool);
+    assert(a == b);
+    SimdDispatch::resetTier();
+    culler.renderOccluders(proj, buildings.data(), buildings.size(), pool);
+    size_t simdVisible = culler.testBoxes(props.data(), props.size(), c.data(), pool);
+    assert(culler.frameStats().culledOccluded > 0 && culler.frameStats().culledFrustum > 0);
+    assert(std::abs((double)simdVisible - (double)scalarVisible) <= 5);
+
+    std::cout << "[OcclusionCulling] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region LOD selection
+
+void run_lod_selection_tests()
+{
+    JobPool pool(3);
+    const float thresholds[3] = { 0.5f, 0.2f, 0.05f };
+    const Matrix4f proj = Matrix4f::perspective(1.0f, 1.0f, 0.1f, 1000.0f);
+    const float p11 = proj(1, 1);
+    const Matrix4f view = Matrix4f::identity();
+
+    // Radius 1 straight ahead at the distance giving a coverage.
+    auto at = [&](float coverage) { return Vector3f(0, 0, -p11 / coverage); };
+
+    LodSelector lods(thresholds, 3, 0.1f);
+    uint32_t near = lods.add(at(0.9f), 1), mid = lods.add(at(0.35f), 1), far = lods.add(at(0.09f), 1);
+    uint32_t tiny = lods.add(at(0.01f), 1), inside = lods.add(Vector3f(0, 0, 0), 1);
+    lods.select(view, proj, pool);
+    assert(lods.lod(near) == 0 && lods.lod(mid) == 1 && lods.lod(far) == 2 && lods.lod(tiny) == 3 && lods.lod(inside) == 0);
+    assert(lods.stats().instances == 5 && lods.stats().changed == 4); // new instances start dropped
+    size_t n;
+    const uint32_t* list = lods.instances(0, n);
+    assert(n == 2 && list[0] == near && list[1] == inside);
+    list = lods.instances(3, n);
+    assert(n == 1 && list[0] == tiny);
+
+    // Hysteresis around the 0.5 threshold: hold LOD 0 down to 0.45, then
+    // hold LOD 1 up to 0.55.
+    for (auto step : { std::make_pair(0.48f, 0), std::make_pair(0.44f, 1), std::make_pair(0.52f, 1), std::make_pair(0.56f, 0) })
+    {
+        lods.setSphere(near, at(step.first), 1);
+        lods.select(view, proj, pool);
+        assert(lods.lod(near) == step.second);
+    }
+    assert(lods.stats().changed == 1);
+
+    // The eye comes from the view matrix: moving the camera back drops a level.
+    lods.select(Matrix4f::translate(0, 0, -p11 / 0.3f), proj, pool);
+    assert(lods.lod(mid) == 2);
+
+    // Random instances: identical for any thread count; tiers agree up to a
+    // few spheres sitting right on a threshold.
+    std::mt19937 rng(43);
+    std::uniform_real_distribution<float> pos(-500, 500), rad(0.2f, 5.0f);
+    LodSelector a(thresholds, 3), b(thresholds, 3), c(thresholds, 3);
+    for (int i = 0; i < 50001; ++i)
+    {
+        Vector3f p(pos(rng), pos(rng) * 0.1f, pos(rng));
+        float r = rad(rng);
+        a.add(p, r); b.add(p, r); c.add(p, r);
+    }
+    JobPool single(1);
+    Matrix4f cam = Matrix4f::rotateY(0.3f) * Matrix4f::translate(10, -2, 30);
+    SimdDispatch::forceTier(SimdTier::Scalar);
+    a.select(cam, proj, single);
+    b.select(cam, proj, pool);
+    SimdDispatch::resetTier();
+    c.select(cam, proj, pool);
+    size_t total = 0, differ = 0;
+    for (int l = 0; l <= 3; ++l)
+    {
+        size_t na, nb;
+        const uint32_t* la = a.instances(l, na);
+        const uint32_t* lb = b.instances(l, nb);
+        assert(na == nb && std::equal(la, la + na, lb) && std::is_sorted(la, la + na));
+        for (size_t k = 0; k < na; ++k) assert(a.lod(la[k]) == l);
+        total += na;
+    }
+    assert(total == a.size());
+    for (uint32_t i = 0; i < a.size(); ++i) differ += a.lod(i) != c.lod(i);
+    assert(differ <= 5);
+
+    std::cout << "[LodSelection] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Mesh simplification
+
+// n x n quads over [0, 1]^2 in the xz plane, height from f.
+template<typename F>
+static void gridMesh(int n, F height, std::vector<Vector3f>& verts, std::vector<uint32_t>& indices)
+{
+    verts.clear(); indices.clear();
+    for (int j = 0; j <= n; ++j)
+        for (int i = 0; i <= n; ++i)
+        {
+            float x = (float)i / n, z = (float)j / n;
+            verts.push_back(Vector3f(x, height(x, z), z));
+        }
+    for (int j = 0; j < n; ++j)
+        for (int i = 0; i < n; ++i)
+        {
+            uint32_t a = j * (n + 1) + i, b = a + 1, c = a + n + 1, d = c + 1;
+            indices.insert(indices.end(), { a, c, b, b, c, d });
+        }
+}
+
+// Unit UV sphere: poles plus (rings - 1) rings of `segments` vertices,
+// counter-clockwise from outside.
+static void sphereMesh(int rings, int segments, std::vector<Vector3f>& verts, std::vector<uint32_t>& indices)
+{
+    verts.clear(); indices.clear();
+    verts.push_back(Vector3f(0, 1, 0));
+    for (int r = 1; r < rings; ++r)
+        for (int s = 0; s < segments; ++s)
+        {
+            float phi = 3.14159265f * r / rings, theta = 6.2831853f * s / segments;
+            verts.push_back(Vector3f(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta)));
+        }
+    verts.push_back(Vector3f(0, -1, 0));
+    auto ringVertex = [&](int r, int s) { return (uint32_t)(1 + (r - 1) * segments + s % segments); };
+    const uint32_t south = (uint32_t)verts.size() - 1;
+    for (int s = 0; s < segments; ++s)
+    {
+        indices.insert(indices.end(), { 0, ringVertex(1, s + 1), ringVertex(1, s) });
+        for (int r = 1; r < rings - 1; ++r)
+        {
+            uint32_t a = ringVertex(r, s), b = ringVertex(r, s + 1), c = ringVertex(r + 1, s), d = ringVertex(r + 1, s + 1);
+            indices.insert(indices.end(), { a, b, c, b, d, c });
+        }
+        indices.insert(indices.end(), { south, ringVertex(rings - 1, s), ringVertex(rings - 1, s + 1) });
+    }
+}
+
+void run_mesh_simplify_tests()
+{
+    std::vector<Vector3f> verts;
+    std::vector<uint32_t> indices;
+    MeshSimplifier simplifier;
+    SimplifyOptions options;
+    SimplifyResult res;
+    auto normal = [&](size_t t) {
+        const Vector3f &a = verts[indices[t * 3]], &b = verts[indices[t * 3 + 1]], &c = verts[indices[t * 3 + 2]];
+        return (b + a * -1).cross(c + a * -1);
+    };
+
+    // A flat open grid reduces to a handful of triangles with no error, and
+    // its outline survives: border planes keep the corners and edges.
+    gridMesh(16, [](float, float) { return 0.0f; }, verts, indices);
+    options.maxError = 1e-3f;
+    size_t n = simplifier.simplify(verts.data(), verts.size(), indices.data(), indices.size() / 3, options, &res);
+    assert(n < 16 && res.error < 1e-3f && res.collapses > 0 && res.passes > 0);
+    float area = 0;
+    for (size_t t = 0; t < n; ++t)
+    {
+        assert(normal(t).y > 0);  // same winding as the input
+        area += normal(t).y / 2;
+    }
+    assert(std::abs(area - 1) < 1e-4f);
+
+    // Locked borders: every border vertex is still referenced.
+    gridMesh(16, [](float, float) { return 0.0f; }, verts, indices);
+    options.lockBorder = true;
+    n = simplifier.simplify(verts.data(), verts.size(), indices.data(), indices.size() / 3, options, &res);
+    std::vector<uint8_t> used(verts.size(), 0);
+    for (size_t k = 0; k < n * 3; ++k) used[indices[k]] = 1;
+    for (int i = 0; i <= 16; ++i)
+        assert(used[i] && used[16 * 17 + i] && used[i * 17] && used[i * 17 + 16]);
+    assert(n >= 62 && n < 512);
+    options.lockBorder = false;
+    options.maxError = std::numeric_limits<float>::infinity();
+
+    // Closed sphere at a quarter of its triangles: small error, normals
+    // still point outward.
+    sphereMesh(24, 48, verts, indices);
+    const size_t sphereTriangles = indices.size() / 3;
+    std::vector<uint32_t> sphere = indices;
+    options.targetTriangles = sphereTriangles / 4;
+    n = simplifier.simplify(verts.data(), verts.size(), indices.data(), sphereTriangles, options, &res);
+    assert(n <= sphereTriangles / 4 && n > sphereTriangles / 8 && res.error > 0 && res.error < 0.05f);
+    for (size_t t = 0; t < n; ++t)
+        assert(normal(t).dot(verts[indices[t * 3]] + verts[indices[t * 3 + 1]] + verts[indices[t * 3 + 2]]) > 0);
+
+    // The error limit stops it early, and tighter limits keep more.
+    size_t previous = 0;
+    for (float limit : { 0.02f, 0.005f, 0.001f })
+    {
+        indices = sphere;
+        options.targetTriangles = 0;
+        options.maxError = limit;
+        n = simplifier.simplify(verts.data(), verts.size(), indices.data(), sphereTriangles, options, &res);
+        assert(res.error <= limit && n > previous);
+        previous = n;
+    }
+    options.maxError = std::numeric_limits<float>::infinity();
+
+    // Batch: jobs on a pool match one simplifier run job by job.
+    std::mt19937 rng(44);
+    std::uniform_real_distribution<float> bump(-0.01f, 0.01f);
+    std::vector<std::vector<Vector3f>> meshVerts(7);
+    std::vector<std::vector<uint32_t>> meshIndices(7), expected(7);
+    std::vector<SimplifyJob> jobs(7);
+    for (int m = 0; m < 7; ++m)
+    {
+        gridMesh(8 + m * 2, [&](float, float) { return bump(rng); }, meshVerts[m], meshIndices[m]);
+        expected[m] = meshIndices[m];
+        options.targetTriangles = meshIndices[m].size() / 3 / 3;
+        options.lockBorder = m % 2 == 0;
+        n = simplifier.simplify(meshVerts[m].data(), meshVerts[m].size(), expected[m].data(), expected[m].size() / 3, options);
+        expected[m].resize(n * 3);
+        jobs[m] = { meshVerts[m].data(), meshVerts[m].size(), meshIndices[m].data(), meshIndices[m].size() / 3, options, {} };
+    }
+    JobPool pool(3);
+    simplifyMeshes(jobs.data(), jobs.size(), pool);
+    for (int m = 0; m < 7; ++m)
+    {
+        assert(jobs[m].result.triangles * 3 == expected[m].size());
+        assert(std::equal(expected[m].begin(), expected[m].end(), meshIndices[m].begin()));
+    }
+
+    std::cout << "[MeshSimplify] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Vertex cache
+
+// Triangles rotated to start at their smallest index, then sorted: equal
+// for two index buffers holding the same triangles with the same winding.
+static std::vector<std::array<uint32_t, 3>> canonicalTriangles(const std::vector<uint32_t>& indices)
+{
+    std::vector<std::array<uint32_t, 3>> tris;
+    for (size_t t = 0; t < indices.size(); t += 3)
+    {
+        std::array<uint32_t, 3> tri = { indices[t], indices[t + 1], indices[t + 2] };
+        std::rotate(tri.begin(), std::min_element(tri.begin(), tri.end()), tri.end());
+        tris.push_back(tri);
+    }
+    std::sort(tris.begin(), tris.end());
+    return tris;
+}
+
+void run_vertex_cache_tests()
+{
+    // FIFO replay: a hit refreshes nothing, so 0 falls out after 3 misses.
+    const uint32_t fifo[] = { 0, 1, 2, 3, 0, 1 };
+    VertexCacheStats s = analyzeVertexCache(fifo, 6, 4, 3);
+    assert(s.triangles == 2 && s.vertices == 4 && s.transformed == 6 && s.acmr == 3 && s.atvr == 1.5f);
+    s = analyzeVertexCache(fifo, 6, 4, 4);
+    assert(s.transformed == 4 && s.acmr == 2 && s.atvr == 1);
+
+    // Shuffled grid: triangles and their starting corners scrambled.
+    std::vector<Vector3f> verts;
+    std::vector<uint32_t> grid;
+    const int n = 64;
+    gridMesh(n, [](float x, float z) { return std::sin(x * 7) * std::cos(z * 5); }, verts, grid);
+    std::mt19937 rng(45);
+    std::vector<uint32_t> shuffled(grid.size());
+    std::vector<size_t> order(grid.size() / 3);
+    for (size_t t = 0; t < order.size(); ++t) order[t] = t;
+    std::shuffle(order.begin(), order.end(), rng);
+    for (size_t t = 0; t < order.size(); ++t)
+    {
+        int r = (int)(rng() % 3);
+        for (int k = 0; k < 3; ++k) shuffled[t * 3 + k] = grid[order[t] * 3 + (k + r) % 3];
+    }
+    VertexCacheStats before = analyzeVertexCache(shuffled.data(), shuffled.size(), verts.size());
+    assert(before.vertices == verts.size() && before.acmr > 2.5f);
+
+    std::vector<uint32_t> optimized(shuffled.size());
+    optimizeVertexCache(optimized.data(), shuffled.data(), shuffled.size(), verts.size());
+    assert(canonicalTriangles(optimized) == canonicalTriangles(grid));
+    VertexCacheStats after = analyzeVertexCache(optimized.data(), optimized.size(), verts.size());
+    assert(after.acmr < 0.8f && after.atvr < 1.6f);
+
+    // Overdraw order: same triangles, reordered, and ACMR within the
+    // threshold (plus slack for the seams between clusters).
+    std::vector<uint32_t> drawOrder(optimized.size());
+    optimizeOverdraw(drawOrder.data(), optimized.data(), optimized.size(), verts.data(), verts.size(), 1.05f);
+    assert(drawOrder != optimized && canonicalTriangles(drawOrder) == canonicalTriangles(grid));
+    assert(analyzeVertexCache(drawOrder.data(), drawOrder.size(), verts.size()).acmr < after.acmr * 1.1f);
+
+    // Fetch order: first use numbers vertices 0, 1, 2, ... and unused ones
+    // are dropped.
+    verts.push_back(Vector3f(9, 9, 9));
+    std::vector<uint32_t> remap(verts.size()), fetch(drawOrder.size());
+    size_t kept = optimizeVertexFetchRemap(remap.data(), drawOrder.data(), drawOrder.size(), verts.size());
+    assert(kept == verts.size() - 1 && remap.back() == UINT32_MAX);
+    remapIndices(fetch.data(), drawOrder.data(), drawOrder.size(), remap.data());
+    std::vector<Vector3f> fetchVerts(kept);
+    remapVertices(fetchVerts.data(), verts.data(), verts.size(), remap.data());
+    uint32_t highest = 0;
+    for (size_t i = 0; i < fetch.size(); ++i)
+    {
+        assert(fetch[i] <= highest + (i > 0));
+        highest = std::max(highest, fetch[i]);
+        assert(fetchVerts[fetch[i]] == verts[drawOrder[i]]);
+    }
+    assert(analyzeVertexCache(fetch.data(), fetch.size(), kept).transformed ==
+           analyzeVertexCache(drawOrder.data(), drawOrder.size(), verts.size()).transformed);
+
+    std::cout << "[VertexCache] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Mesh normals
+
+void run_mesh_normals_tests()
+{
+    std::vector<Vector3f> verts, normals, reference;
+    std::vector<uint32_t> indices;
+    NormalGenerator gen;
+    JobPool pool(3), single(1);
+
+    // Sphere: every weighting points along the position; identical across
+    // thread counts, close across tiers.
+    sphereMesh(48, 96, verts, indices);
+    gen.setTopology(indices.data(), indices.size() / 3, verts.size());
+    normals.resize(verts.size());
+    for (NormalWeighting w : { NormalWeighting::Uniform, NormalWeighting::Area, NormalWeighting::Angle })
+    {
+        gen.computeNormals(verts.data(), normals.data(), w, pool);
+        for (size_t v = 0; v < verts.size(); ++v) assert(normals[v].dot(verts[v]) > 0.999f);
+        reference = normals;
+        gen.computeNormals(verts.data(), normals.data(), w, single);
+        assert(normals == reference);
+        SimdDispatch::forceTier(SimdTier::Scalar);
+        gen.computeNormals(verts.data(), normals.data(), w, pool);
+        SimdDispatch::resetTier();
+        for (size_t v = 0; v < verts.size(); ++v) assert(near3(normals[v], reference[v], 1e-4f));
+    }
+    assert(gen.stats().faceMs >= 0 && gen.stats().vertexMs >= 0);
+
+    // Cube corners: angle weighting gives the diagonal however the faces
+    // are split; area weighting leans toward faces cut at that corner.
+    verts.clear();
+    for (int i = 0; i < 8; ++i) verts.push_back(Vector3f(i & 1 ? 1.f : -1.f, i & 2 ? 1.f : -1.f, i & 4 ? 1.f : -1.f));
+    indices = { 0, 2, 1, 1, 2, 3,  4, 5, 6, 5, 7, 6,  0, 1, 4, 1, 5, 4,
+                2, 6, 3, 3, 6, 7,  0, 4, 2, 2, 4, 6,  1, 3, 5, 3, 7, 5 };
+    gen.setTopology(indices.data(), 12, 8);
+    normals.resize(8);
+    for (SimdTier tier : { SimdTier::Scalar, SimdTier::AVX2 })
+    {
+        SimdDispatch::forceTier(tier);
+        gen.computeNormals(verts.data(), normals.data(), NormalWeighting::Angle, single);
+        for (int v = 0; v < 8; ++v) assert(near3(normals[v], verts[v] * (1 / std::sqrt(3.0f)), 1e-4f));
+    }
+    SimdDispatch::resetTier();
+    gen.computeNormals(verts.data(), normals.data(), NormalWeighting::Area, single);
+    assert(!near3(normals[1], verts[1] * (1 / std::sqrt(3.0f)), 1e-2f));
+
+    // Tangents on a bumpy grid with u = x, v = z: T follows +x, and since
+    // cross(N, T) = -z there, the sign is -1. Mirroring u flips T and the sign.
+    std::vector<Vector2f> uvs;
+    gridMesh(32, [](float x, float z) { return 0.05f * std::sin(x * 6) * std::cos(z * 4); }, verts, indices);
+    for (const Vector3f& p : verts) uvs.push_back(Vector2f(p.x, p.z));
+    gen.setTopology(indices.data(), indices.size() / 3, verts.size());
+    normals.resize(verts.size());
+    std::vector<Vector4f> tangents(verts.size());
+    gen.computeNormals(verts.data(), normals.data(), NormalWeighting::Angle, pool);
+    gen.computeTangents(verts.data(), normals.data(), uvs.data(), tangents.data(), pool);
+    for (size_t v = 0; v < verts.size(); ++v)
+    {
+        Vector3f t = tangents[v].xyz();
+        assert(std::abs(t.length() - 1) < 1e-4f && std::abs(t.dot(normals[v])) < 1e-4f);
+        assert(t.x > 0.95f && tangents[v].w == -1);
+    }
+    std::vector<Vector4f> serial(verts.size());
+    gen.computeTangents(verts.data(), normals.data(), uvs.data(), serial.data(), single);
+    for (size_t v = 0; v < verts.size(); ++v) assert(serial[v] == tangents[v]);
+
+    for (Vector2f& uv : uvs) uv.x = 1 - uv.x;
+    gen.computeTangents(verts.data(), normals.data(), uvs.data(), tangents.data(), pool);
+    for (size_t v = 0; v < verts.size(); ++v) assert(tangents[v].x < -0.95f && tangents[v].w == 1);
+
+    // A face with a zero-length edge but valid, mirrored UVs shares vertex 0
+    // with a regular face. Its corner angles are zero on both tiers, so it
+    // neither steers that vertex's tangent nor flips its sign. Eight faces,
+    // so the SIMD kernel sees it.
+    verts = { Vector3f(0, 0, 0), Vector3f(1, 0, 0), Vector3f(0, 1, 0), Vector3f(0, 0, 0), Vector3f(0, 1, 0) };
+    uvs = { Vector2f(0, 0), Vector2f(1, 0), Vector2f(0, 1), Vector2f(0, 1), Vector2f(1, 0) };
+    indices = { 0, 1, 2,  0, 3, 4 };
+    for (uint32_t f = 2; f < 8; ++f)
+    {
+        uint32_t first = (uint32_t)verts.size();
+        Vector3f o(float(f) * 3, 0, 0);
+        verts.insert(verts.end(), { o, o + Vector3f(1, 0, 0), o + Vector3f(0, 1, 0) });
+        uvs.insert(uvs.end(), { Vector2f(0, 0), Vector2f(1, 0), Vector2f(0, 1) });
+        indices.insert(indices.end(), { first, first + 1, first + 2 });
+    }
+    gen.setTopology(indices.data(), 8, verts.size());
+    normals.assign(verts.size(), Vector3f(0, 0, 1));
+    tangents.resize(verts.size());
+    serial.resize(verts.size());
+    SimdDispatch::forceTier(SimdTier::Scalar);
+    gen.computeTangents(verts.data(), normals.data(), uvs.data(), serial.data(), single);
+    SimdDispatch::resetTier();
+    gen.computeTangents(verts.data(), normals.data(), uvs.data(), tangents.data(), single);
+    for (size_t v = 0; v < verts.size(); ++v)
+        assert(near3(tangents[v].xyz(), serial[v].xyz(), 1e-4f) && tangents[v].w == serial[v].w);
+    assert(near3(tangents[0].xyz(), Vector3f(1, 0, 0), 1e-4f) && tangents[0].w == 1);
+
+    std::cout << "[MeshNormals] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Vertex quantization
+
+void run_vertex_quantization_tests()
+{
+    // binary16: every half survives a round trip, and the bulk (F16C) and
+    // scalar conversions agree bit for bit.
+    std::vector<uint16_t> halves(65536), bulk(65536);
+    std::vector<float> floats(65536), bulkFloats(65536);
+    for (uint32_t h = 0; h < 65536; ++h) halves[h] = (uint16_t)h;
+    halvesToFloats(halves.data(), bulkFloats.data(), halves.size());
+    for (uint32_t h = 0; h < 65536; ++h)
+    {
+        floats[h] = halfToFloat((uint16_t)h);
+        if (std::isnan(floats[h])) { assert(std::isnan(bulkFloats[h])); continue; }
+        assert(std::memcmp(&floats[h], &bulkFloats[h], 4) == 0 && floatToHalf(floats[h]) == h);
+    }
+    assert(floatToHalf(1.0f) == 0x3c00 && floatToHalf(-2.0f) == 0xc000 && halfToFloat(0x3555) == 0.333251953125f);
+    assert(floatToHalf(1 + std::ldexp(1.0f, -11)) == 0x3c00 && floatToHalf(1 + 3 * std::ldexp(1.0f, -11)) == 0x3c02);
+    assert(floatToHalf(65519.0f) == 0x7bff && floatToHalf(65520.0f) == 0x7c00 && floatToHalf(-1e30f) == 0xfc00);
+    assert(floatToHalf(std::ldexp(1.0f, -24)) == 0x0001 && floatToHalf(std::ldexp(1.0f, -25)) == 0 &&
+           floatToHalf(std::ldexp(1.5f, -25)) == 0x0001 && floatToHalf(-0.0f) == 0x8000);
+    assert(std::isnan(halfToFloat(floatToHalf(std::numeric_limits<float>::quiet_NaN()))));
+
+    std::mt19937 rng(47);
+    std::uniform_int_distribution<uint32_t> bits;
+    for (float& f : floats)
+        do { uint32_t b = bits(rng); std::memcpy(&f, &b, 4); } while (std::isnan(f));
+    floatsToHalves(floats.data(), bulk.data(), floats.size());
+    for (size_t i = 0; i < floats.size(); ++i) assert(bulk[i] == floatToHalf(floats[i]));
+
+    // Vertex streams; 1003 vertices so the scalar tails run too.
+    const size_t n = 1003;
+    std::uniform_real_distribution<float> coord(-1, 1);
+    std::vector<Vector3f> positions(n), normals(n), decoded(n);
+    std::vector<Vector2f> uvs(n), decodedUvs(n);
+    AABBf bounds(Vector3f(-50, 0, 10), Vector3f(150, 20, 11));
+    for (size_t i = 0; i < n; ++i)
+    {
+        positions[i] = Vector3f(50 + 100 * coord(rng), 10 + 10 * coord(rng), 10.5f + 0.5f * coord(rng));
+        do normals[i] = Vector3f(coord(rng), coord(rng), coord(rng)); while (normals[i].lengthSquared() < 1e-4f);
+        normals[i] = normals[i].normalized();
+        uvs[i] = Vector2f(2 * coord(rng), 0.5f + 0.5f * coord(rng));
+    }
+    normals[0] = Vector3f(0, 0, -1);
+    normals[1] = Vector3f(1, 0, 0);
+    normals[2] = Vector3f(0, -1, 0);
+    positions[3] = Vector3f(1000, -1000, 10.25f);  // outside: clamped
+
+    std::vector<uint16_t> h3(n * 3), uv16[2];
+    std::vector<int16_t> snorm[2], oct[2];
+    const Vector3f posError = snorm16PositionError(bounds);
+    const Vector2f uvMin(-2, 0), uvMax(2, 1), uvError = unorm16UvError(uvMin, uvMax);
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        if (pass == 0) SimdDispatch::forceTier(SimdTier::Scalar);
+        else SimdDispatch::resetTier();
+
+        encodeHalf3(positions.data(), h3.data(), n);
+        decodeHalf3(h3.data(), decoded.data(), n);
+        for (size_t i = 0; i < n; ++i)
+            assert(near3(decoded[i], positions[i], positions[i].length() * std::ldexp(1.0f, -11)));
+
+        snorm[pass].resize(n * 3);
+        encodeSnorm16(positions.data(), snorm[pass].data(), n, bounds);
+        decodeSnorm16(snorm[pass].data(), decoded.data(), n, bounds);
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (i == 3) { assert(near3(decoded[i], Vector3f(150, 0, 10.25f), 1e-3f)); continue; }
+            assert(std::abs(decoded[i].x - positions[i].x) <= posError.x * 1.01f);
+            assert(std::abs(decoded[i].y - positions[i].y) <= posError.y * 1.01f);
+            assert(std::abs(decoded[i].z - positions[i].z) <= posError.z * 1.01f);
+        }
+
+        oct[pass].resize(n * 2);
+        encodeOct16(normals.data(), oct[pass].data(), n);
+        decodeOct16(oct[pass].data(), decoded.data(), n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            assert(std::abs(decoded[i].length() - 1) < 1e-5f);
+            assert(std::atan2(decoded[i].cross(normals[i]).length(), decoded[i].dot(normals[i])) < 7e-5f);
+        }
+        assert(decoded[0] == Vector3f(0, 0, -1) && decoded[1] == Vector3f(1, 0, 0) && decoded[2] == Vector3f(0, -1, 0));
+
+        uv16[pass].resize(n * 2);
+        encodeUnorm16(uvs.data(), uv16[pass].data(), n, uvMin, uvMax);
+        decodeUnorm16(uv16[pass].data(), decodedUvs.data(), n, uvMin, uvMax);
+        for (size_t i = 0; i < n; ++i)
+            assert(std::abs(decodedUvs[i].x - uvs[i].x) <= uvError.x * 1.01f && std::abs(decodedUvs[i].y - uvs[i].y) <= uvError.y * 1.01f);
+    }
+    // Encoders agree across tiers up to a rounding tie.
+    for (size_t i = 0; i < n * 3; ++i) assert(std::abs(snorm[0][i] - snorm[1][i]) <= 1);
+    for (size_t i = 0; i < n * 2; ++i) assert(std::abs(oct[0][i] - oct[1][i]) <= 1 && std::abs(uv16[0][i] - uv16[1][i]) <= 1);
+
+    // Zero normals (a full SIMD block and a scalar tail) encode as +Z on both tiers.
+    std::vector<Vector3f> zeros(9, Vector3f());
+    zeros[4] = Vector3f(0, 0, -0.0f);
+    for (SimdTier tier : { SimdTier::Scalar, SimdTier::AVX2 })
+    {
+        SimdDispatch::forceTier(tier);
+        std::vector<int16_t> packed(zeros.size() * 2, 99);
+        encodeOct16(zeros.data(), packed.data(), zeros.size());
+        for (int16_t q : packed) assert(q == 0);
+        decodeOct16(packed.data(), decoded.data(), 1);
+        assert(decoded[0] == Vector3f(0, 0, 1));
+    }
+    SimdDispatch::resetTier();
+
+    std::cout << "[VertexQuantization] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Half vectors
+
+void run_half_vector_tests()
+{
+    // Storage is the raw binary16 bits; arithmetic happens in float.
+    static_assert(sizeof(half) == 2 && sizeof(Vector2h) == 4 && sizeof(Matrix4h) == 32, "half storage");
+    half h = 1.5f;
+    assert(h.bits == 0x3e00 && float(h) == 1.5f && half::fromBits(0x3555) == 0.333251953125f);
+    h += 0.25f;
+    h *= 2;
+    assert(h == 3.5f && -h == -3.5f && h > 3 && half(0.1f) != 0.1f);
+    assert(half(1e5f).bits == 0x7c00);
+
+    Vector3h v(3, 4, 12);
+    assert(Vector3h() == Vector3h::zeros() && Vector3h::up().y == 1.0f);
+    assert(v.lengthSquared() == 169.0f && v.length() == 13.0f);
+    Vector3h u = v.normalized();
+    assert(std::abs(u.length() - 1) < 1e-3f && std::abs(u.z - 12.0f / 13) < 1e-3f);
+    assert(v.cross(Vector3h(1, 0, 0)) == Vector3h(0, 12, -4));
+    assert(std::abs(Vector3h(1, 0, 0).angleBetween(Vector3h(0, 1, 0)) - 1.5707963f) < 1e-3f);
+    v += Vector3h(1, 1, 1);
+    v *= 0.5f;
+    assert(v == Vector3h(2, 2.5f, 6.5f));
+
+    // Each product sums in float and rounds once: 2049 is not a half, but the dot is.
+    assert(Vector3h(2048, 1, 0).dot(Vector3h(1, 1, 0)) == 2048.0f);
+    assert(Vector2h(3, 4).length() == 5.0f && std::abs(Vector2h(0, 1).angle() - 1.5707963f) < 1e-3f);
+    assert(Vector2h() == Vector2h::zeros() && Vector2h::ones().x == 1.0f);
+
+    Matrix4h m = Matrix4h::translate(1, 2, 3) * Matrix4h::rotateZ(1.5707963f) * Matrix4h::scale(2, 2, 2);
+    Vector3h p = m * Vector3h(1, 0, 0);
+    assert(std::abs(p.x - 1) < 1e-2f && std::abs(p.y - 4) < 1e-2f && p.z == 3.0f);
+    Vector3h back = m.inverseTRS() * p;
+    assert(std::abs(back.x - 1) < 1e-2f && std::abs(back.y) < 1e-2f && std::abs(back.z) < 1e-2f);
+    std::ostringstream os;
+    os << Vector3h(0.5f, -2, 1024);
+    assert(os.str() == "(0.5, -2, 1024)");
+
+    // Bulk pack/unpack equals per-element rounding on both tiers; 1001
+    // vectors leave a scalar tail after the 8-wide blocks.
+    const size_t n = 1001;
+    std::mt19937 rng(48);
+    std::uniform_real_distribution<float> coord(-1000, 1000);
+    std::vector<Vector3f> in(n), out(n);
+    for (auto& x : in) x = Vector3f(coord(rng), coord(rng) * 1e-3f, coord(rng) * 1e-6f);
+    std::vector<Vector3h> packed(n);
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        if (pass == 0) SimdDispatch::forceTier(SimdTier::Scalar);
+        else SimdDispatch::resetTier();
+        packHalf(in.data(), packed.data(), n);
+        unpackHalf(packed.data(), out.data(), n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            assert(packed[i].x.bits == floatToHalf(in[i].x) && packed[i].y.bits == floatToHalf(in[i].y) &&
+                   packed[i].z.bits == floatToHalf(in[i].z));
+            assert(out[i] == Vector3f(packed[i].x, packed[i].y, packed[i].z));
+        }
+    }
+
+    std::cout << "[HalfVector] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Fixed point
+
+void run_fixed_point_tests()
+{
+    // Q16.16 basics on raw bits.
+    Fixed16 a = 3, b(0.25);
+    assert(a.raw == 3 << 16 && b.raw == 1 << 14 && Fixed16::fromRaw(-1).raw == -1);
+    assert((a + b).raw == 0x34000 && (a - b) == Fixed16(2.75) && (b - a) == Fixed16(-2.75));
+    assert(a * b == Fixed16(0.75) && a / b == 12 && -a / b == -12 && (a * -b).raw == -(3 << 14));
+    assert(Fixed16::fromRaw(1) * Fixed16(0.5) == Fixed16::fromRaw(1));      // half up
+    assert(Fixed16::fromRaw(-1) * Fixed16(0.5) == Fixed16::fromRaw(0));
+    assert(Fixed16(1) / 3 == Fixed16::fromRaw(21845) && Fixed16(-1) / 3 == Fixed16::fromRaw(-21845));
+    assert(a / 0 == Fixed16::fromRaw(INT32_MAX) && -a / 0 == Fixed16::fromRaw(INT32_MIN));
+    assert(Fixed16(32767) + 1 == Fixed16(-32768));                        // wraps
+    assert(int(Fixed16(-2.5)) == -3 && float(Fixed16(-2.5)) == -2.5f && abs(Fixed16(-2)) == 2);
+    Fixed16 c = 1;
+    c += 2; c *= 4; c -= 1; c /= 2;
+    assert(c == Fixed16(5.5) && c > 5 && c <= Fixed16(5.5) && c != 6);
+
+    // Wide products and quotients: the portable kernels match __int128.
+    std::mt19937_64 rng(49);
+    for (int i = 0; i < 20000; ++i)
+    {
+        int64_t x = (int64_t)rng(), y = (int64_t)rng();
+        if (i % 3 == 1) y >>= 30;
+        if (i % 3 == 2) { x >>= 20; y >>= 40; }
+        if (y == 0) y = 1;
+        int64_t hi;
+        uint64_t lo;
+        fixed::mulWide(x, y, hi, lo);
+#if defined(__SIZEOF_INT128__)
+        const __int128 p = (__int128)x * y;
+        assert(hi == (int64_t)(p >> 64) && lo == (uint64_t)p);
+        assert(fixed::mulShiftPortable(x, y, 32) == fixed::mulShift(x, y, 32));
+        assert(fixed::divShiftPortable(x, y, 32) == fixed::divShift(x, y, 32));
+#endif
+    }
+    assert(Fixed32(1) / 3 * 3 == Fixed32::fromRaw((int64_t(1) << 32) - 1));
+    assert(Fixed32(1 << 20) * Fixed32(1 << 10) == Fixed32(int64_t(1) << 30));
+    assert(Fixed32(-7.5) / Fixed32(2.5) == -3 && Fixed32(1e-9) * Fixed32(1e-9) == 0);
+
+    // sqrt is the correctly rounded root.
+    assert(sqrt(Fixed16(16)) == 4 && sqrt(Fixed16(2)) == Fixed16::fromRaw(92682) && sqrt(Fixed16(-1)) == 0);
+    assert(sqrt(Fixed32(int64_t(1) << 30)) == Fixed32(1 << 15) && sqrt(Fixed32(2)) == Fixed32::fromRaw(6074001000));
+    for (int32_t r = 1; r < 1 << 30; r += 7919 * 13)
+    {
+        const double exact = std::sqrt((double)r * 65536);
+        assert(std::abs((double)sqrt(Fixed16::fromRaw(r)).raw - exact) <= 0.5);
+    }
+
+    // Trig: CORDIC within a few ulp of the libm value at either precision.
+    for (double x = -20; x <= 20; x += 0.0137)
+    {
+        assert(std::abs((double)sin(Fixed16(x)) - std::sin((double)Fixed16(x))) < 4e-5);
+        assert(std::abs((double)cos(Fixed16(x)) - std::cos((double)Fixed16(x))) < 4e-5);
+        assert(std::abs((double)sin(Fixed32(x)) - std::sin(x)) < 1e-8);
+        assert(std::abs((double)cos(Fixed32(x)) - std::cos(x)) < 1e-8);
+        const double y = std::sin(x * 3.1) * 1000, z = std::cos(x * 1.7) * 0.001;
+        assert(std::abs((double)atan2(Fixed32(y), Fixed32(x)) - std::atan2((double)Fixed32(y), (double)Fixed32(x))) < 1e-8);
+        assert(std::abs((double)atan2(Fixed32(z), Fixed32(x)) - std::atan2((double)Fixed32(z), (double)Fixed32(x))) < 1e-8);
+        assert(std::abs((double)atan2(Fixed16(x), Fixed16(x * 0.3)) - std::atan2((double)Fixed16(x), (double)Fixed16(x * 0.3))) < 4e-5);
+    }
+    assert(atan2(Fixed16(0), Fixed16(-1)) == Fixed16::fromRaw(205887) && atan2(Fixed16(0), Fixed16(0)) == 0);
+    assert(std::abs((double)acos(Fixed32(0.5)) - std::acos(0.5)) < 1e-8 && acos(Fixed16(2)) == 0);
+    assert(std::abs((double)tan(Fixed32(1)) - std::tan(1.0)) < 1e-8);
+
+    // The vector and matrix templates instantiate unchanged.
+    Vector3x v(3, 4, 12);
+    assert(Vector3x() == Vector3x::zeros() && v.length() == 13 && v.dot(Vector3x::ones()) == 19);
+    assert(std::abs((double)v.normalized().z - 12.0 / 13) < 1e-4 && v.cross(Vector3x(1, 0, 0)) == Vector3x(0, 12, -4));
+    assert(std::abs((double)Vector3x(1, 0, 0).angleBetween(Vector3x(0, 1, 0)) - 1.5707963) < 1e-4);
+    Vector2x w(-1, 1);
+    assert(std::abs((double)w.angle() - 2.3561945) < 1e-4 && Vector2x(3, 4).length() == 5);
+    Matrix4x m = Matrix4x::translate(1, 2, 3) * Matrix4x::rotateZ(Fixed16(1.5707963)) * Matrix4x::scale(2, 2, 2);
+    Vector3x p = m * Vector3x(1, 0, 0);
+    assert(std::abs((double)p.x - 1) < 1e-4 && std::abs((double)p.y - 4) < 1e-4 && p.z == 3);
+    Vector3x back = m.inverseTRS() * p;
+    assert(std::abs((double)back.x - 1) < 1e-3 && std::abs((double)back.y) < 1e-3 && back.z == 0);
+    std::ostringstream os;
+    os << Vector3x(Fixed16(0.5), -2, 1024);
+    assert(os.str() == "(0.5, -2, 1024)");
+
+    // Lockstep: a short orbit simulation hashes to the same bits everywhere.
+    auto simulate = [](auto one) {
+        using T = decltype(one);
+        std::vector<Vector3<T>> pos, vel;
+        for (int i = 0; i < 64; ++i)
+        {
+            T t = T(i) / 64;
+            pos.push_back(Vector3<T>(cos(t * 6), sin(t * 6), t));
+            vel.push_back(Vector3<T>(-sin(t * 6), cos(t * 6), 0) * (T(1) / 8));
+        }
+        const T dt = T(1) / 60;
+        for (int step = 0; step < 600; ++step)
+            for (size_t i = 0; i < pos.size(); ++i)
+            {
+                const T r = pos[i].length();
+                vel[i] += pos[i] * (-dt / (r * r * r));
+                pos[i] += vel[i] * dt;
+            }
+        uint64_t h = 1469598103934665603ull;
+        for (const auto& q : pos)
+            for (T c : { q.x, q.y, q.z }) h = (h ^ (uint64_t)c.raw) * 1099511628211ull;
+        return h;
+    };
+    assert(simulate(Fixed16(1)) == 0x5d0310c28deb9c40ull && simulate(Fixed32(1)) == 0xb81ddebc4d22ca94ull);
+
+    std::cout << "[FixedPoint] Tests done\n";
+}
+
+#pragma endregion
+
+#pragma region Grid coordinates
+
+void run_grid_coords_tests()
+{
+    Vector3i a(1, -2, 5), b(-3, 4, 4);
+    assert(manhattan(a, b) == 11 && chebyshev(a, b) == 6 && a.lengthSquared() == 30 && Vector3i() == Vector3i(0, 0, 0));
+    assert(manhattan(Vector2i(0, 0), Vector2i(-3, 4)) == 7 && chebyshev(Vector2i(0, 0), Vector2i(-3, 4)) == 4);
+
+    // Floor division keeps tiles the same size on both sides of zero.
+    assert(floorDiv(7, 4) == 1 && floorDiv(-1, 4) == -1 && floorDiv(-4, 4) == -1 && floorDiv(-5, 4) == -2);
+    assert(floorMod(7, 4) == 3 && floorMod(-1, 4) == 3 && floorMod(-4, 4) == 0);
+    for (int c = -100; c <= 100; ++c) assert(floorDiv(c, 16) * 16 + floorMod(c, 16) == c && floorMod(c, 16) >= 0);
+    assert(tileOf(Vector3i(-1, 15, 16), 16) == Vector3i(-1, 0, 1) && cellInTile(Vector3i(-1, 15, 16), 16) == Vector3i(15, 15, 0));
+    assert(tileOf(Vector2i(-17, 3), 8) == Vector2i(-3, 0) && cellInTile(Vector2i(-17, 3), 8) == Vector2i(7, 3));
+
+    // Morton codes: known patterns, round trips, and Z-order for a 2x2 block.
+    assert(mortonEncode(Vector2i(1, 0)) == 1 && mortonEncode(Vector2i(0, 1)) == 2 && mortonEncode(Vector2i(3, 3)) == 15);
+    assert(mortonEncode(Vector3i(1, 1, 1)) == 7 && mortonEncode(Vector3i(0, 0, 2)) == 32);
+    assert(mortonEncode(Vector2i(-1, -1)) == ~0ull && mortonEncode(Vector3i(0x1fffff, 0x1fffff, 0x1fffff)) == (1ull << 63) - 1);
+    const size_t n = 1003;
+    std::mt19937 rng(50);
+    std::vector<Vector2i> c2(n), back2(n);
+    std::vector<Vector3i> c3(n), back3(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        c2[i] = Vector2i((int)(rng() & 0x7fffffff), (int)(rng() & 0x7fffffff));
+        c3[i] = Vector3i((int)(rng() & 0x1fffff), (int)(rng() & 0x1fffff), (int)(rng() & 0x1fffff));
+    }
+    std::vector<uint64_t> codes[2][2];
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        if (pass == 0) SimdDispatch::forceTier(SimdTier::Scalar);
+        else SimdDispatch::resetTier();
+        codes[pass][0].resize(n);
+        codes[pass][1].resize(n);
+        mortonEncode(c2.data(), codes[pass][0].data(), n);
+        mortonEncode(c3.data(), codes[pass][1].data(), n);
+        mortonDecode(codes[pass][0].data(), back2.data(), n);
+        mortonDecode(codes[pass][1].data(), back3.data(), n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            assert(back2[i] == c2[i] && back3[i] == c3[i]);
+            assert(codes[pass][0][i] == mortonEncode(c2[i]) && mortonDecode2(codes[pass][0][i]) == c2[i]);
+            assert(codes[pass][1][i] == mortonEncode(c3[i]) && mortonDecode3(codes[pass][1][i]) == c3[i]);
+        }
+    }
+    assert(codes[0][0] == codes[1][0] && codes[0][1] == codes[1][1]);
+
+    // Points to cells: exact agreement across tiers, negative cells floor,
+    // indices clamp to the grid.
+    Grid3 g3{ Vector3f(-10, 0, 5), 0.5f, Vector3i(40, 8, 16) };
+    Grid2 g2{ Vector2f(-10, 0), 0.25f, Vector2i(64, 32) };
+    std::uniform_real_distribution<float> coord(-12, 12);
+    std::vector<Vector3f> p3(n);
+    std::vector<Vector2f> p2(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        p3[i] = Vector3f(coord(rng), coord(rng), coord(rng));
+        p2[i] = Vector2f(coord(rng), coord(rng));
+    }
+    p3[0] = Vector3f(-10.25f, 0, 5.5f);
+    p2[0] = Vector2f(-10, -0.01f);
+    std::vector<Vector3i> cells3[2];
+    std::vector<Vector2i> cells2[2];
+    std::vector<uint32_t> idx3[2], idx2[2];
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        if (pass == 0) SimdDispatch::forceTier(SimdTier::Scalar);
+        else SimdDispatch::resetTier();
+        cells3[pass].resize(n); cells2[pass].resize(n); idx3[pass].resize(n); idx2[pass].resize(n);
+        cellsOf(p3.data(), cells3[pass].data(), n, g3);
+        cellsOf(p2.data(), cells2[pass].data(), n, g2);
+        cellIndices(p3.data(), idx3[pass].data(), n, g3);
+        cellIndices(p2.data(), idx2[pass].data(), n, g2);
+    }
+    SimdDispatch::resetTier();
+    assert(cells3[0][0] == Vector3i(-1, 0, 1) && cells2[0][0] == Vector2i(0, -1));
+    assert(idx3[0][0] == 0 + 40 * (0 + 8 * 1) && idx2[0][0] == 0);
+    for (size_t i = 0; i < n; ++i)
+    {
+        assert(cells3[0][i] == cells3[1][i] && cells2[0][i] == cells2[1][i]);
+        assert(idx3[0][i] == idx3[1][i] && idx2[0][i] == idx2[1][i]);
+        const Vector3i& c = cells3[0][i];
+        const int x = std::min(std::max(c.x, 0), 39), y = std::min(std::max(c.y, 0), 7), z = std::min(std::max(c.z, 0), 15);
+        assert(idx3[0][i] == (uint32_t)(x + 40 * (y + 8 * z)));
+        const Vector2i& d = cells2[0][i];
+        assert(idx2[0][i] == (uint32_t)(std::min(std::max(d.x, 0), 63) + 64 * std::min(std::max(d.y, 0), 31)));
+        assert(p3[i].x >= g3.origin.x + c.x * g3.cellSize && p3[i].x < g3.origin.x + (c.x + 1) * g3.cellSize);
+    }
+
+    std::cout << "[GridCoords] Tests done\n";
+}
+
+#pragma endregion
+
+// ───────────────────────────────────────────
+void run_all_tests()
+{
+    run_vector2_tests();
+
+    run_vector3_tests();
+
+    run_matrix4_tests();
+
+    run_profiler_tests();
+
+    run_simd_dispatch_tests();
+
+    run_job_pool_tests();
+
+    run_spatial_hash_tests();
+
+    run_kdtree_tests();
+
+    run_aabb_tests();
+
+    run_loose_octree_tests();
+
+    run_sweep_prune_tests();
+
+    run_ray_triangle_tests();
+
+    run_gjk_tests();
+
+    run_matrix3_tests();
+
+    run_quaternion_tests();
+
+    run_rigid_body_tests();
+
+    run_particle_system_tests();
+
+    run_skinning_tests();
+
+    run_animation_tests();
+
+    run_spline_tests();
+
+    run_triangle_setup_tests();
+
+    run_occlusion_culling_tests();
+
+    run_lod_selection_tests();
+
+    run_mesh_simplify_tests();
+
+    run_vertex_cache_tests();
+
+    run_mesh_normals_tests();
+
+    run_vertex_quantization_tests();
+
+    run_half_vector_tests();
+
+    run_fixed_point_tests();
+
+    run_grid_coords_tests();
+}
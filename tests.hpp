@@ -0,0 +1,4 @@
+#pragma once
+
+// Runs every correctness test; each failure trips an assert.
+void run_all_tests();
@@ -0,0 +1,401 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Vector3.hpp"
+#include "matrix4.hpp"
+#include "simd_dispatch.hpp"
+#include "job_pool.hpp"
+
+namespace CPL
+{
+    enum class CullMode { None, Back, Front };
+
+    // One screen-space triangle after setup. Vertices are in pixels (origin
+    // top-left, y down) and always wound so the signed area is positive;
+    // backFacing records the original facing. b0/b1 are each vertex's
+    // barycentrics in the source triangle, so a rasterizer can interpolate
+    // the source vertex attributes across clipped pieces.
+    struct SetupTriangle
+    {
+        float    x[3], y[3];
+        float    z[3];          // depth in [0, 1]
+        float    invW[3];       // 1 / clip w, for perspective-correct interpolation
+        float    b0[3], b1[3];
+        uint32_t primitive;     // index of the source triangle
+        bool     backFacing;
+    };
+
+    struct TriangleSetupStats
+    {
+        size_t trianglesIn = 0;
+        size_t culledFrustum = 0;   // entirely outside one clip plane
+        size_t culledBackFace = 0;
+        size_t culledSmall = 0;     // degenerate, or covering no pixel centre (per piece)
+        size_t clipped = 0;         // inputs that crossed a clip plane
+        size_t trianglesOut = 0;    // pieces that survived, in triangles()
+        size_t binEntries = 0;      // (triangle, tile) pairs
+    };
+
+    // CPU front end: bulk MVP transform of indexed Vector3f triangles,
+    // clipping against the homogeneous volume -w <= x, y, z <= w, face and
+    // small-triangle culling, then binning into square screen tiles.
+    // Counter-clockwise triangles (in normalized device coordinates) face
+    // front, as in OpenGL. Every stage splits its work into fixed chunks, so
+    // the output, including each bin's order (submission order), is the same
+    // for any thread count.
+    class TriangleSetup
+    {
+    public:
+        TriangleSetup(int width, int height, int tileSize = 64)
+            : width(width), height(height), tileSize(tileSize),
+              tilesX((width + tileSize - 1) / tileSize), tilesY((height + tileSize - 1) / tileSize) {}
+
+        void setCullMode(CullMode mode) { cull = mode; }
+
+        void process(const Matrix4f& mvp, const Vector3f* vertices, size_t vertexCount,
+                     const uint32_t* indices, size_t triangleCount, JobPool& pool = JobPool::global())
+        {
+            transformVertices(mvp, vertices, vertexCount, pool);
+            setupTriangles(indices, triangleCount, pool);
+            binTriangles(pool);
+        }
+
+        int tileCountX() const { return tilesX; }
+        int tileCountY() const { return tilesY; }
+        int tileSizePixels() const { return tileSize; }
+
+        const std::vector<SetupTriangle>& triangles() const { return output; }
+
+        // Indices into triangles() overlapping tile (tx, ty), in submission order.
+        const uint32_t* bin(int tx, int ty, size_t& count) const
+        {
+            size_t t = (size_t)ty * tilesX + tx;
+            count = binOffsets[t + 1] - binOffsets[t];
+            return binEntries.data() + binOffsets[t];
+        }
+
+        const TriangleSetupStats& stats() const { return frameStats; }
+
+    private:
+        static constexpr size_t VertexGrain = 4096, TriangleGrain = 2048;
+
+        int      width, height, tileSize, tilesX, tilesY;
+        CullMode cull = CullMode::Back;
+
+        // Clip-space vertices as SoA, plus outcodes: bit 2k set when outside
+        // the negative side of axis k, bit 2k + 1 when outside the positive.
+        std::vector<float>    clip[4];
+        std::vector<uint32_t> outcodes;
+
+        std::vector<std::vector<SetupTriangle>> chunkTriangles;
+        std::vector<TriangleSetupStats>         chunkStats;
+        std::vector<SetupTriangle>              output;
+        std::vector<uint32_t>                   tileCounts;  // per chunk, per tile
+        std::vector<size_t>                     binOffsets;
+        std::vector<uint32_t>                   binEntries;
+        TriangleSetupStats                      frameStats;
+
+        struct ClipVertex { float x, y, z, w, b0, b1; };
+
+        // ─── Vertex transform ──────────────────────────────
+
+        static uint32_t outcode(float x, float y, float z, float w)
+        {
+            return (x < -w) | (x > w) << 1 | (y < -w) << 2 | (y > w) << 3 | (z < -w) << 4 | (z > w) << 5;
+        }
+
+        void transformVertices(const Matrix4f& m, const Vector3f* v, size_t n, JobPool& pool)
+        {
+            for (auto& c : clip) c.resize(n);
+            outcodes.resize(n);
+            float* out[4] = { clip[0].data(), clip[1].data(), clip[2].data(), clip[3].data() };
+            uint32_t* codes = outcodes.data();
+#if defined(CPL_X86)
+            const bool simd = SimdDispatch::tier() >= SimdTier::AVX2;
+#endif
+            pool.parallelFor(n, VertexGrain, [&](size_t b, size_t e) {
+#if defined(CPL_X86)
+                if (simd) b = transformAVX2(m, v, b, e, out, codes);
+#endif
+                for (size_t i = b; i < e; ++i)
+                {
+                    float c[4];
+                    for (int r = 0; r < 4; ++r) c[r] = m(r, 0) * v[i].x + m(r, 1) * v[i].y + m(r, 2) * v[i].z + m(r, 3);
+                    for (int r = 0; r < 4; ++r) out[r][i] = c[r];
+                    codes[i] = outcode(c[0], c[1], c[2], c[3]);
+                }
+            });
+        }
+
+#if defined(CPL_X86)
+        CPL_TARGET_AVX2 static size_t transformAVX2(const Matrix4f& m, const Vector3f* v, size_t b, size_t e,
+                                                    float* const* out, uint32_t* codes)
+        {
+            __m256 row[4][4];
+            for (int r = 0; r < 4; ++r)
+                for (int c = 0; c < 4; ++c) row[r][c] = _mm256_set1_ps(m(r, c));
+            const __m256 sign = _mm256_set1_ps(-0.0f);
+            size_t i = b;
+            for (; i + 8 <= e; i += 8)
+            {
+                __m256 x, y, z;
+                kernels::load3(v + i, x, y, z);
+                __m256 c[4];
+                for (int r = 0; r < 4; ++r)
+                {
+                    c[r] = _mm256_fmadd_ps(row[r][0], x, _mm256_fmadd_ps(row[r][1], y, _mm256_fmadd_ps(row[r][2], z, row[r][3])));
+                    _mm256_storeu_ps(out[r] + i, c[r]);
+                }
+                __m256 negW = _mm256_xor_ps(c[3], sign);
+                __m256i code = _mm256_setzero_si256();
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    __m256i below = _mm256_castps_si256(_mm256_cmp_ps(c[axis], negW, _CMP_LT_OQ));
+                    __m256i above = _mm256_castps_si256(_mm256_cmp_ps(c[axis], c[3], _CMP_GT_OQ));
+                    code = _mm256_or_si256(code, _mm256_and_si256(below, _mm256_set1_epi32(1 << (2 * axis))));
+                    code = _mm256_or_si256(code, _mm256_and_si256(above, _mm256_set1_epi32(2 << (2 * axis))));
+                }
+                _mm256_storeu_si256((__m256i*)(codes + i), code);
+            }
+            return i;
+        }
+#endif
+
+        // ─── Clipping, culling, projection ──────────────────
+
+        // Signed distance to plane p (0..5), non-negative inside.
+        static float planeDistance(const ClipVertex& v, int p)
+        {
+            float c = p < 2 ? v.x : (p < 4 ? v.y : v.z);
+            return (p & 1) ? v.w - c : v.w + c;
+        }
+
+        // Sutherland-Hodgman against the planes flagged in `planes`.
+        static int clipPolygon(ClipVertex* poly, int count, uint32_t planes)
+        {
+            ClipVertex scratch[9];
+            for (int p = 0; p < 6 && count > 0; ++p)
+            {
+                if (!(planes & (1u << p))) continue;
+                int n = 0;
+                for (int i = 0; i < count; ++i)
+                {
+                    const ClipVertex& a = poly[i];
+                    const ClipVertex& b = poly[(i + 1) % count];
+                    float da = planeDistance(a, p), db = planeDistance(b, p);
+                    if (da >= 0) scratch[n++] = a;
+                    if ((da >= 0) != (db >= 0))
+                    {
+                        float t = da / (da - db);
+                        scratch[n++] = { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t,
+                                         a.w + (b.w - a.w) * t, a.b0 + (b.b0 - a.b0) * t, a.b1 + (b.b1 - a.b1) * t };
+                    }
+                }
+                std::copy(scratch, scratch + n, poly);
+                count = n;
+            }
+            return count;
+        }
+
+        struct ScreenVertex { float x, y, z, invW, b0, b1; };
+
+        ScreenVertex project(const ClipVertex& v) const
+        {
+            float iw = 1 / v.w;
+            return { (v.x * iw * 0.5f + 0.5f) * width, (0.5f - v.y * iw * 0.5f) * height,
+                     v.z * iw * 0.5f + 0.5f, iw, v.b0, v.b1 };
+        }
+
+        // Twice the signed area on screen; y points down, so a triangle that
+        // is counter-clockwise in NDC comes out negative. The products of the
+        // float differences are exact in double, so the sign does not depend
+        // on FMA contraction and two equal vertices always give exactly 0.
+        static double area2(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c)
+        {
+            return double(b.x - a.x) * double(c.y - a.y) - double(c.x - a.x) * double(b.y - a.y);
+        }
+
+        // Two corners at the same clip position: no area whatever the
+        // transform rounding, and clipping would only turn that into noise.
+        bool coincident(const uint32_t* idx) const
+        {
+            auto same = [&](uint32_t i, uint32_t j) {
+                return clip[0][i] == clip[0][j] && clip[1][i] == clip[1][j] && clip[2][i] == clip[2][j] && clip[3][i] == clip[3][j];
+            };
+            return same(idx[0], idx[1]) || same(idx[1], idx[2]) || same(idx[0], idx[2]);
+        }
+
+        // True when the bounding box contains no pixel centre (i + 0.5).
+        static bool missesPixelCentres(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c)
+        {
+            float minX = std::min({ a.x, b.x, c.x }), maxX = std::max({ a.x, b.x, c.x });
+            float minY = std::min({ a.y, b.y, c.y }), maxY = std::max({ a.y, b.y, c.y });
+            return std::ceil(minX - 0.5f) > std::floor(maxX - 0.5f) || std::ceil(minY - 0.5f) > std::floor(maxY - 0.5f);
+        }
+
+        void emit(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c, uint32_t primitive, bool backFacing,
+                  std::vector<SetupTriangle>& out, TriangleSetupStats& st) const
+        {
+            double area = area2(a, b, c);
+            if (area == 0 || missesPixelCentres(a, b, c)) { ++st.culledSmall; return; }
+            const ScreenVertex* v[3] = { &a, &b, &c };
+            if (area < 0) std::swap(v[1], v[2]);
+            SetupTriangle t;
+            for (int k = 0; k < 3; ++k)
+            {
+                t.x[k] = v[k]->x; t.y[k] = v[k]->y; t.z[k] = v[k]->z; t.invW[k] = v[k]->invW;
+                t.b0[k] = v[k]->b0; t.b1[k] = v[k]->b1;
+            }
+            t.primitive = primitive;
+            t.backFacing = backFacing;
+            out.push_back(t);
+            ++st.trianglesOut;
+        }
+
+        bool culled(bool backFacing) const
+        {
+            return (cull == CullMode::Back && backFacing) || (cull == CullMode::Front && !backFacing);
+        }
+
+        void setupTriangles(const uint32_t* indices, size_t count, JobPool& pool)
+        {
+            const size_t chunks = JobPool::chunkCount(count, TriangleGrain);
+            chunkTriangles.resize(chunks);
+            chunkStats.assign(chunks, TriangleSetupStats());
+            pool.parallelChunks(count, TriangleGrain, [&](size_t chunk, size_t b, size_t e) {
+                std::vector<SetupTriangle>& out = chunkTriangles[chunk];
+                TriangleSetupStats& st = chunkStats[chunk];
+                out.clear();
+                st.trianglesIn = e - b;
+                for (size_t t = b; t < e; ++t)
+                {
+                    const uint32_t* idx = indices + t * 3;
+                    uint32_t c0 = outcodes[idx[0]], c1 = outcodes[idx[1]], c2 = outcodes[idx[2]];
+                    if (c0 & c1 & c2) { ++st.culledFrustum; continue; }
+                    if (coincident(idx)) { ++st.culledSmall; continue; }
+
+                    ClipVertex poly[9];
+                    const float bary[3][2] = { { 1, 0 }, { 0, 1 }, { 0, 0 } };
+                    for (int k = 0; k < 3; ++k)
+                        poly[k] = { clip[0][idx[k]], clip[1][idx[k]], clip[2][idx[k]], clip[3][idx[k]], bary[k][0], bary[k][1] };
+
+                    if ((c0 | c1 | c2) == 0)
+                    {
+                        ScreenVertex a = project(poly[0]), bb = project(poly[1]), c = project(poly[2]);
+                        bool backFacing = area2(a, bb, c) > 0;
+                        if (culled(backFacing)) { ++st.culledBackFace; continue; }
+                        emit(a, bb, c, (uint32_t)t, backFacing, out, st);
+                        continue;
+                    }
+
+                    ++st.clipped;
+                    int n = clipPolygon(poly, 3, c0 | c1 | c2);
+                    if (n < 3) { ++st.culledFrustum; continue; }
+                    ScreenVertex s[9];
+                    double area = 0;
+                    for (int k = 0; k < n; ++k) s[k] = project(poly[k]);
+                    for (int k = 1; k + 1 < n; ++k) area += area2(s[0], s[k], s[k + 1]);
+                    bool backFacing = area > 0;
+                    if (culled(backFacing)) { ++st.culledBackFace; continue; }
+                    for (int k = 1; k + 1 < n; ++k) emit(s[0], s[k], s[k + 1], (uint32_t)t, backFacing, out, st);
+                }
+            });
+
+            frameStats = TriangleSetupStats();
+            size_t total = 0;
+            for (size_t c = 0; c < chunks; ++c)
+            {
+                const TriangleSetupStats& st = chunkStats[c];
+                frameStats.trianglesIn += st.trianglesIn;
+                frameStats.culledFrustum += st.culledFrustum;
+                frameStats.culledBackFace += st.culledBackFace;
+                frameStats.culledSmall += st.culledSmall;
+                frameStats.clipped += st.clipped;
+                frameStats.trianglesOut += st.trianglesOut;
+                total += chunkTriangles[c].size();
+            }
+            output.resize(total);
+            std::vector<size_t> first(chunks + 1, 0);
+            for (size_t c = 0; c < chunks; ++c) first[c + 1] = first[c] + chunkTriangles[c].size();
+            pool.parallelFor(chunks, 1, [&](size_t b, size_t e) {
+                for (size_t c = b; c < e; ++c) std::copy(chunkTriangles[c].begin(), chunkTriangles[c].end(), output.begin() + first[c]);
+            });
+        }
+
+        // ─── Binning ───────────────────────────────────────
+
+        // Calls fn(tile) for every tile the triangle may cover: its bounding
+        // box, minus tiles lying wholly outside one of the edges.
+        template<typename F>
+        void forEachTile(const SetupTriangle& t, F&& fn) const
+        {
+            float minX = std::min({ t.x[0], t.x[1], t.x[2] }), maxX = std::max({ t.x[0], t.x[1], t.x[2] });
+            float minY = std::min({ t.y[0], t.y[1], t.y[2] }), maxY = std::max({ t.y[0], t.y[1], t.y[2] });
+            int tx0 = std::max(0, (int)std::floor(minX / tileSize)), tx1 = std::min(tilesX - 1, (int)std::floor(maxX / tileSize));
+            int ty0 = std::max(0, (int)std::floor(minY / tileSize)), ty1 = std::min(tilesY - 1, (int)std::floor(maxY / tileSize));
+            if (tx0 == tx1 && ty0 == ty1)
+            {
+                fn(ty0 * tilesX + tx0);
+                return;
+            }
+            // Edge functions E(p) = (x1 - x0)(py - y0) - (y1 - y0)(px - x0), all
+            // non-negative inside since the area is positive. Test each at the
+            // tile corner where it is largest.
+            float ex[3], ey[3], e0[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                int n = (k + 1) % 3;
+                ex[k] = -(t.y[n] - t.y[k]);
+                ey[k] = t.x[n] - t.x[k];
+                e0[k] = -(ex[k] * t.x[k] + ey[k] * t.y[k]);
+            }
+            for (int ty = ty0; ty <= ty1; ++ty)
+                for (int tx = tx0; tx <= tx1; ++tx)
+                {
+                    float x0 = float(tx * tileSize), y0 = float(ty * tileSize);
+                    float x1 = x0 + tileSize, y1 = y0 + tileSize;
+                    bool outside = false;
+                    for (int k = 0; k < 3 && !outside; ++k)
+                        outside = ex[k] * (ex[k] > 0 ? x1 : x0) + ey[k] * (ey[k] > 0 ? y1 : y0) + e0[k] < 0;
+                    if (!outside) fn(ty * tilesX + tx);
+                }
+        }
+
+        // Counting sort into per-tile lists: count per (chunk, tile), prefix
+        // sum tile-major then chunk-minor, then scatter.
+        void binTriangles(JobPool& pool)
+        {
+            const size_t tiles = (size_t)tilesX * tilesY;
+            const size_t chunks = JobPool::chunkCount(output.size(), TriangleGrain);
+            tileCounts.assign(chunks * tiles, 0);
+            pool.parallelChunks(output.size(), TriangleGrain, [&](size_t chunk, size_t b, size_t e) {
+                uint32_t* counts = tileCounts.data() + chunk * tiles;
+                for (size_t i = b; i < e; ++i) forEachTile(output[i], [&](size_t tile) { ++counts[tile]; });
+            });
+
+            binOffsets.assign(tiles + 1, 0);
+            size_t running = 0;
+            for (size_t tile = 0; tile < tiles; ++tile)
+            {
+                binOffsets[tile] = running;
+                for (size_t c = 0; c < chunks; ++c)
+                {
+                    uint32_t n = tileCounts[c * tiles + tile];
+                    tileCounts[c * tiles + tile] = (uint32_t)running;
+                    running += n;
+                }
+            }
+            binOffsets[tiles] = running;
+            binEntries.resize(running);
+            frameStats.binEntries = running;
+
+            pool.parallelChunks(output.size(), TriangleGrain, [&](size_t chunk, size_t b, size_t e) {
+                uint32_t* cursor = tileCounts.data() + chunk * tiles;
+                for (size_t i = b; i < e; ++i) forEachTile(output[i], [&](size_t tile) { binEntries[cursor[tile]++] = (uint32_t)i; });
+            });
+        }
+    };
+}
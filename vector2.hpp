@@ -1,6 +1,7 @@
 ﻿#pragma once
 #include <cmath>
 #include <ostream>
+#include <type_traits>
 
 namespace CPL 
 {
@@ -12,8 +13,12 @@ namespace CPL
 		T x;
 		T y;
 
+		// length(), normalization and angles truncate to nothing useful on an
+		// integer lattice; grid_coords.hpp has manhattan() and chebyshev().
+		static constexpr bool IsReal = !std::is_integral<T>::value;
+
 		// Default constructor
-		Vector2() :x(0.0f), y(0.0f) {}
+		Vector2() :x(T(0)), y(T(0)) {}
 		Vector2(T x, T y) : x(x), y(y)	{}
 
 		Vector2(const Vector2& other) : x(other.x), y(other.y) {}
@@ -41,17 +46,17 @@ namespace CPL
 
 		static Vector2 ones()
 		{
-			return Vector2(1.0f, 1.0f);
+			return Vector2(T(1), T(1));
 		}
 
 		static Vector2 zeros()
 		{
-			return Vector2(0.0f, 0.0f);
+			return Vector2(T(0), T(0));
 		}
 
 		static Vector2 up()
 		{
-			return Vector2(0.0f, 1.0f);
+			return Vector2(T(0), T(1));
 		}
 
 		bool operator==(const Vector2& other)
@@ -105,11 +110,15 @@ namespace CPL
 
 		T length() const noexcept
 		{
-			return std::sqrt(lengthSquared());
+			static_assert(IsReal, "length() needs a non-integer scalar");
+			// Unqualified math so scalar types can supply their own through ADL.
+			using std::sqrt;
+			return T(sqrt(lengthSquared()));
 		}
 
 		Vector2 normalized() const noexcept
 		{
+			static_assert(IsReal, "normalized() needs a non-integer scalar");
 			T len = length();
 			if (len == T(0)) return Vector2(0, 0);
 			return Vector2(x / len, y / len);
@@ -117,6 +126,7 @@ namespace CPL
 
 		void normalize()
 		{
+			static_assert(IsReal, "normalize() needs a non-integer scalar");
 			T len = length();
 			if (len == T(0)) return;
 			x /= len;
@@ -125,15 +135,19 @@ namespace CPL
 
 		T angle() const noexcept
 		{
-			return std::atan2(y, x);
+			static_assert(IsReal, "angle() needs a non-integer scalar");
+			using std::atan2;
+			return T(atan2(y, x));
 		}
 
 		T angleBetween(const Vector2& other) const noexcept
 		{
+			static_assert(IsReal, "angleBetween() needs a non-integer scalar");
 			T cosTheta = dot(other) / (length() * other.length());
 			if (cosTheta > 1)  cosTheta = 1;
 			if (cosTheta < -1) cosTheta = -1;
-			return std::acos(cosTheta);
+			using std::acos;
+			return T(acos(cosTheta));
 		}
 
 		Vector2 direction() const noexcept
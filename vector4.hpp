@@ -0,0 +1,49 @@
+#pragma once
+#include <cmath>
+#include <ostream>
+#include "Vector3.hpp"
+
+namespace CPL
+{
+    // Homogeneous coordinates, mostly clip-space positions straight out of a
+    // projection matrix. w is kept; divide explicitly with perspectiveDivide().
+    template<typename T>
+    class Vector4
+    {
+    public:
+        T x, y, z, w;
+
+        Vector4() : x(0), y(0), z(0), w(0) {}
+        Vector4(T x, T y, T z, T w) : x(x), y(y), z(z), w(w) {}
+        Vector4(const Vector3<T>& v, T w) : x(v.x), y(v.y), z(v.z), w(w) {}
+
+        static Vector4 zeros() { return Vector4(0, 0, 0, 0); }
+
+        Vector4 operator+(const Vector4& o) const { return { x + o.x, y + o.y, z + o.z, w + o.w }; }
+        Vector4& operator+=(const Vector4& o) { x += o.x; y += o.y; z += o.z; w += o.w; return *this; }
+
+        Vector4 operator*(T s)   const { return { x * s, y * s, z * s, w * s }; }
+        Vector4& operator*=(T s) { x *= s; y *= s; z *= s; w *= s; return *this; }
+
+        bool operator==(const Vector4& o) const { return x == o.x && y == o.y && z == o.z && w == o.w; }
+        bool operator!=(const Vector4& o) const { return !(*this == o); }
+
+        T dot(const Vector4& o) const { return x * o.x + y * o.y + z * o.z + w * o.w; }
+
+        Vector3<T> xyz() const { return { x, y, z }; }
+
+        // (x, y, z) / w; w must be non-zero (clip first).
+        Vector3<T> perspectiveDivide() const
+        {
+            T inv = 1 / w;
+            return { x * inv, y * inv, z * inv };
+        }
+
+        friend std::ostream& operator<<(std::ostream& os, const Vector4& v)
+        {
+            return os << '(' << v.x << ", " << v.y << ", " << v.z << ", " << v.w << ')';
+        }
+    };
+
+    using Vector4f = Vector4<float>;
+}
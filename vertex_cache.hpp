@@ -0,0 +1,296 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Vector3.hpp"
+
+namespace CPL
+{
+    struct VertexCacheStats
+    {
+        size_t triangles = 0;
+        size_t vertices = 0;       // distinct vertices referenced
+        size_t transformed = 0;    // cache misses: vertex shader invocations
+        float  acmr = 0;           // transformed / triangles; 0.5 is the ideal for a large grid
+        float  atvr = 0;           // transformed / vertices; 1 is the ideal
+    };
+
+    // Replays the index buffer through a FIFO post-transform cache of
+    // `cacheSize` entries, the model most hardware is closest to.
+    inline VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                                               unsigned cacheSize = 16)
+    {
+        VertexCacheStats s;
+        // A vertex is cached while it entered fewer than cacheSize misses ago.
+        std::vector<size_t> entered(vertexCount, 0);
+        std::vector<uint8_t> seen(vertexCount, 0);
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            uint32_t v = indices[i];
+            if (!seen[v]) { seen[v] = 1; ++s.vertices; }
+            if (entered[v] == 0 || s.transformed - entered[v] >= cacheSize)
+            {
+                ++s.transformed;
+                entered[v] = s.transformed;
+            }
+        }
+        s.triangles = indexCount / 3;
+        s.acmr = s.triangles ? (float)s.transformed / s.triangles : 0;
+        s.atvr = s.vertices ? (float)s.transformed / s.vertices : 0;
+        return s;
+    }
+
+    // Triangle order for the post-transform cache after Forsyth, "Linear-
+    // Speed Vertex Cache Optimisation": vertices score by their position in
+    // a simulated LRU cache and by how many triangles still need them, and
+    // the highest-scoring triangle among those touching the cache goes
+    // next. Linear time; writes triangles (winding kept) to `destination`,
+    // which must not alias `indices`.
+    class VertexCacheOptimizer
+    {
+    public:
+        static constexpr int CacheSize = 32;
+
+        void optimize(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount)
+        {
+            const size_t triCount = indexCount / 3;
+            buildAdjacency(indices, triCount, vertexCount);
+            cachePos.assign(vertexCount, -1);
+            vertexScore.resize(vertexCount);
+            for (size_t v = 0; v < vertexCount; ++v) vertexScore[v] = score(-1, live[v]);
+            triScore.resize(triCount);
+            for (size_t t = 0; t < triCount; ++t)
+                triScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+            emitted.assign(triCount, 0);
+
+            int cacheCount = 0;
+            size_t cursor = 0;  // scan position for restarts when the cache has no candidates
+            int64_t best = -1;
+            for (size_t out = 0; out < triCount; ++out)
+            {
+                if (best < 0)
+                {
+                    while (emitted[cursor]) ++cursor;
+                    best = (int64_t)cursor;
+                }
+                const uint32_t* tri = indices + best * 3;
+                std::copy(tri, tri + 3, destination + out * 3);
+                emitted[best] = 1;
+
+                // The triangle's vertices move to the front; the rest shift back.
+                int next = 0;
+                for (int k = 0; k < 3; ++k)
+                {
+                    uint32_t v = tri[k];
+                    if (std::find(scratch, scratch + next, v) == scratch + next) scratch[next++] = v;
+                    uint32_t* begin = adjTriangles.data() + adjOffsets[v];
+                    uint32_t* end = begin + live[v];
+                    *std::find(begin, end, (uint32_t)best) = end[-1];
+                    --live[v];
+                }
+                for (int i = 0; i < cacheCount; ++i)
+                {
+                    uint32_t v = cache[i];
+                    if (v != tri[0] && v != tri[1] && v != tri[2]) scratch[next++] = v;
+                }
+                for (int i = CacheSize; i < next; ++i) cachePos[scratch[i]] = -1;
+                cacheCount = std::min(next, (int)CacheSize);
+                std::copy(scratch, scratch + cacheCount, cache);
+
+                // Rescore everything that was in the cache and push the
+                // change into the live triangles around each vertex.
+                best = -1;
+                float bestScore = 0;
+                for (int i = 0; i < next; ++i)
+                {
+                    uint32_t v = scratch[i];
+                    if (i < CacheSize) cachePos[v] = i;
+                    float updated = score(cachePos[v], live[v]);
+                    float delta = updated - vertexScore[v];
+                    vertexScore[v] = updated;
+                    const uint32_t* adj = adjTriangles.data() + adjOffsets[v];
+                    for (uint32_t k = 0; k < live[v]; ++k) triScore[adj[k]] += delta;
+                }
+                for (int i = 0; i < cacheCount; ++i)
+                {
+                    uint32_t v = cache[i];
+                    const uint32_t* adj = adjTriangles.data() + adjOffsets[v];
+                    for (uint32_t k = 0; k < live[v]; ++k)
+                        if (triScore[adj[k]] > bestScore) { bestScore = triScore[adj[k]]; best = adj[k]; }
+                }
+            }
+        }
+
+    private:
+        std::vector<uint32_t> adjOffsets, adjTriangles, live;
+        std::vector<int>      cachePos;
+        std::vector<float>    vertexScore, triScore;
+        std::vector<uint8_t>  emitted;
+        uint32_t              cache[CacheSize], scratch[CacheSize + 3];
+
+        // Forsyth's constants: the last triangle's vertices get a flat 0.75
+        // so the next triangle need not reuse all three; the rest decay
+        // with cache position. Few remaining triangles boosts a vertex so
+        // it gets finished off instead of lingering.
+        static float score(int position, uint32_t remaining)
+        {
+            struct Tables
+            {
+                float cache[CacheSize], valence[64];
+                Tables()
+                {
+                    for (int i = 0; i < CacheSize; ++i)
+                        cache[i] = i < 3 ? 0.75f : std::pow(1.0f - float(i - 3) / (CacheSize - 3), 1.5f);
+                    valence[0] = 0;
+                    for (int i = 1; i < 64; ++i) valence[i] = 2.0f / std::sqrt((float)i);
+                }
+            };
+            static const Tables tables;
+            if (remaining == 0) return -1;  // no triangles left: never a candidate
+            return (position >= 0 ? tables.cache[position] : 0) + tables.valence[std::min(remaining, 63u)];
+        }
+
+        void buildAdjacency(const uint32_t* indices, size_t triCount, size_t vertexCount)
+        {
+            live.assign(vertexCount, 0);
+            for (size_t i = 0; i < triCount * 3; ++i) ++live[indices[i]];
+            adjOffsets.resize(vertexCount + 1);
+            adjOffsets[0] = 0;
+            for (size_t v = 0; v < vertexCount; ++v) adjOffsets[v + 1] = adjOffsets[v] + live[v];
+            adjTriangles.resize(triCount * 3);
+            std::vector<uint32_t> fill(adjOffsets.begin(), adjOffsets.end() - 1);
+            for (size_t t = 0; t < triCount; ++t)
+                for (int k = 0; k < 3; ++k) adjTriangles[fill[indices[t * 3 + k]]++] = (uint32_t)t;
+        }
+    };
+
+    inline void optimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount)
+    {
+        VertexCacheOptimizer().optimize(destination, indices, indexCount, vertexCount);
+    }
+
+    // Overdraw pass to run after the cache pass (Sander et al., "Fast
+    // Triangle Reordering for Vertex Locality and Reduced Overdraw").
+    // Cuts the cache-ordered triangles into clusters, then orders the
+    // clusters outward-facing first: by dot(cluster centroid - mesh
+    // centroid, cluster normal), descending, since those tend to be drawn
+    // before what they hide from most views. A cluster ends where the
+    // replayed cache restarts anyway (no vertex of a triangle cached) or,
+    // within that, as soon as its own ACMR from a cold cache is within
+    // `threshold` of the surrounding run's: reordering then costs at most
+    // that factor in transformed vertices.
+    inline void optimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+                                 const Vector3f* positions, size_t vertexCount, float threshold = 1.05f,
+                                 unsigned cacheSize = 16)
+    {
+        const size_t triCount = indexCount / 3;
+        std::vector<size_t> entered(vertexCount, 0);
+        size_t transformed = 0;
+        auto misses = [&](size_t t) {
+            int m = 0;
+            for (int k = 0; k < 3; ++k)
+            {
+                uint32_t v = indices[t * 3 + k];
+                if (entered[v] == 0 || transformed - entered[v] >= cacheSize) { entered[v] = ++transformed; ++m; }
+            }
+            return m;
+        };
+        // Flushing is a jump in the miss counter past every cached entry.
+        auto flush = [&] { transformed += cacheSize; };
+
+        std::vector<size_t> hard;
+        std::vector<size_t> hardMisses;
+        for (size_t t = 0; t < triCount; ++t)
+        {
+            int m = misses(t);
+            if (t == 0 || m == 3) { hard.push_back(t); hardMisses.push_back(0); }
+            hardMisses.back() += m;
+        }
+        hard.push_back(triCount);
+
+        std::vector<size_t> clusterStart;
+        for (size_t h = 0; h + 1 < hard.size(); ++h)
+        {
+            const float target = threshold * (float)hardMisses[h] / float(hard[h + 1] - hard[h]);
+            flush();
+            size_t start = hard[h], runMisses = 0;
+            clusterStart.push_back(start);
+            for (size_t t = hard[h]; t < hard[h + 1]; ++t)
+            {
+                runMisses += misses(t);
+                if (t + 1 < hard[h + 1] && (float)runMisses <= target * float(t + 1 - start))
+                {
+                    flush();
+                    start = t + 1;
+                    runMisses = 0;
+                    clusterStart.push_back(start);
+                }
+            }
+        }
+        clusterStart.push_back(triCount);
+
+        // Area-weighted centroid and normal per cluster and for the mesh.
+        const size_t clusters = clusterStart.size() - 1;
+        std::vector<Vector3f> centroid(clusters), normal(clusters);
+        std::vector<float> area(clusters, 0);
+        Vector3f meshCentroid;
+        float meshArea = 0;
+        for (size_t c = 0; c < clusters; ++c)
+        {
+            for (size_t t = clusterStart[c]; t < clusterStart[c + 1]; ++t)
+            {
+                const Vector3f &p0 = positions[indices[t * 3]], &p1 = positions[indices[t * 3 + 1]], &p2 = positions[indices[t * 3 + 2]];
+                Vector3f n = (p1 + p0 * -1).cross(p2 + p0 * -1);
+                float a = n.length();
+                centroid[c] += (p0 + p1 + p2) * (a / 3);
+                normal[c] += n;
+                area[c] += a;
+            }
+            meshCentroid += centroid[c];
+            meshArea += area[c];
+            if (area[c] > 0) centroid[c] /= area[c];
+        }
+        if (meshArea > 0) meshCentroid /= meshArea;
+
+        std::vector<float> key(clusters);
+        std::vector<size_t> order(clusters);
+        for (size_t c = 0; c < clusters; ++c)
+        {
+            key[c] = (centroid[c] + meshCentroid * -1).dot(normal[c].normalized());
+            order[c] = c;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return key[a] > key[b]; });
+
+        uint32_t* out = destination;
+        for (size_t c : order)
+            out = std::copy(indices + clusterStart[c] * 3, indices + clusterStart[c + 1] * 3, out);
+    }
+
+    // Vertex order for fetch locality: vertices renumbered by first use in
+    // the index buffer. Fills remap[old] = new (UINT32_MAX for unused
+    // vertices, which sort last and are dropped) and returns the number of
+    // vertices kept. Apply with remapIndices and remapVertices on every stream.
+    inline size_t optimizeVertexFetchRemap(uint32_t* remap, const uint32_t* indices, size_t indexCount, size_t vertexCount)
+    {
+        std::fill(remap, remap + vertexCount, UINT32_MAX);
+        uint32_t next = 0;
+        for (size_t i = 0; i < indexCount; ++i)
+            if (remap[indices[i]] == UINT32_MAX) remap[indices[i]] = next++;
+        return next;
+    }
+
+    inline void remapIndices(uint32_t* destination, const uint32_t* indices, size_t indexCount, const uint32_t* remap)
+    {
+        for (size_t i = 0; i < indexCount; ++i) destination[i] = remap[indices[i]];
+    }
+
+    // destination must hold as many vertices as optimizeVertexFetchRemap kept.
+    template<typename T>
+    void remapVertices(T* destination, const T* vertices, size_t vertexCount, const uint32_t* remap)
+    {
+        for (size_t v = 0; v < vertexCount; ++v)
+            if (remap[v] != UINT32_MAX) destination[remap[v]] = vertices[v];
+    }
+}
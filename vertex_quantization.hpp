@@ -0,0 +1,328 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include "vector2.hpp"
+#include "Vector3.hpp"
+#include "aabb.hpp"
+#include "half.hpp"
+#include "simd_dispatch.hpp"
+
+namespace CPL
+{
+    // Compact vertex attribute encodings for streams of n vertices, each
+    // with a bulk encoder and decoder (8 vertices per step on the AVX2
+    // tier) and a known error bound:
+    //
+    //   positions  3 x half        6 bytes  relative error 2^-11 of |p|
+    //   positions  3 x snorm16     6 bytes  half-extent / 65534 per axis, in an AABB
+    //   normals    2 x snorm16     4 bytes  octahedral map, < 7e-5 rad
+    //   uvs        2 x unorm16     4 bytes  range / 131070 per axis
+    //
+    // Quantized outputs are interleaved per vertex (x, y, z, x, y, z, ...).
+
+    inline void encodeHalf3(const Vector3f* in, uint16_t* out, size_t n) { floatsToHalves(&in->x, out, n * 3); }
+    inline void decodeHalf3(const uint16_t* in, Vector3f* out, size_t n) { halvesToFloats(in, &out->x, n * 3); }
+
+    // Largest per-axis error of encodeSnorm16 positions in `bounds`.
+    inline Vector3f snorm16PositionError(const AABBf& bounds) { return bounds.extents() * (0.5f / 32767); }
+
+    // Largest per-axis error of encodeUnorm16 uvs in [min, max].
+    inline Vector2f unorm16UvError(const Vector2f& min, const Vector2f& max)
+    {
+        return Vector2f((max.x - min.x) * (0.5f / 65535), (max.y - min.y) * (0.5f / 65535));
+    }
+
+    namespace kernels
+    {
+        // Per-component affine maps shared by the scalar and SIMD paths:
+        // encode q = round(clamp((v - offset) * scale, lo, hi)),
+        // decode v = q * step + offset.
+        template<int N>
+        struct Affine
+        {
+            float offset[N], scale[N], step[N];
+        };
+
+        inline Affine<3> snorm16Positions(const AABBf& bounds)
+        {
+            Affine<3> a;
+            Vector3f c = bounds.center(), e = bounds.extents();
+            const float cs[3] = { c.x, c.y, c.z }, es[3] = { e.x, e.y, e.z };
+            for (int k = 0; k < 3; ++k)
+            {
+                a.offset[k] = cs[k];
+                a.scale[k] = es[k] > 0 ? 32767 / es[k] : 0;
+                a.step[k] = es[k] / 32767;
+            }
+            return a;
+        }
+
+        inline Affine<2> unorm16Uvs(const Vector2f& min, const Vector2f& max)
+        {
+            Affine<2> a;
+            const float lo[2] = { min.x, min.y }, hi[2] = { max.x, max.y };
+            for (int k = 0; k < 2; ++k)
+            {
+                a.offset[k] = lo[k];
+                a.scale[k] = hi[k] > lo[k] ? 65535 / (hi[k] - lo[k]) : 0;
+                a.step[k] = (hi[k] - lo[k]) / 65535;
+            }
+            return a;
+        }
+
+        inline float quantize(float v, float offset, float scale, float lo, float hi)
+        {
+            return std::nearbyint(std::min(std::max((v - offset) * scale, lo), hi));
+        }
+
+        // Octahedral map of a unit vector to [-1, 1]^2 (Cigolle et al. 2014).
+        // The zero vector has no direction and maps to (0, 0), i.e. +Z.
+        inline void octEncode(float x, float y, float z, float& u, float& v)
+        {
+            float l1 = std::abs(x) + std::abs(y) + std::abs(z);
+            float inv = l1 > 0 ? 1 / l1 : 0.0f;
+            u = x * inv;
+            v = y * inv;
+            if (z < 0)
+            {
+                float su = u >= 0 ? 1.0f : -1.0f, sv = v >= 0 ? 1.0f : -1.0f;
+                float fu = (1 - std::abs(v)) * su;
+                v = (1 - std::abs(u)) * sv;
+                u = fu;
+            }
+        }
+
+        inline Vector3f octDecode(float u, float v)
+        {
+            float z = 1 - std::abs(u) - std::abs(v);
+            float t = std::max(-z, 0.0f);
+            u += u >= 0 ? -t : t;
+            v += v >= 0 ? -t : t;
+            float inv = 1 / std::sqrt(u * u + v * v + z * z);
+            return { u * inv, v * inv, z * inv };
+        }
+
+#if defined(CPL_X86)
+        // int32 lanes of a and b to 16 int16 in order a0..a7, b0..b7.
+        CPL_TARGET_AVX2 inline __m256i packSigned(__m256i a, __m256i b)
+        {
+            return _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+        }
+
+        CPL_TARGET_AVX2 inline __m256i packUnsigned(__m256i a, __m256i b)
+        {
+            return _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+        }
+
+        // A 3-periodic constant for the 8 floats starting at component `first`.
+        CPL_TARGET_AVX2 inline __m256 periodic3(const float* c, int first)
+        {
+            float lanes[8];
+            for (int i = 0; i < 8; ++i) lanes[i] = c[(first + i) % 3];
+            return _mm256_loadu_ps(lanes);
+        }
+
+        // The interleaved stream is 3-periodic, so 24 floats (8 vertices)
+        // line up with three fixed patterns of per-lane constants.
+        CPL_TARGET_AVX2 inline size_t encodeSnorm16AVX2(const float* in, int16_t* out, size_t n, const Affine<3>& a)
+        {
+            __m256 offset[3], scale[3];
+            for (int r = 0; r < 3; ++r) { offset[r] = periodic3(a.offset, r * 8); scale[r] = periodic3(a.scale, r * 8); }
+            const __m256 lo = _mm256_set1_ps(-32767), hi = _mm256_set1_ps(32767);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                __m256i q[3];
+                for (int r = 0; r < 3; ++r)
+                {
+                    __m256 v = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(in + i * 3 + r * 8), offset[r]), scale[r]);
+                    q[r] = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(v, lo), hi));
+                }
+                _mm256_storeu_si256((__m256i*)(out + i * 3), packSigned(q[0], q[1]));
+                _mm_storeu_si128((__m128i*)(out + i * 3 + 16), _mm256_castsi256_si128(packSigned(q[2], q[2])));
+            }
+            return i;
+        }
+
+        CPL_TARGET_AVX2 inline size_t decodeSnorm16AVX2(const int16_t* in, float* out, size_t n, const Affine<3>& a)
+        {
+            __m256 offset[3], step[3];
+            for (int r = 0; r < 3; ++r) { offset[r] = periodic3(a.offset, r * 8); step[r] = periodic3(a.step, r * 8); }
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+                for (int r = 0; r < 3; ++r)
+                {
+                    __m256 q = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(in + i * 3 + r * 8))));
+                    _mm256_storeu_ps(out + i * 3 + r * 8, _mm256_fmadd_ps(q, step[r], offset[r]));
+                }
+            return i;
+        }
+
+        CPL_TARGET_AVX2 inline size_t encodeOct16AVX2(const Vector3f* in, int16_t* out, size_t n)
+        {
+            const __m256 sign = _mm256_set1_ps(-0.0f), one = _mm256_set1_ps(1.0f), zero = _mm256_setzero_ps();
+            const __m256 q = _mm256_set1_ps(32767);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                __m256 x, y, z;
+                load3(in + i, x, y, z);
+                __m256 ax = _mm256_andnot_ps(sign, x), ay = _mm256_andnot_ps(sign, y), az = _mm256_andnot_ps(sign, z);
+                __m256 l1 = _mm256_add_ps(_mm256_add_ps(ax, ay), az);
+                // Zero vectors get inv = 0 and land on +Z, as in octEncode().
+                __m256 inv = _mm256_and_ps(_mm256_div_ps(one, l1), _mm256_cmp_ps(l1, zero, _CMP_GT_OQ));
+                __m256 u = _mm256_mul_ps(x, inv), v = _mm256_mul_ps(y, inv);
+                // Lower hemisphere folds over the diagonals, keeping the signs of u and v.
+                __m256 su = _mm256_or_ps(one, _mm256_and_ps(sign, _mm256_cmp_ps(u, zero, _CMP_LT_OQ)));
+                __m256 sv = _mm256_or_ps(one, _mm256_and_ps(sign, _mm256_cmp_ps(v, zero, _CMP_LT_OQ)));
+                __m256 fu = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_andnot_ps(sign, v)), su);
+                __m256 fv = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_andnot_ps(sign, u)), sv);
+                __m256 lower = _mm256_cmp_ps(z, zero, _CMP_LT_OQ);
+                u = _mm256_blendv_ps(u, fu, lower);
+                v = _mm256_blendv_ps(v, fv, lower);
+                __m256i qu = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(u, _mm256_set1_ps(-1.0f)), one), q));
+                __m256i qv = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(v, _mm256_set1_ps(-1.0f)), one), q));
+                // (u, v) pairs: u in the low half of each 32-bit word.
+                __m256i words = _mm256_or_si256(_mm256_and_si256(qu, _mm256_set1_epi32(0xffff)), _mm256_slli_epi32(qv, 16));
+                _mm256_storeu_si256((__m256i*)(out + i * 2), words);
+            }
+            return i;
+        }
+
+        CPL_TARGET_AVX2 inline size_t decodeOct16AVX2(const int16_t* in, Vector3f* out, size_t n)
+        {
+            const __m256 sign = _mm256_set1_ps(-0.0f), one = _mm256_set1_ps(1.0f), zero = _mm256_setzero_ps();
+            const __m256 step = _mm256_set1_ps(1.0f / 32767);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                __m256i words = _mm256_loadu_si256((const __m256i*)(in + i * 2));
+                __m256 u = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(words, 16), 16)), step);
+                __m256 v = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srai_epi32(words, 16)), step);
+                __m256 z = _mm256_sub_ps(_mm256_sub_ps(one, _mm256_andnot_ps(sign, u)), _mm256_andnot_ps(sign, v));
+                __m256 t = _mm256_max_ps(_mm256_sub_ps(zero, z), zero);
+                // u += u >= 0 ? -t : t
+                u = _mm256_add_ps(u, _mm256_blendv_ps(_mm256_sub_ps(zero, t), t, _mm256_cmp_ps(u, zero, _CMP_LT_OQ)));
+                v = _mm256_add_ps(v, _mm256_blendv_ps(_mm256_sub_ps(zero, t), t, _mm256_cmp_ps(v, zero, _CMP_LT_OQ)));
+                __m256 inv = _mm256_div_ps(one, _mm256_sqrt_ps(_mm256_fmadd_ps(u, u, _mm256_fmadd_ps(v, v, _mm256_mul_ps(z, z)))));
+                store3(out + i, _mm256_mul_ps(u, inv), _mm256_mul_ps(v, inv), _mm256_mul_ps(z, inv));
+            }
+            return i;
+        }
+
+        // Interleaved uvs are 2-periodic: one pattern covers every register.
+        CPL_TARGET_AVX2 inline size_t encodeUnorm16AVX2(const float* in, uint16_t* out, size_t n, const Affine<2>& a)
+        {
+            const __m256 offset = _mm256_setr_ps(a.offset[0], a.offset[1], a.offset[0], a.offset[1], a.offset[0], a.offset[1], a.offset[0], a.offset[1]);
+            const __m256 scale = _mm256_setr_ps(a.scale[0], a.scale[1], a.scale[0], a.scale[1], a.scale[0], a.scale[1], a.scale[0], a.scale[1]);
+            const __m256 lo = _mm256_setzero_ps(), hi = _mm256_set1_ps(65535);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                __m256i q[2];
+                for (int r = 0; r < 2; ++r)
+                {
+                    __m256 v = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(in + i * 2 + r * 8), offset), scale);
+                    q[r] = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(v, lo), hi));
+                }
+                _mm256_storeu_si256((__m256i*)(out + i * 2), packUnsigned(q[0], q[1]));
+            }
+            return i;
+        }
+
+        CPL_TARGET_AVX2 inline size_t decodeUnorm16AVX2(const uint16_t* in, float* out, size_t n, const Affine<2>& a)
+        {
+            const __m256 offset = _mm256_setr_ps(a.offset[0], a.offset[1], a.offset[0], a.offset[1], a.offset[0], a.offset[1], a.offset[0], a.offset[1]);
+            const __m256 step = _mm256_setr_ps(a.step[0], a.step[1], a.step[0], a.step[1], a.step[0], a.step[1], a.step[0], a.step[1]);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+                for (int r = 0; r < 2; ++r)
+                {
+                    __m256 q = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(in + i * 2 + r * 8))));
+                    _mm256_storeu_ps(out + i * 2 + r * 8, _mm256_fmadd_ps(q, step, offset));
+                }
+            return i;
+        }
+#endif
+    }
+
+    // Positions as offsets from the center of `bounds`, in units of its
+    // extents; points outside are clamped to the box.
+    inline void encodeSnorm16(const Vector3f* in, int16_t* out, size_t n, const AABBf& bounds)
+    {
+        const kernels::Affine<3> a = kernels::snorm16Positions(bounds);
+        const float* f = &in->x;
+        size_t i = 0;
+#if defined(CPL_X86)
+        if (SimdDispatch::tier() >= SimdTier::AVX2) i = kernels::encodeSnorm16AVX2(f, out, n, a);
+#endif
+        for (; i < n; ++i)
+            for (int k = 0; k < 3; ++k)
+                out[i * 3 + k] = (int16_t)kernels::quantize(f[i * 3 + k], a.offset[k], a.scale[k], -32767, 32767);
+    }
+
+    inline void decodeSnorm16(const int16_t* in, Vector3f* out, size_t n, const AABBf& bounds)
+    {
+        const kernels::Affine<3> a = kernels::snorm16Positions(bounds);
+        float* f = &out->x;
+        size_t i = 0;
+#if defined(CPL_X86)
+        if (SimdDispatch::tier() >= SimdTier::AVX2) i = kernels::decodeSnorm16AVX2(in, f, n, a);
+#endif
+        for (; i < n; ++i)
+            for (int k = 0; k < 3; ++k) f[i * 3 + k] = in[i * 3 + k] * a.step[k] + a.offset[k];
+    }
+
+    // Unit vectors (normals, directions) as two snorm16 octahedral coordinates.
+    inline void encodeOct16(const Vector3f* in, int16_t* out, size_t n)
+    {
+        size_t i = 0;
+#if defined(CPL_X86)
+        if (SimdDispatch::tier() >= SimdTier::AVX2) i = kernels::encodeOct16AVX2(in, out, n);
+#endif
+        for (; i < n; ++i)
+        {
+            float u, v;
+            kernels::octEncode(in[i].x, in[i].y, in[i].z, u, v);
+            out[i * 2] = (int16_t)kernels::quantize(u, 0, 32767, -32767, 32767);
+            out[i * 2 + 1] = (int16_t)kernels::quantize(v, 0, 32767, -32767, 32767);
+        }
+    }
+
+    inline void decodeOct16(const int16_t* in, Vector3f* out, size_t n)
+    {
+        size_t i = 0;
+#if defined(CPL_X86)
+        if (SimdDispatch::tier() >= SimdTier::AVX2) i = kernels::decodeOct16AVX2(in, out, n);
+#endif
+        for (; i < n; ++i) out[i] = kernels::octDecode(in[i * 2] * (1.0f / 32767), in[i * 2 + 1] * (1.0f / 32767));
+    }
+
+    // Texture coordinates within [min, max] (clamped), e.g. the mesh's UV bounds.
+    inline void encodeUnorm16(const Vector2f* in, uint16_t* out, size_t n, const Vector2f& min, const Vector2f& max)
+    {
+        const kernels::Affine<2> a = kernels::unorm16Uvs(min, max);
+        const float* f = &in->x;
+        size_t i = 0;
+#if defined(CPL_X86)
+        if (SimdDispatch::tier() >= SimdTier::AVX2) i = kernels::encodeUnorm16AVX2(f, out, n, a);
+#endif
+        for (; i < n; ++i)
+            for (int k = 0; k < 2; ++k)
+                out[i * 2 + k] = (uint16_t)kernels::quantize(f[i * 2 + k], a.offset[k], a.scale[k], 0, 65535);
+    }
+
+    inline void decodeUnorm16(const uint16_t* in, Vector2f* out, size_t n, const Vector2f& min, const Vector2f& max)
+    {
+        const kernels::Affine<2> a = kernels::unorm16Uvs(min, max);
+        float* f = &out->x;
+        size_t i = 0;
+#if defined(CPL_X86)
+        if (SimdDispatch::tier() >= SimdTier::AVX2) i = kernels::decodeUnorm16AVX2(in, f, n, a);
+#endif
+        for (; i < n; ++i)
+            for (int k = 0; k < 2; ++k) f[i * 2 + k] = in[i * 2 + k] * a.step[k] + a.offset[k];
+    }
+}